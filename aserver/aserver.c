@@ -22,6 +22,7 @@
 
 #include <sys/shm.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
 #include <poll.h>
 #include <sys/un.h>
 #include <sys/uio.h>
@@ -34,6 +35,8 @@
 #include <netdb.h>
 #include <limits.h>
 #include <signal.h>
+#include <pthread.h>
+#include <time.h>
 
 
 char *command;
@@ -110,45 +113,47 @@ static int make_inet_socket(int port)
 	return sock;
 }
 
-struct pollfd *pollfds;
-unsigned int pollfds_count = 0;
+/*
+ * The main thread waits for the new connections with epoll.  Every
+ * connected client is then served by its own thread, so a slow command
+ * of one client does not hold up the others.
+ */
+int epoll_fd = -1;
 typedef struct waiter waiter_t;
-typedef int (*waiter_handler_t)(waiter_t *waiter, unsigned short events);
+typedef int (*waiter_handler_t)(waiter_t *waiter, unsigned int events);
 struct waiter {
 	int fd;
 	void *private_data;
 	waiter_handler_t handler;
 };
-waiter_t *waiters;
 
-static void add_waiter(int fd, unsigned short events, waiter_handler_t handler,
-		void *data)
+static int add_waiter(int fd, unsigned int events, waiter_handler_t handler,
+		      void *data)
 {
-	waiter_t *w = &waiters[fd];
-	struct pollfd *pfd = &pollfds[pollfds_count];
-	assert(!w->handler);
-	pfd->fd = fd;
-	pfd->events = events;
-	pfd->revents = 0;
+	struct epoll_event ev;
+	waiter_t *w = malloc(sizeof(*w));
+	if (!w)
+		return -ENOMEM;
 	w->fd = fd;
 	w->private_data = data;
 	w->handler = handler;
-	pollfds_count++;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = events;
+	ev.data.ptr = w;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		int result = -errno;
+		SYSERROR("epoll_ctl failed");
+		free(w);
+		return result;
+	}
+	return 0;
 }
 
-static void del_waiter(int fd)
+static void del_waiter(waiter_t *w)
 {
-	waiter_t *w = &waiters[fd];
-	unsigned int k;
-	assert(w->handler);
-	w->handler = 0;
-	for (k = 0; k < pollfds_count; ++k) {
-		if (pollfds[k].fd == fd)
-			break;
-	}
-	assert(k < pollfds_count);
-	pollfds_count--;
-	memmove(&pollfds[k], &pollfds[k + 1], pollfds_count - k);
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_DEL, w->fd, NULL) < 0)
+		SYSERROR("epoll_ctl failed");
+	free(w);
 }
 
 typedef struct client client_t;
@@ -157,6 +162,9 @@ typedef struct {
 	int (*open)(client_t *client, int *cookie);
 	int (*cmd)(client_t *client);
 	int (*close)(client_t *client);
+	int (*idle)(client_t *client);
+	int (*wakeup)(client_t *client, int events);
+	int (*timeout)(client_t *client);
 } transport_ops_t;
 
 struct client {
@@ -204,11 +212,24 @@ struct client {
 		struct {
 			int ctrl_id;
 			void *ctrl;
+			unsigned int slot_req;	/* the last handled slot command */
+			long long pub_stamp;	/* the last published snapshot */
+			long long pub_period;	/* republish interval, 0 if none */
 		} shm;
 	} transport;
 };
 
 LIST_HEAD(clients);
+pthread_mutex_t clients_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* how long a client thread waits for the next slot command before sleeping */
+#define SLOT_SPIN_NS	100000
+/*
+ * The client threads spinning at once; one CPU is left to the clients,
+ * the other threads go to sleep at once and are woken by the socket.
+ */
+static int slot_spinners;
+static int slot_spinners_max;
 
 typedef struct {
 	struct list_head list;
@@ -217,31 +238,6 @@ typedef struct {
 } inet_pending_t;
 LIST_HEAD(inet_pendings);
 
-#if 0
-static int pcm_handler(waiter_t *waiter, unsigned short events)
-{
-	client_t *client = waiter->private_data;
-	char buf[1];
-	ssize_t n;
-	if (events & POLLIN) {
-		n = write(client->poll_fd, buf, 1);
-		if (n != 1) {
-			SYSERROR("write failed");
-			return -errno;
-		}
-	} else if (events & POLLOUT) {
-		n = read(client->poll_fd, buf, 1);
-		if (n != 1) {
-			SYSERROR("read failed");
-			return -errno;
-		}
-	}
-	del_waiter(waiter->fd);
-	client->polling = 0;
-	return 0;
-}
-#endif
-
 static void pcm_shm_hw_ptr_changed(snd_pcm_t *pcm, snd_pcm_t *src ATTRIBUTE_UNUSED)
 {
 	client_t *client = pcm->hw.private_data;
@@ -310,6 +306,10 @@ static int pcm_shm_open(client_t *client, int *cookie)
 		SYSERROR("shmat failed");
 		goto _err;
 	}
+	client->transport.shm.slot_req = 0;
+	client->transport.shm.pub_period = 0;
+	((snd_pcm_shm_ctrl_t *)client->transport.shm.ctrl)->slot.caps =
+		SND_PCM_SHM_CAP_SLOT | SND_PCM_SHM_CAP_PUBLISH;
 	*cookie = shmid;
 	return 0;
 
@@ -323,10 +323,6 @@ static int pcm_shm_close(client_t *client)
 {
 	int err;
 	snd_pcm_shm_ctrl_t *ctrl = client->transport.shm.ctrl;
-	if (client->polling) {
-		del_waiter(client->device.pcm.fd);
-		client->polling = 0;
-	}
 	err = snd_pcm_close(client->device.pcm.handle);
 	ctrl->result = err;
 	if (err < 0) 
@@ -374,11 +370,12 @@ static int shm_ack_fd(client_t *client, int fd)
 	return 0;
 }
 
-static int shm_rbptr_fd(client_t *client, snd_pcm_rbptr_t *rbptr)
+static int shm_rbptr_fd(snd_pcm_rbptr_t *rbptr, int *fd)
 {
 	if (rbptr->fd < 0)
 		return -EINVAL;
-	return shm_ack_fd(client, rbptr->fd);
+	*fd = rbptr->fd;
+	return 1;
 }
 
 static void async_handler(snd_async_handler_t *handler)
@@ -388,16 +385,16 @@ static void async_handler(snd_async_handler_t *handler)
 	kill(client->async_pid, client->async_sig);
 }
 
-static int pcm_shm_cmd(client_t *client)
+/*
+ * Execute the command in the control block.  Returns 0 when the command
+ * is answered with a plain ack, 1 when the answer passes the descriptor
+ * *fd and a negative error code when no answer is to be sent.
+ */
+static int pcm_shm_exec(client_t *client, int *fd)
 {
 	volatile snd_pcm_shm_ctrl_t *ctrl = client->transport.shm.ctrl;
-	char buf[1];
-	int err;
 	int cmd;
 	snd_pcm_t *pcm;
-	err = read(client->ctrl_fd, buf, 1);
-	if (err != 1)
-		return -EBADFD;
 	cmd = ctrl->cmd;
 	ctrl->cmd = 0;
 	pcm = client->device.pcm.handle;
@@ -469,8 +466,10 @@ static int pcm_shm_cmd(client_t *client)
 	case SNDRV_PCM_IOCTL_CHANNEL_INFO:
 		ctrl->result = snd_pcm_channel_info(pcm, (snd_pcm_channel_info_t *) &ctrl->u.channel_info);
 		if (ctrl->result >= 0 &&
-		    ctrl->u.channel_info.type == SND_PCM_AREA_MMAP)
-			return shm_ack_fd(client, ctrl->u.channel_info.u.mmap.fd);
+		    ctrl->u.channel_info.type == SND_PCM_AREA_MMAP) {
+			*fd = ctrl->u.channel_info.u.mmap.fd;
+			return 1;
+		}
 		break;
 	case SNDRV_PCM_IOCTL_REWIND:
 		ctrl->result = snd_pcm_rewind(pcm, ctrl->u.rewind.frames);
@@ -507,41 +506,279 @@ static int pcm_shm_cmd(client_t *client)
 		break;
 	case SND_PCM_IOCTL_POLL_DESCRIPTOR:
 		ctrl->result = 0;
-		return shm_ack_fd(client, _snd_pcm_poll_descriptor(pcm));
+		*fd = _snd_pcm_poll_descriptor(pcm);
+		return 1;
 	case SND_PCM_IOCTL_CLOSE:
 		client->ops->close(client);
 		break;
 	case SND_PCM_IOCTL_HW_PTR_FD:
-		return shm_rbptr_fd(client, &pcm->hw);
+		return shm_rbptr_fd(&pcm->hw, fd);
 	case SND_PCM_IOCTL_APPL_PTR_FD:
-		return shm_rbptr_fd(client, &pcm->appl);
+		return shm_rbptr_fd(&pcm->appl, fd);
 	default:
 		ERROR("Bogus cmd: %x", ctrl->cmd);
 		ctrl->result = -ENOSYS;
 	}
+	return 0;
+}
+
+static long long shm_now_ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/*
+ * Publish the state, avail and delay for the fast ops of the client.
+ * While the stream runs, the snapshot is refreshed every quarter of a
+ * period (at most once per millisecond).
+ */
+static void pcm_shm_publish(client_t *client)
+{
+	snd_pcm_shm_ctrl_t *ctrl = client->transport.shm.ctrl;
+	snd_pcm_shm_pub_t *pub;
+	snd_pcm_t *pcm;
+	snd_pcm_sframes_t avail, delay = 0;
+	snd_pcm_state_t state;
+	unsigned int seq;
+	long long period = 0;
+	int valid = 0;
+
+	if (!client->open || !ctrl || !ctrl->pub.enable)
+		return;
+	pub = &ctrl->pub;
+	pcm = client->device.pcm.handle;
+	state = snd_pcm_state(pcm);
+	switch (state) {
+	case SND_PCM_STATE_PREPARED:
+	case SND_PCM_STATE_RUNNING:
+	case SND_PCM_STATE_DRAINING:
+	case SND_PCM_STATE_PAUSED:
+		valid = snd_pcm_avail_delay(pcm, &avail, &delay) >= 0;
+		/* the update may have stopped the stream */
+		state = snd_pcm_state(pcm);
+		break;
+	default:
+		break;
+	}
+	seq = pub->seq;
+	__atomic_store_n(&pub->seq, seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	pub->state = state;
+	pub->valid = valid;
+	if (valid) {
+		pub->avail = avail;
+		pub->delay = delay;
+	}
+	pub->stamp = client->transport.shm.pub_stamp = shm_now_ns();
+	__atomic_store_n(&pub->seq, seq + 2, __ATOMIC_RELEASE);
+
+	if ((state == SND_PCM_STATE_RUNNING || state == SND_PCM_STATE_DRAINING) &&
+	    pcm->rate > 0) {
+		period = pcm->period_size * 1000000000LL / pcm->rate / 4;
+		if (period < 1000000)
+			period = 1000000;
+	}
+	client->transport.shm.pub_period = period;
+}
+
+/* take the wait flag if it still waits for the command req */
+static int slot_take(unsigned int *wait, unsigned int req)
+{
+	unsigned int expected = req;
+	return __atomic_load_n(wait, __ATOMIC_RELAXED) == req &&
+		__atomic_compare_exchange_n(wait, &expected, 0, 0,
+					    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+static int slot_pending(client_t *client)
+{
+	snd_pcm_shm_ctrl_t *ctrl = client->transport.shm.ctrl;
+	return __atomic_load_n(&ctrl->slot.req, __ATOMIC_ACQUIRE) !=
+		client->transport.shm.slot_req;
+}
+
+/* complete a command posted in the slot */
+static int pcm_shm_slot_cmd(client_t *client)
+{
+	snd_pcm_shm_ctrl_t *ctrl = client->transport.shm.ctrl;
+	char buf[1] = "";
+	int err, fd;
+
+	client->transport.shm.slot_req = __atomic_load_n(&ctrl->slot.req, __ATOMIC_ACQUIRE);
+	switch (ctrl->cmd) {
+	case SNDRV_PCM_IOCTL_CHANNEL_INFO:
+	case SND_PCM_IOCTL_POLL_DESCRIPTOR:
+	case SND_PCM_IOCTL_HW_PTR_FD:
+	case SND_PCM_IOCTL_APPL_PTR_FD:
+	case SND_PCM_IOCTL_CLOSE:
+		/* these need the control socket */
+		ERROR("Bogus slot cmd: %x", ctrl->cmd);
+		ctrl->cmd = 0;
+		ctrl->result = -EINVAL;
+		break;
+	default:
+		pcm_shm_exec(client, &fd);
+		pcm_shm_publish(client);
+		break;
+	}
+	__atomic_store_n(&ctrl->slot.ack, client->transport.shm.slot_req, __ATOMIC_RELEASE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (slot_take(&ctrl->slot.client_wait, client->transport.shm.slot_req)) {
+		err = write(client->ctrl_fd, buf, 1);
+		if (err != 1)
+			return -EBADFD;
+	}
+	return 0;
+}
+
+static int pcm_shm_cmd(client_t *client)
+{
+	char buf[1];
+	int err, fd;
+	err = read(client->ctrl_fd, buf, 1);
+	if (err != 1)
+		return -EBADFD;
+	/* a wakeup for the posted slot command or a socket command */
+	if (slot_pending(client))
+		return pcm_shm_slot_cmd(client);
+	err = pcm_shm_exec(client, &fd);
+	if (err < 0)
+		return err;
+	pcm_shm_publish(client);
+	if (err > 0)
+		return shm_ack_fd(client, fd);
 	return shm_ack(client);
 }
 
+static int slot_spin_get(void)
+{
+	int n = __atomic_load_n(&slot_spinners, __ATOMIC_RELAXED);
+
+	do {
+		if (n >= slot_spinners_max)
+			return 0;
+	} while (!__atomic_compare_exchange_n(&slot_spinners, &n, n + 1, 1,
+					      __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+	return 1;
+}
+
+static void slot_spin_put(void)
+{
+	__atomic_fetch_sub(&slot_spinners, 1, __ATOMIC_RELAXED);
+}
+
+static long slot_elapsed_ns(const struct timespec *start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000000000L +
+		(now.tv_nsec - start->tv_nsec);
+}
+
+/*
+ * Serve the slot commands while the client keeps posting them, and
+ * arm the wait flag before the thread goes to sleep on the socket.
+ * Returns 1 when the thread may sleep.
+ */
+static int pcm_shm_idle(client_t *client)
+{
+	snd_pcm_shm_ctrl_t *ctrl = client->transport.shm.ctrl;
+	struct timespec start;
+	unsigned int k, next;
+	char buf[1];
+	int err;
+
+	if (client->transport.shm.pub_period > 0 &&
+	    shm_now_ns() - client->transport.shm.pub_stamp >= client->transport.shm.pub_period)
+		pcm_shm_publish(client);
+	if (slot_spin_get()) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (k = 0; ; k++) {
+			if (slot_pending(client)) {
+				err = pcm_shm_slot_cmd(client);
+				if (err < 0) {
+					slot_spin_put();
+					return err;
+				}
+				clock_gettime(CLOCK_MONOTONIC, &start);
+				continue;
+			}
+			if ((k & 63) == 0 && slot_elapsed_ns(&start) >= SLOT_SPIN_NS)
+				break;
+		}
+		slot_spin_put();
+	}
+	next = SND_PCM_SHM_SLOT_NEXT(client->transport.shm.slot_req);
+	__atomic_store_n(&ctrl->slot.server_wait, next, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (!slot_pending(client))
+		return 1;
+	/* posted meanwhile; if the client took the flag, eat its wakeup */
+	if (!slot_take(&ctrl->slot.server_wait, next)) {
+		err = read(client->ctrl_fd, buf, 1);
+		if (err != 1)
+			return -EBADFD;
+	}
+	err = pcm_shm_slot_cmd(client);
+	return err < 0 ? err : 0;
+}
+
+/*
+ * Disarm the wait flag after the sleep.  When the client took it, its
+ * wakeup byte is pending; it is read by the command handler on POLLIN,
+ * otherwise it is eaten here.
+ */
+static int pcm_shm_wakeup(client_t *client, int events)
+{
+	snd_pcm_shm_ctrl_t *ctrl = client->transport.shm.ctrl;
+	char buf[1];
+	int err;
+	if (__atomic_exchange_n(&ctrl->slot.server_wait, 0, __ATOMIC_SEQ_CST) ||
+	    events != 0)
+		return 0;
+	err = read(client->ctrl_fd, buf, 1);
+	if (err != 1)
+		return -EBADFD;
+	return 0;
+}
+
+/* the poll timeout until the next refresh of the published snapshot */
+static int pcm_shm_timeout(client_t *client)
+{
+	long long left;
+
+	if (client->transport.shm.pub_period <= 0)
+		return -1;
+	left = client->transport.shm.pub_stamp + client->transport.shm.pub_period -
+		shm_now_ns();
+	if (left <= 0)
+		return 0;
+	return (left + 999999) / 1000000;
+}
+
 transport_ops_t pcm_shm_ops = {
 	.open	= pcm_shm_open,
 	.cmd	= pcm_shm_cmd,
 	.close	= pcm_shm_close,
+	.idle	= pcm_shm_idle,
+	.wakeup	= pcm_shm_wakeup,
+	.timeout = pcm_shm_timeout,
 };
 
-static int ctl_handler(waiter_t *waiter, unsigned short events)
+static int ctl_handler(client_t *client, unsigned short events)
 {
-	client_t *client = waiter->private_data;
 	char buf[1] = "";
 	ssize_t n;
-	if (events & POLLIN) {
+	client->polling = 0;
+	if ((events & POLLIN) && client->poll_fd >= 0) {
 		n = write(client->poll_fd, buf, 1);
 		if (n != 1) {
 			SYSERROR("write failed");
 			return -errno;
 		}
 	}
-	del_waiter(waiter->fd);
-	client->polling = 0;
 	return 0;
 }
 
@@ -572,7 +809,6 @@ static int ctl_shm_open(client_t *client, int *cookie)
 		goto _err;
 	}
 	*cookie = shmid;
-	add_waiter(client->device.ctl.fd, POLLIN, ctl_handler, client);
 	client->polling = 1;
 	return 0;
 
@@ -586,10 +822,7 @@ static int ctl_shm_close(client_t *client)
 {
 	int err;
 	snd_ctl_shm_ctrl_t *ctrl = client->transport.shm.ctrl;
-	if (client->polling) {
-		del_waiter(client->device.ctl.fd);
-		client->polling = 0;
-	}
+	client->polling = 0;
 	err = snd_ctl_close(client->device.ctl.handle);
 	ctrl->result = err;
 	if (err < 0) 
@@ -732,7 +965,7 @@ static int snd_client_open(client_t *client)
 	err = read(client->ctrl_fd, &req, sizeof(req));
 	if (err < 0) {
 		SYSERROR("read failed");
-		exit(1);
+		return -EBADFD;
 	}
 	if (err != sizeof(req)) {
 		ans.result = -EINVAL;
@@ -742,7 +975,7 @@ static int snd_client_open(client_t *client)
 	err = read(client->ctrl_fd, name, req.namelen);
 	if (err < 0) {
 		SYSERROR("read failed");
-		exit(1);
+		return -EBADFD;
 	}
 	if (err != req.namelen) {
 		ans.result = -EINVAL;
@@ -795,52 +1028,137 @@ static int snd_client_open(client_t *client)
 	err = write(client->ctrl_fd, &ans, sizeof(ans));
 	if (err != sizeof(ans)) {
 		SYSERROR("write failed");
-		exit(1);
+		return -EBADFD;
 	}
 	return 0;
 }
 
-static int client_poll_handler(waiter_t *waiter, unsigned short events ATTRIBUTE_UNUSED)
+static void client_free(client_t *client)
 {
-	client_t *client = waiter->private_data;
 	if (client->open)
 		client->ops->close(client);
-	close(client->poll_fd);
+	if (client->poll_fd >= 0)
+		close(client->poll_fd);
 	close(client->ctrl_fd);
-	del_waiter(client->poll_fd);
-	del_waiter(client->ctrl_fd);
+	pthread_mutex_lock(&clients_mutex);
 	list_del(&client->list);
+	pthread_mutex_unlock(&clients_mutex);
 	free(client);
-	return 0;
 }
 
-static int client_ctrl_handler(waiter_t *waiter, unsigned short events)
+/* wait for the next command, return the events of the control socket */
+static int client_poll(client_t *client, int timeout)
+{
+	struct pollfd pfds[3];
+	unsigned int count = 1, k;
+	int err;
+
+	pfds[0].fd = client->ctrl_fd;
+	pfds[0].events = POLLIN;
+	if (client->poll_fd >= 0) {
+		pfds[count].fd = client->poll_fd;
+		pfds[count++].events = 0;
+	}
+	if (client->polling) {
+		pfds[count].fd = client->device.ctl.fd;
+		pfds[count++].events = POLLIN;
+	}
+	do {
+		err = poll(pfds, count, timeout);
+	} while (err < 0 && errno == EINTR);
+	if (err < 0) {
+		err = -errno;
+		SYSERROR("poll failed");
+		return err;
+	}
+	for (k = 1; k < count; k++) {
+		if (!pfds[k].revents)
+			continue;
+		if (pfds[k].fd == client->poll_fd)
+			return POLLHUP;
+		err = ctl_handler(client, pfds[k].revents);
+		if (err < 0)
+			ERROR("ctl handler failed");
+	}
+	return pfds[0].revents;
+}
+
+static void *client_thread(void *arg)
 {
-	client_t *client = waiter->private_data;
-	if (events & POLLHUP) {
+	client_t *client = arg;
+	int events, timeout, err;
+
+	while (1) {
+		if (client->open && client->ops->idle) {
+			/* sleep only with the wait flag armed */
+			do {
+				err = client->ops->idle(client);
+			} while (err == 0);
+			if (err < 0)
+				break;
+		}
+		timeout = -1;
+		if (client->open && client->ops->timeout)
+			timeout = client->ops->timeout(client);
+		events = client_poll(client, timeout);
+		if (client->open && client->ops->wakeup &&
+		    client->ops->wakeup(client, events) < 0)
+			break;
+		if (events < 0 || (events & (POLLHUP | POLLERR | POLLNVAL)))
+			break;
+		if (!(events & POLLIN))
+			continue;
 		if (client->open)
-			client->ops->close(client);
-		close(client->ctrl_fd);
-		del_waiter(client->ctrl_fd);
-		list_del(&client->list);
-		free(client);
-		return 0;
+			err = client->ops->cmd(client);
+		else
+			err = snd_client_open(client);
+		if (err < 0) {
+			ERROR("client command failed");
+			if (err == -EBADFD)
+				break;
+		}
 	}
-	if (client->open)
-		return client->ops->cmd(client);
-	else
-		return snd_client_open(client);
+	client_free(client);
+	return NULL;
+}
+
+static int client_start(int ctrl_fd, int poll_fd, int local)
+{
+	pthread_attr_t attr;
+	pthread_t thread;
+	client_t *client;
+	int err;
+
+	client = calloc(1, sizeof(*client));
+	if (!client)
+		return -ENOMEM;
+	client->ctrl_fd = ctrl_fd;
+	client->poll_fd = poll_fd;
+	client->local = local;
+	client->open = 0;
+	pthread_mutex_lock(&clients_mutex);
+	list_add_tail(&client->list, &clients);
+	pthread_mutex_unlock(&clients_mutex);
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	err = pthread_create(&thread, &attr, client_thread, client);
+	pthread_attr_destroy(&attr);
+	if (err) {
+		ERROR("pthread_create failed: %s", strerror(err));
+		client_free(client);
+		return -err;
+	}
+	return 0;
 }
 
-static int inet_pending_handler(waiter_t *waiter, unsigned short events)
+static int inet_pending_handler(waiter_t *waiter, unsigned int events)
 {
 	inet_pending_t *pending = waiter->private_data;
 	inet_pending_t *pdata;
-	client_t *client;
 	uint32_t cookie;
 	struct list_head *item;
 	int remove = 0;
-	if (events & POLLHUP)
+	if (events & EPOLLHUP)
 		remove = 1;
 	else {
 		int err = read(waiter->fd, &cookie, sizeof(cookie));
@@ -852,9 +1170,9 @@ static int inet_pending_handler(waiter_t *waiter, unsigned short events)
 				remove = 1;
 		}
 	}
-	del_waiter(waiter->fd);
+	del_waiter(waiter);
 	if (remove) {
-		close(waiter->fd);
+		close(pending->fd);
 		list_del(&pending->list);
 		free(pending);
 		return 0;
@@ -869,22 +1187,15 @@ static int inet_pending_handler(waiter_t *waiter, unsigned short events)
 	return 0;
 
  found:
-	client = calloc(1, sizeof(*client));
-	client->local = 0;
-	client->poll_fd = pdata->fd;
-	client->ctrl_fd = waiter->fd;
-	add_waiter(client->ctrl_fd, POLLIN | POLLHUP, client_ctrl_handler, client);
-	add_waiter(client->poll_fd, POLLHUP, client_poll_handler, client);
-	client->open = 0;
-	list_add_tail(&client->list, &clients);
 	list_del(&pending->list);
 	list_del(&pdata->list);
+	client_start(pending->fd, pdata->fd, 0);
 	free(pending);
 	free(pdata);
 	return 0;
 }
 
-static int local_handler(waiter_t *waiter, unsigned short events ATTRIBUTE_UNUSED)
+static int local_handler(waiter_t *waiter, unsigned int events ATTRIBUTE_UNUSED)
 {
 	int sock;
 	sock = accept(waiter->fd, 0, 0);
@@ -892,20 +1203,13 @@ static int local_handler(waiter_t *waiter, unsigned short events ATTRIBUTE_UNUSE
 		int result = -errno;
 		SYSERROR("accept failed");
 		return result;
-	} else {
-		client_t *client = calloc(1, sizeof(*client));
-		client->ctrl_fd = sock;
-		client->local = 1;
-		client->open = 0;
-		add_waiter(sock, POLLIN | POLLHUP, client_ctrl_handler, client);
-		list_add_tail(&client->list, &clients);
 	}
-	return 0;
+	return client_start(sock, -1, 1);
 }
 
-static int inet_handler(waiter_t *waiter, unsigned short events ATTRIBUTE_UNUSED)
+static int inet_handler(waiter_t *waiter, unsigned int events ATTRIBUTE_UNUSED)
 {
-	int sock;
+	int sock, err;
 	sock = accept(waiter->fd, 0, 0);
 	if (sock < 0) {
 		int result = -errno;
@@ -913,30 +1217,43 @@ static int inet_handler(waiter_t *waiter, unsigned short events ATTRIBUTE_UNUSED
 		return result;
 	} else {
 		inet_pending_t *pending = calloc(1, sizeof(*pending));
+		if (!pending) {
+			close(sock);
+			return -ENOMEM;
+		}
 		pending->fd = sock;
 		pending->cookie = 0;
-		add_waiter(sock, POLLIN, inet_pending_handler, pending);
+		err = add_waiter(sock, EPOLLIN, inet_pending_handler, pending);
+		if (err < 0) {
+			close(sock);
+			free(pending);
+			return err;
+		}
 		list_add_tail(&pending->list, &inet_pendings);
 	}
 	return 0;
 }
 
+#define SERVER_EVENTS	16
+
 static int server(const char *sockname, int port)
 {
+	struct epoll_event events[SERVER_EVENTS];
 	int err, result, sockn = -1, socki = -1;
-	unsigned int k;
-	long open_max;
+	int k;
 
 	if (!sockname && port < 0)
 		return -EINVAL;
-	open_max = sysconf(_SC_OPEN_MAX);
-	if (open_max < 0) {
+	/* the client threads only spin for the next command with spare CPUs */
+	slot_spinners_max = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+	if (slot_spinners_max < 0)
+		slot_spinners_max = 0;
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd < 0) {
 		result = -errno;
-		SYSERROR("sysconf failed");
+		SYSERROR("epoll_create1 failed");
 		return result;
 	}
-	pollfds = calloc((size_t) open_max, sizeof(*pollfds));
-	waiters = calloc((size_t) open_max, sizeof(*waiters));
 
 	if (sockname) {
 		sockn = make_local_socket(sockname);
@@ -952,7 +1269,9 @@ static int server(const char *sockname, int port)
 			SYSERROR("listen failed");
 			goto _end;
 		}
-		add_waiter(sockn, POLLIN, local_handler, NULL);
+		result = add_waiter(sockn, EPOLLIN, local_handler, NULL);
+		if (result < 0)
+			goto _end;
 	}
 	if (port >= 0) {
 		socki = make_inet_socket(port);
@@ -968,32 +1287,23 @@ static int server(const char *sockname, int port)
 			SYSERROR("listen failed");
 			goto _end;
 		}
-		add_waiter(socki, POLLIN, inet_handler, NULL);
+		result = add_waiter(socki, EPOLLIN, inet_handler, NULL);
+		if (result < 0)
+			goto _end;
 	}
 
 	while (1) {
-		struct pollfd pfds[open_max];
-		size_t pfds_count;
-		do {
-			err = poll(pollfds, pollfds_count, -1);
-		} while (err == 0);
+		err = epoll_wait(epoll_fd, events, SERVER_EVENTS, -1);
 		if (err < 0) {
-			SYSERROR("poll failed");
+			if (errno != EINTR)
+				SYSERROR("epoll_wait failed");
 			continue;
 		}
-
-		pfds_count = pollfds_count;
-		memcpy(pfds, pollfds, sizeof(*pfds) * pfds_count);
-		for (k = 0; k < pfds_count; k++) {
-			struct pollfd *pfd = &pfds[k];
-			if (pfd->revents) {
-				waiter_t *w = &waiters[pfd->fd];
-				if (!w->handler)
-					continue;
-				err = w->handler(w, pfd->revents);
-				if (err < 0)
-					ERROR("waiter handler failed");
-			}
+		/* a handler only deletes its own waiter */
+		for (k = 0; k < err; k++) {
+			waiter_t *w = events[k].data.ptr;
+			if (w->handler(w, events[k].events) < 0)
+				ERROR("waiter handler failed");
 		}
 	}
  _end:
@@ -1001,8 +1311,7 @@ static int server(const char *sockname, int port)
 		close(sockn);
 	if (socki >= 0)
 		close(socki);
-	free(pollfds);
-	free(waiters);
+	close(epoll_fd);
 	return result;
 }
 					
@@ -1091,6 +1400,8 @@ int main(int argc, char **argv)
 		ERROR("either socket or port need to be defined");
 		return 1;
 	}
+	/* a vanished client must not take the server down */
+	signal(SIGPIPE, SIG_IGN);
 	server(sockname, port);
 	return 0;
 }
@@ -58,6 +58,47 @@ typedef struct {
 	int changed;
 } snd_pcm_shm_rbptr_t;
 
+/*
+ * Command slot: the client posts a command by bumping req and the server
+ * completes it by setting ack to the same value, so no socket traffic is
+ * needed while both sides are running.  A side going to sleep stores the
+ * number of the command it waits for in its wait flag; the other side
+ * takes the flag only for that very command and wakes it with a byte on
+ * the control socket.  The commands passing a file descriptor still use
+ * the control socket.
+ */
+typedef struct {
+	unsigned int caps;		/* SND_PCM_SHM_CAP_* set by the server */
+	unsigned int req __attribute__((aligned(64)));
+	unsigned int server_wait;	/* the server sleeps until this req */
+	unsigned int ack __attribute__((aligned(64)));
+	unsigned int client_wait;	/* the client sleeps until this ack */
+} snd_pcm_shm_slot_t;
+
+#define SND_PCM_SHM_CAP_SLOT		(1 << 0)
+#define SND_PCM_SHM_CAP_PUBLISH		(1 << 1)
+
+/*
+ * Published state: when the client sets enable, the server stores a
+ * snapshot of the state and of the avail and delay derived from the
+ * ring buffer pointers (which are shared in hw and appl above) here
+ * after every command and periodically while the stream runs, so the
+ * client can answer state, avail_update and delay itself.  seq is odd
+ * while the server updates the snapshot and zero until the first one.
+ */
+typedef struct {
+	unsigned int enable;		/* set by the client */
+	unsigned int seq __attribute__((aligned(64)));
+	int state;
+	int valid;			/* avail and delay are set */
+	snd_pcm_uframes_t avail;
+	snd_pcm_sframes_t delay;
+	long long stamp;		/* CLOCK_MONOTONIC in ns */
+} snd_pcm_shm_pub_t;
+
+/* the number of the slot command following req, zero means no command */
+#define SND_PCM_SHM_SLOT_NEXT(req)	((req) + 1 ? (req) + 1 : 1)
+
 typedef struct {
 	long result;
 	int cmd;
@@ -102,6 +143,8 @@ typedef struct {
 			off_t offset;
 		} rbptr;
 	} u;
+	snd_pcm_shm_slot_t slot;
+	snd_pcm_shm_pub_t pub;
 	char data[0];
 } snd_pcm_shm_ctrl_t;
 
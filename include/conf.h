@@ -108,6 +108,7 @@ int snd_config_searchv(snd_config_t *config,
 int snd_config_search_definition(snd_config_t *config,
 				 const char *base, const char *key,
 				 snd_config_t **result);
+int snd_config_search_definition_stats(unsigned long *hits, unsigned long *misses);
 
 /**
  * \brief custom expansion callback
@@ -361,6 +361,8 @@ static inline int snd_open_device(const char *filename, int fmode)
 	snd1_dlobj_cache_put
 #define snd_dlobj_cache_cleanup \
 	snd1_dlobj_cache_cleanup
+#define snd_card_registry_cleanup \
+	snd1_card_registry_cleanup
 #define snd_config_set_hop \
 	snd1_config_set_hop
 #define snd_config_check_hop \
@@ -374,6 +376,9 @@ void *snd_dlobj_cache_get2(const char *lib, const char *name, const char *versio
 int snd_dlobj_cache_put(void *open_func);
 void snd_dlobj_cache_cleanup(void);
 
+/* card registry (control/cards.c) */
+void snd_card_registry_cleanup(void);
+
 /* for recursive checks */
 void snd_config_set_hop(snd_config_t *conf, int hop);
 int snd_config_check_hop(snd_config_t *conf);
@@ -385,8 +390,15 @@ int snd_config_search_alias_hooks(snd_config_t *config,
 
 int _snd_conf_generic_id(const char *id);
 
+int _snd_input_map(snd_input_t *input, const unsigned char **data, size_t *size);
 int _snd_config_load_with_include(snd_config_t *config, snd_input_t *in,
 				  int override, const char * const *default_include_path);
+typedef void (*snd_config_file_cb_t)(void *private_data, const char *filename);
+int _snd_config_load_with_include_cb(snd_config_t *config, snd_input_t *in,
+				     int override,
+				     const char * const *default_include_path,
+				     snd_config_file_cb_t file_cb,
+				     void *file_private);
 
 /* convenience macros */
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
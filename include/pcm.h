@@ -1121,6 +1121,30 @@ int snd_pcm_dump_setup(snd_pcm_t *pcm, snd_output_t *out);
 int snd_pcm_hw_params_dump(snd_pcm_hw_params_t *params, snd_output_t *out);
 int snd_pcm_sw_params_dump(snd_pcm_sw_params_t *params, snd_output_t *out);
 int snd_pcm_status_dump(snd_pcm_status_t *status, snd_output_t *out);
+int snd_pcm_hw_params_cache_stats(unsigned long *hits, unsigned long *misses);
+
+/** PCM performance counters, see #snd_pcm_perf_get() */
+typedef struct _snd_pcm_perf_counters {
+	/** processing calls (transfers, conversions, mixing, commits) */
+	unsigned long long calls;
+	/** frames processed by the calls */
+	unsigned long long frames;
+	/** cumulative duration of the calls in nanoseconds */
+	unsigned long long total_ns;
+	/** longest call in nanoseconds */
+	unsigned long long max_ns;
+	/** system calls issued on the data path */
+	unsigned long long syscalls;
+	/** xruns detected */
+	unsigned long long xruns;
+} snd_pcm_perf_counters_t;
+
+int snd_pcm_perf_enable(snd_pcm_t *pcm, int enable);
+int snd_pcm_perf_get(snd_pcm_t *pcm, snd_pcm_perf_counters_t *counters);
+int snd_pcm_perf_reset(snd_pcm_t *pcm);
+int snd_pcm_trace_enable(int enable);
+int snd_pcm_trace_dump(snd_pcm_t *pcm, snd_output_t *out);
+int snd_pcm_trace_dump_fd(snd_pcm_t *pcm, int fd);
 
 /** \} */
 
@@ -71,7 +71,7 @@ typedef struct _snd_rawmidi snd_rawmidi_t;
 typedef enum _snd_rawmidi_type {
 	/** Kernel level RawMidi */
 	SND_RAWMIDI_TYPE_HW,
-	/** Shared memory client RawMidi (not yet implemented) */
+	/** Shared memory ring RawMidi */
 	SND_RAWMIDI_TYPE_SHM,
 	/** INET client RawMidi (not yet implemented) */
 	SND_RAWMIDI_TYPE_INET,
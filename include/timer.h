@@ -109,6 +109,14 @@ typedef struct _snd_timer_tread {
 	unsigned int val;		/**< Event value */
 } snd_timer_tread_t;
 
+/** summary of a batched timer read */
+typedef struct _snd_timer_batch {
+	unsigned int events;		/**< count of read events */
+	unsigned int ticks;		/**< coalesced count of ticks from tick events */
+	snd_htimestamp_t tstamp;	/**< time stamp of the most recent event */
+	snd_htimestamp_t latency;	/**< delay between the most recent event and its delivery */
+} snd_timer_batch_t;
+
 /** global timer - system */
 #define SND_TIMER_GLOBAL_SYSTEM 0
 /** global timer - RTC */
@@ -163,6 +171,8 @@ int snd_timer_start(snd_timer_t *handle);
 int snd_timer_stop(snd_timer_t *handle);
 int snd_timer_continue(snd_timer_t *handle);
 ssize_t snd_timer_read(snd_timer_t *handle, void *buffer, size_t size);
+ssize_t snd_timer_read_batch(snd_timer_t *handle, snd_timer_tread_t *events,
+			     size_t count, snd_timer_batch_t *batch);
 
 size_t snd_timer_id_sizeof(void);
 /** allocate #snd_timer_id_t container on stack */
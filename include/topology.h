@@ -22,6 +22,7 @@
 #define __ALSA_TOPOLOGY_H
 
 #include <stdint.h>
+#include <sys/types.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -1124,6 +1125,26 @@ int snd_tplg_build(snd_tplg_t *tplg, const char *outfile);
  */
 int snd_tplg_build_bin(snd_tplg_t *tplg, void **bin, size_t *size);
 
+/**
+ * \brief Topology output callback for #snd_tplg_build_stream.
+ * \param private_data The private data passed to #snd_tplg_build_stream.
+ * \param data Output data.
+ * \param size Output data size in bytes.
+ * \return The number of bytes written, otherwise a negative error code
+ */
+typedef ssize_t (*snd_tplg_write_t)(void *private_data, const void *data, size_t size);
+
+/**
+ * \brief Build all registered topology data and stream it to a callback.
+ * \param tplg Topology instance.
+ * \param write Output callback, called with the blocks as they are built.
+ * \param private_data Private data for the output callback.
+ * \return Zero on success, otherwise a negative error code
+ *
+ * Unlike #snd_tplg_build_bin, the binary is never kept whole in memory.
+ */
+int snd_tplg_build_stream(snd_tplg_t *tplg, snd_tplg_write_t write, void *private_data);
+
 /**
  * \brief Attach private data to topology manifest.
  * \param tplg Topology instance.
@@ -658,6 +658,23 @@ static inline uint8_t snd_ump_sysex_msg_length(const uint32_t *ump)
 int snd_ump_msg_sysex_expand(const uint32_t *ump, uint8_t *buf, size_t maxlen,
 			     size_t *filled);
 
+int snd_ump_packet_length(unsigned int type);
+
+ssize_t snd_ump_msg_decode_bytes(const uint32_t *ump, size_t words,
+				 uint8_t *buf, size_t maxlen, size_t *consumed);
+
+/** MIDI 1.0 byte stream to UMP encoder */
+typedef struct _snd_ump_msg_encoder snd_ump_msg_encoder_t;
+
+int snd_ump_msg_encoder_new(snd_ump_msg_encoder_t **encp, unsigned int group,
+			    int midi2);
+void snd_ump_msg_encoder_free(snd_ump_msg_encoder_t *enc);
+void snd_ump_msg_encoder_reset(snd_ump_msg_encoder_t *enc);
+ssize_t snd_ump_msg_encode_bytes(snd_ump_msg_encoder_t *enc,
+				 const uint8_t *buf, size_t len,
+				 uint32_t *ump, size_t maxwords,
+				 size_t *consumed);
+
 #ifdef __cplusplus
 }
 #endif
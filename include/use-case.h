@@ -87,6 +87,15 @@ extern "C" {
  *     modifier.
  *  + Get the ALSA master playback and capture volume/switch kcontrols
  *     or mixer elements for each use case.
+ *
+ * The evaluated card configuration may be cached across processes. The
+ * cache is disabled by default and it is enabled by the
+ * ALSA_CONFIG_UCM2_CACHE environment variable. An absolute path selects
+ * the cache directory, any other non-empty value selects
+ * $XDG_CACHE_HOME/alsa/ucm2 or $HOME/.cache/alsa/ucm2. A cached model
+ * is used only when the configuration files (including the alsa-lib
+ * &lt;file&gt; includes), the substituted card, environment and sysfs
+ * state and the evaluated conditions did not change.
  */
 
 
@@ -59,16 +59,92 @@ static int alisp_include_file(struct alisp_instance *instance, const char *filen
  *  object handling
  */
 
-static int get_string_hash(const char *s)
+static unsigned int get_string_hash(const char *s)
 {
-	int val = 0;
+	unsigned int val = 2166136261U;
+
 	if (s == NULL)
 		return val;
 	while (*s)
-		val += *s++;
-	return val & ALISP_OBJ_PAIR_HASH_MASK;
+		val = (val ^ (unsigned char)*s++) * 16777619U;
+	return val;
+}
+
+static unsigned int get_long_hash(unsigned long val)
+{
+	/* fold the upper half of the 64-bit values in */
+	return (unsigned int)val ^ (unsigned int)(val >> 16 >> 16);
+}
+
+static int obj_hash_init(struct alisp_obj_hash *hash,
+			 unsigned int (*key)(struct list_head *pos))
+{
+	unsigned int i;
+
+	hash->lists = malloc(sizeof(*hash->lists) << ALISP_OBJ_HASH_SHIFT);
+	if (hash->lists == NULL)
+		return -ENOMEM;
+	for (i = 0; i < 1U << ALISP_OBJ_HASH_SHIFT; i++)
+		INIT_LIST_HEAD(&hash->lists[i]);
+	hash->shift = ALISP_OBJ_HASH_SHIFT;
+	hash->count = 0;
+	hash->key = key;
+	return 0;
+}
+
+static void obj_hash_done(struct alisp_obj_hash *hash)
+{
+	free(hash->lists);
+	hash->lists = NULL;
+}
+
+static inline struct list_head *obj_hash_list(struct alisp_obj_hash *hash, unsigned int key)
+{
+	/* the multiplication mixes all key bits into the top ones */
+	return &hash->lists[(key * 2654435761U) >> (32 - hash->shift)];
+}
+
+static void obj_hash_grow(struct alisp_obj_hash *hash)
+{
+	struct list_head *old = hash->lists, *pos, *pos1;
+	unsigned int i, size = 1U << hash->shift;
+
+	hash->lists = malloc(sizeof(*hash->lists) * size * 2);
+	if (hash->lists == NULL) {
+		/* the longer chains still work */
+		hash->lists = old;
+		return;
+	}
+	for (i = 0; i < size * 2; i++)
+		INIT_LIST_HEAD(&hash->lists[i]);
+	hash->shift++;
+	for (i = 0; i < size; i++)
+		list_for_each_safe(pos, pos1, &old[i])
+			list_add_tail(pos, obj_hash_list(hash, hash->key(pos)));
+	free(old);
+}
+
+static void obj_hash_add(struct alisp_obj_hash *hash, struct list_head *pos, unsigned int key)
+{
+	if (++hash->count > 1U << hash->shift && hash->shift < 24)
+		obj_hash_grow(hash);
+	list_add(pos, obj_hash_list(hash, key));
+}
+
+static inline void obj_hash_del(struct alisp_obj_hash *hash, struct list_head *pos)
+{
+	list_del(pos);
+	hash->count--;
 }
 
+#define obj_hash_for_each(hash, i, pos) \
+	for (i = 0; i < 1U << (hash)->shift; i++) \
+		list_for_each(pos, &(hash)->lists[i])
+
+#define obj_hash_for_each_safe(hash, i, pos, pos1) \
+	for (i = 0; i < 1U << (hash)->shift; i++) \
+		list_for_each_safe(pos, pos1, &(hash)->lists[i])
+
 static void nomem(void)
 {
 	SNDERR("alisp: no enough memory");
@@ -126,12 +202,49 @@ static void lisp_debug(struct alisp_instance *instance, const char *fmt, ...)
 	va_end(ap);
 }
 
+static unsigned int used_obj_key(struct list_head *pos)
+{
+	struct alisp_object *p = list_entry(pos, struct alisp_object, list);
+
+	switch (alisp_get_type(p)) {
+	case ALISP_OBJ_INTEGER:
+		return get_long_hash(p->value.i);
+	case ALISP_OBJ_FLOAT:
+		return get_long_hash((long)p->value.f);
+	case ALISP_OBJ_POINTER:
+		return get_long_hash((unsigned long)p->value.ptr);
+	default:
+		return get_string_hash(p->value.s);
+	}
+}
+
+static unsigned int setobj_key(struct list_head *pos)
+{
+	return get_string_hash(list_entry(pos, struct alisp_object_pair, list)->name);
+}
+
+/* the objects are carved from chunks and recycled through the free list */
+static struct alisp_object * alloc_object(struct alisp_instance *instance)
+{
+	struct alisp_obj_chunk *chunk = instance->obj_chunks;
+
+	if (chunk == NULL || chunk->used >= ALISP_OBJ_CHUNK) {
+		chunk = malloc(sizeof(*chunk));
+		if (chunk == NULL)
+			return NULL;
+		chunk->next = instance->obj_chunks;
+		chunk->used = 0;
+		instance->obj_chunks = chunk;
+	}
+	return &chunk->objs[chunk->used++];
+}
+
 static struct alisp_object * new_object(struct alisp_instance *instance, int type)
 {
 	struct alisp_object * p;
 
 	if (list_empty(&instance->free_objs_list)) {
-		p = (struct alisp_object *)malloc(sizeof(struct alisp_object));
+		p = alloc_object(instance);
 		if (p == NULL) {
 			nomem();
 			return NULL;
@@ -151,7 +264,7 @@ static struct alisp_object * new_object(struct alisp_instance *instance, int typ
 	if (type == ALISP_OBJ_CONS) {
 		p->value.c.car = &alsa_lisp_nil;
 		p->value.c.cdr = &alsa_lisp_nil;
-		list_add(&p->list, &instance->used_objs_list[0][ALISP_OBJ_CONS]);
+		list_add(&p->list, &instance->used_cons_list);
 	}
 
 	if (instance->used_objs + instance->free_objs > instance->max_objs)
@@ -186,14 +299,12 @@ static void delete_object(struct alisp_instance *instance, struct alisp_object *
 			alisp_compare_type(p, ALISP_OBJ_IDENTIFIER) ? p->value.s : "???");
 	if (alisp_dec_refs(p))
 		return;
-	list_del(&p->list);
+	if (alisp_compare_type(p, ALISP_OBJ_CONS))
+		list_del(&p->list);
+	else
+		obj_hash_del(&instance->used_objs_hash[alisp_get_type(p)], &p->list);
 	instance->used_objs--;
 	free_object(p);
-	if (instance->free_objs >= ALISP_FREE_OBJ_POOL) {
-		lisp_debug(instance, "freed cons %p", p);
-		free(p);
-		return;
-	}
 	lisp_debug(instance, "moved cons %p to free list", p);
 	list_add(&p->list, &instance->free_objs_list);
 	instance->free_objs++;
@@ -256,15 +367,36 @@ static struct alisp_object * incref_tree_explicit(struct alisp_instance *instanc
 }
 #endif
 
-static void free_objects(struct alisp_instance *instance)
+static void free_used_list(struct alisp_instance *instance, struct list_head *head)
 {
 	struct list_head *pos, *pos1;
 	struct alisp_object * p;
+
+	list_for_each_safe(pos, pos1, head) {
+		p = list_entry(pos, struct alisp_object, list);
+		lisp_warn(instance, "object %p is still referenced %i times!", p, alisp_get_refs(p));
+#if 0
+		snd_output_printf(instance->wout, ">>>> ");
+		princ_object(instance->wout, p);
+		snd_output_printf(instance->wout, " <<<<\n");
+#endif
+		if (alisp_get_refs(p) > 0)
+			alisp_set_refs(p, 1);
+		delete_object(instance, p);
+	}
+}
+
+static void free_objects(struct alisp_instance *instance)
+{
+	struct list_head *pos, *pos1;
 	struct alisp_object_pair * pair;
-	int i, j;
+	struct alisp_obj_chunk * chunk;
+	struct alisp_obj_hash * hash;
+	unsigned int i;
+	int j;
 
-	for (i = 0; i < ALISP_OBJ_PAIR_HASH_SIZE; i++) {
-		list_for_each_safe(pos, pos1, &instance->setobjs_list[i]) {
+	if (instance->setobjs_hash.lists) {
+		obj_hash_for_each_safe(&instance->setobjs_hash, i, pos, pos1) {
 			pair = list_entry(pos, struct alisp_object_pair, list);
 			lisp_debug(instance, "freeing pair: '%s' -> %p", pair->name, pair->value);
 			delete_tree(instance, pair->value);
@@ -272,27 +404,22 @@ static void free_objects(struct alisp_instance *instance)
 			free(pair);
 		}
 	}
-	for (i = 0; i < ALISP_OBJ_PAIR_HASH_SIZE; i++)
-		for (j = 0; j <= ALISP_OBJ_LAST_SEARCH; j++) {
-			list_for_each_safe(pos, pos1, &instance->used_objs_list[i][j]) {
-				p = list_entry(pos, struct alisp_object, list);
-				lisp_warn(instance, "object %p is still referenced %i times!", p, alisp_get_refs(p));
-#if 0
-				snd_output_printf(instance->wout, ">>>> ");
-				princ_object(instance->wout, p);
-				snd_output_printf(instance->wout, " <<<<\n");
-#endif
-				if (alisp_get_refs(p) > 0)
-					alisp_set_refs(p, 1);
-				delete_object(instance, p);
-			}
-		}
-	list_for_each_safe(pos, pos1, &instance->free_objs_list) {
-		p = list_entry(pos, struct alisp_object, list);
-		list_del(&p->list);
-		free(p);
-		lisp_debug(instance, "freed (all) cons %p", p);
+	for (j = 0; j < ALISP_OBJ_CONS; j++) {
+		hash = &instance->used_objs_hash[j];
+		if (hash->lists == NULL)
+			continue;
+		for (i = 0; i < 1U << hash->shift; i++)
+			free_used_list(instance, &hash->lists[i]);
 	}
+	free_used_list(instance, &instance->used_cons_list);
+	while ((chunk = instance->obj_chunks) != NULL) {
+		instance->obj_chunks = chunk->next;
+		lisp_debug(instance, "freed (all) %u conses at %p", chunk->used, chunk->objs);
+		free(chunk);
+	}
+	obj_hash_done(&instance->setobjs_hash);
+	for (j = 0; j < ALISP_OBJ_CONS; j++)
+		obj_hash_done(&instance->used_objs_hash[j]);
 }
 
 static struct alisp_object * search_object_identifier(struct alisp_instance *instance, const char *s)
@@ -300,7 +427,7 @@ static struct alisp_object * search_object_identifier(struct alisp_instance *ins
 	struct list_head * pos;
 	struct alisp_object * p;
 
-	list_for_each(pos, &instance->used_objs_list[get_string_hash(s)][ALISP_OBJ_IDENTIFIER]) {
+	list_for_each(pos, obj_hash_list(&instance->used_objs_hash[ALISP_OBJ_IDENTIFIER], get_string_hash(s))) {
 		p = list_entry(pos, struct alisp_object, list);
 		if (alisp_get_refs(p) > ALISP_MAX_REFS_LIMIT)
 			continue;
@@ -316,7 +443,7 @@ static struct alisp_object * search_object_string(struct alisp_instance *instanc
 	struct list_head * pos;
 	struct alisp_object * p;
 
-	list_for_each(pos, &instance->used_objs_list[get_string_hash(s)][ALISP_OBJ_STRING]) {
+	list_for_each(pos, obj_hash_list(&instance->used_objs_hash[ALISP_OBJ_STRING], get_string_hash(s))) {
 		p = list_entry(pos, struct alisp_object, list);
 		if (!strcmp(p->value.s, s)) {
 			if (alisp_get_refs(p) > ALISP_MAX_REFS_LIMIT)
@@ -333,7 +460,7 @@ static struct alisp_object * search_object_integer(struct alisp_instance *instan
 	struct list_head * pos;
 	struct alisp_object * p;
 
-	list_for_each(pos, &instance->used_objs_list[in & ALISP_OBJ_PAIR_HASH_MASK][ALISP_OBJ_INTEGER]) {
+	list_for_each(pos, obj_hash_list(&instance->used_objs_hash[ALISP_OBJ_INTEGER], get_long_hash(in))) {
 		p = list_entry(pos, struct alisp_object, list);
 		if (p->value.i == in) {
 			if (alisp_get_refs(p) > ALISP_MAX_REFS_LIMIT)
@@ -350,7 +477,7 @@ static struct alisp_object * search_object_float(struct alisp_instance *instance
 	struct list_head * pos;
 	struct alisp_object * p;
 
-	list_for_each(pos, &instance->used_objs_list[(long)in & ALISP_OBJ_PAIR_HASH_MASK][ALISP_OBJ_FLOAT]) {
+	list_for_each(pos, obj_hash_list(&instance->used_objs_hash[ALISP_OBJ_FLOAT], get_long_hash((long)in))) {
 		p = list_entry(pos, struct alisp_object, list);
 		if (p->value.i == in) {
 			if (alisp_get_refs(p) > ALISP_MAX_REFS_LIMIT)
@@ -367,7 +494,7 @@ static struct alisp_object * search_object_pointer(struct alisp_instance *instan
 	struct list_head * pos;
 	struct alisp_object * p;
 
-	list_for_each(pos, &instance->used_objs_list[(long)ptr & ALISP_OBJ_PAIR_HASH_MASK][ALISP_OBJ_POINTER]) {
+	list_for_each(pos, obj_hash_list(&instance->used_objs_hash[ALISP_OBJ_POINTER], get_long_hash((unsigned long)ptr))) {
 		p = list_entry(pos, struct alisp_object, list);
 		if (p->value.ptr == ptr) {
 			if (alisp_get_refs(p) > ALISP_MAX_REFS_LIMIT)
@@ -388,8 +515,9 @@ static struct alisp_object * new_integer(struct alisp_instance *instance, long v
 		return obj;
 	obj = new_object(instance, ALISP_OBJ_INTEGER);
 	if (obj) {
-		list_add(&obj->list, &instance->used_objs_list[value & ALISP_OBJ_PAIR_HASH_MASK][ALISP_OBJ_INTEGER]);
 		obj->value.i = value;
+		obj_hash_add(&instance->used_objs_hash[ALISP_OBJ_INTEGER], &obj->list,
+			     get_long_hash(value));
 	}
 	return obj;
 }
@@ -403,8 +531,9 @@ static struct alisp_object * new_float(struct alisp_instance *instance, double v
 		return obj;
 	obj = new_object(instance, ALISP_OBJ_FLOAT);
 	if (obj) {
-		list_add(&obj->list, &instance->used_objs_list[(long)value & ALISP_OBJ_PAIR_HASH_MASK][ALISP_OBJ_FLOAT]);
 		obj->value.f = value;
+		obj_hash_add(&instance->used_objs_hash[ALISP_OBJ_FLOAT], &obj->list,
+			     get_long_hash((long)value));
 	}
 	return obj;
 }
@@ -412,36 +541,48 @@ static struct alisp_object * new_float(struct alisp_instance *instance, double v
 static struct alisp_object * new_string(struct alisp_instance *instance, const char *str)
 {
 	struct alisp_object * obj;
+	char *s;
 	
 	obj = search_object_string(instance, str);
 	if (obj != NULL)
 		return obj;
-	obj = new_object(instance, ALISP_OBJ_STRING);
-	if (obj)
-		list_add(&obj->list, &instance->used_objs_list[get_string_hash(str)][ALISP_OBJ_STRING]);
-	if (obj && (obj->value.s = strdup(str)) == NULL) {
-		delete_object(instance, obj);
+	s = strdup(str);
+	if (s == NULL) {
 		nomem();
 		return NULL;
 	}
+	obj = new_object(instance, ALISP_OBJ_STRING);
+	if (obj == NULL) {
+		free(s);
+		return NULL;
+	}
+	obj->value.s = s;
+	obj_hash_add(&instance->used_objs_hash[ALISP_OBJ_STRING], &obj->list,
+		     get_string_hash(str));
 	return obj;
 }
 
 static struct alisp_object * new_identifier(struct alisp_instance *instance, const char *id)
 {
 	struct alisp_object * obj;
+	char *s;
 	
 	obj = search_object_identifier(instance, id);
 	if (obj != NULL)
 		return obj;
-	obj = new_object(instance, ALISP_OBJ_IDENTIFIER);
-	if (obj)
-		list_add(&obj->list, &instance->used_objs_list[get_string_hash(id)][ALISP_OBJ_IDENTIFIER]);
-	if (obj && (obj->value.s = strdup(id)) == NULL) {
-		delete_object(instance, obj);
+	s = strdup(id);
+	if (s == NULL) {
 		nomem();
 		return NULL;
 	}
+	obj = new_object(instance, ALISP_OBJ_IDENTIFIER);
+	if (obj == NULL) {
+		free(s);
+		return NULL;
+	}
+	obj->value.s = s;
+	obj_hash_add(&instance->used_objs_hash[ALISP_OBJ_IDENTIFIER], &obj->list,
+		     get_string_hash(id));
 	return obj;
 }
 
@@ -454,8 +595,9 @@ static struct alisp_object * new_pointer(struct alisp_instance *instance, const
 		return obj;
 	obj = new_object(instance, ALISP_OBJ_POINTER);
 	if (obj) {
-		list_add(&obj->list, &instance->used_objs_list[(long)ptr & ALISP_OBJ_PAIR_HASH_MASK][ALISP_OBJ_POINTER]);
 		obj->value.ptr = ptr;
+		obj_hash_add(&instance->used_objs_hash[ALISP_OBJ_POINTER], &obj->list,
+			     get_long_hash((unsigned long)ptr));
 	}
 	return obj;
 }
@@ -842,7 +984,7 @@ static struct alisp_object_pair * set_object_direct(struct alisp_instance *insta
 		free(p);
 		return NULL;
 	}
-	list_add(&p->list, &instance->setobjs_list[get_string_hash(id)]);
+	obj_hash_add(&instance->setobjs_hash, &p->list, get_string_hash(id));
 	p->value = value;
 	return p;
 }
@@ -876,7 +1018,7 @@ static struct alisp_object_pair * set_object(struct alisp_instance *instance, st
 
 	id = name->value.s;
 
-	list_for_each(pos, &instance->setobjs_list[get_string_hash(id)]) {
+	list_for_each(pos, obj_hash_list(&instance->setobjs_hash, get_string_hash(id))) {
 		p = list_entry(pos, struct alisp_object_pair, list);
 		if (!strcmp(p->name, id)) {
 			delete_tree(instance, p->value);
@@ -896,7 +1038,7 @@ static struct alisp_object_pair * set_object(struct alisp_instance *instance, st
 		free(p);
 		return NULL;
 	}
-	list_add(&p->list, &instance->setobjs_list[get_string_hash(id)]);
+	obj_hash_add(&instance->setobjs_hash, &p->list, get_string_hash(id));
 	p->value = value;
 	return p;
 }
@@ -915,10 +1057,10 @@ static struct alisp_object * unset_object(struct alisp_instance *instance, struc
 	}
 	id = name->value.s;
 
-	list_for_each(pos, &instance->setobjs_list[get_string_hash(id)]) {
+	list_for_each(pos, obj_hash_list(&instance->setobjs_hash, get_string_hash(id))) {
 		p = list_entry(pos, struct alisp_object_pair, list);
 		if (!strcmp(p->name, id)) {
-			list_del(&p->list);
+			obj_hash_del(&instance->setobjs_hash, &p->list);
 			res = p->value;
 			free((void *)p->name);
 			free(p);
@@ -934,7 +1076,7 @@ static struct alisp_object * get_object1(struct alisp_instance *instance, const
 	struct alisp_object_pair *p;
 	struct list_head *pos;
 
-	list_for_each(pos, &instance->setobjs_list[get_string_hash(id)]) {
+	list_for_each(pos, obj_hash_list(&instance->setobjs_hash, get_string_hash(id))) {
 		p = list_entry(pos, struct alisp_object_pair, list);
 		if (!strcmp(p->name, id))
 			return p->value;
@@ -966,7 +1108,7 @@ static struct alisp_object * replace_object(struct alisp_instance *instance, str
 		return &alsa_lisp_nil;
 	}
 	id = name->value.s;
-	list_for_each(pos, &instance->setobjs_list[get_string_hash(id)]) {
+	list_for_each(pos, obj_hash_list(&instance->setobjs_hash, get_string_hash(id))) {
 		p = list_entry(pos, struct alisp_object_pair, list);
 		if (!strcmp(p->name, id)) {
 			r = p->value;
@@ -983,7 +1125,8 @@ static void dump_objects(struct alisp_instance *instance, const char *fname)
 	struct alisp_object_pair *p;
 	snd_output_t *out;
 	struct list_head *pos;
-	int i, err;
+	unsigned int i;
+	int err;
 
 	if (!strcmp(fname, "-"))
 		err = snd_output_stdio_attach(&out, stdout, 0);
@@ -994,21 +1137,19 @@ static void dump_objects(struct alisp_instance *instance, const char *fname)
 		return;
 	}
 
-	for (i = 0; i < ALISP_OBJ_PAIR_HASH_SIZE; i++) {
-		list_for_each(pos, &instance->setobjs_list[i]) {
-			p = list_entry(pos, struct alisp_object_pair, list);
-			if (alisp_compare_type(p->value, ALISP_OBJ_CONS) &&
-			    alisp_compare_type(p->value->value.c.car, ALISP_OBJ_IDENTIFIER) &&
-			    !strcmp(p->value->value.c.car->value.s, "lambda")) {
-			    	snd_output_printf(out, "(defun %s ", p->name);
-			    	princ_cons(out, p->value->value.c.cdr);
-			    	snd_output_printf(out, ")\n");
-			    	continue;
-			}
-			snd_output_printf(out, "(setq %s '", p->name);
- 			princ_object(out, p->value);
-			snd_output_printf(out, ")\n");
+	obj_hash_for_each(&instance->setobjs_hash, i, pos) {
+		p = list_entry(pos, struct alisp_object_pair, list);
+		if (alisp_compare_type(p->value, ALISP_OBJ_CONS) &&
+		    alisp_compare_type(p->value->value.c.car, ALISP_OBJ_IDENTIFIER) &&
+		    !strcmp(p->value->value.c.car->value.s, "lambda")) {
+		    	snd_output_printf(out, "(defun %s ", p->name);
+		    	princ_cons(out, p->value->value.c.cdr);
+		    	snd_output_printf(out, ")\n");
+		    	continue;
 		}
+		snd_output_printf(out, "(setq %s '", p->name);
+		princ_object(out, p->value);
+		snd_output_printf(out, ")\n");
 	}
 	snd_output_close(out);
 }
@@ -1028,24 +1169,31 @@ static const char *obj_type_str(struct alisp_object * p)
 	}
 }
 
+static void print_used_obj(snd_output_t *out, struct list_head *pos)
+{
+	struct alisp_object * p = list_entry(pos, struct alisp_object, list);
+
+	snd_output_printf(out, "**   %p (%s) (", p, obj_type_str(p));
+	if (!alisp_compare_type(p, ALISP_OBJ_CONS))
+		princ_object(out, p);
+	else
+		snd_output_printf(out, "cons");
+	snd_output_printf(out, ") refs=%i\n", alisp_get_refs(p));
+}
+
 static void print_obj_lists(struct alisp_instance *instance, snd_output_t *out)
 {
 	struct list_head *pos;
 	struct alisp_object * p;
-	int i, j;
+	unsigned int i;
+	int j;
 
 	snd_output_printf(out, "** used objects\n");
-	for (i = 0; i < ALISP_OBJ_PAIR_HASH_SIZE; i++)
-		for (j = 0; j <= ALISP_OBJ_LAST_SEARCH; j++)
-			list_for_each(pos, &instance->used_objs_list[i][j]) {
-				p = list_entry(pos, struct alisp_object, list);
-				snd_output_printf(out, "**   %p (%s) (", p, obj_type_str(p));
-				if (!alisp_compare_type(p, ALISP_OBJ_CONS))
-					princ_object(out, p);
-				else
-					snd_output_printf(out, "cons");
-				snd_output_printf(out, ") refs=%i\n", alisp_get_refs(p));
-			}
+	for (j = 0; j < ALISP_OBJ_CONS; j++)
+		obj_hash_for_each(&instance->used_objs_hash[j], i, pos)
+			print_used_obj(out, pos);
+	list_for_each(pos, &instance->used_cons_list)
+		print_used_obj(out, pos);
 	snd_output_printf(out, "** free objects\n");
 	list_for_each(pos, &instance->free_objs_list) {
 		p = list_entry(pos, struct alisp_object, list);
@@ -3201,7 +3349,7 @@ int alsa_lisp(struct alisp_cfg *cfg, struct alisp_instance **_instance)
 {
 	struct alisp_instance *instance;
 	struct alisp_object *p, *p1;
-	int i, j, retval = 0;
+	int i, retval = 0;
 	
 	instance = (struct alisp_instance *)calloc(1, sizeof(struct alisp_instance));
 	if (instance == NULL) {
@@ -3218,10 +3366,15 @@ int alsa_lisp(struct alisp_cfg *cfg, struct alisp_instance **_instance)
 	instance->wout = cfg->wout;
 	instance->dout = cfg->dout;
 	INIT_LIST_HEAD(&instance->free_objs_list);
-	for (i = 0; i < ALISP_OBJ_PAIR_HASH_SIZE; i++) {
-		for (j = 0; j <= ALISP_OBJ_LAST_SEARCH; j++)
-			INIT_LIST_HEAD(&instance->used_objs_list[i][j]);
-		INIT_LIST_HEAD(&instance->setobjs_list[i]);
+	INIT_LIST_HEAD(&instance->used_cons_list);
+	retval = obj_hash_init(&instance->setobjs_hash, setobj_key);
+	for (i = 0; retval >= 0 && i < ALISP_OBJ_CONS; i++)
+		retval = obj_hash_init(&instance->used_objs_hash[i], used_obj_key);
+	if (retval < 0) {
+		nomem();
+		free_objects(instance);
+		free(instance);
+		return retval;
 	}
 	
 	init_lex(instance);
@@ -116,10 +116,22 @@ struct alisp_object_pair {
 };
 
 #define ALISP_LEX_BUF_MAX	16
-#define ALISP_OBJ_PAIR_HASH_SHIFT 4
-#define ALISP_OBJ_PAIR_HASH_SIZE (1<<ALISP_OBJ_PAIR_HASH_SHIFT)
-#define ALISP_OBJ_PAIR_HASH_MASK (ALISP_OBJ_PAIR_HASH_SIZE-1)
-#define ALISP_FREE_OBJ_POOL	512	/* free objects above this pool */
+#define ALISP_OBJ_HASH_SHIFT	4	/* initial size of the hashes */
+#define ALISP_OBJ_CHUNK		128	/* objects allocated at once */
+
+/* list heads selected by a key hash, doubled when the entries outnumber them */
+struct alisp_obj_hash {
+	struct list_head *lists;
+	unsigned int shift;		/* log2 of the number of lists */
+	unsigned int count;		/* number of entries */
+	unsigned int (*key)(struct list_head *pos);
+};
+
+struct alisp_obj_chunk {
+	struct alisp_obj_chunk *next;
+	unsigned int used;		/* objects taken from this chunk */
+	struct alisp_object objs[ALISP_OBJ_CHUNK];
+};
 
 struct alisp_instance {
 	int verbose: 1,
@@ -145,7 +157,9 @@ struct alisp_instance {
 	long used_objs;
 	long max_objs;
 	struct list_head free_objs_list;
-	struct list_head used_objs_list[ALISP_OBJ_PAIR_HASH_SIZE][ALISP_OBJ_LAST_SEARCH + 1];
+	struct alisp_obj_chunk *obj_chunks;
+	struct alisp_obj_hash used_objs_hash[ALISP_OBJ_CONS];
+	struct list_head used_cons_list;
 	/* set object */
-	struct list_head setobjs_list[ALISP_OBJ_PAIR_HASH_SIZE];
+	struct alisp_obj_hash setobjs_hash;
 };
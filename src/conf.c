@@ -460,11 +460,48 @@ struct _snd_config {
 	struct list_head list;
 	snd_config_t *parent;
 	int hop;
+	unsigned int flags;
+	struct snd_config_arena *arena; /* NULL for malloc'ed nodes */
+};
+
+/* node flags: the id / string value lives in the node arena */
+#define CONFIG_ARENA_ID		(1U << 0)
+#define CONFIG_ARENA_STRING	(1U << 1)
+
+/*
+ * Whole trees (the parsed global tree, expanded copies) are allocated
+ * from an arena: the nodes, the interned ids and the copied string
+ * values are carved from a few large chunks.  Each node keeps a pointer
+ * to its arena, so nodes can be moved between trees freely; the arena
+ * is released when the last of its nodes is deleted.  A moved node
+ * still allocates its new children from its own arena, so any thread
+ * may allocate from an arena: the allocations, the interned ids and the
+ * free list are protected by snd_config_lock().
+ */
+struct config_arena_chunk {
+	struct config_arena_chunk *next;
+};
+
+struct snd_config_arena {
+	unsigned int nodes;		/* live nodes + creator reference, atomic */
+	snd_config_t *free_nodes;	/* deleted nodes, linked by parent */
+	struct config_arena_chunk *chunks;
+	char *ptr;			/* free space in the current chunk */
+	size_t left;
+	size_t chunk_size;
+	const char **ids;		/* interned ids, open addressing */
+	unsigned int ids_mask;
+	unsigned int ids_count;
+	unsigned int generation;	/* bumped when a tree using the arena changes */
+	struct list_head defs;		/* expanded definitions of the top nodes */
+	unsigned int defs_count;
 };
 
 struct filedesc {
 	char *name;
 	snd_input_t *in;
+	const unsigned char *ptr;	/* in-memory input, NULL for getc */
+	const unsigned char *end;
 	unsigned int line, column;
 	struct filedesc *next;
 
@@ -492,6 +529,8 @@ typedef struct {
 	struct filedesc *current;
 	int unget;
 	int ch;
+	snd_config_file_cb_t file_cb;	/* reports every probed include file */
+	void *file_private;
 } input_t;
 
 #ifdef HAVE_LIBPTHREAD
@@ -635,16 +674,25 @@ static char *_snd_config_path(const char *name)
  *    <searchdir:relative-path/to/user/share/alsa>;
  *    These directories should be subdirectories of /usr/share/alsa.
  */
+static int input_file_open(snd_input_t **inputp, const char *file,
+			   input_t *input)
+{
+	if (input->file_cb)
+		input->file_cb(input->file_private, file);
+	return snd_input_stdio_open(inputp, file, "r");
+}
+
 static int input_stdio_open(snd_input_t **inputp, const char *file,
-			    struct filedesc *current)
+			    input_t *input)
 {
+	struct filedesc *current = input->current;
 	struct list_head *pos;
 	struct include_path *path;
 	char full_path[PATH_MAX];
 	int err;
 
 	if (file[0] == '/')
-		return snd_input_stdio_open(inputp, file, "r");
+		return input_file_open(inputp, file, input);
 
 	/* search file in user specified include paths. These directories
 	 * are subdirectories of /usr/share/alsa.
@@ -657,7 +705,7 @@ static int input_stdio_open(snd_input_t **inputp, const char *file,
 				continue;
 
 			snprintf(full_path, PATH_MAX, "%s/%s", path->dir, file);
-			err = snd_input_stdio_open(inputp, full_path, "r");
+			err = input_file_open(inputp, full_path, input);
 			if (err == 0)
 				return 0;
 		}
@@ -743,6 +791,21 @@ int _snd_safe_strtod(const char *str, double *val)
 	return 0;
 }
 
+/*
+ * Tokenize the whole input from memory when the input handle allows it,
+ * the strings are then copied as spans instead of char by char.
+ */
+static void filedesc_map(struct filedesc *fd)
+{
+	size_t size;
+
+	if (_snd_input_map(fd->in, &fd->ptr, &size) < 0) {
+		fd->ptr = fd->end = NULL;
+		return;
+	}
+	fd->end = fd->ptr + size;
+}
+
 static int get_char(input_t *input)
 {
 	int c;
@@ -753,7 +816,10 @@ static int get_char(input_t *input)
 	}
  again:
 	fd = input->current;
-	c = snd_input_getc(fd->in);
+	if (fd->ptr)
+		c = fd->ptr < fd->end ? *fd->ptr++ : EOF;
+	else
+		c = snd_input_getc(fd->in);
 	switch (c) {
 	case '\n':
 		fd->column = 0;
@@ -789,13 +855,13 @@ static int get_delimstring(char **string, int delim, input_t *input);
 
 static int get_char_skip_comments(input_t *input)
 {
+	struct filedesc *fd;
 	int c;
 	while (1) {
 		c = get_char(input);
 		if (c == '<') {
 			char *str;
 			snd_input_t *in;
-			struct filedesc *fd;
 			DIR *dirp;
 			int err = get_delimstring(&str, '>', input);
 			if (err < 0)
@@ -834,9 +900,9 @@ static int get_char_skip_comments(input_t *input)
 				if (tmp == NULL)
 					return -ENOMEM;
 				str = tmp;
-				err = snd_input_stdio_open(&in, str, "r");
+				err = input_file_open(&in, str, input);
 			} else { /* absolute or relative file path */
-				err = input_stdio_open(&in, str, input->current);
+				err = input_stdio_open(&in, str, input);
 			}
 
 			if (err < 0) {
@@ -855,11 +921,22 @@ static int get_char_skip_comments(input_t *input)
 			fd->line = 1;
 			fd->column = 0;
 			INIT_LIST_HEAD(&fd->include_paths);
+			filedesc_map(fd);
 			input->current = fd;
 			continue;
 		}
 		if (c != '#')
 			break;
+		fd = input->current;
+		if (fd->ptr) {
+			const unsigned char *nl = memchr(fd->ptr, '\n', fd->end - fd->ptr);
+			if (nl) {
+				fd->ptr = nl + 1;
+				fd->line++;
+				fd->column = 0;
+				continue;
+			}
+		}
 		while (1) {
 			c = get_char(input);
 			if (c < 0)
@@ -998,11 +1075,64 @@ static char *copy_local_string(struct local_string *s)
 	return dst;
 }
 
+static char *copy_span(const unsigned char *start, const unsigned char *end)
+{
+	char *dst = malloc(end - start + 1);
+	if (dst) {
+		memcpy(dst, start, end - start);
+		dst[end - start] = '\0';
+	}
+	return dst;
+}
+
+static inline int is_freestring_delim(int c, int id)
+{
+	switch (c) {
+	case '.':
+		return id;
+	case ' ':
+	case '\f':
+	case '\t':
+	case '\n':
+	case '\r':
+	case '=':
+	case ',':
+	case ';':
+	case '{':
+	case '}':
+	case '[':
+	case ']':
+	case '\'':
+	case '"':
+	case '\\':
+	case '#':
+		return 1;
+	default:
+		return 0;
+	}
+}
+
 static int get_freestring(char **string, int id, input_t *input)
 {
+	struct filedesc *fd = input->current;
 	struct local_string str;
+	const unsigned char *p;
 	int c;
 
+	/* the string ends inside the in-memory input */
+	if (!input->unget && fd->ptr) {
+		for (p = fd->ptr; p < fd->end; p++) {
+			if (is_freestring_delim(*p, id)) {
+				*string = copy_span(fd->ptr, p);
+				if (!*string)
+					return -ENOMEM;
+				fd->column += p - fd->ptr;
+				fd->ptr = p;
+				return 0;
+			}
+		}
+	}
+
 	init_local_string(&str);
 	while (1) {
 		c = get_char(input);
@@ -1016,27 +1146,7 @@ static int get_freestring(char **string, int id, input_t *input)
 			}
 			break;
 		}
-		switch (c) {
-		case '.':
-			if (!id)
-				break;
-			/* fall through */
-		case ' ':
-		case '\f':
-		case '\t':
-		case '\n':
-		case '\r':
-		case '=':
-		case ',':
-		case ';':
-		case '{':
-		case '}':
-		case '[':
-		case ']':
-		case '\'':
-		case '"':
-		case '\\':
-		case '#':
+		if (is_freestring_delim(c, id)) {
 			*string = copy_local_string(&str);
 			if (! *string)
 				c = -ENOMEM;
@@ -1045,8 +1155,6 @@ static int get_freestring(char **string, int id, input_t *input)
 				c = 0;
 			}
 			goto _out;
-		default:
-			break;
 		}
 		if (add_char_local_string(&str, c) < 0) {
 			c = -ENOMEM;
@@ -1060,9 +1168,27 @@ static int get_freestring(char **string, int id, input_t *input)
 			
 static int get_delimstring(char **string, int delim, input_t *input)
 {
+	struct filedesc *fd = input->current;
 	struct local_string str;
+	const unsigned char *p;
 	int c;
 
+	/* plain strings (no escapes, tabs or newlines) inside the in-memory input */
+	if (!input->unget && fd->ptr) {
+		for (p = fd->ptr; p < fd->end; p++) {
+			if (*p == delim) {
+				*string = copy_span(fd->ptr, p);
+				if (!*string)
+					return -ENOMEM;
+				fd->column += p - fd->ptr + 1;
+				fd->ptr = p + 1;
+				return 0;
+			}
+			if (*p == '\\' || *p == '\n' || *p == '\t')
+				break;
+		}
+	}
+
 	init_local_string(&str);
 	while (1) {
 		c = get_char(input);
@@ -1123,19 +1249,247 @@ static int get_string(char **string, int id, input_t *input)
 	}
 }
 
-static int _snd_config_make(snd_config_t **config, char **id, snd_config_type_t type)
+#define CONFIG_ARENA_ALIGN	8
+#define CONFIG_ARENA_CHUNK_MIN	1024
+#define CONFIG_ARENA_CHUNK_MAX	(64 * 1024)
+
+static struct snd_config_arena *config_arena_new(void)
+{
+	struct snd_config_arena *arena = calloc(1, sizeof(*arena));
+	if (arena == NULL)
+		return NULL;
+	arena->nodes = 1;
+	arena->chunk_size = CONFIG_ARENA_CHUNK_MIN;
+	INIT_LIST_HEAD(&arena->defs);
+	return arena;
+}
+
+static void config_defs_free(struct snd_config_arena *arena);
+
+/* drop a node (or the creator) reference, the last one frees the arena */
+static void config_arena_put(struct snd_config_arena *arena)
+{
+	struct config_arena_chunk *chunk, *next;
+
+	/* nodes moved to other trees may be deleted from other threads */
+	if (__atomic_sub_fetch(&arena->nodes, 1, __ATOMIC_ACQ_REL) > 0)
+		return;
+	config_defs_free(arena);
+	for (chunk = arena->chunks; chunk; chunk = next) {
+		next = chunk->next;
+		free(chunk);
+	}
+	free(arena->ids);
+	free(arena);
+}
+
+/* called with snd_config_lock() held */
+static void *config_arena_alloc(struct snd_config_arena *arena, size_t size)
+{
+	struct config_arena_chunk *chunk;
+	size_t csize;
+	void *res;
+
+	size = (size + CONFIG_ARENA_ALIGN - 1) & ~(size_t)(CONFIG_ARENA_ALIGN - 1);
+	if (size > arena->left) {
+		csize = arena->chunk_size;
+		if (csize < CONFIG_ARENA_CHUNK_MAX)
+			arena->chunk_size *= 2;
+		if (size > csize / 4) {
+			/* a big string gets its own chunk */
+			chunk = malloc(CONFIG_ARENA_ALIGN + size);
+			if (chunk == NULL)
+				return NULL;
+			if (arena->chunks) {
+				chunk->next = arena->chunks->next;
+				arena->chunks->next = chunk;
+			} else {
+				chunk->next = NULL;
+				arena->chunks = chunk;
+			}
+			return (char *)chunk + CONFIG_ARENA_ALIGN;
+		}
+		chunk = malloc(csize);
+		if (chunk == NULL)
+			return NULL;
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+		arena->ptr = (char *)chunk + CONFIG_ARENA_ALIGN;
+		arena->left = csize - CONFIG_ARENA_ALIGN;
+	}
+	res = arena->ptr;
+	arena->ptr += size;
+	arena->left -= size;
+	return res;
+}
+
+static char *config_arena_strdup(struct snd_config_arena *arena, const char *str)
+{
+	size_t len = strlen(str) + 1;
+	char *res = config_arena_alloc(arena, len);
+	if (res)
+		memcpy(res, str, len);
+	return res;
+}
+
+static unsigned int config_id_hash(const char *id)
+{
+	unsigned int h = 2166136261U;
+	while (*id)
+		h = (h ^ (unsigned char)*id++) * 16777619U;
+	return h;
+}
+
+/* return the arena copy of id, identical ids share one copy */
+static const char *config_arena_intern(struct snd_config_arena *arena, const char *id)
+{
+	unsigned int h, i;
+	const char *res = NULL;
+
+	snd_config_lock();
+	if (arena->ids_count * 2 >= arena->ids_mask) {
+		unsigned int mask = arena->ids_mask ? arena->ids_mask * 2 + 1 : 255;
+		const char **ids = calloc(mask + 1, sizeof(*ids));
+		if (ids == NULL)
+			goto __unlock;
+		for (i = 0; arena->ids && i <= arena->ids_mask; i++) {
+			if (arena->ids[i] == NULL)
+				continue;
+			h = config_id_hash(arena->ids[i]) & mask;
+			while (ids[h])
+				h = (h + 1) & mask;
+			ids[h] = arena->ids[i];
+		}
+		free(arena->ids);
+		arena->ids = ids;
+		arena->ids_mask = mask;
+	}
+	h = config_id_hash(id) & arena->ids_mask;
+	while ((res = arena->ids[h]) != NULL) {
+		if (strcmp(res, id) == 0)
+			goto __unlock;
+		h = (h + 1) & arena->ids_mask;
+	}
+	res = config_arena_strdup(arena, id);
+	if (res) {
+		arena->ids[h] = res;
+		arena->ids_count++;
+	}
+ __unlock:
+	snd_config_unlock();
+	return res;
+}
+
+static snd_config_t *config_alloc(struct snd_config_arena *arena)
 {
 	snd_config_t *n;
+
+	if (arena == NULL)
+		return calloc(1, sizeof(*n));
+	snd_config_lock();
+	n = arena->free_nodes;
+	if (n)
+		arena->free_nodes = n->parent;
+	else
+		n = config_arena_alloc(arena, sizeof(*n));
+	snd_config_unlock();
+	if (n == NULL)
+		return NULL;
+	memset(n, 0, sizeof(*n));
+	n->arena = arena;
+	__atomic_add_fetch(&arena->nodes, 1, __ATOMIC_RELAXED);
+	return n;
+}
+
+static void config_free_id(snd_config_t *config)
+{
+	if (!(config->flags & CONFIG_ARENA_ID))
+		free(config->id);
+	config->flags &= ~CONFIG_ARENA_ID;
+}
+
+static void config_free_string(snd_config_t *config)
+{
+	if (!(config->flags & CONFIG_ARENA_STRING))
+		free(config->u.string);
+	config->flags &= ~CONFIG_ARENA_STRING;
+}
+
+static void config_free(snd_config_t *config)
+{
+	struct snd_config_arena *arena = config->arena;
+
+	if (arena == NULL) {
+		free(config);
+		return;
+	}
+	snd_config_lock();
+	config->parent = arena->free_nodes;
+	arena->free_nodes = config;
+	snd_config_unlock();
+	config_arena_put(arena);
+}
+
+/* invalidate the cached definitions of all trees containing config */
+static void config_changed(snd_config_t *config)
+{
+	for (; config; config = config->parent)
+		if (config->arena)
+			config->arena->generation++;
+}
+
+/* replace the arena id and string value of config with malloc'ed copies */
+static int config_unshare_strings(snd_config_t *config)
+{
+	char *id = NULL, *str = NULL;
+
+	if (config->flags & CONFIG_ARENA_ID) {
+		id = strdup(config->id);
+		if (id == NULL)
+			return -ENOMEM;
+	}
+	if (config->flags & CONFIG_ARENA_STRING) {
+		str = strdup(config->u.string);
+		if (str == NULL) {
+			free(id);
+			return -ENOMEM;
+		}
+	}
+	if (config->flags & CONFIG_ARENA_ID)
+		config->id = id;
+	if (config->flags & CONFIG_ARENA_STRING)
+		config->u.string = str;
+	config->flags &= ~(CONFIG_ARENA_ID | CONFIG_ARENA_STRING);
+	return 0;
+}
+
+/* the id is taken over (or interned and freed for arena nodes) */
+static int _snd_config_make_arena(snd_config_t **config, char **id,
+				  snd_config_type_t type,
+				  struct snd_config_arena *arena)
+{
+	snd_config_t *n;
+	const char *aid;
 	assert(config);
-	n = calloc(1, sizeof(*n));
+	n = config_alloc(arena);
 	if (n == NULL) {
-		if (*id) {
+		if (id && *id) {
 			free(*id);
 			*id = NULL;
 		}
 		return -ENOMEM;
 	}
-	if (id) {
+	if (id && *id && arena) {
+		aid = config_arena_intern(arena, *id);
+		free(*id);
+		*id = NULL;
+		if (aid == NULL) {
+			config_free(n);
+			return -ENOMEM;
+		}
+		n->id = (char *)aid;
+		n->flags |= CONFIG_ARENA_ID;
+	} else if (id) {
 		n->id = *id;
 		*id = NULL;
 	}
@@ -1145,7 +1499,71 @@ static int _snd_config_make(snd_config_t **config, char **id, snd_config_type_t
 	*config = n;
 	return 0;
 }
-	
+
+static int _snd_config_make(snd_config_t **config, char **id, snd_config_type_t type)
+{
+	return _snd_config_make_arena(config, id, type, NULL);
+}
+
+/* like snd_config_make(), but the node is allocated from arena */
+static int config_make_const(snd_config_t **config, const char *id,
+			     snd_config_type_t type,
+			     struct snd_config_arena *arena)
+{
+	snd_config_t *n;
+	const char *aid;
+	if (arena == NULL)
+		return snd_config_make(config, id, type);
+	n = config_alloc(arena);
+	if (n == NULL)
+		return -ENOMEM;
+	if (id) {
+		aid = config_arena_intern(arena, id);
+		if (aid == NULL) {
+			config_free(n);
+			return -ENOMEM;
+		}
+		n->id = (char *)aid;
+		n->flags |= CONFIG_ARENA_ID;
+	}
+	n->type = type;
+	if (type == SND_CONFIG_TYPE_COMPOUND)
+		INIT_LIST_HEAD(&n->u.compound.fields);
+	*config = n;
+	return 0;
+}
+
+/* set the string value, copied to the node arena */
+static int config_set_string_arena(snd_config_t *config, const char *value)
+{
+	char *str;
+
+	if (config->arena == NULL || value == NULL)
+		return snd_config_set_string(config, value);
+	snd_config_lock();
+	str = config_arena_strdup(config->arena, value);
+	snd_config_unlock();
+	if (str == NULL)
+		return -ENOMEM;
+	config_free_string(config);
+	config->u.string = str;
+	config->flags |= CONFIG_ARENA_STRING;
+	return 0;
+}
+
+/* create a top level node allocating the whole tree from a new arena */
+static int config_top_arena(snd_config_t **config)
+{
+	struct snd_config_arena *arena = config_arena_new();
+	int err;
+
+	if (arena == NULL)
+		return -ENOMEM;
+	err = _snd_config_make_arena(config, NULL, SND_CONFIG_TYPE_COMPOUND, arena);
+	config_arena_put(arena);
+	return err;
+}
+
 
 static int _snd_config_make_add(snd_config_t **config, char **id,
 				snd_config_type_t type, snd_config_t *parent)
@@ -1153,7 +1571,7 @@ static int _snd_config_make_add(snd_config_t **config, char **id,
 	snd_config_t *n;
 	int err;
 	assert(parent->type == SND_CONFIG_TYPE_COMPOUND);
-	err = _snd_config_make(&n, id, type);
+	err = _snd_config_make_arena(&n, id, type, parent->arena);
 	if (err < 0)
 		return err;
 	n->parent = parent;
@@ -1251,7 +1669,7 @@ static int parse_value(snd_config_t **_n, snd_config_t *parent, input_t *input,
 		if (err < 0)
 			return err;
 	}
-	free(n->u.string);
+	config_free_string(n);
 	n->u.string = s;
 	*_n = n;
 	return 0;
@@ -1730,6 +2148,12 @@ static int _snd_config_save_children(snd_config_t *config, snd_output_t *out,
 int snd_config_substitute(snd_config_t *dst, snd_config_t *src)
 {
 	assert(dst && src);
+	if (src->arena != dst->arena) {
+		/* the arena strings of src must not outlive its arena */
+		int err = config_unshare_strings(src);
+		if (err < 0)
+			return err;
+	}
 	if (dst->type == SND_CONFIG_TYPE_COMPOUND) {
 		int err = snd_config_delete_compound_members(dst);
 		if (err < 0)
@@ -1745,13 +2169,15 @@ int snd_config_substitute(snd_config_t *dst, snd_config_t *src)
 		src->u.compound.fields.next->prev = &dst->u.compound.fields;
 		src->u.compound.fields.prev->next = &dst->u.compound.fields;
 	}
-	free(dst->id);
+	config_free_id(dst);
 	if (dst->type == SND_CONFIG_TYPE_STRING)
-		free(dst->u.string);
+		config_free_string(dst);
 	dst->id = src->id;
 	dst->type = src->type;
 	dst->u = src->u;
-	free(src);
+	dst->flags = src->flags;
+	config_free(src);
+	config_changed(dst);
 	return 0;
 }
 
@@ -1926,8 +2352,9 @@ int snd_config_set_id(snd_config_t *config, const char *id)
 			return -EINVAL;
 		new_id = NULL;
 	}
-	free(config->id);
+	config_free_id(config);
 	config->id = new_id;
+	config_changed(config);
 	return 0;
 }
 
@@ -1939,6 +2366,9 @@ int snd_config_set_id(snd_config_t *config, const char *id)
  * The returned node is an empty compound node without a parent and
  * without an id.
  *
+ * The nodes loaded into the tree (#snd_config_load) are allocated
+ * together with the top node from a shared memory arena.
+ *
  * \par Errors:
  * <dl>
  * <dt>-ENOMEM<dd>Out of memory.
@@ -1950,18 +2380,32 @@ int snd_config_set_id(snd_config_t *config, const char *id)
 int snd_config_top(snd_config_t **config)
 {
 	assert(config);
-	return _snd_config_make(config, 0, SND_CONFIG_TYPE_COMPOUND);
+	return config_top_arena(config);
 }
 
 #ifndef DOC_HIDDEN
 int _snd_config_load_with_include(snd_config_t *config, snd_input_t *in,
 				  int override, const char * const *include_paths)
+{
+	return _snd_config_load_with_include_cb(config, in, override,
+						include_paths, NULL, NULL);
+}
+
+/* the file callback gets the path of every file opened or probed by
+ * the <file> includes, including the search directory candidates
+ * which do not exist */
+int _snd_config_load_with_include_cb(snd_config_t *config, snd_input_t *in,
+				     int override,
+				     const char * const *include_paths,
+				     snd_config_file_cb_t file_cb,
+				     void *file_private)
 {
 	int err;
 	input_t input;
 	struct filedesc *fd, *fd_next;
 
 	assert(config && in);
+	config_changed(config);
 	fd = malloc(sizeof(*fd));
 	if (!fd)
 		return -ENOMEM;
@@ -1971,6 +2415,7 @@ int _snd_config_load_with_include(snd_config_t *config, snd_input_t *in,
 	fd->column = 0;
 	fd->next = NULL;
 	INIT_LIST_HEAD(&fd->include_paths);
+	filedesc_map(fd);
 	if (include_paths) {
 		for (; *include_paths; include_paths++) {
 			err = add_include_path(fd, *include_paths);
@@ -1984,6 +2429,8 @@ int _snd_config_load_with_include(snd_config_t *config, snd_input_t *in,
 	}
 	input.current = fd;
 	input.unget = 0;
+	input.file_cb = file_cb;
+	input.file_private = file_private;
 	err = parse_defs(config, &input, 0, override);
 	fd = input.current;
 	if (err < 0) {
@@ -2152,6 +2599,7 @@ int snd_config_add(snd_config_t *parent, snd_config_t *child)
 	}
 	child->parent = parent;
 	list_add_tail(&child->list, &parent->u.compound.fields);
+	config_changed(parent);
 	return 0;
 }
 
@@ -2193,6 +2641,7 @@ int snd_config_add_after(snd_config_t *after, snd_config_t *child)
 	}
 	child->parent = parent;
 	list_insert(&child->list, &after->list, after->list.next);
+	config_changed(parent);
 	return 0;
 }
 
@@ -2234,6 +2683,7 @@ int snd_config_add_before(snd_config_t *before, snd_config_t *child)
 	}
 	child->parent = parent;
 	list_insert(&child->list, before->list.prev, &before->list);
+	config_changed(parent);
 	return 0;
 }
 
@@ -2350,37 +2800,15 @@ int snd_config_merge(snd_config_t *dst, snd_config_t *src, int override)
 int snd_config_remove(snd_config_t *config)
 {
 	assert(config);
+	config_changed(config);
 	if (config->parent)
 		list_del(&config->list);
 	config->parent = NULL;
 	return 0;
 }
 
-/**
- * \brief Frees a configuration node.
- * \param config Handle to the configuration node to be deleted.
- * \return Zero if successful, otherwise a negative error code.
- *
- * This function frees a configuration node and all its resources.
- *
- * If the node is a child node, it is removed from the tree before being
- * deleted.
- *
- * If the node is a compound node, its descendants (the whole subtree)
- * are deleted recursively.
- *
- * The function is supposed to be called only for locally copied config
- * trees.  For the global tree, take the reference via #snd_config_update_ref
- * and free it via #snd_config_unref.
- *
- * \par Conforming to:
- * LSB 3.2
- *
- * \sa snd_config_remove
- */
-int snd_config_delete(snd_config_t *config)
+static int _snd_config_delete(snd_config_t *config)
 {
-	assert(config);
 	if (config->refcount > 0) {
 		config->refcount--;
 		return 0;
@@ -2394,7 +2822,7 @@ int snd_config_delete(snd_config_t *config)
 		while (i != &config->u.compound.fields) {
 			struct list_head *nexti = i->next;
 			snd_config_t *child = snd_config_iterator_entry(i);
-			err = snd_config_delete(child);
+			err = _snd_config_delete(child);
 			if (err < 0)
 				return err;
 			i = nexti;
@@ -2402,18 +2830,48 @@ int snd_config_delete(snd_config_t *config)
 		break;
 	}
 	case SND_CONFIG_TYPE_STRING:
-		free(config->u.string);
+		config_free_string(config);
 		break;
 	default:
 		break;
 	}
 	if (config->parent)
 		list_del(&config->list);
-	free(config->id);
-	free(config);
+	config_free_id(config);
+	config_free(config);
 	return 0;
 }
 
+/**
+ * \brief Frees a configuration node.
+ * \param config Handle to the configuration node to be deleted.
+ * \return Zero if successful, otherwise a negative error code.
+ *
+ * This function frees a configuration node and all its resources.
+ *
+ * If the node is a child node, it is removed from the tree before being
+ * deleted.
+ *
+ * If the node is a compound node, its descendants (the whole subtree)
+ * are deleted recursively.
+ *
+ * The function is supposed to be called only for locally copied config
+ * trees.  For the global tree, take the reference via #snd_config_update_ref
+ * and free it via #snd_config_unref.
+ *
+ * \par Conforming to:
+ * LSB 3.2
+ *
+ * \sa snd_config_remove
+ */
+int snd_config_delete(snd_config_t *config)
+{
+	assert(config);
+	if (config->refcount == 0)
+		config_changed(config);
+	return _snd_config_delete(config);
+}
+
 /**
  * \brief Deletes the children of a node.
  * \param config Handle to the compound configuration node.
@@ -2976,6 +3434,7 @@ int snd_config_set_integer(snd_config_t *config, long value)
 	if (config->type != SND_CONFIG_TYPE_INTEGER)
 		return -EINVAL;
 	config->u.integer = value;
+	config_changed(config);
 	return 0;
 }
 
@@ -2999,6 +3458,7 @@ int snd_config_set_integer64(snd_config_t *config, long long value)
 	if (config->type != SND_CONFIG_TYPE_INTEGER64)
 		return -EINVAL;
 	config->u.integer64 = value;
+	config_changed(config);
 	return 0;
 }
 
@@ -3019,6 +3479,7 @@ int snd_config_set_real(snd_config_t *config, double value)
 	if (config->type != SND_CONFIG_TYPE_REAL)
 		return -EINVAL;
 	config->u.real = value;
+	config_changed(config);
 	return 0;
 }
 
@@ -3052,8 +3513,9 @@ int snd_config_set_string(snd_config_t *config, const char *value)
 	} else {
 		new_string = NULL;
 	}
-	free(config->u.string);
+	config_free_string(config);
 	config->u.string = new_string;
+	config_changed(config);
 	return 0;
 }
 
@@ -3076,6 +3538,7 @@ int snd_config_set_pointer(snd_config_t *config, const void *value)
 	if (config->type != SND_CONFIG_TYPE_POINTER)
 		return -EINVAL;
 	config->u.ptr = value;
+	config_changed(config);
 	return 0;
 }
 
@@ -3140,13 +3603,14 @@ int snd_config_set_ascii(snd_config_t *config, const char *ascii)
 			char *ptr = strdup(ascii);
 			if (ptr == NULL)
 				return -ENOMEM;
-			free(config->u.string);
+			config_free_string(config);
 			config->u.string = ptr;
 		}
 		break;
 	default:
 		return -EINVAL;
 	}
+	config_changed(config);
 	return 0;
 }
 
@@ -4789,6 +5253,7 @@ int snd_config_update_free_global(void)
 	snd_config_unlock();
 	/* FIXME: better to place this in another place... */
 	snd_dlobj_cache_cleanup();
+	snd_card_registry_cleanup();
 
 	return 0;
 }
@@ -4882,6 +5347,7 @@ typedef int (*snd_config_walk_callback_t)(snd_config_t *src,
 					  snd_config_t **dst,
 					  snd_config_walk_pass_t pass,
 					  snd_config_expand_fcn_t fcn,
+					  struct snd_config_arena *arena,
 					  void *private_data);
 #endif
 
@@ -4890,6 +5356,7 @@ static int snd_config_walk(snd_config_t *src,
 			   snd_config_t **dst, 
 			   snd_config_walk_callback_t callback,
 			   snd_config_expand_fcn_t fcn,
+			   struct snd_config_arena *arena,
 			   void *private_data)
 {
 	int err;
@@ -4897,7 +5364,7 @@ static int snd_config_walk(snd_config_t *src,
 
 	switch (snd_config_get_type(src)) {
 	case SND_CONFIG_TYPE_COMPOUND:
-		err = callback(src, root, dst, SND_CONFIG_WALK_PASS_PRE, fcn, private_data);
+		err = callback(src, root, dst, SND_CONFIG_WALK_PASS_PRE, fcn, arena, private_data);
 		if (err <= 0)
 			return err;
 		snd_config_for_each(i, next, src) {
@@ -4905,7 +5372,7 @@ static int snd_config_walk(snd_config_t *src,
 			snd_config_t *d = NULL;
 
 			err = snd_config_walk(s, root, (dst && *dst) ? &d : NULL,
-					      callback, fcn, private_data);
+					      callback, fcn, arena, private_data);
 			if (err < 0)
 				goto _error;
 			if (err && d) {
@@ -4914,7 +5381,7 @@ static int snd_config_walk(snd_config_t *src,
 					goto _error;
 			}
 		}
-		err = callback(src, root, dst, SND_CONFIG_WALK_PASS_POST, fcn, private_data);
+		err = callback(src, root, dst, SND_CONFIG_WALK_PASS_POST, fcn, arena, private_data);
 		if (err <= 0) {
 		_error:
 			if (dst && *dst)
@@ -4922,17 +5389,40 @@ static int snd_config_walk(snd_config_t *src,
 		}
 		break;
 	default:
-		err = callback(src, root, dst, SND_CONFIG_WALK_PASS_LEAF, fcn, private_data);
+		err = callback(src, root, dst, SND_CONFIG_WALK_PASS_LEAF, fcn, arena, private_data);
 		break;
 	}
 	return err;
 }
 
+/* walk creating a new tree, compound trees are allocated from an arena */
+static int snd_config_walk_copy(snd_config_t *src,
+				snd_config_t *root,
+				snd_config_t **dst,
+				snd_config_walk_callback_t callback,
+				snd_config_expand_fcn_t fcn,
+				void *private_data)
+{
+	struct snd_config_arena *arena = NULL;
+	int err;
+
+	if (snd_config_get_type(src) == SND_CONFIG_TYPE_COMPOUND) {
+		arena = config_arena_new();
+		if (arena == NULL)
+			return -ENOMEM;
+	}
+	err = snd_config_walk(src, root, dst, callback, fcn, arena, private_data);
+	if (arena)
+		config_arena_put(arena);
+	return err;
+}
+
 static int _snd_config_copy(snd_config_t *src,
 			    snd_config_t *root ATTRIBUTE_UNUSED,
 			    snd_config_t **dst,
 			    snd_config_walk_pass_t pass,
 			    snd_config_expand_fcn_t fcn ATTRIBUTE_UNUSED,
+			    struct snd_config_arena *arena,
 			    void *private_data ATTRIBUTE_UNUSED)
 {
 	int err;
@@ -4940,12 +5430,13 @@ static int _snd_config_copy(snd_config_t *src,
 	snd_config_type_t type = snd_config_get_type(src);
 	switch (pass) {
 	case SND_CONFIG_WALK_PASS_PRE:
-		err = snd_config_make_compound(dst, id, src->u.compound.join);
+		err = config_make_const(dst, id, SND_CONFIG_TYPE_COMPOUND, arena);
 		if (err < 0)
 			return err;
+		(*dst)->u.compound.join = src->u.compound.join;
 		break;
 	case SND_CONFIG_WALK_PASS_LEAF:
-		err = snd_config_make(dst, id, type);
+		err = config_make_const(dst, id, type, arena);
 		if (err < 0)
 			return err;
 		switch (type) {
@@ -4978,9 +5469,11 @@ static int _snd_config_copy(snd_config_t *src,
 			const char *s;
 			err = snd_config_get_string(src, &s);
 			assert(err >= 0);
-			err = snd_config_set_string(*dst, s);
-			if (err < 0)
+			err = config_set_string_arena(*dst, s);
+			if (err < 0) {
+				snd_config_delete(*dst);
 				return err;
+			}
 			break;
 		}
 		default:
@@ -5014,7 +5507,7 @@ static int _snd_config_copy(snd_config_t *src,
 int snd_config_copy(snd_config_t **dst,
 		    snd_config_t *src)
 {
-	return snd_config_walk(src, NULL, dst, _snd_config_copy, NULL, NULL);
+	return snd_config_walk_copy(src, NULL, dst, _snd_config_copy, NULL, NULL);
 }
 
 static int _snd_config_expand_vars(snd_config_t **dst, const char *s, void *private_data)
@@ -5032,6 +5525,7 @@ static int _snd_config_expand(snd_config_t *src,
 			      snd_config_t **dst,
 			      snd_config_walk_pass_t pass,
 			      snd_config_expand_fcn_t fcn,
+			      struct snd_config_arena *arena,
 			      void *private_data)
 {
 	int err;
@@ -5042,9 +5536,10 @@ static int _snd_config_expand(snd_config_t *src,
 	{
 		if (id && strcmp(id, "@args") == 0)
 			return 0;
-		err = snd_config_make_compound(dst, id, src->u.compound.join);
+		err = config_make_const(dst, id, SND_CONFIG_TYPE_COMPOUND, arena);
 		if (err < 0)
 			return err;
+		(*dst)->u.compound.join = src->u.compound.join;
 		break;
 	}
 	case SND_CONFIG_WALK_PASS_LEAF:
@@ -5054,9 +5549,10 @@ static int _snd_config_expand(snd_config_t *src,
 			long v;
 			err = snd_config_get_integer(src, &v);
 			assert(err >= 0);
-			err = snd_config_imake_integer(dst, id, v);
+			err = config_make_const(dst, id, SND_CONFIG_TYPE_INTEGER, arena);
 			if (err < 0)
 				return err;
+			(*dst)->u.integer = v;
 			break;
 		}
 		case SND_CONFIG_TYPE_INTEGER64:
@@ -5064,9 +5560,10 @@ static int _snd_config_expand(snd_config_t *src,
 			long long v;
 			err = snd_config_get_integer64(src, &v);
 			assert(err >= 0);
-			err = snd_config_imake_integer64(dst, id, v);
+			err = config_make_const(dst, id, SND_CONFIG_TYPE_INTEGER64, arena);
 			if (err < 0)
 				return err;
+			(*dst)->u.integer64 = v;
 			break;
 		}
 		case SND_CONFIG_TYPE_REAL:
@@ -5074,9 +5571,10 @@ static int _snd_config_expand(snd_config_t *src,
 			double v;
 			err = snd_config_get_real(src, &v);
 			assert(err >= 0);
-			err = snd_config_imake_real(dst, id, v);
+			err = config_make_const(dst, id, SND_CONFIG_TYPE_REAL, arena);
 			if (err < 0)
 				return err;
+			(*dst)->u.real = v;
 			break;
 		}
 		case SND_CONFIG_TYPE_STRING:
@@ -5096,9 +5594,14 @@ static int _snd_config_expand(snd_config_t *src,
 					return err;
 				}
 			} else {
-				err = snd_config_imake_string(dst, id, s);
+				err = config_make_const(dst, id, SND_CONFIG_TYPE_STRING, arena);
 				if (err < 0)
 					return err;
+				err = config_set_string_arena(*dst, s);
+				if (err < 0) {
+					snd_config_delete(*dst);
+					return err;
+				}
 			}
 			break;
 		}
@@ -5112,11 +5615,247 @@ static int _snd_config_expand(snd_config_t *src,
 	return 1;
 }
 
+#ifndef DOC_HIDDEN
+#ifdef HAVE___THREAD
+#define TLS_PFX		__thread
+#else
+#define TLS_PFX		/* NOP */
+#endif
+#endif
+
+/*
+ * Cache of the expanded definitions (#snd_config_search_definition).
+ *
+ * The entries are kept in the arena of the searched top node and they
+ * are valid while the tree is not changed (the arena generation) and
+ * the environment variables read by the getenv functions keep their
+ * values.  Expansions calling functions which depend on other state
+ * (hardware, private data, external libraries) are not cached.
+ */
+#define CONFIG_DEFS_MAX		64
+
+struct config_def_env {
+	char *var;
+	char *value;			/* NULL if not set */
+};
+
+struct config_def_deps {
+	struct config_def_deps *prev;	/* outer expansion */
+	int uncacheable;
+	unsigned int envs_count;
+	unsigned int envs_alloc;
+	struct config_def_env *envs;
+};
+
+struct config_def {
+	struct list_head list;		/* most recently used first */
+	snd_config_t *root;
+	char *base;
+	char *name;
+	unsigned int generation;
+	snd_config_t *result;		/* NULL if the definition does not exist */
+	struct config_def_deps deps;
+};
+
+static TLS_PFX struct config_def_deps *config_def_deps;
+static unsigned long config_def_hits, config_def_misses;
+
+static void config_def_deps_free(struct config_def_deps *deps)
+{
+	unsigned int i;
+
+	for (i = 0; i < deps->envs_count; i++) {
+		free(deps->envs[i].var);
+		free(deps->envs[i].value);
+	}
+	free(deps->envs);
+}
+
+static void config_def_deps_add_env(struct config_def_deps *deps,
+				    const char *var, const char *value)
+{
+	struct config_def_env *env;
+	unsigned int i;
+
+	for (i = 0; i < deps->envs_count; i++)
+		if (strcmp(deps->envs[i].var, var) == 0)
+			return;
+	if (deps->envs_count >= deps->envs_alloc) {
+		unsigned int alloc = deps->envs_alloc ? deps->envs_alloc * 2 : 4;
+		env = realloc(deps->envs, alloc * sizeof(*env));
+		if (env == NULL)
+			goto __nomem;
+		deps->envs = env;
+		deps->envs_alloc = alloc;
+	}
+	env = &deps->envs[deps->envs_count];
+	env->var = strdup(var);
+	env->value = value ? strdup(value) : NULL;
+	if (env->var == NULL || (value && env->value == NULL)) {
+		free(env->var);
+		free(env->value);
+		goto __nomem;
+	}
+	deps->envs_count++;
+	return;
+      __nomem:
+	deps->uncacheable = 1;
+}
+
+static void config_def_deps_merge(struct config_def_deps *dst,
+				  const struct config_def_deps *src)
+{
+	unsigned int i;
+
+	if (dst == NULL)
+		return;
+	if (src->uncacheable)
+		dst->uncacheable = 1;
+	for (i = 0; i < src->envs_count && !dst->uncacheable; i++)
+		config_def_deps_add_env(dst, src->envs[i].var, src->envs[i].value);
+}
+
+/* record what the function evaluated for the current expansion depends on */
+static void config_def_record(const char *lib, const char *func_name,
+			      snd_config_t *src)
+{
+	struct config_def_deps *deps = config_def_deps;
+	snd_config_iterator_t i, next;
+	snd_config_t *n;
+	const char *var;
+
+	if (deps == NULL || deps->uncacheable)
+		return;
+	if (lib)
+		goto __uncacheable;
+	if (strcmp(func_name, "snd_func_concat") == 0 ||
+	    strcmp(func_name, "snd_func_iadd") == 0 ||
+	    strcmp(func_name, "snd_func_imul") == 0 ||
+	    strcmp(func_name, "snd_func_datadir") == 0)
+		return;
+	/* refer reads the tree, unless it loads a file */
+	if (strcmp(func_name, "snd_func_refer") == 0) {
+		if (snd_config_search(src, "file", &n) >= 0)
+			goto __uncacheable;
+		return;
+	}
+	if (strcmp(func_name, "snd_func_getenv") == 0 ||
+	    strcmp(func_name, "snd_func_igetenv") == 0) {
+		if (snd_config_search(src, "vars", &n) < 0 ||
+		    snd_config_get_type(n) != SND_CONFIG_TYPE_COMPOUND)
+			return;
+		snd_config_for_each(i, next, n) {
+			if (snd_config_get_string(snd_config_iterator_entry(i), &var) < 0)
+				goto __uncacheable;
+			config_def_deps_add_env(deps, var, getenv(var));
+		}
+		return;
+	}
+      __uncacheable:
+	deps->uncacheable = 1;
+}
+
+static void config_def_free(struct snd_config_arena *arena, struct config_def *def)
+{
+	list_del(&def->list);
+	arena->defs_count--;
+	if (def->result)
+		snd_config_delete(def->result);
+	config_def_deps_free(&def->deps);
+	free(def->base);
+	free(def->name);
+	free(def);
+}
+
+static void config_defs_free(struct snd_config_arena *arena)
+{
+	while (!list_empty(&arena->defs))
+		config_def_free(arena, list_entry(arena->defs.next, struct config_def, list));
+}
+
+static int config_def_valid(struct snd_config_arena *arena, const struct config_def *def)
+{
+	const char *value;
+	unsigned int i;
+
+	if (def->generation != arena->generation)
+		return 0;
+	for (i = 0; i < def->deps.envs_count; i++) {
+		value = getenv(def->deps.envs[i].var);
+		if (value == NULL || def->deps.envs[i].value == NULL) {
+			if (value != def->deps.envs[i].value)
+				return 0;
+		} else if (strcmp(value, def->deps.envs[i].value) != 0) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static struct config_def *config_def_find(snd_config_t *root, const char *base,
+					  const char *name)
+{
+	struct snd_config_arena *arena = root->arena;
+	struct list_head *pos;
+	struct config_def *def;
+
+	list_for_each(pos, &arena->defs) {
+		def = list_entry(pos, struct config_def, list);
+		if (def->root != root || strcmp(def->name, name) != 0)
+			continue;
+		if (base == NULL || def->base == NULL) {
+			if (base != def->base)
+				continue;
+		} else if (strcmp(base, def->base) != 0) {
+			continue;
+		}
+		if (!config_def_valid(arena, def)) {
+			config_def_free(arena, def);
+			return NULL;
+		}
+		list_del(&def->list);
+		list_add(&def->list, &arena->defs);
+		return def;
+	}
+	return NULL;
+}
+
+static void config_def_store(snd_config_t *root, const char *base, const char *name,
+			     snd_config_t *result, struct config_def_deps *deps)
+{
+	struct snd_config_arena *arena = root->arena;
+	struct config_def *def;
+
+	def = calloc(1, sizeof(*def));
+	if (def == NULL)
+		return;
+	def->name = strdup(name);
+	def->base = base ? strdup(base) : NULL;
+	if (def->name == NULL || (base && def->base == NULL) ||
+	    (result && snd_config_copy(&def->result, result) < 0)) {
+		free(def->name);
+		free(def->base);
+		free(def);
+		return;
+	}
+	def->root = root;
+	def->generation = arena->generation;
+	def->deps = *deps;
+	def->deps.prev = NULL;
+	deps->envs = NULL;
+	deps->envs_count = deps->envs_alloc = 0;
+	if (arena->defs_count >= CONFIG_DEFS_MAX)
+		config_def_free(arena, list_entry(arena->defs.prev, struct config_def, list));
+	list_add(&def->list, &arena->defs);
+	arena->defs_count++;
+}
+
 static int _snd_config_evaluate(snd_config_t *src,
 				snd_config_t *root,
 				snd_config_t **dst ATTRIBUTE_UNUSED,
 				snd_config_walk_pass_t pass,
 				snd_config_expand_fcn_t fcn ATTRIBUTE_UNUSED,
+				struct snd_config_arena *arena ATTRIBUTE_UNUSED,
 				void *private_data)
 {
 	int err;
@@ -5199,6 +5938,7 @@ static int _snd_config_evaluate(snd_config_t *src,
 			snd_config_delete(func_conf);
 		if (err >= 0) {
 			snd_config_t *eval;
+			config_def_record(lib, func_name, src);
 			err = func(&eval, root, src, private_data);
 			if (err < 0)
 				SNDERR("function %s returned error: %s", func_name, snd_strerror(err));
@@ -5231,7 +5971,7 @@ int snd_config_evaluate(snd_config_t *config, snd_config_t *root,
 {
 	/* FIXME: Only in place evaluation is currently implemented */
 	assert(result == NULL);
-	return snd_config_walk(config, root, result, _snd_config_evaluate, NULL, private_data);
+	return snd_config_walk(config, root, result, _snd_config_evaluate, NULL, NULL, private_data);
 }
 
 static int load_defaults(snd_config_t *subs, snd_config_t *defs)
@@ -5657,7 +6397,7 @@ int snd_config_expand_custom(snd_config_t *config, snd_config_t *root,
 	snd_config_t *res;
 	int err;
 
-	err = snd_config_walk(config, root, &res, _snd_config_expand, fcn, private_data);
+	err = snd_config_walk_copy(config, root, &res, _snd_config_expand, fcn, private_data);
 	if (err < 0) {
 		SNDERR("Expand error (walk): %s", snd_strerror(err));
 		return err;
@@ -5716,7 +6456,7 @@ int snd_config_expand(snd_config_t *config, snd_config_t *root, const char *args
 			SNDERR("Args evaluate error: %s", snd_strerror(err));
 			goto _end;
 		}
-		err = snd_config_walk(config, root, &res, _snd_config_expand, _snd_config_expand_vars, subs);
+		err = snd_config_walk_copy(config, root, &res, _snd_config_expand, _snd_config_expand_vars, subs);
 		if (err < 0) {
 			SNDERR("Expand error (walk): %s", snd_strerror(err));
 			goto _end;
@@ -5756,6 +6496,12 @@ int snd_config_expand(snd_config_t *config, snd_config_t *root, const char *args
  * In any case, \a result is a new node that must be freed by the
  * caller.
  *
+ * When \a config is a top level node, the expanded definitions are
+ * cached until the tree changes, so repeated searches for the same
+ * \a name only copy the cached result.  Expansions evaluating functions
+ * which depend on the hardware or the private data are not cached, see
+ * #snd_config_search_definition_stats.
+ *
  * \par Errors:
  * <dl>
  * <dt>-ENOENT<dd>An id in \a key or an alias id does not exist.
@@ -5770,9 +6516,11 @@ int snd_config_search_definition(snd_config_t *config,
 				 snd_config_t **result)
 {
 	snd_config_t *conf;
+	struct config_def *def;
+	struct config_def_deps deps;
 	char *key;
 	const char *args = strchr(name, ':');
-	int err;
+	int err, cache;
 	if (args) {
 		args++;
 		key = alloca(args - name);
@@ -5786,16 +6534,68 @@ int snd_config_search_definition(snd_config_t *config,
 	 *  and the key starts from root given by the 'config' parameter
 	 */
 	snd_config_lock();
+	cache = config->parent == NULL && config->arena != NULL;
+	if (cache) {
+		def = config_def_find(config, base, name);
+		if (def) {
+			config_def_hits++;
+			config_def_deps_merge(config_def_deps, &def->deps);
+			if (def->result)
+				err = snd_config_copy(result, def->result);
+			else
+				err = -ENOENT;
+			snd_config_unlock();
+			return err;
+		}
+		config_def_misses++;
+	}
 	err = snd_config_search_alias_hooks(config, strchr(key, '.') ? NULL : base, key, &conf);
 	if (err < 0) {
+		if (cache && err == -ENOENT) {
+			memset(&deps, 0, sizeof(deps));
+			config_def_store(config, base, name, NULL, &deps);
+		}
 		snd_config_unlock();
 		return err;
 	}
+	if (cache) {
+		memset(&deps, 0, sizeof(deps));
+		deps.prev = config_def_deps;
+		config_def_deps = &deps;
+	}
 	err = snd_config_expand(conf, config, args, NULL, result);
+	if (cache) {
+		config_def_deps = deps.prev;
+		config_def_deps_merge(deps.prev, &deps);
+		if (err >= 0 && !deps.uncacheable)
+			config_def_store(config, base, name, *result, &deps);
+		config_def_deps_free(&deps);
+	}
 	snd_config_unlock();
 	return err;
 }
 
+/**
+ * \brief Returns the statistics of the expanded definitions cache.
+ * \param[out] hits The number of #snd_config_search_definition calls
+ *                  served from the cache.
+ * \param[out] misses The number of calls which expanded the definition.
+ * \return Zero if successful, otherwise a negative error code.
+ *
+ * Either pointer may be \c NULL.  This is a debugging aid, the counters
+ * are global for the process.
+ */
+int snd_config_search_definition_stats(unsigned long *hits, unsigned long *misses)
+{
+	snd_config_lock();
+	if (hits)
+		*hits = config_def_hits;
+	if (misses)
+		*misses = config_def_misses;
+	snd_config_unlock();
+	return 0;
+}
+
 #ifndef DOC_HIDDEN
 void snd_config_set_hop(snd_config_t *conf, int hop)
 {
@@ -32,7 +32,15 @@
 #include <string.h>
 #include <ctype.h>
 #include <fcntl.h>
+#include <dirent.h>
+#include <stdbool.h>
 #include <sys/ioctl.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 #ifndef DOC_HIDDEN
 #define SND_FILE_CONTROL	ALSA_DEVICE_DIRECTORY "controlC%i"
@@ -58,11 +66,426 @@ static int snd_card_load2(const char *control)
 	}
 }
 
+#ifdef HAVE_SYS_INOTIFY_H
+/*
+ * Registry of the cards present in the system.
+ *
+ * The control devices are listed by one scan of the device directory
+ * and the card info of each is read once.  An inotify watch on the
+ * directory marks the cards whose control device was created, removed
+ * or changed its attributes (permissions), so only those are probed
+ * again.  While the device directory does not exist, its parent is
+ * watched for its creation and no card is present.  Without inotify or
+ * with the aload devices, which load the drivers on open, the cards
+ * are probed on every call as before.
+ *
+ * The card id can be changed through sysfs without any event on the
+ * device directory, so the card info of a present card is read again
+ * by every lookup which returns or compares it.  The registry saves the
+ * probes of the absent cards.  The inotify descriptor is released by
+ * snd_config_update_free_global().
+ */
+struct snd_card_slot {
+	bool stale;			/* probe again */
+	int err;			/* card index or negative error */
+	unsigned long stamp;		/* changes with every probe */
+	snd_ctl_card_info_t info;
+};
+
+static struct {
+	pid_t pid;			/* owner of the watch (fork) */
+	int fd;				/* inotify, -1 when not watching */
+	bool parent;			/* watching the parent directory */
+	unsigned long stamp;		/* the last probe stamp */
+	struct snd_card_slot cards[SND_MAX_CARDS];
+} card_registry = { .fd = -1 };
+
+#ifdef HAVE_LIBPTHREAD
+static pthread_mutex_t card_registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define card_registry_lock()	pthread_mutex_lock(&card_registry_mutex)
+#define card_registry_unlock()	pthread_mutex_unlock(&card_registry_mutex)
+#else
+#define card_registry_lock()	do { } while (0)
+#define card_registry_unlock()	do { } while (0)
+#endif
+
+#define CONTROL_PREFIX		"controlC"
+
+static int card_registry_index(const char *name)
+{
+	const char *p;
+	int card = 0;
+
+	if (strncmp(name, CONTROL_PREFIX, sizeof(CONTROL_PREFIX) - 1))
+		return -1;
+	p = name + sizeof(CONTROL_PREFIX) - 1;
+	if (!isdigit(*p))
+		return -1;
+	for (; isdigit(*p); p++) {
+		card = card * 10 + *p - '0';
+		if (card >= SND_MAX_CARDS)
+			return -1;
+	}
+	return *p ? -1 : card;
+}
+
+#ifdef SUPPORT_ALOAD
+static bool card_registry_aload(void)
+{
+	struct dirent *d;
+	bool found = false;
+	DIR *dir;
+
+	dir = opendir(ALOAD_DEVICE_DIRECTORY);
+	if (!dir)
+		return false;
+	while (!found && (d = readdir(dir)) != NULL)
+		found = strncmp(d->d_name, "aloadC", 6) == 0;
+	closedir(dir);
+	return found;
+}
+#endif
+
+/* the device directory without the trailing slash and its parent */
+static void card_registry_dirs(char *dir, size_t size, const char **parent,
+			       const char **base)
+{
+	char *p;
+
+	snd_strlcpy(dir, ALSA_DEVICE_DIRECTORY, size);
+	for (p = dir + strlen(dir); p > dir + 1 && p[-1] == '/'; p--)
+		p[-1] = '\0';
+	p = strrchr(dir, '/');
+	if (p == NULL) {
+		*parent = NULL;
+		*base = dir;
+	} else {
+		*parent = p == dir ? "/" : dir;
+		*p = '\0';
+		*base = p + 1;
+	}
+}
+
+static void card_registry_close(void)
+{
+	close(card_registry.fd);
+	card_registry.fd = -1;
+}
+
+/* start watching and list the control devices */
+static int card_registry_scan(void)
+{
+	char path[PATH_MAX];
+	const char *parent, *base;
+	struct dirent *d;
+	DIR *dir;
+	int card, err;
+
+#ifdef SUPPORT_ALOAD
+	if (card_registry_aload())
+		return -ENXIO;
+#endif
+	card_registry.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (card_registry.fd < 0) {
+		/* no descriptor left (EMFILE, ENFILE) or no inotify:
+		 * probe the cards directly, try again with the next call */
+		return -errno;
+	}
+	card_registry.parent = false;
+	for (card = 0; card < SND_MAX_CARDS; card++) {
+		card_registry.cards[card].stale = false;
+		card_registry.cards[card].err = -ENOENT;
+	}
+	/* the watch is set up first, so no change is missed */
+	if (inotify_add_watch(card_registry.fd, ALSA_DEVICE_DIRECTORY,
+			      IN_CREATE | IN_DELETE | IN_ATTRIB |
+			      IN_MOVED_FROM | IN_MOVED_TO |
+			      IN_DELETE_SELF | IN_MOVE_SELF) < 0) {
+		err = -errno;
+		if (err != -ENOENT)
+			goto _err;
+		card_registry_dirs(path, sizeof(path), &parent, &base);
+		if (parent == NULL ||
+		    inotify_add_watch(card_registry.fd, parent,
+				      IN_CREATE | IN_MOVED_TO |
+				      IN_DELETE_SELF | IN_MOVE_SELF) < 0) {
+			err = -errno;
+			goto _err;
+		}
+		card_registry.parent = true;
+		/* created meanwhile? */
+		if (access(ALSA_DEVICE_DIRECTORY, F_OK) == 0) {
+			err = -EAGAIN;
+			goto _err;
+		}
+		return 0;
+	}
+	dir = opendir(ALSA_DEVICE_DIRECTORY);
+	if (!dir) {
+		err = -errno;
+		goto _err;
+	}
+	while ((d = readdir(dir)) != NULL) {
+		card = card_registry_index(d->d_name);
+		if (card >= 0)
+			card_registry.cards[card].stale = true;
+	}
+	closedir(dir);
+	return 0;
+
+      _err:
+	card_registry_close();
+	return err;
+}
+
+/* mark the cards changed since the last call */
+static int card_registry_events(void)
+{
+	char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+	const struct inotify_event *ev;
+	ssize_t len;
+	char *p;
+	int card;
+
+	while ((len = read(card_registry.fd, buf, sizeof(buf))) > 0) {
+		for (p = buf; p < buf + len; p += sizeof(*ev) + ev->len) {
+			ev = (const struct inotify_event *)p;
+			if (ev->mask & (IN_Q_OVERFLOW | IN_IGNORED |
+					IN_DELETE_SELF | IN_MOVE_SELF))
+				return -ESTALE;
+			if (ev->len == 0)
+				continue;
+			if (card_registry.parent) {
+				char path[PATH_MAX];
+				const char *parent, *base;
+
+				card_registry_dirs(path, sizeof(path), &parent, &base);
+				if (strcmp(ev->name, base) == 0)
+					return -ESTALE;
+				continue;
+			}
+			card = card_registry_index(ev->name);
+			if (card >= 0)
+				card_registry.cards[card].stale = true;
+		}
+	}
+	if (len < 0 && errno != EAGAIN && errno != EINTR)
+		return -errno;
+	return 0;
+}
+
+/* bring the registry up to date, return false when it is not usable */
+static bool card_registry_update(void)
+{
+	if (card_registry.fd >= 0 && card_registry.pid != getpid()) {
+		/* the watch belongs to the parent process */
+		card_registry_close();
+	}
+	if (card_registry.fd >= 0 && card_registry_events() < 0)
+		card_registry_close();
+	if (card_registry.fd < 0) {
+		if (card_registry_scan() < 0)
+			return false;
+		card_registry.pid = getpid();
+	}
+	return true;
+}
+
+static int card_registry_probe(int card, struct snd_card_slot *slot)
+{
+	char control[sizeof(SND_FILE_CONTROL) + 10];
+	int fd;
+
+	sprintf(control, SND_FILE_CONTROL, card);
+	fd = snd_open_device(control, O_RDONLY);
+	if (fd < 0)
+		goto _err;
+	if (ioctl(fd, SNDRV_CTL_IOCTL_CARD_INFO, &slot->info) < 0) {
+		int err = -errno;
+		close(fd);
+		errno = -err;
+		goto _err;
+	}
+	close(fd);
+	return slot->info.card;
+
+      _err:
+#ifdef SUPPORT_ALOAD
+	/* the error of the missing aload device, as snd_card_load1() */
+	return -ENOENT;
+#else
+	return -errno;
+#endif
+}
+
+static struct snd_card_slot *card_registry_slot(int card)
+{
+	struct snd_card_slot *slot = &card_registry.cards[card];
+
+	if (slot->stale) {
+		slot->err = card_registry_probe(card, slot);
+		slot->stamp = ++card_registry.stamp;
+		slot->stale = false;
+	}
+	return slot;
+}
+
+/* read the card info of a present card again (renamed through sysfs) */
+static struct snd_card_slot *card_registry_slot_info(int card)
+{
+	struct snd_card_slot *slot = card_registry_slot(card);
+	snd_ctl_card_info_t info;
+
+	if (slot->err < 0)
+		return slot;
+	info = slot->info;
+	slot->err = card_registry_probe(card, slot);
+	if (slot->err < 0 || memcmp(&info, &slot->info, sizeof(info)))
+		slot->stamp = ++card_registry.stamp;
+	return slot;
+}
+
+/*
+ * Look up a card, return false if the registry is not usable and the
+ * card must be probed directly.  Otherwise *err is the card index or
+ * a negative error code and info is filled for the present card.
+ */
+static bool card_registry_get(int card, int *err, snd_ctl_card_info_t *info)
+{
+	struct snd_card_slot *slot;
+
+	if (card < 0 || card >= SND_MAX_CARDS)
+		return false;
+	card_registry_lock();
+	if (!card_registry_update()) {
+		card_registry_unlock();
+		return false;
+	}
+	slot = info ? card_registry_slot_info(card) : card_registry_slot(card);
+	*err = slot->err;
+	if (info && slot->err >= 0)
+		*info = slot->info;
+	card_registry_unlock();
+	return true;
+}
+
+/* the first present card from the given index, -1 if none */
+static bool card_registry_next(int card, int *next)
+{
+	card_registry_lock();
+	if (!card_registry_update()) {
+		card_registry_unlock();
+		return false;
+	}
+	for (*next = -1; card < SND_MAX_CARDS; card++) {
+		if (card_registry_slot(card)->err >= 0) {
+			*next = card;
+			break;
+		}
+	}
+	card_registry_unlock();
+	return true;
+}
+
+/* the present card with the given id, -ENODEV if none */
+static bool card_registry_find_id(const char *id, int *card)
+{
+	struct snd_card_slot *slot;
+	int i;
+
+	card_registry_lock();
+	if (!card_registry_update()) {
+		card_registry_unlock();
+		return false;
+	}
+	*card = -ENODEV;
+	for (i = 0; i < SND_MAX_CARDS; i++) {
+		slot = card_registry_slot_info(i);
+		if (slot->err >= 0 && !strcmp((const char *)slot->info.id, id)) {
+			*card = i;
+			break;
+		}
+	}
+	card_registry_unlock();
+	return true;
+}
+
+#ifndef DOC_HIDDEN
+/*
+ * Return the probe stamp of a present card.  The stamp changes when the
+ * control device of the card is created, removed or changed, or when its
+ * card info changes, so the callers can keep data derived from the card
+ * until it changes.
+ * -ENOSYS means the card changes cannot be tracked.
+ */
+int snd_card_stamp(int card, unsigned long *stamp)
+{
+	struct snd_card_slot *slot;
+	int err;
+
+	if (card < 0 || card >= SND_MAX_CARDS)
+		return -EINVAL;
+	card_registry_lock();
+	if (!card_registry_update()) {
+		card_registry_unlock();
+		return -ENOSYS;
+	}
+	slot = card_registry_slot_info(card);
+	err = slot->err < 0 ? slot->err : 0;
+	*stamp = slot->stamp;
+	card_registry_unlock();
+	return err;
+}
+
+/* stop watching, the next lookup scans the device directory again */
+void snd_card_registry_cleanup(void)
+{
+	card_registry_lock();
+	if (card_registry.fd >= 0)
+		card_registry_close();
+	card_registry_unlock();
+}
+#endif
+#else
+static bool card_registry_get(int card ATTRIBUTE_UNUSED,
+			      int *err ATTRIBUTE_UNUSED,
+			      snd_ctl_card_info_t *info ATTRIBUTE_UNUSED)
+{
+	return false;
+}
+
+static bool card_registry_next(int card ATTRIBUTE_UNUSED,
+			       int *next ATTRIBUTE_UNUSED)
+{
+	return false;
+}
+
+static bool card_registry_find_id(const char *id ATTRIBUTE_UNUSED,
+				  int *card ATTRIBUTE_UNUSED)
+{
+	return false;
+}
+
+#ifndef DOC_HIDDEN
+int snd_card_stamp(int card ATTRIBUTE_UNUSED,
+		   unsigned long *stamp ATTRIBUTE_UNUSED)
+{
+	return -ENOSYS;
+}
+
+void snd_card_registry_cleanup(void)
+{
+}
+#endif
+#endif /* HAVE_SYS_INOTIFY_H */
+
 static int snd_card_load1(int card)
 {
 	int res;
 	char control[sizeof(SND_FILE_CONTROL) + 10];
 
+	if (card_registry_get(card, &res, NULL))
+		return res;
 	sprintf(control, SND_FILE_CONTROL, card);
 	res = snd_card_load2(control);
 #ifdef SUPPORT_ALOAD
@@ -113,6 +536,8 @@ int snd_card_next(int *rcard)
 		return -EINVAL;
 	card = *rcard;
 	card = card < 0 ? 0 : card + 1;
+	if (card_registry_next(card, rcard))
+		return 0;
 	for (; card < SND_MAX_CARDS; card++) {
 		if (snd_card_load(card)) {
 			*rcard = card;
@@ -161,6 +586,8 @@ int snd_card_get_index(const char *string)
 		/* We got a device name */
 		return snd_card_load2(string);
 	/* We got in ID */
+	if (card_registry_find_id(string, &card))
+		return card;
 	for (card = 0; card < SND_MAX_CARDS; card++) {
 #ifdef SUPPORT_ALOAD
 		if (! snd_card_load(card))
@@ -197,13 +624,18 @@ int snd_card_get_name(int card, char **name)
 	
 	if (name == NULL)
 		return -EINVAL;
-	if ((err = snd_ctl_hw_open(&handle, NULL, card, 0)) < 0)
-		return err;
-	if ((err = snd_ctl_card_info(handle, &info)) < 0) {
+	if (card_registry_get(card, &err, &info)) {
+		if (err < 0)
+			return err;
+	} else {
+		if ((err = snd_ctl_hw_open(&handle, NULL, card, 0)) < 0)
+			return err;
+		if ((err = snd_ctl_card_info(handle, &info)) < 0) {
+			snd_ctl_close(handle);
+			return err;
+		}
 		snd_ctl_close(handle);
-		return err;
 	}
-	snd_ctl_close(handle);
 	*name = strdup((const char *)info.name);
 	if (*name == NULL)
 		return -ENOMEM;
@@ -227,13 +659,18 @@ int snd_card_get_longname(int card, char **name)
 	
 	if (name == NULL)
 		return -EINVAL;
-	if ((err = snd_ctl_hw_open(&handle, NULL, card, 0)) < 0)
-		return err;
-	if ((err = snd_ctl_card_info(handle, &info)) < 0) {
+	if (card_registry_get(card, &err, &info)) {
+		if (err < 0)
+			return err;
+	} else {
+		if ((err = snd_ctl_hw_open(&handle, NULL, card, 0)) < 0)
+			return err;
+		if ((err = snd_ctl_card_info(handle, &info)) < 0) {
+			snd_ctl_close(handle);
+			return err;
+		}
 		snd_ctl_close(handle);
-		return err;
 	}
-	snd_ctl_close(handle);
 	*name = strdup((const char *)info.longname);
 	if (*name == NULL)
 		return -ENOMEM;
@@ -96,6 +96,7 @@ struct _snd_hctl {
 
 /* make local functions really local */
 #define snd_ctl_new	snd1_ctl_new
+#define snd_card_stamp	snd1_card_stamp
 
 int snd_ctl_new(snd_ctl_t **ctlp, snd_ctl_type_t type, const char *name, int mode);
 int _snd_ctl_poll_descriptor(snd_ctl_t *ctl);
@@ -103,6 +104,7 @@ int _snd_ctl_poll_descriptor(snd_ctl_t *ctl);
 int snd_ctl_hw_open(snd_ctl_t **handle, const char *name, int card, int mode);
 int snd_ctl_shm_open(snd_ctl_t **handlep, const char *name, const char *sockname, const char *sname, int mode);
 int snd_ctl_async(snd_ctl_t *ctl, int sig, pid_t pid);
+int snd_card_stamp(int card, unsigned long *stamp);
 
 #define CTLINABORT(x) ((x)->nonblock == 2)
 
@@ -32,6 +32,7 @@
 #include <stdarg.h>
 #include <unistd.h>
 #include <string.h>
+#include <poll.h>
 
 #ifndef DOC_HIDDEN
 #if 0
@@ -77,30 +78,175 @@ typedef struct {
 		size_t channel_map_items;
 		size_t channel_map_alloc;
 		long *channel_map;
+		unsigned int cache_gen;		/* valid if equal to priv->cache_gen */
+		snd_ctl_elem_value_t *cache;	/* last known child value */
 	} *controls;
 	unsigned int event_mask;
+	int cacheable;
 } snd_ctl_map_t;
 
+typedef struct {
+	snd_ctl_map_t *map;
+	struct snd_ctl_map_ctl *mctl;
+} snd_ctl_map_ref_t;
+
+typedef struct {
+	unsigned int key;
+	unsigned int index;		/* item index + 1, zero for a free slot */
+} snd_ctl_remap_slot_t;
+
+/*
+ * Open addressing index of the item arrays. The items are verified after
+ * the lookup, so the slots of the changed numids are left in place.
+ */
+typedef struct {
+	unsigned int size;		/* power of two */
+	unsigned int used;
+	snd_ctl_remap_slot_t *slots;
+} snd_ctl_remap_hash_t;
+
 typedef struct {
 	snd_ctl_t *child;
+	int subscribed;
+	unsigned int cache_gen;		/* bumped to drop all cached values */
 	int numid_remap_active;
 	unsigned int numid_app_last;
 	size_t numid_items;
 	size_t numid_alloc;
 	snd_ctl_numid_t *numid;
 	snd_ctl_numid_t numid_temp;
+	snd_ctl_remap_hash_t numid_child_hash;
+	snd_ctl_remap_hash_t numid_app_hash;
 	size_t remap_items;
 	size_t remap_alloc;
 	snd_ctl_remap_id_t *remap;
+	snd_ctl_remap_hash_t remap_child_numid_hash;
+	snd_ctl_remap_hash_t remap_child_id_hash;
+	snd_ctl_remap_hash_t remap_app_numid_hash;
+	snd_ctl_remap_hash_t remap_app_id_hash;
 	size_t map_items;
 	size_t map_alloc;
 	snd_ctl_map_t *map;
+	snd_ctl_remap_hash_t map_numid_hash;
+	snd_ctl_remap_hash_t map_id_hash;
+	size_t map_refs_items;
+	snd_ctl_map_ref_t *map_refs;
+	snd_ctl_remap_hash_t map_ref_numid_hash;
+	snd_ctl_remap_hash_t map_ref_id_hash;
 	size_t map_read_queue_head;
 	size_t map_read_queue_tail;
 	snd_ctl_map_t **map_read_queue;
 } snd_ctl_remap_t;
 #endif
 
+static unsigned int remap_hash_numid(unsigned int numid)
+{
+	return numid * 2654435761U;
+}
+
+static unsigned int remap_hash_id(const snd_ctl_elem_id_t *id)
+{
+	unsigned int hash = 2166136261U;
+	size_t i;
+
+	hash = (hash ^ id->iface) * 16777619U;
+	hash = (hash ^ id->device) * 16777619U;
+	hash = (hash ^ id->subdevice) * 16777619U;
+	hash = (hash ^ id->index) * 16777619U;
+	for (i = 0; i < sizeof(id->name) && id->name[i]; i++)
+		hash = (hash ^ id->name[i]) * 16777619U;
+	/* the low bits select the slot, mix the upper bits in */
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bU;
+	hash ^= hash >> 13;
+	return hash;
+}
+
+static void remap_hash_put(snd_ctl_remap_hash_t *hash, unsigned int key,
+			   unsigned int index)
+{
+	unsigned int mask = hash->size - 1, pos;
+
+	for (pos = key & mask; hash->slots[pos].index; pos = (pos + 1) & mask)
+		;
+	hash->slots[pos].key = key;
+	hash->slots[pos].index = index;
+	hash->used++;
+}
+
+/* make room for one more slot, so that the following put cannot fail */
+static int remap_hash_reserve(snd_ctl_remap_hash_t *hash)
+{
+	snd_ctl_remap_slot_t *slots;
+	unsigned int size, pos;
+
+	if ((hash->used + 1) * 2 > hash->size) {
+		slots = hash->slots;
+		size = hash->size;
+		hash->size = size ? size * 2 : 64;
+		hash->slots = calloc(hash->size, sizeof(*slots));
+		if (hash->slots == NULL) {
+			hash->slots = slots;
+			hash->size = size;
+			return -ENOMEM;
+		}
+		hash->used = 0;
+		for (pos = 0; pos < size; pos++)
+			if (slots[pos].index)
+				remap_hash_put(hash, slots[pos].key, slots[pos].index);
+		free(slots);
+	}
+	return 0;
+}
+
+static int remap_hash_insert(snd_ctl_remap_hash_t *hash, unsigned int key,
+			     size_t index)
+{
+	int err = remap_hash_reserve(hash);
+
+	if (err < 0)
+		return err;
+	remap_hash_put(hash, key, index + 1);
+	return 0;
+}
+
+static snd_ctl_remap_slot_t *remap_hash_scan(snd_ctl_remap_hash_t *hash,
+					     unsigned int key, unsigned int *pos)
+{
+	snd_ctl_remap_slot_t *slot;
+
+	for (;;) {
+		slot = &hash->slots[*pos];
+		if (!slot->index)
+			return NULL;
+		if (slot->key == key)
+			return slot;
+		*pos = (*pos + 1) & (hash->size - 1);
+	}
+}
+
+static snd_ctl_remap_slot_t *remap_hash_first(snd_ctl_remap_hash_t *hash,
+					      unsigned int key, unsigned int *pos)
+{
+	if (hash->size == 0)
+		return NULL;
+	*pos = key & (hash->size - 1);
+	return remap_hash_scan(hash, key, pos);
+}
+
+static snd_ctl_remap_slot_t *remap_hash_next(snd_ctl_remap_hash_t *hash,
+					     unsigned int key, unsigned int *pos)
+{
+	*pos = (*pos + 1) & (hash->size - 1);
+	return remap_hash_scan(hash, key, pos);
+}
+
+#ifndef DOC_HIDDEN
+#define remap_hash_for_each(hash, key, pos, slot) \
+	for (slot = remap_hash_first(hash, key, &pos); slot; \
+	     slot = remap_hash_next(hash, key, &pos))
+#endif
+
 static snd_ctl_numid_t *remap_numid_temp(snd_ctl_remap_t *priv, unsigned int numid)
 {
 	priv->numid_temp.numid_child = numid;
@@ -110,16 +256,19 @@ static snd_ctl_numid_t *remap_numid_temp(snd_ctl_remap_t *priv, unsigned int num
 
 static snd_ctl_numid_t *remap_find_numid_app(snd_ctl_remap_t *priv, unsigned int numid_app)
 {
-	snd_ctl_numid_t *numid;
-	size_t count;
+	snd_ctl_remap_slot_t *slot;
+	snd_ctl_numid_t *numid, *found = NULL;
+	unsigned int key, pos;
 
 	if (!priv->numid_remap_active)
 		return remap_numid_temp(priv, numid_app);
-	numid = priv->numid;
-	for (count = priv->numid_items; count > 0; count--, numid++)
-		if (numid_app == numid->numid_app)
-			return numid;
-	return NULL;
+	key = remap_hash_numid(numid_app);
+	remap_hash_for_each(&priv->numid_app_hash, key, pos, slot) {
+		numid = &priv->numid[slot->index - 1];
+		if (numid_app == numid->numid_app && (!found || numid < found))
+			found = numid;
+	}
+	return found;
 }
 
 static snd_ctl_numid_t *remap_numid_new(snd_ctl_remap_t *priv, unsigned int numid_child,
@@ -135,6 +284,16 @@ static snd_ctl_numid_t *remap_numid_new(snd_ctl_remap_t *priv, unsigned int numi
 		priv->numid_alloc += 16;
 		priv->numid = numid;
 	}
+	/* the slots must not point past the items when an insert fails */
+	if ((numid_child > 0 && remap_hash_reserve(&priv->numid_child_hash) < 0) ||
+	    remap_hash_reserve(&priv->numid_app_hash) < 0)
+		return NULL;
+	/* the map controls have no child numid */
+	if (numid_child > 0)
+		remap_hash_put(&priv->numid_child_hash, remap_hash_numid(numid_child),
+			       priv->numid_items + 1);
+	remap_hash_put(&priv->numid_app_hash, remap_hash_numid(numid_app),
+		       priv->numid_items + 1);
 	numid = &priv->numid[priv->numid_items++];
 	numid->numid_child = numid_child;
 	numid->numid_app = numid_app;
@@ -160,87 +319,155 @@ static snd_ctl_numid_t *remap_numid_child_new(snd_ctl_remap_t *priv, unsigned in
 
 static snd_ctl_numid_t *remap_find_numid_child(snd_ctl_remap_t *priv, unsigned int numid_child)
 {
-	snd_ctl_numid_t *numid;
-	size_t count;
+	snd_ctl_remap_slot_t *slot;
+	snd_ctl_numid_t *numid, *found = NULL;
+	unsigned int key, pos;
 
 	if (!priv->numid_remap_active)
 		return remap_numid_temp(priv, numid_child);
-	numid = priv->numid;
-	for (count = priv->numid_items; count > 0; count--, numid++)
-		if (numid_child == numid->numid_child)
-			return numid;
+	key = remap_hash_numid(numid_child);
+	remap_hash_for_each(&priv->numid_child_hash, key, pos, slot) {
+		numid = &priv->numid[slot->index - 1];
+		if (numid_child == numid->numid_child && (!found || numid < found))
+			found = numid;
+	}
+	if (found)
+		return found;
 	return remap_numid_child_new(priv, numid_child);
 }
 
-static snd_ctl_remap_id_t *remap_find_id_child(snd_ctl_remap_t *priv, snd_ctl_elem_id_t *id)
+static snd_ctl_remap_id_t *remap_find_rid(snd_ctl_remap_t *priv,
+					  snd_ctl_remap_hash_t *numid_hash,
+					  snd_ctl_remap_hash_t *id_hash,
+					  snd_ctl_elem_id_t *id, int app)
 {
-	size_t count;
-	snd_ctl_remap_id_t *rid;
+	snd_ctl_remap_slot_t *slot;
+	snd_ctl_remap_id_t *rid, *found = NULL;
+	snd_ctl_elem_id_t *rid_id;
+	unsigned int key, pos;
 
 	if (id->numid > 0) {
-		rid = priv->remap;
-		for (count = priv->remap_items; count > 0; count--, rid++)
-			if (id->numid == rid->id_child.numid)
-				return rid;
+		key = remap_hash_numid(id->numid);
+		remap_hash_for_each(numid_hash, key, pos, slot) {
+			rid = &priv->remap[slot->index - 1];
+			rid_id = app ? &rid->id_app : &rid->id_child;
+			if (id->numid == rid_id->numid && (!found || rid < found))
+				found = rid;
+		}
+		if (found)
+			return found;
 	}
-	rid = priv->remap;
-	for (count = priv->remap_items; count > 0; count--, rid++)
-		if (snd_ctl_elem_id_compare_set(id, &rid->id_child) == 0)
-			return rid;
-	return NULL;
+	key = remap_hash_id(id);
+	remap_hash_for_each(id_hash, key, pos, slot) {
+		rid = &priv->remap[slot->index - 1];
+		rid_id = app ? &rid->id_app : &rid->id_child;
+		if (snd_ctl_elem_id_compare_set(id, rid_id) == 0 &&
+		    (!found || rid < found))
+			found = rid;
+	}
+	return found;
+}
+
+static snd_ctl_remap_id_t *remap_find_id_child(snd_ctl_remap_t *priv, snd_ctl_elem_id_t *id)
+{
+	return remap_find_rid(priv, &priv->remap_child_numid_hash,
+			      &priv->remap_child_id_hash, id, 0);
 }
 
 static snd_ctl_remap_id_t *remap_find_id_app(snd_ctl_remap_t *priv, snd_ctl_elem_id_t *id)
 {
-	size_t count;
-	snd_ctl_remap_id_t *rid;
+	return remap_find_rid(priv, &priv->remap_app_numid_hash,
+			      &priv->remap_app_id_hash, id, 1);
+}
 
-	if (id->numid > 0) {
-		rid = priv->remap;
-		for (count = priv->remap_items; count > 0; count--, rid++)
-			if (id->numid == rid->id_app.numid)
-				return rid;
+static int remap_rid_set_numid(snd_ctl_remap_t *priv, snd_ctl_remap_id_t *rid,
+			       unsigned int numid_child, unsigned int numid_app)
+{
+	size_t index = rid - priv->remap;
+	int err;
+
+	if (numid_child > 0 && numid_child != rid->id_child.numid) {
+		err = remap_hash_insert(&priv->remap_child_numid_hash,
+					remap_hash_numid(numid_child), index);
+		if (err < 0)
+			return err;
 	}
-	rid = priv->remap;
-	for (count = priv->remap_items; count > 0; count--, rid++)
-		if (snd_ctl_elem_id_compare_set(id, &rid->id_app) == 0)
-			return rid;
-	return NULL;
+	if (numid_app > 0 && numid_app != rid->id_app.numid) {
+		err = remap_hash_insert(&priv->remap_app_numid_hash,
+					remap_hash_numid(numid_app), index);
+		if (err < 0)
+			return err;
+	}
+	rid->id_child.numid = numid_child;
+	rid->id_app.numid = numid_app;
+	return 0;
 }
 
 static snd_ctl_map_t *remap_find_map_numid(snd_ctl_remap_t *priv, unsigned int numid)
 {
-	size_t count;
-	snd_ctl_map_t *map;
+	snd_ctl_remap_slot_t *slot;
+	snd_ctl_map_t *map, *found = NULL;
+	unsigned int key, pos;
 
 	if (numid == 0)
 		return NULL;
-	map = priv->map;
-	for (count = priv->map_items; count > 0; count--, map++) {
-		if (numid == map->map_id.numid)
-			return map;
+	key = remap_hash_numid(numid);
+	remap_hash_for_each(&priv->map_numid_hash, key, pos, slot) {
+		map = &priv->map[slot->index - 1];
+		if (numid == map->map_id.numid && (!found || map < found))
+			found = map;
 	}
-	return NULL;
+	return found;
 }
 
 static snd_ctl_map_t *remap_find_map_id(snd_ctl_remap_t *priv, snd_ctl_elem_id_t *id)
 {
-	size_t count;
-	snd_ctl_map_t *map;
+	snd_ctl_remap_slot_t *slot;
+	snd_ctl_map_t *map, *found = NULL;
+	unsigned int key, pos;
 
 	if (id->numid > 0)
 		return remap_find_map_numid(priv, id->numid);
-	map = priv->map;
-	for (count = priv->map_items; count > 0; count--, map++)
-		if (snd_ctl_elem_id_compare_set(id, &map->map_id) == 0)
-			return map;
-	return NULL;
+	key = remap_hash_id(id);
+	remap_hash_for_each(&priv->map_id_hash, key, pos, slot) {
+		map = &priv->map[slot->index - 1];
+		if (snd_ctl_elem_id_compare_set(id, &map->map_id) == 0 &&
+		    (!found || map < found))
+			found = map;
+	}
+	return found;
+}
+
+static int remap_mctl_set_numid(snd_ctl_remap_t *priv, struct snd_ctl_map_ctl *mctl,
+				unsigned int numid)
+{
+	snd_ctl_remap_slot_t *slot;
+	unsigned int pos;
+	size_t index;
+	int err;
+
+	if (numid > 0 && numid != mctl->id_child.numid) {
+		/* the references are created after the config is parsed */
+		remap_hash_for_each(&priv->map_ref_id_hash, remap_hash_id(&mctl->id_child), pos, slot) {
+			index = slot->index - 1;
+			if (priv->map_refs[index].mctl != mctl)
+				continue;
+			err = remap_hash_insert(&priv->map_ref_numid_hash,
+						remap_hash_numid(numid), index);
+			if (err < 0)
+				return err;
+			break;
+		}
+	}
+	mctl->id_child.numid = numid;
+	return 0;
 }
 
 static int remap_id_to_child(snd_ctl_remap_t *priv, snd_ctl_elem_id_t *id, snd_ctl_remap_id_t **_rid)
 {
 	snd_ctl_remap_id_t *rid;
 	snd_ctl_numid_t *numid;
+	int err;
 
 	debug_id(id, "%s enter\n", __func__);
 	rid = remap_find_id_app(priv, id);
@@ -248,8 +475,10 @@ static int remap_id_to_child(snd_ctl_remap_t *priv, snd_ctl_elem_id_t *id, snd_c
 		if (rid->id_app.numid == 0) {
 			numid = remap_find_numid_app(priv, id->numid);
 			if (numid) {
-				rid->id_child.numid = numid->numid_child;
-				rid->id_app.numid = numid->numid_app;
+				err = remap_rid_set_numid(priv, rid, numid->numid_child,
+							  numid->numid_app);
+				if (err < 0)
+					return err;
 			}
 		}
 		*id = rid->id_child;
@@ -276,8 +505,9 @@ static int remap_id_to_app(snd_ctl_remap_t *priv, snd_ctl_elem_id_t *id, snd_ctl
 			numid = remap_numid_child_new(priv, id->numid);
 			if (numid == NULL)
 				return -EIO;
-			rid->id_child.numid = numid->numid_child;
-			rid->id_app.numid = numid->numid_app;
+			if (remap_rid_set_numid(priv, rid, numid->numid_child,
+						numid->numid_app) < 0)
+				return -ENOMEM;
 		}
 		*id = rid->id_app;
 	} else {
@@ -291,6 +521,11 @@ static int remap_id_to_app(snd_ctl_remap_t *priv, snd_ctl_elem_id_t *id, snd_ctl
 	return err;
 }
 
+static void remap_hash_free(snd_ctl_remap_hash_t *hash)
+{
+	free(hash->slots);
+}
+
 static void remap_free(snd_ctl_remap_t *priv)
 {
 	size_t idx1, idx2;
@@ -298,14 +533,27 @@ static void remap_free(snd_ctl_remap_t *priv)
 
 	for (idx1 = 0; idx1 < priv->map_items; idx1++) {
 		map = &priv->map[idx1];
-		for (idx2 = 0; idx2 < map->controls_items; idx2++)
+		for (idx2 = 0; idx2 < map->controls_items; idx2++) {
 			free(map->controls[idx2].channel_map);
+			free(map->controls[idx2].cache);
+		}
 		free(map->controls);
 	}
 	free(priv->map_read_queue);
+	free(priv->map_refs);
 	free(priv->map);
 	free(priv->remap);
 	free(priv->numid);
+	remap_hash_free(&priv->numid_child_hash);
+	remap_hash_free(&priv->numid_app_hash);
+	remap_hash_free(&priv->remap_child_numid_hash);
+	remap_hash_free(&priv->remap_child_id_hash);
+	remap_hash_free(&priv->remap_app_numid_hash);
+	remap_hash_free(&priv->remap_app_id_hash);
+	remap_hash_free(&priv->map_numid_hash);
+	remap_hash_free(&priv->map_id_hash);
+	remap_hash_free(&priv->map_ref_numid_hash);
+	remap_hash_free(&priv->map_ref_id_hash);
 	free(priv);
 }
 
@@ -329,10 +577,26 @@ static int snd_ctl_remap_async(snd_ctl_t *ctl, int sig, pid_t pid)
 	return snd_ctl_async(priv->child, sig, pid);
 }
 
+static void remap_map_cache_invalidate(snd_ctl_remap_t *priv)
+{
+	/* zero marks a single invalidated value */
+	if (++priv->cache_gen == 0)
+		priv->cache_gen = 1;
+}
+
 static int snd_ctl_remap_subscribe_events(snd_ctl_t *ctl, int subscribe)
 {
 	snd_ctl_remap_t *priv = ctl->private_data;
-	return snd_ctl_subscribe_events(priv->child, subscribe);
+	int err;
+
+	err = snd_ctl_subscribe_events(priv->child, subscribe);
+	if (err < 0 || subscribe < 0)
+		return err;
+	/* the cached child values are kept valid using the change events */
+	priv->subscribed = !!subscribe;
+	if (!priv->subscribed)
+		remap_map_cache_invalidate(priv);
+	return err;
 }
 
 static int snd_ctl_remap_card_info(snd_ctl_t *ctl, snd_ctl_card_info_t *info)
@@ -359,7 +623,9 @@ static int snd_ctl_remap_elem_list(snd_ctl_t *ctl, snd_ctl_elem_list_t *list)
 		id = &list->pids[index];
 		rid = remap_find_id_child(priv, id);
 		if (rid) {
-			rid->id_app.numid = id->numid;
+			err = remap_rid_set_numid(priv, rid, rid->id_child.numid, id->numid);
+			if (err < 0)
+				return err;
 			*id = rid->id_app;
 		}
 		numid = remap_find_numid_child(priv, id->numid);
@@ -414,7 +680,9 @@ static int remap_map_elem_info(snd_ctl_remap_t *priv, snd_ctl_elem_info_t *info)
 	    info2.type != SNDRV_CTL_ELEM_TYPE_INTEGER64 &&
 	    info2.type != SNDRV_CTL_ELEM_TYPE_BYTES)
 		return -EIO;
-	map->controls[0].id_child.numid = info2.id.numid;
+	err = remap_mctl_set_numid(priv, &map->controls[0], info2.id.numid);
+	if (err < 0)
+		return err;
 	map->type = info2.type;
 	access = info2.access;
 	owner = info2.owner;
@@ -456,6 +724,13 @@ static int remap_map_elem_info(snd_ctl_remap_t *priv, snd_ctl_elem_info_t *info)
 		info->value.integer64 = info2.value.integer64;
 	if (access & SNDRV_CTL_ELEM_ACCESS_LOCK)
 		info->owner = owner;
+	/*
+	 * the cache costs a poll() per access to check the pending events,
+	 * so it only pays off instead of several ioctls of a hw child
+	 */
+	map->cacheable = !(access & SNDRV_CTL_ELEM_ACCESS_VOLATILE) &&
+			 map->controls_items > 1 &&
+			 snd_ctl_type(priv->child) == SND_CTL_TYPE_HW;
 	return 0;
 }
 
@@ -476,6 +751,69 @@ static int snd_ctl_remap_elem_info(snd_ctl_t *ctl, snd_ctl_elem_info_t *info)
 	return remap_id_to_app(priv, &info->id, rid, err);
 }
 
+static void remap_map_cache_update(snd_ctl_remap_t *priv, snd_ctl_map_t *map,
+				   struct snd_ctl_map_ctl *mctl,
+				   snd_ctl_elem_value_t *control)
+{
+	if (!priv->subscribed || !map->cacheable)
+		return;
+	if (mctl->cache == NULL) {
+		mctl->cache = malloc(sizeof(*mctl->cache));
+		if (mctl->cache == NULL)
+			return;
+	}
+	*mctl->cache = *control;
+	mctl->cache_gen = priv->cache_gen;
+}
+
+/*
+ * An event which was not read through this handle yet may announce
+ * a change made by anyone, so the cached values are used only while the
+ * child has no event pending.
+ */
+static void remap_map_cache_check(snd_ctl_remap_t *priv, snd_ctl_map_t *map)
+{
+	struct pollfd pfd;
+	unsigned short revents;
+	size_t item;
+
+	if (!priv->subscribed || !map->cacheable)
+		return;
+	for (item = 0; item < map->controls_items; item++)
+		if (map->controls[item].cache_gen == priv->cache_gen)
+			break;
+	/* nothing cached */
+	if (item == map->controls_items)
+		return;
+	if (snd_ctl_poll_descriptors_count(priv->child) == 1 &&
+	    snd_ctl_poll_descriptors(priv->child, &pfd, 1) == 1 &&
+	    poll(&pfd, 1, 0) >= 0 &&
+	    snd_ctl_poll_descriptors_revents(priv->child, &pfd, 1, &revents) >= 0 &&
+	    revents == 0)
+		return;
+	remap_map_cache_invalidate(priv);
+}
+
+static int remap_map_child_read(snd_ctl_remap_t *priv, snd_ctl_map_t *map,
+				struct snd_ctl_map_ctl *mctl,
+				snd_ctl_elem_value_t *control)
+{
+	int err;
+
+	if (mctl->cache_gen == priv->cache_gen) {
+		*control = *mctl->cache;
+		return 0;
+	}
+	snd_ctl_elem_value_clear(control);
+	control->id = mctl->id_child;
+	debug_id(&control->id, "%s\n", __func__);
+	err = snd_ctl_elem_read(priv->child, control);
+	if (err < 0)
+		return err;
+	remap_map_cache_update(priv, map, mctl, control);
+	return 0;
+}
+
 static int remap_map_elem_read(snd_ctl_remap_t *priv, snd_ctl_elem_value_t *control)
 {
 	snd_ctl_map_t *map;
@@ -488,14 +826,12 @@ static int remap_map_elem_read(snd_ctl_remap_t *priv, snd_ctl_elem_value_t *cont
 	if (map == NULL)
 		return -EREMAPNOTFOUND;
 	debug_id(&control->id, "%s\n", __func__);
+	remap_map_cache_check(priv, map);
 	snd_ctl_elem_value_clear(control);
 	control->id = map->map_id;
 	for (item = 0; item < map->controls_items; item++) {
 		mctl = &map->controls[item];
-		snd_ctl_elem_value_clear(&control2);
-		control2.id = mctl->id_child;
-		debug_id(&control2.id, "%s controls[%zd]\n", __func__, item);
-		err = snd_ctl_elem_read(priv->child, &control2);
+		err = remap_map_child_read(priv, map, mctl, &control2);
 		if (err < 0)
 			return err;
 		if (map->type == SNDRV_CTL_ELEM_TYPE_BOOLEAN ||
@@ -551,13 +887,11 @@ static int remap_map_elem_write(snd_ctl_remap_t *priv, snd_ctl_elem_value_t *con
 	if (map == NULL)
 		return -EREMAPNOTFOUND;
 	debug_id(&control->id, "%s\n", __func__);
+	remap_map_cache_check(priv, map);
 	control->id = map->map_id;
 	for (item = 0; item < map->controls_items; item++) {
 		mctl = &map->controls[item];
-		snd_ctl_elem_value_clear(&control2);
-		control2.id = mctl->id_child;
-		debug_id(&control2.id, "%s controls[%zd]\n", __func__, item);
-		err = snd_ctl_elem_read(priv->child, &control2);
+		err = remap_map_child_read(priv, map, mctl, &control2);
 		if (err < 0)
 			return err;
 		changes = 0;
@@ -590,8 +924,12 @@ static int remap_map_elem_write(snd_ctl_remap_t *priv, snd_ctl_elem_value_t *con
 		debug_id(&control2.id, "%s changes %d\n", __func__, changes);
 		if (changes > 0) {
 			err = snd_ctl_elem_write(priv->child, &control2);
-			if (err < 0)
+			if (err < 0) {
+				mctl->cache_gen = 0;
 				return err;
+			}
+			/* a different stored value is notified by an event */
+			remap_map_cache_update(priv, map, mctl, &control2);
 		}
 	}
 	return 0;
@@ -659,8 +997,7 @@ static int remap_get_map_numid(snd_ctl_remap_t *priv, struct snd_ctl_map_ctl *mc
 	numid = remap_find_numid_child(priv, info.id.numid);
 	if (numid == NULL)
 		return -EIO;
-	mctl->id_child.numid = info.id.numid;
-	return 0;
+	return remap_mctl_set_numid(priv, mctl, info.id.numid);
 }
 
 static int remap_map_elem_tlv(snd_ctl_remap_t *priv, int op_flag, unsigned int numid,
@@ -794,45 +1131,45 @@ static void _next_ptr(size_t *ptr, size_t count)
 	*ptr = (*ptr + 1) % count;
 }
 
-static void remap_event_for_all_map_controls(snd_ctl_remap_t *priv,
-					     snd_ctl_elem_id_t *id,
-					     unsigned int event_mask)
+static int remap_event_for_all_map_controls(snd_ctl_remap_t *priv,
+					    snd_ctl_elem_id_t *id,
+					    unsigned int event_mask)
 {
-	size_t count, index, head;
+	snd_ctl_remap_slot_t *slot;
+	snd_ctl_map_ref_t *ref;
 	snd_ctl_map_t *map;
-	struct snd_ctl_map_ctl *mctl;
-	int found;
+	unsigned int pos;
+	int found, err;
 
 	if (event_mask == SNDRV_CTL_EVENT_MASK_REMOVE)
 		event_mask = SNDRV_CTL_EVENT_MASK_INFO;
-	map = priv->map;
-	for (count = priv->map_items; count > 0; count--, map++) {
-		for (index = 0; index < map->controls_items; index++) {
-			mctl = &map->controls[index];
-			if (mctl->id_child.numid == 0) {
-				if (snd_ctl_elem_id_compare_set(id, &mctl->id_child))
-					continue;
-				mctl->id_child.numid = id->numid;
-			}
-			if (id->numid != mctl->id_child.numid)
-				continue;
-			debug_id(&map->map_id, "%s found (all)\n", __func__);
-			map->event_mask |= event_mask;
-			found = 0;
-			for (head = priv->map_read_queue_head;
-			     head != priv->map_read_queue_tail;
-			     _next_ptr(&head, priv->map_items))
-				if (priv->map_read_queue[head] == map) {
-					found = 1;
-					break;
-				}
-			if (found)
-				continue;
-			debug_id(&map->map_id, "%s marking for read\n", __func__);
-			priv->map_read_queue[priv->map_read_queue_tail] = map;
-			_next_ptr(&priv->map_read_queue_tail, priv->map_items);
-		}
+	/* resolve the numid of the map controls given by name */
+	remap_hash_for_each(&priv->map_ref_id_hash, remap_hash_id(id), pos, slot) {
+		ref = &priv->map_refs[slot->index - 1];
+		if (ref->mctl->id_child.numid != 0 ||
+		    snd_ctl_elem_id_compare_set(id, &ref->mctl->id_child))
+			continue;
+		err = remap_mctl_set_numid(priv, ref->mctl, id->numid);
+		if (err < 0)
+			return err;
 	}
+	remap_hash_for_each(&priv->map_ref_numid_hash, remap_hash_numid(id->numid), pos, slot) {
+		ref = &priv->map_refs[slot->index - 1];
+		map = ref->map;
+		if (id->numid != ref->mctl->id_child.numid)
+			continue;
+		debug_id(&map->map_id, "%s found (all)\n", __func__);
+		ref->mctl->cache_gen = 0;
+		/* a non-zero mask means that the map is already queued */
+		found = map->event_mask != 0;
+		map->event_mask |= event_mask;
+		if (found)
+			continue;
+		debug_id(&map->map_id, "%s marking for read\n", __func__);
+		priv->map_read_queue[priv->map_read_queue_tail] = map;
+		_next_ptr(&priv->map_read_queue_tail, priv->map_items);
+	}
+	return 0;
 }
 
 static int snd_ctl_remap_read(snd_ctl_t *ctl, snd_ctl_event_t *event)
@@ -841,7 +1178,7 @@ static int snd_ctl_remap_read(snd_ctl_t *ctl, snd_ctl_event_t *event)
 	snd_ctl_remap_id_t *rid;
 	snd_ctl_numid_t *numid;
 	snd_ctl_map_t *map;
-	int err;
+	int result, err;
 
 	if (priv->map_read_queue_head != priv->map_read_queue_tail) {
 		map = priv->map_read_queue[priv->map_read_queue_head];
@@ -854,22 +1191,27 @@ static int snd_ctl_remap_read(snd_ctl_t *ctl, snd_ctl_event_t *event)
 		debug_id(&map->map_id, "%s queue read\n", __func__);
 		return 1;
 	}
-	err = snd_ctl_read(priv->child, event);
-	if (err < 0 || event->type != SNDRV_CTL_EVENT_ELEM)
-		return err;
+	result = snd_ctl_read(priv->child, event);
+	if (result < 0 || event->type != SNDRV_CTL_EVENT_ELEM)
+		return result;
 	if (event->data.elem.mask == SNDRV_CTL_EVENT_MASK_REMOVE ||
 	    (event->data.elem.mask & (SNDRV_CTL_EVENT_MASK_VALUE | SNDRV_CTL_EVENT_MASK_INFO |
 				      SNDRV_CTL_EVENT_MASK_ADD | SNDRV_CTL_EVENT_MASK_TLV)) != 0) {
 		debug_id(&event->data.elem.id, "%s event mask 0x%x\n", __func__, event->data.elem.mask);
-		remap_event_for_all_map_controls(priv, &event->data.elem.id, event->data.elem.mask);
+		err = remap_event_for_all_map_controls(priv, &event->data.elem.id,
+						       event->data.elem.mask);
+		if (err < 0)
+			return err;
 		rid = remap_find_id_child(priv, &event->data.elem.id);
 		if (rid) {
 			if (rid->id_child.numid == 0) {
 				numid = remap_find_numid_child(priv, event->data.elem.id.numid);
 				if (numid == NULL)
 					return -EIO;
-				rid->id_child.numid = numid->numid_child;
-				rid->id_app.numid = numid->numid_app;
+				err = remap_rid_set_numid(priv, rid, numid->numid_child,
+							  numid->numid_app);
+				if (err < 0)
+					return err;
 			}
 			event->data.elem.id = rid->id_app;
 		} else {
@@ -879,7 +1221,7 @@ static int snd_ctl_remap_read(snd_ctl_t *ctl, snd_ctl_event_t *event)
 			event->data.elem.id.numid = numid->numid_app;
 		}
 	}
-	return err;
+	return result;
 }
 
 static const snd_ctl_ops_t snd_ctl_remap_ops = {
@@ -913,6 +1255,7 @@ static int add_to_remap(snd_ctl_remap_t *priv,
 			snd_ctl_elem_id_t *app)
 {
 	snd_ctl_remap_id_t *rid;
+	size_t index = priv->remap_items;
 
 	if (priv->remap_alloc == priv->remap_items) {
 		rid = realloc(priv->remap, (priv->remap_alloc + 16) * sizeof(*rid));
@@ -922,6 +1265,19 @@ static int add_to_remap(snd_ctl_remap_t *priv,
 		priv->remap_alloc += 16;
 		priv->remap = rid;
 	}
+	if (remap_hash_reserve(&priv->remap_child_id_hash) < 0 ||
+	    remap_hash_reserve(&priv->remap_app_id_hash) < 0 ||
+	    (child->numid > 0 && remap_hash_reserve(&priv->remap_child_numid_hash) < 0) ||
+	    (app->numid > 0 && remap_hash_reserve(&priv->remap_app_numid_hash) < 0))
+		return -ENOMEM;
+	remap_hash_put(&priv->remap_child_id_hash, remap_hash_id(child), index + 1);
+	remap_hash_put(&priv->remap_app_id_hash, remap_hash_id(app), index + 1);
+	if (child->numid > 0)
+		remap_hash_put(&priv->remap_child_numid_hash,
+			       remap_hash_numid(child->numid), index + 1);
+	if (app->numid > 0)
+		remap_hash_put(&priv->remap_app_numid_hash,
+			       remap_hash_numid(app->numid), index + 1);
 	rid = &priv->remap[priv->remap_items++];
 	rid->id_child = *child;
 	rid->id_app = *app;
@@ -988,11 +1344,17 @@ static int new_map(snd_ctl_remap_t *priv, snd_ctl_map_t **_map, snd_ctl_elem_id_
 		priv->map_alloc += 16;
 		priv->map = map;
 	}
-	map = &priv->map[priv->map_items++];
-	map->map_id = *id;
+	if (remap_hash_reserve(&priv->map_numid_hash) < 0 ||
+	    remap_hash_reserve(&priv->map_id_hash) < 0)
+		return -ENOMEM;
 	numid = remap_numid_new(priv, 0, ++priv->numid_app_last);
 	if (numid == NULL)
 		return -ENOMEM;
+	remap_hash_put(&priv->map_numid_hash, remap_hash_numid(numid->numid_app),
+		       priv->map_items + 1);
+	remap_hash_put(&priv->map_id_hash, remap_hash_id(id), priv->map_items + 1);
+	map = &priv->map[priv->map_items++];
+	map->map_id = *id;
 	map->map_id.numid = numid->numid_app;
 	debug_id(&map->map_id, "%s created\n", __func__);
 	*_map = map;
@@ -1109,6 +1471,43 @@ static int parse_map1(snd_ctl_map_t *map, snd_config_t *conf)
 	return 0;
 }
 
+/* index the child controls of all maps for the event dispatch */
+static int index_map_controls(snd_ctl_remap_t *priv)
+{
+	snd_ctl_map_ref_t *ref;
+	snd_ctl_map_t *map;
+	size_t idx1, idx2, count = 0;
+
+	for (idx1 = 0; idx1 < priv->map_items; idx1++)
+		count += priv->map[idx1].controls_items;
+	if (count == 0)
+		return 0;
+	priv->map_refs = calloc(count, sizeof(*priv->map_refs));
+	if (priv->map_refs == NULL)
+		return -ENOMEM;
+	for (idx1 = 0; idx1 < priv->map_items; idx1++) {
+		map = &priv->map[idx1];
+		for (idx2 = 0; idx2 < map->controls_items; idx2++) {
+			ref = &priv->map_refs[priv->map_refs_items];
+			ref->map = map;
+			ref->mctl = &map->controls[idx2];
+			if (remap_hash_reserve(&priv->map_ref_id_hash) < 0 ||
+			    (ref->mctl->id_child.numid > 0 &&
+			     remap_hash_reserve(&priv->map_ref_numid_hash) < 0))
+				return -ENOMEM;
+			remap_hash_put(&priv->map_ref_id_hash,
+				       remap_hash_id(&ref->mctl->id_child),
+				       priv->map_refs_items + 1);
+			if (ref->mctl->id_child.numid > 0)
+				remap_hash_put(&priv->map_ref_numid_hash,
+					       remap_hash_numid(ref->mctl->id_child.numid),
+					       priv->map_refs_items + 1);
+			priv->map_refs_items++;
+		}
+	}
+	return 0;
+}
+
 static int parse_map(snd_ctl_remap_t *priv, snd_config_t *conf)
 {
 	snd_config_iterator_t i, next;
@@ -1167,6 +1566,7 @@ int snd_ctl_remap_open(snd_ctl_t **handlep, const char *name, snd_config_t *rema
 	priv = calloc(1, sizeof(*priv));
 	if (priv == NULL)
 		return -ENOMEM;
+	priv->cache_gen = 1;
 
 	err = parse_remap(priv, remap);
 	if (err < 0) {
@@ -1198,6 +1598,12 @@ int snd_ctl_remap_open(snd_ctl_t **handlep, const char *name, snd_config_t *rema
 		goto _err;
 	}
 
+	err = index_map_controls(priv);
+	if (err < 0) {
+		result = err;
+		goto _err;
+	}
+
 	priv->numid_remap_active = priv->map_items > 0;
 
 	priv->child = child;
@@ -1226,6 +1632,11 @@ This plugin can remap (rename) identifiers (except the numid part) for
 a child control to another. The plugin can also merge the multiple
 child controls to one or split one control to more.
 
+While the events are subscribed, the values of the hardware child controls
+used by the maps of several controls are cached.  The cache is used only while
+no child event is pending, so the values are up to date also when the
+application does not read the events.
+
 \code
 ctl.name {
 	type remap              # Route & Volume conversion PCM
@@ -26,7 +26,11 @@
  *
  */
 
-#include "local.h"
+#include "control_local.h"
+#include <stdint.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 #ifndef DOC_HIDDEN
 #define DEV_SKIP	9999 /* some non-existing device number */
@@ -48,12 +52,8 @@ struct hint_list {
 };
 #endif
 
-static int hint_list_add(struct hint_list *list,
-			 const char *name,
-			 const char *description)
+static int hint_list_grow(struct hint_list *list)
 {
-	char *x;
-
 	if (list->count + 1 >= list->allocated) {
 		char **n = realloc(list->list, (list->allocated + 10) * sizeof(char *));
 		if (n == NULL)
@@ -62,6 +62,17 @@ static int hint_list_add(struct hint_list *list,
 		list->allocated += 10;
 		list->list = n;
 	}
+	return 0;
+}
+
+static int hint_list_add(struct hint_list *list,
+			 const char *name,
+			 const char *description)
+{
+	char *x;
+
+	if (hint_list_grow(list) < 0)
+		return -ENOMEM;
 	if (name == NULL) {
 		x = NULL;
 	} else {
@@ -554,6 +565,385 @@ static int add_software_devices(snd_config_t *config, snd_config_t *rw_config,
 	return 0;
 }
 
+/*
+ * The hints of the cards are gathered in parallel and remembered.
+ *
+ * Every card is evaluated into its own hint list.  The lists are added
+ * to the result in the card order, so the result is the same as when
+ * the cards are evaluated in turn.  The worker threads use their own
+ * copies of the configuration, the expansions themselves are serialized
+ * by the configuration lock, but the control devices are opened and
+ * queried concurrently.
+ *
+ * A card list is kept for the next call while the control device of the
+ * card stays the same (see snd_card_stamp()), and while the loaded
+ * configuration and the environment (used by the configuration
+ * functions) are unchanged.  The cache can be disabled by setting the
+ * environment variable LIBASOUND_NAMEHINT_CACHE to 0.
+ */
+#ifndef DOC_HIDDEN
+#define HINT_THREADS_MAX	4	/* threads evaluating the cards */
+
+struct hint_card {
+	int card;
+	int err;
+	int cached;			/* the list comes from the cache */
+	int stamp_valid;		/* the card changes are tracked */
+	unsigned long stamp;
+	char **list;
+	unsigned int count;
+};
+
+struct hint_cache_entry {
+	struct hint_cache_entry *next;
+	int card;
+	unsigned long stamp;
+	char *siface;
+	int show_all;
+	uint64_t sig;			/* configuration and environment */
+	char **list;
+	unsigned int count;
+};
+
+struct hint_work {
+	snd_config_t *config;
+	const struct hint_list *tmpl;
+	struct hint_card *cards;
+	unsigned int count;
+	unsigned int next;		/* the next card to evaluate */
+#ifdef HAVE_LIBPTHREAD
+	pthread_mutex_t mutex;
+#endif
+};
+#endif
+
+extern char **environ;
+
+static struct hint_cache_entry *hint_cache;
+
+#ifdef HAVE_LIBPTHREAD
+static pthread_mutex_t hint_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define hint_cache_lock()	pthread_mutex_lock(&hint_cache_mutex)
+#define hint_cache_unlock()	pthread_mutex_unlock(&hint_cache_mutex)
+#else
+#define hint_cache_lock()	do { } while (0)
+#define hint_cache_unlock()	do { } while (0)
+#endif
+
+static int hint_cache_enabled(void)
+{
+	static int enabled = -1;	/* uninitialized */
+
+	/* evaluate env var only once for consistency */
+	if (enabled < 0) {
+		const char *p = getenv("LIBASOUND_NAMEHINT_CACHE");
+		enabled = !p || *p != '0';
+	}
+	return enabled;
+}
+
+static uint64_t hint_sig(uint64_t h, const void *data, size_t size)
+{
+	const unsigned char *p = data;
+
+	while (size-- > 0)
+		h = (h ^ *p++) * 1099511628211ULL;
+	return h;
+}
+
+static uint64_t hint_sig_string(uint64_t h, const char *str)
+{
+	if (str)
+		return hint_sig(h, str, strlen(str) + 1);
+	return hint_sig(h, "", 1);
+}
+
+static uint64_t hint_sig_conf(uint64_t h, snd_config_t *conf)
+{
+	snd_config_iterator_t i, next;
+	snd_config_type_t type = snd_config_get_type(conf);
+	const char *id = NULL, *str;
+	long integer;
+	long long integer64;
+	double real;
+	const void *ptr;
+
+	snd_config_get_id(conf, &id);
+	h = hint_sig_string(h, id);
+	h = hint_sig(h, &type, sizeof(type));
+	switch (type) {
+	case SND_CONFIG_TYPE_INTEGER:
+		snd_config_get_integer(conf, &integer);
+		return hint_sig(h, &integer, sizeof(integer));
+	case SND_CONFIG_TYPE_INTEGER64:
+		snd_config_get_integer64(conf, &integer64);
+		return hint_sig(h, &integer64, sizeof(integer64));
+	case SND_CONFIG_TYPE_REAL:
+		snd_config_get_real(conf, &real);
+		return hint_sig(h, &real, sizeof(real));
+	case SND_CONFIG_TYPE_STRING:
+		snd_config_get_string(conf, &str);
+		return hint_sig_string(h, str);
+	case SND_CONFIG_TYPE_POINTER:
+		snd_config_get_pointer(conf, &ptr);
+		return hint_sig(h, &ptr, sizeof(ptr));
+	case SND_CONFIG_TYPE_COMPOUND:
+		snd_config_for_each(i, next, conf)
+			h = hint_sig_conf(h, snd_config_iterator_entry(i));
+		return hint_sig(h, "}", 1);
+	}
+	return h;
+}
+
+/* the signature of everything the card hints depend on besides the card */
+static uint64_t hint_cache_sig(snd_config_t *config)
+{
+	uint64_t h = 14695981039346656037ULL;
+	char **env;
+
+	h = hint_sig_conf(h, config);
+	for (env = environ; env && *env; env++)
+		h = hint_sig_string(h, *env);
+	return h;
+}
+
+static void hint_strings_free(char **list, unsigned int count)
+{
+	unsigned int i;
+
+	for (i = 0; i < count; i++)
+		free(list[i]);
+	free(list);
+}
+
+static char **hint_strings_dup(char **list, unsigned int count)
+{
+	char **res;
+	unsigned int i;
+
+	res = calloc(count + 1, sizeof(*res));
+	if (res == NULL)
+		return NULL;
+	for (i = 0; i < count; i++) {
+		res[i] = strdup(list[i]);
+		if (res[i] == NULL) {
+			hint_strings_free(res, i);
+			return NULL;
+		}
+	}
+	return res;
+}
+
+static void hint_cache_entry_free(struct hint_cache_entry *e)
+{
+	hint_strings_free(e->list, e->count);
+	free(e->siface);
+	free(e);
+}
+
+static struct hint_cache_entry **hint_cache_find(const struct hint_list *list,
+						 int card)
+{
+	struct hint_cache_entry **pe;
+
+	for (pe = &hint_cache; *pe; pe = &(*pe)->next) {
+		if ((*pe)->card == card &&
+		    (*pe)->show_all == list->show_all &&
+		    strcmp((*pe)->siface, list->siface) == 0)
+			break;
+	}
+	return pe;
+}
+
+/* fill the card hints from the cache */
+static void hint_cache_get(const struct hint_list *list, struct hint_card *hc,
+			   uint64_t sig)
+{
+	struct hint_cache_entry *e;
+
+	hc->stamp_valid = hint_cache_enabled() &&
+			  snd_card_stamp(hc->card, &hc->stamp) == 0;
+	if (!hc->stamp_valid)
+		return;
+	hint_cache_lock();
+	e = *hint_cache_find(list, hc->card);
+	if (e && e->stamp == hc->stamp && e->sig == sig) {
+		hc->list = hint_strings_dup(e->list, e->count);
+		if (hc->list) {
+			hc->count = e->count;
+			hc->cached = 1;
+		}
+	}
+	hint_cache_unlock();
+}
+
+/* remember the evaluated card hints */
+static void hint_cache_put(const struct hint_list *list, struct hint_card *hc,
+			   uint64_t sig)
+{
+	struct hint_cache_entry **pe, *e;
+
+	if (hc->cached || !hc->stamp_valid || hc->err < 0)
+		return;
+	e = calloc(1, sizeof(*e));
+	if (e == NULL)
+		return;
+	e->card = hc->card;
+	e->stamp = hc->stamp;
+	e->show_all = list->show_all;
+	e->sig = sig;
+	e->siface = strdup(list->siface);
+	e->list = hint_strings_dup(hc->list, hc->count);
+	if (e->siface == NULL || e->list == NULL) {
+		free(e->siface);
+		free(e->list);
+		free(e);
+		return;
+	}
+	e->count = hc->count;
+	hint_cache_lock();
+	pe = hint_cache_find(list, hc->card);
+	if (*pe) {
+		e->next = (*pe)->next;
+		hint_cache_entry_free(*pe);
+	}
+	*pe = e;
+	hint_cache_unlock();
+}
+
+/* evaluate the hints of one card into its own list */
+static void card_hints(snd_config_t *config, snd_config_t *rw_config,
+		       const struct hint_list *tmpl, struct hint_card *hc)
+{
+	struct hint_list list = *tmpl;
+	int err;
+
+	list.list = NULL;
+	list.count = list.allocated = 0;
+	list.cardname = NULL;
+	err = get_card_name(&list, hc->card);
+	if (err >= 0)
+		err = add_card(config, rw_config, &list, hc->card);
+	free(list.cardname);
+	hc->err = err;
+	hc->list = list.list;
+	hc->count = list.count;
+}
+
+static struct hint_card *hint_work_next(struct hint_work *work)
+{
+	struct hint_card *hc = NULL;
+
+#ifdef HAVE_LIBPTHREAD
+	pthread_mutex_lock(&work->mutex);
+#endif
+	while (work->next < work->count) {
+		hc = &work->cards[work->next++];
+		if (!hc->cached)
+			break;
+		hc = NULL;
+	}
+#ifdef HAVE_LIBPTHREAD
+	pthread_mutex_unlock(&work->mutex);
+#endif
+	return hc;
+}
+
+static void hint_work_run(struct hint_work *work, snd_config_t *rw_config)
+{
+	snd_config_t *copy = NULL;
+	struct hint_card *hc;
+
+	while ((hc = hint_work_next(work)) != NULL) {
+		if (rw_config == NULL) {
+			if (snd_config_copy(&copy, work->config) < 0) {
+				hc->err = -ENOMEM;
+				continue;
+			}
+			rw_config = copy;
+		}
+		card_hints(work->config, rw_config, work->tmpl, hc);
+	}
+	if (copy)
+		snd_config_delete(copy);
+}
+
+#ifdef HAVE_LIBPTHREAD
+static void *hint_work_thread(void *arg)
+{
+	hint_work_run(arg, NULL);
+	return NULL;
+}
+#endif
+
+/*
+ * Evaluate the hints of the given cards, the calling thread takes its
+ * share of the cards after the software devices.
+ */
+static int add_cards(snd_config_t *config, snd_config_t *rw_config,
+		     struct hint_list *list, struct hint_card *cards,
+		     unsigned int count, int software)
+{
+	struct hint_work work;
+#ifdef HAVE_LIBPTHREAD
+	pthread_t threads[HINT_THREADS_MAX - 1];
+#endif
+	unsigned int i, j, pending = 0, nthreads = 0;
+	uint64_t sig = 0;
+	int err = 0;
+
+	if (count > 0 && hint_cache_enabled())
+		sig = hint_cache_sig(config);
+	for (i = 0; i < count; i++) {
+		hint_cache_get(list, &cards[i], sig);
+		if (!cards[i].cached)
+			pending++;
+	}
+
+	work.config = config;
+	work.tmpl = list;
+	work.cards = cards;
+	work.count = count;
+	work.next = 0;
+#ifdef HAVE_LIBPTHREAD
+	pthread_mutex_init(&work.mutex, NULL);
+	while (nthreads + 1 < pending && nthreads + 1 < HINT_THREADS_MAX) {
+		if (pthread_create(&threads[nthreads], NULL,
+				   hint_work_thread, &work) != 0)
+			break;
+		nthreads++;
+	}
+#endif
+	if (software)
+		add_software_devices(config, rw_config, list);
+	hint_work_run(&work, rw_config);
+#ifdef HAVE_LIBPTHREAD
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&work.mutex);
+#endif
+
+	/* the first error in the card order wins, as with the cards in turn */
+	for (i = 0; i < count; i++) {
+		struct hint_card *hc = &cards[i];
+
+		if (err >= 0 && hc->err < 0)
+			err = hc->err;
+		hint_cache_put(list, hc, sig);
+		for (j = 0; j < hc->count; j++) {
+			if (hint_list_grow(list) < 0) {
+				free(hc->list[j]);
+				err = -ENOMEM;
+				continue;
+			}
+			list->list[list->count++] = hc->list[j];
+		}
+		free(hc->list);
+		hc->list = NULL;
+	}
+	return err;
+}
+
 /**
  * \brief Get a set of device name hints
  * \param card Card number or -1 (means all cards)
@@ -579,6 +969,11 @@ static int add_software_devices(snd_config_t *config, snd_config_t *rw_config,
  *
  * Special variables: defaults.namehint.showall specifies if all device
  * definitions are accepted (boolean type).
+ *
+ * The cards are evaluated in parallel and their hints are remembered
+ * until the card, the configuration or the environment changes.  Set
+ * the environment variable LIBASOUND_NAMEHINT_CACHE to 0 to disable
+ * the cache.
  */
 int snd_device_name_hint(int card, const char *iface, void ***hints)
 {
@@ -588,6 +983,8 @@ int snd_device_name_hint(int card, const char *iface, void ***hints)
 	snd_config_t *conf, *local_config = NULL, *local_config_rw = NULL;
 	snd_config_update_t *local_config_update = NULL;
 	snd_config_iterator_t i, next;
+	struct hint_card cards[SND_MAX_CARDS];
+	unsigned int count = 0;
 	int err;
 
 	if (hints == NULL)
@@ -622,26 +1019,22 @@ int snd_device_name_hint(int card, const char *iface, void ***hints)
 
 	if (snd_config_search(local_config, "defaults.namehint.showall", &conf) >= 0)
 		list.show_all = snd_config_get_bool(conf) > 0;
+	memset(cards, 0, sizeof(cards));
 	if (card >= 0) {
-		err = get_card_name(&list, card);
-		if (err >= 0)
-			err = add_card(local_config, local_config_rw, &list, card);
+		/* the errors of a single card are not reported */
+		cards[0].card = card;
+		add_cards(local_config, local_config_rw, &list, cards, 1, 0);
 	} else {
-		add_software_devices(local_config, local_config_rw, &list);
 		err = snd_card_next(&card);
-		if (err < 0)
-			goto __error;
-		while (card >= 0) {
-			err = get_card_name(&list, card);
-			if (err < 0)
-				goto __error;
-			err = add_card(local_config, local_config_rw, &list, card);
-			if (err < 0)
-				goto __error;
+		while (err >= 0 && card >= 0 && count < SND_MAX_CARDS) {
+			cards[count++].card = card;
 			err = snd_card_next(&card);
-			if (err < 0)
-				goto __error;
 		}
+		if (err < 0)
+			goto __error;
+		err = add_cards(local_config, local_config_rw, &list, cards, count, 1);
+		if (err < 0)
+			goto __error;
 	}
 	sprintf(ehints, "namehint.%s", list.siface);
 	err = snd_config_search(local_config, ehints, &conf);
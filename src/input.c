@@ -32,6 +32,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <sys/stat.h>
 
 #ifndef DOC_HIDDEN
 
@@ -41,6 +42,7 @@ typedef struct _snd_input_ops {
 	char *(*(gets))(snd_input_t *input, char *str, size_t size);
 	int (*getch)(snd_input_t *input);
 	int (*ungetch)(snd_input_t *input, int c);
+	int (*map)(snd_input_t *input, const unsigned char **data, size_t *size);
 } snd_input_ops_t;
 
 struct _snd_input {
@@ -118,9 +120,21 @@ int snd_input_ungetc(snd_input_t *input, int c)
 }
 
 #ifndef DOC_HIDDEN
+/*
+ * Make the remaining input data directly accessible in memory. The data
+ * are consumed and stay valid until the input handle is closed.
+ */
+int _snd_input_map(snd_input_t *input, const unsigned char **data, size_t *size)
+{
+	if (input->ops->map == NULL)
+		return -ENXIO;
+	return input->ops->map(input, data, size);
+}
+
 typedef struct _snd_input_stdio {
 	int close;
 	FILE *fp;
+	unsigned char *data;	/* the rest of the file read by map */
 } snd_input_stdio_t;
 
 static int snd_input_stdio_close(snd_input_t *input ATTRIBUTE_UNUSED)
@@ -128,6 +142,7 @@ static int snd_input_stdio_close(snd_input_t *input ATTRIBUTE_UNUSED)
 	snd_input_stdio_t *stdio = input->private_data;
 	if (stdio->close)
 		fclose(stdio->fp);
+	free(stdio->data);
 	free(stdio);
 	return 0;
 }
@@ -157,12 +172,56 @@ static int snd_input_stdio_ungetc(snd_input_t *input, int c)
 	return ungetc(c, stdio->fp);
 }
 
+/* read the rest of the file in one go */
+static int snd_input_stdio_map(snd_input_t *input, const unsigned char **data, size_t *size)
+{
+	snd_input_stdio_t *stdio = input->private_data;
+	struct stat st;
+	size_t alloc = 4096, len = 0, r;
+	unsigned char *buf, *nbuf;
+	long pos;
+
+	if (stdio->data)
+		return -EBUSY;
+	if (fstat(fileno(stdio->fp), &st) == 0 && S_ISREG(st.st_mode)) {
+		pos = ftell(stdio->fp);
+		if (pos >= 0 && pos <= st.st_size)
+			alloc = st.st_size - pos + 1;
+	}
+	buf = malloc(alloc);
+	if (buf == NULL)
+		return -ENOMEM;
+	while (1) {
+		r = fread(buf + len, 1, alloc - len, stdio->fp);
+		len += r;
+		if (len < alloc) {
+			if (ferror(stdio->fp)) {
+				free(buf);
+				return -EIO;
+			}
+			break;
+		}
+		nbuf = realloc(buf, alloc * 2);
+		if (nbuf == NULL) {
+			free(buf);
+			return -ENOMEM;
+		}
+		buf = nbuf;
+		alloc *= 2;
+	}
+	stdio->data = buf;
+	*data = buf;
+	*size = len;
+	return 0;
+}
+
 static const snd_input_ops_t snd_input_stdio_ops = {
 	.close		= snd_input_stdio_close,
 	.scan		= snd_input_stdio_scan,
 	.gets		= snd_input_stdio_gets,
 	.getch		= snd_input_stdio_getc,
 	.ungetch	= snd_input_stdio_ungetc,
+	.map		= snd_input_stdio_map,
 };
 #endif
 
@@ -283,12 +342,23 @@ static int snd_input_buffer_ungetc(snd_input_t *input, int c)
 	return c;
 }
 
+static int snd_input_buffer_map(snd_input_t *input, const unsigned char **data, size_t *size)
+{
+	snd_input_buffer_t *buffer = input->private_data;
+	*data = buffer->ptr;
+	*size = buffer->size;
+	buffer->ptr += buffer->size;
+	buffer->size = 0;
+	return 0;
+}
+
 static const snd_input_ops_t snd_input_buffer_ops = {
 	.close		= snd_input_buffer_close,
 	.scan		= snd_input_buffer_scan,
 	.gets		= snd_input_buffer_gets,
 	.getch		= snd_input_buffer_getc,
 	.ungetch	= snd_input_buffer_ungetc,
+	.map		= snd_input_buffer_map,
 };
 #endif
 
@@ -516,6 +516,29 @@ LIBASOUND_THREAD_SAFE=0 aplay foo.wav
 \endcode
 for making the debugging easier.
 
+\section pcm_perf Performance counters
+
+Each PCM handle can count its processing calls, the frames processed,
+the time spent in the calls, the system calls on the data path and the
+xruns, see #snd_pcm_perf_enable() and #snd_pcm_perf_get().  The counters
+of a plugin exclude the time of its slave, so the expensive stage of a
+plugin chain is easy to spot in the output of #snd_pcm_dump().  They are
+enabled for all handles including the slaves by the environment variable
+LIBASOUND_PCM_PERF, e.g.
+\code
+LIBASOUND_PCM_PERF=1 aplay -v foo.wav
+\endcode
+
+\section pcm_trace Tracing
+
+The library can record the last calls of the application on the PCM
+handles with their timestamp, duration, result and pointers into a lock
+free ring per thread, see #snd_pcm_trace_enable().  The tracing is enabled
+also by the environment variable LIBASOUND_PCM_TRACE.  The history is
+printed by #snd_pcm_trace_dump(), or by #snd_pcm_trace_dump_fd() from
+a signal handler.  The tracing can be left out of the library by the
+configure option --disable-pcm-trace.
+
 \section pcm_dev_names PCM naming conventions
 
 The ALSA library uses a generic string representation for names of devices.
@@ -950,9 +973,18 @@ int snd_pcm_hw_params_current(snd_pcm_t *pcm, snd_pcm_hw_params_t *params)
  */
 int snd_pcm_hw_params(snd_pcm_t *pcm, snd_pcm_hw_params_t *params)
 {
+	snd_pcm_hw_params_t saved;
+	unsigned long hits;
 	int err;
 	assert(pcm && params);
+	hits = snd_pcm_refine_hits(pcm);
+	saved = *params;
 	err = _snd_pcm_hw_params_internal(pcm, params);
+	/* the cached constraints may be stale, try again without them */
+	if (err < 0 && snd_pcm_refine_flush(pcm, hits)) {
+		*params = saved;
+		err = _snd_pcm_hw_params_internal(pcm, params);
+	}
 	if (err < 0)
 		return err;
 	err = snd_pcm_prepare(pcm);
@@ -1188,9 +1220,12 @@ int snd_pcm_resume(snd_pcm_t *pcm)
 		return -EIO;
 	}
 	/* lock handled in the callback */
-	if (pcm->fast_ops->resume)
+	if (pcm->fast_ops->resume) {
+		unsigned long long start = snd_pcm_trace_begin();
+
 		err = pcm->fast_ops->resume(pcm->fast_op_arg);
-	else
+		snd_pcm_trace(pcm, PCM_TRACE_RESUME, start, err);
+	} else
 		err = -ENOSYS;
 	return err;
 }
@@ -1245,9 +1280,12 @@ int snd_pcm_prepare(snd_pcm_t *pcm)
 	if (err < 0)
 		return err;
 	snd_pcm_lock(pcm->fast_op_arg);
-	if (pcm->fast_ops->prepare)
+	if (pcm->fast_ops->prepare) {
+		unsigned long long start = snd_pcm_trace_begin();
+
 		err = pcm->fast_ops->prepare(pcm->fast_op_arg);
-	else
+		snd_pcm_trace(pcm, PCM_TRACE_PREPARE, start, err);
+	} else
 		err = -ENOSYS;
 	snd_pcm_unlock(pcm->fast_op_arg);
 	return err;
@@ -1272,9 +1310,12 @@ int snd_pcm_reset(snd_pcm_t *pcm)
 		return -EIO;
 	}
 	snd_pcm_lock(pcm->fast_op_arg);
-	if (pcm->fast_ops->reset)
+	if (pcm->fast_ops->reset) {
+		unsigned long long start = snd_pcm_trace_begin();
+
 		err = pcm->fast_ops->reset(pcm->fast_op_arg);
-	else
+		snd_pcm_trace(pcm, PCM_TRACE_RESET, start, err);
+	} else
 		err = -ENOSYS;
 	snd_pcm_unlock(pcm->fast_op_arg);
 	return err;
@@ -1332,9 +1373,12 @@ int snd_pcm_drop(snd_pcm_t *pcm)
 	if (err < 0)
 		return err;
 	snd_pcm_lock(pcm->fast_op_arg);
-	if (pcm->fast_ops->drop)
+	if (pcm->fast_ops->drop) {
+		unsigned long long start = snd_pcm_trace_begin();
+
 		err = pcm->fast_ops->drop(pcm->fast_op_arg);
-	else
+		snd_pcm_trace(pcm, PCM_TRACE_DROP, start, err);
+	} else
 		err = -ENOSYS;
 	snd_pcm_unlock(pcm->fast_op_arg);
 	return err;
@@ -1370,9 +1414,12 @@ int snd_pcm_drain(snd_pcm_t *pcm)
 	if (err == 1)
 		return 0;
 	/* lock handled in the callback */
-	if (pcm->fast_ops->drain)
+	if (pcm->fast_ops->drain) {
+		unsigned long long start = snd_pcm_trace_begin();
+
 		err = pcm->fast_ops->drain(pcm->fast_op_arg);
-	else
+		snd_pcm_trace(pcm, PCM_TRACE_DRAIN, start, err);
+	} else
 		err = -ENOSYS;
 	return err;
 }
@@ -1402,9 +1449,13 @@ int snd_pcm_pause(snd_pcm_t *pcm, int enable)
 	if (err < 0)
 		return err;
 	snd_pcm_lock(pcm->fast_op_arg);
-	if (pcm->fast_ops->pause)
+	if (pcm->fast_ops->pause) {
+		unsigned long long start = snd_pcm_trace_begin();
+
 		err = pcm->fast_ops->pause(pcm->fast_op_arg, enable);
-	else
+		snd_pcm_trace(pcm, enable ? PCM_TRACE_PAUSE : PCM_TRACE_RELEASE,
+			      start, err);
+	} else
 		err = -ENOSYS;
 	snd_pcm_unlock(pcm->fast_op_arg);
 	return err;
@@ -2396,6 +2447,16 @@ int snd_pcm_dump_setup(snd_pcm_t *pcm, snd_output_t *out)
 {
 	snd_pcm_dump_hw_setup(pcm, out);
 	snd_pcm_dump_sw_setup(pcm, out);
+	if (pcm->perf.enabled) {
+		const snd_pcm_perf_counters_t *c = &pcm->perf.c;
+
+		snd_output_printf(out, "  perf_calls   : %llu\n", c->calls);
+		snd_output_printf(out, "  perf_frames  : %llu\n", c->frames);
+		snd_output_printf(out, "  perf_time    : %llu ns (max %llu ns)\n",
+				  c->total_ns, c->max_ns);
+		snd_output_printf(out, "  perf_syscalls: %llu\n", c->syscalls);
+		snd_output_printf(out, "  perf_xruns   : %llu\n", c->xruns);
+	}
 	return 0;
 }
 
@@ -2439,6 +2500,75 @@ int snd_pcm_dump(snd_pcm_t *pcm, snd_output_t *out)
 	return err;
 }
 
+/**
+ * \brief Enable or disable the performance counters of a PCM
+ * \param pcm PCM handle
+ * \param enable 1 = enable, 0 = disable
+ * \return 0 on success otherwise a negative error code
+ *
+ * The counters record the processing calls of this PCM (the transfers
+ * of the hw plugin, the conversions of the plugins, the mixing of the
+ * direct plugins), the frames processed, their cumulative and maximal
+ * duration, the system calls issued on the data path and the detected
+ * xruns.  The time of a plugin excludes its slave, so the expensive
+ * stage of a chain is the one with the largest time.
+ *
+ * This function affects only the given handle and the conversions
+ * inserted later by a plug PCM.  The environment variable
+ * \c LIBASOUND_PCM_PERF set to \c 1 enables the counters of every PCM
+ * at open, including the slaves of the plugins, which are printed by
+ * #snd_pcm_dump().  The counters are not reset.
+ */
+int snd_pcm_perf_enable(snd_pcm_t *pcm, int enable)
+{
+	assert(pcm);
+	snd_pcm_lock(pcm->fast_op_arg);
+	pcm->perf.enabled = !!enable;
+	pcm->fast_op_arg->perf.enabled = !!enable;
+	snd_pcm_unlock(pcm->fast_op_arg);
+	return 0;
+}
+
+/**
+ * \brief Get the performance counters of a PCM
+ * \param pcm PCM handle
+ * \param counters Returned counters
+ * \return 0 on success, -ENOENT if the counters are disabled
+ *
+ * See #snd_pcm_perf_enable() for the meaning of the counters.  The
+ * counters of a plug PCM are those of the first conversion it inserted,
+ * which does the transfers.
+ */
+int snd_pcm_perf_get(snd_pcm_t *pcm, snd_pcm_perf_counters_t *counters)
+{
+	int err = 0;
+
+	assert(pcm && counters);
+	pcm = pcm->fast_op_arg;
+	snd_pcm_lock(pcm);
+	if (pcm->perf.enabled)
+		*counters = pcm->perf.c;
+	else
+		err = -ENOENT;
+	snd_pcm_unlock(pcm);
+	return err;
+}
+
+/**
+ * \brief Reset the performance counters of a PCM
+ * \param pcm PCM handle
+ * \return 0 on success otherwise a negative error code
+ */
+int snd_pcm_perf_reset(snd_pcm_t *pcm)
+{
+	assert(pcm);
+	pcm = pcm->fast_op_arg;
+	snd_pcm_lock(pcm);
+	memset(&pcm->perf.c, 0, sizeof(pcm->perf.c));
+	snd_pcm_unlock(pcm);
+	return 0;
+}
+
 /**
  * \brief Convert bytes in frames for a PCM
  * \param pcm PCM handle
@@ -2586,6 +2716,7 @@ static int snd_pcm_open_conf(snd_pcm_t **pcmp, const char *name,
 		free(val);
 		return -EINVAL;
 	}
+	snd_pcm_refine_open_conf(name, pcm_conf, stream, mode);
 	err = snd_config_search(pcm_conf, "type", &conf);
 	if (err < 0) {
 		SNDERR("type is not defined");
@@ -2744,6 +2875,7 @@ static int snd_pcm_open_noupdate(snd_pcm_t **pcmp, snd_config_t *root,
 int snd_pcm_open(snd_pcm_t **pcmp, const char *name, 
 		 snd_pcm_stream_t stream, int mode)
 {
+	struct snd_pcm_refine_open open;
 	snd_config_t *top;
 	int err;
 
@@ -2757,7 +2889,9 @@ int snd_pcm_open(snd_pcm_t **pcmp, const char *name,
 		if (err < 0)
 			return err;
 	}
+	snd_pcm_refine_open_begin(&open);
 	err = snd_pcm_open_noupdate(pcmp, top, name, stream, mode, 0);
+	snd_pcm_refine_open_end(&open, err);
 	snd_config_unref(top);
 	return err;
 }
@@ -2775,8 +2909,14 @@ int snd_pcm_open_lconf(snd_pcm_t **pcmp, const char *name,
 		       snd_pcm_stream_t stream, int mode,
 		       snd_config_t *lconf)
 {
+	struct snd_pcm_refine_open open;
+	int err;
+
 	assert(pcmp && name && lconf);
-	return snd_pcm_open_noupdate(pcmp, lconf, name, stream, mode, 0);
+	snd_pcm_refine_open_begin(&open);
+	err = snd_pcm_open_noupdate(pcmp, lconf, name, stream, mode, 0);
+	snd_pcm_refine_open_end(&open, err);
+	return err;
 }
 
 /**
@@ -2804,6 +2944,18 @@ int snd_pcm_open_fallback(snd_pcm_t **pcmp, snd_config_t *root,
 }
 
 #ifndef DOC_HIDDEN
+static int snd_pcm_perf_default(void)
+{
+	static int enabled = -1;	/* uninitialized */
+
+	/* evaluate env var only once at the first open for consistency */
+	if (enabled < 0) {
+		const char *p = getenv("LIBASOUND_PCM_PERF");
+		enabled = p && *p && *p != '0';
+	}
+	return enabled;
+}
+
 int snd_pcm_new(snd_pcm_t **pcmp, snd_pcm_type_t type, const char *name,
 		snd_pcm_stream_t stream, int mode)
 {
@@ -2851,6 +3003,9 @@ int snd_pcm_new(snd_pcm_t **pcmp, snd_pcm_type_t type, const char *name,
 		pcm->lock_enabled = do_lock_enable;
 	}
 #endif
+	pcm->perf.enabled = snd_pcm_perf_default();
+	snd_pcm_trace_init();
+	snd_pcm_refine_new(pcm);
 	*pcmp = pcm;
 	return 0;
 }
@@ -2858,6 +3013,7 @@ int snd_pcm_new(snd_pcm_t **pcmp, snd_pcm_type_t type, const char *name,
 int snd_pcm_free(snd_pcm_t *pcm)
 {
 	assert(pcm);
+	snd_pcm_refine_free(pcm);
 	free(pcm->name);
 	free(pcm->hw.link_dst);
 	free(pcm->appl.link_dst);
@@ -2990,9 +3146,12 @@ int snd_pcm_wait_nocheck(snd_pcm_t *pcm, int timeout)
 	else if (timeout < -1)
 		SNDMSG("invalid snd_pcm_wait timeout argument %d", timeout);
 	do {
+		unsigned long long start = snd_pcm_trace_wakeup_begin();
+
 		__snd_pcm_unlock(pcm->fast_op_arg);
 		err_poll = poll(pfd, npfds, timeout);
 		__snd_pcm_lock(pcm->fast_op_arg);
+		snd_pcm_trace_wakeup(pcm, start, err_poll < 0 ? -errno : err_poll);
 		if (err_poll < 0) {
 			if (errno == EINTR && !PCMINABORT(pcm) && !(pcm->mode & SND_PCM_EINTR))
 		                continue;
@@ -7543,9 +7702,14 @@ snd_pcm_sframes_t __snd_pcm_mmap_commit(snd_pcm_t *pcm,
 		       snd_pcm_mmap_avail(pcm));
 		return -EPIPE;
 	}
-	if (pcm->fast_ops->mmap_commit)
-		return pcm->fast_ops->mmap_commit(pcm->fast_op_arg, offset, frames);
-	else
+	if (pcm->fast_ops->mmap_commit) {
+		unsigned long long start = snd_pcm_trace_begin();
+		snd_pcm_sframes_t result;
+
+		result = pcm->fast_ops->mmap_commit(pcm->fast_op_arg, offset, frames);
+		snd_pcm_trace(pcm, PCM_TRACE_COMMIT, start, result);
+		return result;
+	} else
 		return -ENOSYS;
 }
 
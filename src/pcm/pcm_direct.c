@@ -529,32 +529,30 @@ int snd_pcm_direct_async(snd_pcm_t *pcm, int sig, pid_t pid)
 int snd_pcm_direct_clear_timer_queue(snd_pcm_direct_t *dmix)
 {
 	int changed = 0;
-	if (dmix->timer_need_poll) {
+	if (dmix->tread) {
+		/* drain the queue with as few reads as possible */
+		snd_timer_tread_t rbuf[32];
+		ssize_t len;
+		do {
+			if (dmix->timer_need_poll &&
+			    poll(&dmix->timer_fd, 1, 0) <= 0)
+				break;
+			len = snd_timer_read_batch(dmix->timer, rbuf,
+						   ARRAY_SIZE(rbuf), NULL);
+			if (len > 0)
+				changed++;
+		} while (len == ARRAY_SIZE(rbuf));
+	} else if (dmix->timer_need_poll) {
 		while (poll(&dmix->timer_fd, 1, 0) > 0) {
+			snd_timer_read_t rbuf;
 			changed++;
 			/* we don't need the value */
-			if (dmix->tread) {
-				snd_timer_tread_t rbuf[4];
-				snd_timer_read(dmix->timer, rbuf, sizeof(rbuf));
-			} else {
-				snd_timer_read_t rbuf;
-				snd_timer_read(dmix->timer, &rbuf, sizeof(rbuf));
-			}
+			snd_timer_read(dmix->timer, &rbuf, sizeof(rbuf));
 		}
 	} else {
-		if (dmix->tread) {
-			snd_timer_tread_t rbuf[4];
-			int len;
-			while ((len = snd_timer_read(dmix->timer, rbuf,
-						     sizeof(rbuf))) > 0
-						     && (++changed) &&
-			       len != sizeof(rbuf[0]))
-				;
-		} else {
-			snd_timer_read_t rbuf;
-			while (snd_timer_read(dmix->timer, &rbuf, sizeof(rbuf)) > 0)
-				changed++;
-		}
+		snd_timer_read_t rbuf;
+		while (snd_timer_read(dmix->timer, &rbuf, sizeof(rbuf)) > 0)
+			changed++;
 	}
 	return changed;
 }
@@ -701,6 +699,7 @@ int snd_pcm_direct_check_xrun(snd_pcm_direct_t *direct, snd_pcm_t *pcm)
 			return -ESTRPIPE;
 		} else {
 			direct->state = SND_PCM_STATE_XRUN;
+			snd_pcm_perf_xrun(&pcm->perf);
 			return -EPIPE;
 		}
 	}
@@ -313,8 +313,9 @@ static void snd_pcm_dmix_sync_area(snd_pcm_t *pcm)
 {
 	snd_pcm_direct_t *dmix = pcm->private_data;
 	snd_pcm_uframes_t slave_hw_ptr, slave_appl_ptr, slave_size;
-	snd_pcm_uframes_t appl_ptr, size, transfer;
+	snd_pcm_uframes_t appl_ptr, size, transfer, mixed;
 	const snd_pcm_channel_area_t *src_areas, *dst_areas;
+	unsigned long long start;
 	
 	/* calculate the size to transfer */
 	/* check the available size in the local buffer
@@ -364,6 +365,8 @@ static void snd_pcm_dmix_sync_area(snd_pcm_t *pcm)
 	slave_appl_ptr = dmix->slave_appl_ptr % dmix->slave_buffer_size;
 	dmix->slave_appl_ptr += size;
 	dmix->slave_appl_ptr %= dmix->slave_boundary;
+	start = snd_pcm_perf_begin(&pcm->perf);
+	mixed = size;
 	dmix_down_sem(dmix);
 	for (;;) {
 		transfer = size;
@@ -381,6 +384,7 @@ static void snd_pcm_dmix_sync_area(snd_pcm_t *pcm)
 		appl_ptr %= pcm->buffer_size;
 	}
 	dmix_up_sem(dmix);
+	snd_pcm_perf_end(&pcm->perf, start, mixed);
 }
 
 /*
@@ -413,6 +417,7 @@ static int snd_pcm_dmix_sync_ptr0(snd_pcm_t *pcm, snd_pcm_uframes_t slave_hw_ptr
 		gettimestamp(&dmix->trigger_tstamp, pcm->tstamp_type);
 		if (dmix->state == SND_PCM_STATE_RUNNING) {
 			dmix->state = SND_PCM_STATE_XRUN;
+			snd_pcm_perf_xrun(&pcm->perf);
 			return -EPIPE;
 		}
 		dmix->state = SND_PCM_STATE_SETUP;
@@ -109,8 +109,9 @@ static void snd_pcm_dshare_sync_area(snd_pcm_t *pcm)
 {
 	snd_pcm_direct_t *dshare = pcm->private_data;
 	snd_pcm_uframes_t slave_hw_ptr, slave_appl_ptr, slave_size;
-	snd_pcm_uframes_t appl_ptr, size;
+	snd_pcm_uframes_t appl_ptr, size, shared;
 	const snd_pcm_channel_area_t *src_areas, *dst_areas;
+	unsigned long long start;
 	
 	/* calculate the size to transfer */
 	size = pcm_frame_diff(dshare->appl_ptr, dshare->last_appl_ptr, pcm->boundary);
@@ -139,6 +140,8 @@ static void snd_pcm_dshare_sync_area(snd_pcm_t *pcm)
 	slave_appl_ptr = dshare->slave_appl_ptr % dshare->slave_buffer_size;
 	dshare->slave_appl_ptr += size;
 	dshare->slave_appl_ptr %= dshare->slave_boundary;
+	start = snd_pcm_perf_begin(&pcm->perf);
+	shared = size;
 	for (;;) {
 		snd_pcm_uframes_t transfer = size;
 		if (appl_ptr + transfer > pcm->buffer_size)
@@ -154,6 +157,7 @@ static void snd_pcm_dshare_sync_area(snd_pcm_t *pcm)
 		appl_ptr += transfer;
 		appl_ptr %= pcm->buffer_size;
 	}
+	snd_pcm_perf_end(&pcm->perf, start, shared);
 }
 
 /*
@@ -188,6 +192,7 @@ static int snd_pcm_dshare_sync_ptr0(snd_pcm_t *pcm, snd_pcm_uframes_t slave_hw_p
 		gettimestamp(&dshare->trigger_tstamp, pcm->tstamp_type);
 		if (dshare->state == SND_PCM_STATE_RUNNING) {
 			dshare->state = SND_PCM_STATE_XRUN;
+			snd_pcm_perf_xrun(&pcm->perf);
 			return -EPIPE;
 		}
 		dshare->state = SND_PCM_STATE_SETUP;
@@ -106,6 +106,8 @@ static void snd_pcm_dsnoop_sync_area(snd_pcm_t *pcm, snd_pcm_uframes_t slave_hw_
 	snd_pcm_uframes_t hw_ptr = dsnoop->hw_ptr;
 	snd_pcm_uframes_t transfer;
 	const snd_pcm_channel_area_t *src_areas, *dst_areas;
+	unsigned long long start = snd_pcm_perf_begin(&pcm->perf);
+	snd_pcm_uframes_t snooped = size;
 	
 	/* add sample areas here */
 	dst_areas = snd_pcm_mmap_areas(pcm);
@@ -123,6 +125,7 @@ static void snd_pcm_dsnoop_sync_area(snd_pcm_t *pcm, snd_pcm_uframes_t slave_hw_
 		hw_ptr += transfer;
 		hw_ptr %= pcm->buffer_size;
 	}
+	snd_pcm_perf_end(&pcm->perf, start, snooped);
 }
 
 /*
@@ -156,6 +159,7 @@ static int snd_pcm_dsnoop_sync_ptr(snd_pcm_t *pcm)
 		gettimestamp(&dsnoop->trigger_tstamp, pcm->tstamp_type);
 		dsnoop->state = SND_PCM_STATE_XRUN;
 		dsnoop->avail_max = avail;
+		snd_pcm_perf_xrun(&pcm->perf);
 		return -EPIPE;
 	}
 	if (avail > dsnoop->avail_max)
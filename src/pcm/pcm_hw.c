@@ -97,6 +97,10 @@ typedef struct {
 	bool mmap_status_fallbacked;
 	bool mmap_control_fallbacked;
 	struct snd_pcm_sync_ptr *sync_ptr;
+	unsigned long sync_ptr_calls;	/* SNDRV_PCM_IOCTL_SYNC_PTR calls */
+	long long sync_ptr_stamp;	/* time of the reusable status, 0 = none */
+	unsigned int sync_ptr_gen;	/* hw_state_gen at sync_ptr_stamp */
+	snd_pcm_perf_t *perf;		/* counters of the PCM */
 
 	bool prepare_reset_sw_params;
 	bool perfect_drain;
@@ -122,6 +126,17 @@ typedef struct {
 #define SNDRV_FILE_PCM_STREAM_CAPTURE		ALSA_DEVICE_DIRECTORY "pcmC%iD%ic"
 #define SNDRV_PCM_VERSION_MAX			SNDRV_PROTOCOL_VERSION(2, 0, 9)
 
+/* how old the status of the last SYNC_PTR call may be to answer a query */
+#define SYNC_PTR_FRESH_NS			100000
+
+/*
+ * Bumped by the ioctls changing the state of a stream (also prepare, reset,
+ * link and unlink).  It is process wide, so it also covers the streams of
+ * the link group, which the kernel changes together and the library does
+ * not track.
+ */
+static unsigned int hw_state_gen;
+
 /* update appl_ptr with driver */
 #define FAST_PCM_STATE(hw) \
 	((snd_pcm_state_t) (hw)->mmap_status->state)
@@ -139,15 +154,48 @@ struct timespec snd_pcm_hw_fast_tstamp(snd_pcm_t *pcm)
 }
 #endif /* DOC_HIDDEN */
 
+static int sync_ptr_batch_enabled(void)
+{
+	static int enabled = -1;	/* uninitialized */
+
+	/* evaluate env var only once at the first call for consistency */
+	if (enabled < 0) {
+		const char *p = getenv("LIBASOUND_SYNC_PTR_BATCH");
+		enabled = !p || *p != '0';
+	}
+	return enabled;
+}
+
+static long long hw_now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+static inline void hw_state_changed(void)
+{
+	__atomic_add_fetch(&hw_state_gen, 1, __ATOMIC_RELAXED);
+}
+
 static int sync_ptr1(snd_pcm_hw_t *hw, unsigned int flags)
 {
 	int err;
 	hw->sync_ptr->flags = flags;
+	hw->sync_ptr_calls++;
+	hw->sync_ptr_stamp = 0;
+	snd_pcm_perf_syscall(hw->perf);
 	if (ioctl(hw->fd, SNDRV_PCM_IOCTL_SYNC_PTR, hw->sync_ptr) < 0) {
 		err = -errno;
 		SYSMSG("SNDRV_PCM_IOCTL_SYNC_PTR failed (%i)", err);
 		return err;
 	}
+	/* every call returns the current status, whatever the flags are */
+	if (sync_ptr_batch_enabled()) {
+		hw->sync_ptr_gen = __atomic_load_n(&hw_state_gen, __ATOMIC_RELAXED);
+		hw->sync_ptr_stamp = hw_now_ns();
+	}
 	return 0;
 }
 
@@ -212,17 +260,45 @@ static int query_status_data(snd_pcm_hw_t *hw)
 			 SNDRV_PCM_SYNC_PTR_AVAIL_MIN);
 }
 
+/*
+ * Refresh the status for a query which does not change anything.  The
+ * status returned by the previous call (e.g. the appl_ptr update of the
+ * last mmap_commit) answers one such query when it is recent and no
+ * stream changed its state meanwhile, so the usual avail_update after
+ * a commit or the state check before a transfer costs no extra ioctl.
+ */
+static int refresh_status_data(snd_pcm_hw_t *hw)
+{
+	long long stamp = hw->sync_ptr_stamp;
+
+	if (!hw->mmap_status_fallbacked)
+		return 0;
+	if (stamp) {
+		hw->sync_ptr_stamp = 0;
+		if (hw->sync_ptr_gen == __atomic_load_n(&hw_state_gen, __ATOMIC_RELAXED) &&
+		    hw_now_ns() - stamp <= SYNC_PTR_FRESH_NS)
+			return 0;
+	}
+	return query_status_data(hw);
+}
+
 static int snd_pcm_hw_clear_timer_queue(snd_pcm_hw_t *hw)
 {
-	if (hw->period_timer_need_poll) {
-		while (poll(&hw->period_timer_pfd, 1, 0) > 0) {
-			snd_timer_tread_t rbuf[4];
+	snd_timer_tread_t rbuf[32];
+	ssize_t len;
+
+	do {
+		if (hw->period_timer_need_poll &&
+		    poll(&hw->period_timer_pfd, 1, 0) <= 0)
+			break;
+		len = snd_timer_read_batch(hw->period_timer, rbuf,
+					   ARRAY_SIZE(rbuf), NULL);
+		if (len == -EINVAL) {
+			/* opened without tread */
 			snd_timer_read(hw->period_timer, rbuf, sizeof(rbuf));
+			break;
 		}
-	} else {
-		snd_timer_tread_t rbuf[4];
-		snd_timer_read(hw->period_timer, rbuf, sizeof(rbuf));
-	}
+	} while (len == ARRAY_SIZE(rbuf));
 	return 0;
 }
 
@@ -518,6 +594,7 @@ static int snd_pcm_hw_hw_free(snd_pcm_t *pcm)
 		SYSMSG("SNDRV_PCM_IOCTL_HW_FREE failed (%i)", err);
 		return err;
 	}
+	hw_state_changed();
 	return 0;
 }
 
@@ -607,18 +684,21 @@ static int snd_pcm_hw_status(snd_pcm_t *pcm, snd_pcm_status_t * status)
 	snd_pcm_hw_t *hw = pcm->private_data;
 	int fd = hw->fd, err;
 	if (SNDRV_PROTOCOL_VERSION(2, 0, 13) > hw->version) {
+		snd_pcm_perf_syscall(&pcm->perf);
 		if (ioctl(fd, SNDRV_PCM_IOCTL_STATUS, status) < 0) {
 			err = -errno;
 			SYSMSG("SNDRV_PCM_IOCTL_STATUS failed (%i)", err);
 			return err;
 		}
 	} else {
+		snd_pcm_perf_syscall(&pcm->perf);
 		if (ioctl(fd, SNDRV_PCM_IOCTL_STATUS_EXT, status) < 0) {
 			err = -errno;
 			SYSMSG("SNDRV_PCM_IOCTL_STATUS_EXT failed (%i)", err);
 			return err;
 		}
 	}
+	hw_state_changed();
 	if (SNDRV_PROTOCOL_VERSION(2, 0, 5) > hw->version) {
 		status->tstamp.tv_nsec *= 1000L;
 		status->trigger_tstamp.tv_nsec *= 1000L;
@@ -631,7 +711,7 @@ static snd_pcm_state_t snd_pcm_hw_state(snd_pcm_t *pcm)
 	snd_pcm_hw_t *hw = pcm->private_data;
 	/* the -ENODEV may come from the snd_disconnect_ioctl() or
 	   snd_power_wait() in kernel */
-	if (query_status_data(hw) == -ENODEV)
+	if (refresh_status_data(hw) == -ENODEV)
 		return SND_PCM_STATE_DISCONNECTED;
 	return (snd_pcm_state_t) hw->mmap_status->state;
 }
@@ -640,11 +720,13 @@ static int snd_pcm_hw_delay(snd_pcm_t *pcm, snd_pcm_sframes_t *delayp)
 {
 	snd_pcm_hw_t *hw = pcm->private_data;
 	int fd = hw->fd, err;
+	snd_pcm_perf_syscall(&pcm->perf);
 	if (ioctl(fd, SNDRV_PCM_IOCTL_DELAY, delayp) < 0) {
 		err = -errno;
 		SYSMSG("SNDRV_PCM_IOCTL_DELAY failed (%i)", err);
 		return err;
 	}
+	hw_state_changed();
 	return 0;
 }
 
@@ -658,11 +740,13 @@ static int snd_pcm_hw_hwsync(snd_pcm_t *pcm)
 			if (err < 0)
 				return err;
 		} else {
+			snd_pcm_perf_syscall(&pcm->perf);
 			if (ioctl(fd, SNDRV_PCM_IOCTL_HWSYNC) < 0) {
 				err = -errno;
 				SYSMSG("SNDRV_PCM_IOCTL_HWSYNC failed (%i)", err);
 				return err;
 			}
+			hw_state_changed();
 		}
 	} else {
 		snd_pcm_sframes_t delay;
@@ -695,11 +779,14 @@ static int snd_pcm_hw_prepare(snd_pcm_t *pcm)
 		}
 		hw->prepare_reset_sw_params = false;
 	}
+	snd_pcm_perf_syscall(&pcm->perf);
 	if (ioctl(fd, SNDRV_PCM_IOCTL_PREPARE) < 0) {
 		err = -errno;
 		SYSMSG("SNDRV_PCM_IOCTL_PREPARE failed (%i)", err);
 		return err;
 	}
+	/* the linked streams are prepared, too */
+	hw_state_changed();
 	return query_status_and_control_data(hw);
 }
 
@@ -707,11 +794,13 @@ static int snd_pcm_hw_reset(snd_pcm_t *pcm)
 {
 	snd_pcm_hw_t *hw = pcm->private_data;
 	int fd = hw->fd, err;
+	snd_pcm_perf_syscall(&pcm->perf);
 	if (ioctl(fd, SNDRV_PCM_IOCTL_RESET) < 0) {
 		err = -errno;
 		SYSMSG("SNDRV_PCM_IOCTL_RESET failed (%i)", err);
 		return err;
 	}
+	hw_state_changed();
 	return query_status_and_control_data(hw);
 }
 
@@ -724,6 +813,7 @@ static int snd_pcm_hw_start(snd_pcm_t *pcm)
 	       snd_pcm_mmap_playback_hw_avail(pcm) > 0);
 #endif
 	issue_applptr(hw);
+	snd_pcm_perf_syscall(&pcm->perf);
 	if (ioctl(hw->fd, SNDRV_PCM_IOCTL_START) < 0) {
 		err = -errno;
 		SYSMSG("SNDRV_PCM_IOCTL_START failed (%i)", err);
@@ -733,6 +823,7 @@ static int snd_pcm_hw_start(snd_pcm_t *pcm)
 #endif
 		return err;
 	}
+	hw_state_changed();
 	return 0;
 }
 
@@ -740,12 +831,13 @@ static int snd_pcm_hw_drop(snd_pcm_t *pcm)
 {
 	snd_pcm_hw_t *hw = pcm->private_data;
 	int err;
+	snd_pcm_perf_syscall(&pcm->perf);
 	if (ioctl(hw->fd, SNDRV_PCM_IOCTL_DROP) < 0) {
 		err = -errno;
 		SYSMSG("SNDRV_PCM_IOCTL_DROP failed (%i)", err);
 		return err;
-	} else {
 	}
+	hw_state_changed();
 	return 0;
 }
 
@@ -798,11 +890,13 @@ __manual_silence:
 		hw->prepare_reset_sw_params = true;
 	}
 __skip_silence:
+	snd_pcm_perf_syscall(&pcm->perf);
 	if (ioctl(hw->fd, SNDRV_PCM_IOCTL_DRAIN) < 0) {
 		err = -errno;
 		SYSMSG("SNDRV_PCM_IOCTL_DRAIN failed (%i)", err);
 		return err;
 	}
+	hw_state_changed();
 	return 0;
 }
 
@@ -810,11 +904,13 @@ static int snd_pcm_hw_pause(snd_pcm_t *pcm, int enable)
 {
 	snd_pcm_hw_t *hw = pcm->private_data;
 	int err;
+	snd_pcm_perf_syscall(&pcm->perf);
 	if (ioctl(hw->fd, SNDRV_PCM_IOCTL_PAUSE, enable) < 0) {
 		err = -errno;
 		SYSMSG("SNDRV_PCM_IOCTL_PAUSE failed (%i)", err);
 		return err;
 	}
+	hw_state_changed();
 	return 0;
 }
 
@@ -827,6 +923,7 @@ static snd_pcm_sframes_t snd_pcm_hw_rewind(snd_pcm_t *pcm, snd_pcm_uframes_t fra
 {
 	snd_pcm_hw_t *hw = pcm->private_data;
 	int err;
+	snd_pcm_perf_syscall(&pcm->perf);
 	if (ioctl(hw->fd, SNDRV_PCM_IOCTL_REWIND, &frames) < 0) {
 		err = -errno;
 		SYSMSG("SNDRV_PCM_IOCTL_REWIND failed (%i)", err);
@@ -848,6 +945,7 @@ static snd_pcm_sframes_t snd_pcm_hw_forward(snd_pcm_t *pcm, snd_pcm_uframes_t fr
 	snd_pcm_hw_t *hw = pcm->private_data;
 	int err;
 	if (SNDRV_PROTOCOL_VERSION(2, 0, 4) <= hw->version) {
+		snd_pcm_perf_syscall(&pcm->perf);
 		if (ioctl(hw->fd, SNDRV_PCM_IOCTL_FORWARD, &frames) < 0) {
 			err = -errno;
 			SYSMSG("SNDRV_PCM_IOCTL_FORWARD failed (%i)", err);
@@ -885,11 +983,13 @@ static int snd_pcm_hw_resume(snd_pcm_t *pcm)
 {
 	snd_pcm_hw_t *hw = pcm->private_data;
 	int fd = hw->fd, err;
+	snd_pcm_perf_syscall(&pcm->perf);
 	if (ioctl(fd, SNDRV_PCM_IOCTL_RESUME) < 0) {
 		err = -errno;
 		SYSMSG("SNDRV_PCM_IOCTL_RESUME failed (%i)", err);
 		return err;
 	}
+	hw_state_changed();
 	return 0;
 }
 
@@ -901,6 +1001,7 @@ static int hw_link(snd_pcm_t *pcm1, snd_pcm_t *pcm2)
 		SYSMSG("SNDRV_PCM_IOCTL_LINK failed (%i)", -errno);
 		return -errno;
 	}
+	hw_state_changed();
 	return 0;
 }
 
@@ -931,6 +1032,7 @@ static int snd_pcm_hw_unlink(snd_pcm_t *pcm)
 		SYSMSG("SNDRV_PCM_IOCTL_UNLINK failed (%i)", -errno);
 		return -errno;
 	}
+	hw_state_changed();
 	return 0;
 }
 
@@ -939,14 +1041,20 @@ static snd_pcm_sframes_t snd_pcm_hw_writei(snd_pcm_t *pcm, const void *buffer, s
 	int err;
 	snd_pcm_hw_t *hw = pcm->private_data;
 	int fd = hw->fd;
+	unsigned long long start;
 	struct snd_xferi xferi;
 	xferi.buf = (char*) buffer;
 	xferi.frames = size;
 	xferi.result = 0; /* make valgrind happy */
+	start = snd_pcm_perf_begin(&pcm->perf);
+	snd_pcm_perf_syscall(&pcm->perf);
 	if (ioctl(fd, SNDRV_PCM_IOCTL_WRITEI_FRAMES, &xferi) < 0)
 		err = -errno;
 	else
 		err = query_status_and_control_data(hw);
+	snd_pcm_perf_end(&pcm->perf, start, xferi.result);
+	if (err == -EPIPE)
+		snd_pcm_perf_xrun(&pcm->perf);
 #ifdef DEBUG_RW
 	fprintf(stderr, "hw_writei: frames = %li, xferi.result = %li, err = %i\n", size, xferi.result, err);
 #endif
@@ -960,14 +1068,20 @@ static snd_pcm_sframes_t snd_pcm_hw_writen(snd_pcm_t *pcm, void **bufs, snd_pcm_
 	int err;
 	snd_pcm_hw_t *hw = pcm->private_data;
 	int fd = hw->fd;
+	unsigned long long start;
 	struct snd_xfern xfern;
 	memset(&xfern, 0, sizeof(xfern)); /* make valgrind happy */
 	xfern.bufs = bufs;
 	xfern.frames = size;
+	start = snd_pcm_perf_begin(&pcm->perf);
+	snd_pcm_perf_syscall(&pcm->perf);
 	if (ioctl(fd, SNDRV_PCM_IOCTL_WRITEN_FRAMES, &xfern) < 0)
 		err = -errno;
 	else
 		err = query_status_and_control_data(hw);
+	snd_pcm_perf_end(&pcm->perf, start, xfern.result);
+	if (err == -EPIPE)
+		snd_pcm_perf_xrun(&pcm->perf);
 #ifdef DEBUG_RW
 	fprintf(stderr, "hw_writen: frames = %li, result = %li, err = %i\n", size, xfern.result, err);
 #endif
@@ -981,14 +1095,20 @@ static snd_pcm_sframes_t snd_pcm_hw_readi(snd_pcm_t *pcm, void *buffer, snd_pcm_
 	int err;
 	snd_pcm_hw_t *hw = pcm->private_data;
 	int fd = hw->fd;
+	unsigned long long start;
 	struct snd_xferi xferi;
 	xferi.buf = buffer;
 	xferi.frames = size;
 	xferi.result = 0; /* make valgrind happy */
+	start = snd_pcm_perf_begin(&pcm->perf);
+	snd_pcm_perf_syscall(&pcm->perf);
 	if (ioctl(fd, SNDRV_PCM_IOCTL_READI_FRAMES, &xferi) < 0)
 		err = -errno;
 	else
 		err = query_status_and_control_data(hw);
+	snd_pcm_perf_end(&pcm->perf, start, xferi.result);
+	if (err == -EPIPE)
+		snd_pcm_perf_xrun(&pcm->perf);
 #ifdef DEBUG_RW
 	fprintf(stderr, "hw_readi: frames = %li, result = %li, err = %i\n", size, xferi.result, err);
 #endif
@@ -1002,14 +1122,20 @@ static snd_pcm_sframes_t snd_pcm_hw_readn(snd_pcm_t *pcm, void **bufs, snd_pcm_u
 	int err;
 	snd_pcm_hw_t *hw = pcm->private_data;
 	int fd = hw->fd;
+	unsigned long long start;
 	struct snd_xfern xfern;
 	memset(&xfern, 0, sizeof(xfern)); /* make valgrind happy */
 	xfern.bufs = bufs;
 	xfern.frames = size;
+	start = snd_pcm_perf_begin(&pcm->perf);
+	snd_pcm_perf_syscall(&pcm->perf);
 	if (ioctl(fd, SNDRV_PCM_IOCTL_READN_FRAMES, &xfern) < 0)
 		err = -errno;
 	else
 		err = query_status_and_control_data(hw);
+	snd_pcm_perf_end(&pcm->perf, start, xfern.result);
+	if (err == -EPIPE)
+		snd_pcm_perf_xrun(&pcm->perf);
 #ifdef DEBUG_RW
 	fprintf(stderr, "hw_readn: frames = %li, result = %li, err = %i\n", size, xfern.result, err);
 #endif
@@ -1186,9 +1312,11 @@ static snd_pcm_sframes_t snd_pcm_hw_mmap_commit(snd_pcm_t *pcm,
 						snd_pcm_uframes_t size)
 {
 	snd_pcm_hw_t *hw = pcm->private_data;
+	unsigned long long start = snd_pcm_perf_begin(&pcm->perf);
 
 	snd_pcm_mmap_appl_forward(pcm, size);
 	issue_applptr(hw);
+	snd_pcm_perf_end(&pcm->perf, start, size);
 #ifdef DEBUG_MMAP
 	fprintf(stderr, "appl_forward: hw_ptr = %li, appl_ptr = %li, size = %li\n", *pcm->hw.ptr, *pcm->appl.ptr, size);
 #endif
@@ -1200,15 +1328,18 @@ static snd_pcm_sframes_t snd_pcm_hw_avail_update(snd_pcm_t *pcm)
 	snd_pcm_hw_t *hw = pcm->private_data;
 	snd_pcm_uframes_t avail;
 
-	query_status_data(hw);
+	refresh_status_data(hw);
 	avail = snd_pcm_mmap_avail(pcm);
 	switch (FAST_PCM_STATE(hw)) {
 	case SNDRV_PCM_STATE_RUNNING:
 		if (avail >= pcm->stop_threshold) {
+			snd_pcm_perf_xrun(&pcm->perf);
 			/* SNDRV_PCM_IOCTL_XRUN ioctl has been implemented since PCM kernel API 2.0.1 */
 			if (SNDRV_PROTOCOL_VERSION(2, 0, 1) <= hw->version) {
+				snd_pcm_perf_syscall(&pcm->perf);
 				if (ioctl(hw->fd, SNDRV_PCM_IOCTL_XRUN) < 0)
 					return -errno;
+				hw_state_changed();
 			}
 			/* everything is ok, state == SND_PCM_STATE_XRUN at the moment */
 			return -EPIPE;
@@ -1517,6 +1648,8 @@ static void snd_pcm_hw_dump(snd_pcm_t *pcm, snd_output_t *out)
 		snd_pcm_dump_setup(pcm, out);
 		snd_output_printf(out, "  appl_ptr     : %li\n", hw->mmap_control->appl_ptr);
 		snd_output_printf(out, "  hw_ptr       : %li\n", hw->mmap_status->hw_ptr);
+		if (hw->sync_ptr)
+			snd_output_printf(out, "  sync_ptr     : %lu calls\n", hw->sync_ptr_calls);
 	}
 }
 
@@ -1704,6 +1837,12 @@ int snd_pcm_hw_open_fd(snd_pcm_t **pcmp, const char *name, int fd,
 	hw->rates.min = hw->rates.max = 0;
 	hw->channels = 0;
 
+	/* the cached refinements are valid for the same device only */
+	snd_pcm_refine_open_data(info.id, sizeof(info.id));
+	snd_pcm_refine_open_data(info.name, sizeof(info.name));
+	snd_pcm_refine_open_data(&info.card, sizeof(info.card));
+	snd_pcm_refine_open_data(&info.device, sizeof(info.device));
+
 	ret = snd_pcm_new(&pcm, SND_PCM_TYPE_HW, name, info.stream, mode);
 	if (ret < 0) {
 		free(hw);
@@ -1714,6 +1853,7 @@ int snd_pcm_hw_open_fd(snd_pcm_t **pcmp, const char *name, int fd,
 	pcm->ops = &snd_pcm_hw_ops;
 	pcm->fast_ops = &snd_pcm_hw_fast_ops;
 	pcm->private_data = hw;
+	hw->perf = &pcm->perf;
 	pcm->poll_fd = fd;
 	pcm->poll_events = info.stream == SND_PCM_STREAM_PLAYBACK ? POLLOUT : POLLIN;
 	pcm->tstamp_type = tstamp_type;
@@ -1854,6 +1994,15 @@ pcm.name {
 }
 \endcode
 
+When the status and control structures cannot be mapped (or sync_ptr_ioctl
+is set), every pointer update and status query costs a SYNC_PTR ioctl.
+As each such call returns the current status, a recent one answers the
+following state or avail query, so e.g. an avail_update right after the
+appl_ptr update of a commit needs no ioctl of its own.  Any stream state
+change performed through the library cancels the reuse.  The number of
+SYNC_PTR calls is shown by snd_pcm_dump().  The reuse can be disabled by
+setting the environment variable LIBASOUND_SYNC_PTR_BATCH=0.
+
 \subsection pcm_plugins_hw_funcref Function reference
 
 <UL>
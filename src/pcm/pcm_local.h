@@ -191,6 +191,12 @@ typedef struct {
 	int (*mmap_begin)(snd_pcm_t *pcm, const snd_pcm_channel_area_t **areas, snd_pcm_uframes_t *offset, snd_pcm_uframes_t *frames); /* locked */
 } snd_pcm_fast_ops_t;
 
+/* performance counters of a PCM, see snd_pcm_perf_get() */
+typedef struct {
+	int enabled;
+	snd_pcm_perf_counters_t c;
+} snd_pcm_perf_t;
+
 struct _snd_pcm {
 	void *open_func;
 	char *name;
@@ -250,6 +256,9 @@ struct _snd_pcm {
 	snd_pcm_t *fast_op_arg;
 	void *private_data;
 	struct list_head async_handlers;
+	struct snd_pcm_refine_def *refine_def;	/* refine cache, NULL if none */
+	unsigned int refine_slot;	/* position in the opened chain */
+	snd_pcm_perf_t perf;		/* performance counters */
 #ifdef THREAD_SAFE_API
 	int need_lock;		/* true = this PCM (plugin) is thread-unsafe,
 				 * thus it needs a lock.
@@ -370,6 +379,34 @@ struct _snd_pcm {
 	snd1_pcm_hw_param_name
 #define snd_pcm_sw_params_current_no_lock \
 	snd1_pcm_sw_params_current_no_lock
+#define snd_pcm_refine_open_begin \
+	snd1_pcm_refine_open_begin
+#define snd_pcm_refine_open_end \
+	snd1_pcm_refine_open_end
+#define snd_pcm_refine_open_conf \
+	snd1_pcm_refine_open_conf
+#define snd_pcm_refine_open_data \
+	snd1_pcm_refine_open_data
+#define snd_pcm_refine_new \
+	snd1_pcm_refine_new
+#define snd_pcm_refine_free \
+	snd1_pcm_refine_free
+#define snd_pcm_refine_hits \
+	snd1_pcm_refine_hits
+#define snd_pcm_refine_flush \
+	snd1_pcm_refine_flush
+#define snd_pcm_trace_active \
+	snd1_pcm_trace_active
+#define snd_pcm_trace_init \
+	snd1_pcm_trace_init
+#define snd_pcm_trace_now \
+	snd1_pcm_trace_now
+#define snd_pcm_trace_enter \
+	snd1_pcm_trace_enter
+#define snd_pcm_trace_leave \
+	snd1_pcm_trace_leave
+#define snd_pcm_trace_event \
+	snd1_pcm_trace_event
 
 int snd_pcm_new(snd_pcm_t **pcmp, snd_pcm_type_t type, const char *name,
 		snd_pcm_stream_t stream, int mode);
@@ -437,18 +474,106 @@ snd_pcm_sframes_t __snd_pcm_mmap_commit(snd_pcm_t *pcm,
 					snd_pcm_uframes_t frames);
 int __snd_pcm_wait_in_lock(snd_pcm_t *pcm, int timeout);
 
+/* events of the PCM tracing, see pcm_trace.c */
+enum {
+	PCM_TRACE_AVAIL,	/* avail_update, the result is the avail */
+	PCM_TRACE_COMMIT,	/* mmap_commit */
+	PCM_TRACE_WRITE,	/* writei/writen */
+	PCM_TRACE_READ,		/* readi/readn */
+	PCM_TRACE_WAKEUP,	/* return from poll() in snd_pcm_wait() */
+	PCM_TRACE_PREPARE,
+	PCM_TRACE_RESET,
+	PCM_TRACE_START,
+	PCM_TRACE_DROP,
+	PCM_TRACE_DRAIN,
+	PCM_TRACE_PAUSE,
+	PCM_TRACE_RELEASE,	/* pause release */
+	PCM_TRACE_RESUME,
+	PCM_TRACE_LAST = PCM_TRACE_RESUME
+};
+
+#ifdef BUILD_PCM_TRACE
+extern int snd_pcm_trace_active;
+void snd_pcm_trace_init(void);
+unsigned long long snd_pcm_trace_now(void);
+unsigned long long snd_pcm_trace_enter(void);
+void snd_pcm_trace_leave(snd_pcm_t *pcm, unsigned int type,
+			 unsigned long long start, long result);
+void snd_pcm_trace_event(snd_pcm_t *pcm, unsigned int type,
+			 unsigned long long start, long result);
+
+/*
+ * snd_pcm_trace_begin() returns the start time of a call, or zero when
+ * the tracing is disabled or the call is made by another traced call
+ * (a plugin calling its slave); snd_pcm_trace() records the call with
+ * its result when it was started.  Only the calls of the application
+ * are recorded so.
+ */
+static inline unsigned long long snd_pcm_trace_begin(void)
+{
+	if (!__atomic_load_n(&snd_pcm_trace_active, __ATOMIC_RELAXED))
+		return 0;
+	return snd_pcm_trace_enter();
+}
+
+static inline void snd_pcm_trace(snd_pcm_t *pcm, unsigned int type,
+				 unsigned long long start, long result)
+{
+	if (start)
+		snd_pcm_trace_leave(pcm, type, start, result);
+}
+
+/* the same for the wakeups, recorded also inside of a blocking call */
+static inline unsigned long long snd_pcm_trace_wakeup_begin(void)
+{
+	if (!__atomic_load_n(&snd_pcm_trace_active, __ATOMIC_RELAXED))
+		return 0;
+	return snd_pcm_trace_now();
+}
+
+static inline void snd_pcm_trace_wakeup(snd_pcm_t *pcm,
+					unsigned long long start, long result)
+{
+	if (start)
+		snd_pcm_trace_event(pcm, PCM_TRACE_WAKEUP, start, result);
+}
+#else /* BUILD_PCM_TRACE */
+static inline void snd_pcm_trace_init(void) { }
+static inline unsigned long long snd_pcm_trace_begin(void) { return 0; }
+static inline void snd_pcm_trace(snd_pcm_t *pcm ATTRIBUTE_UNUSED,
+				 unsigned int type ATTRIBUTE_UNUSED,
+				 unsigned long long start ATTRIBUTE_UNUSED,
+				 long result ATTRIBUTE_UNUSED) { }
+static inline unsigned long long snd_pcm_trace_wakeup_begin(void) { return 0; }
+static inline void snd_pcm_trace_wakeup(snd_pcm_t *pcm ATTRIBUTE_UNUSED,
+					unsigned long long start ATTRIBUTE_UNUSED,
+					long result ATTRIBUTE_UNUSED) { }
+#endif /* BUILD_PCM_TRACE */
+
 static inline snd_pcm_sframes_t __snd_pcm_avail_update(snd_pcm_t *pcm)
 {
+	unsigned long long start;
+	snd_pcm_sframes_t result;
+
 	if (!pcm->fast_ops->avail_update)
 		return -ENOSYS;
-	return pcm->fast_ops->avail_update(pcm->fast_op_arg);
+	start = snd_pcm_trace_begin();
+	result = pcm->fast_ops->avail_update(pcm->fast_op_arg);
+	snd_pcm_trace(pcm, PCM_TRACE_AVAIL, start, result);
+	return result;
 }
 
 static inline int __snd_pcm_start(snd_pcm_t *pcm)
 {
+	unsigned long long start;
+	int err;
+
 	if (!pcm->fast_ops->start)
 		return -ENOSYS;
-	return pcm->fast_ops->start(pcm->fast_op_arg);
+	start = snd_pcm_trace_begin();
+	err = pcm->fast_ops->start(pcm->fast_op_arg);
+	snd_pcm_trace(pcm, PCM_TRACE_START, start, err);
+	return err;
 }
 
 static inline snd_pcm_state_t __snd_pcm_state(snd_pcm_t *pcm)
@@ -642,34 +767,58 @@ static inline snd_pcm_sframes_t snd_pcm_mmap_delay(snd_pcm_t *pcm)
 
 static inline snd_pcm_sframes_t _snd_pcm_writei(snd_pcm_t *pcm, const void *buffer, snd_pcm_uframes_t size)
 {
+	unsigned long long start;
+	snd_pcm_sframes_t result;
+
 	/* lock handled in the callback */
 	if (!pcm->fast_ops->writei)
 		return -ENOSYS;
-	return pcm->fast_ops->writei(pcm->fast_op_arg, buffer, size);
+	start = snd_pcm_trace_begin();
+	result = pcm->fast_ops->writei(pcm->fast_op_arg, buffer, size);
+	snd_pcm_trace(pcm, PCM_TRACE_WRITE, start, result);
+	return result;
 }
 
 static inline snd_pcm_sframes_t _snd_pcm_writen(snd_pcm_t *pcm, void **bufs, snd_pcm_uframes_t size)
 {
+	unsigned long long start;
+	snd_pcm_sframes_t result;
+
 	/* lock handled in the callback */
 	if (!pcm->fast_ops->writen)
 		return -ENOSYS;
-	return pcm->fast_ops->writen(pcm->fast_op_arg, bufs, size);
+	start = snd_pcm_trace_begin();
+	result = pcm->fast_ops->writen(pcm->fast_op_arg, bufs, size);
+	snd_pcm_trace(pcm, PCM_TRACE_WRITE, start, result);
+	return result;
 }
 
 static inline snd_pcm_sframes_t _snd_pcm_readi(snd_pcm_t *pcm, void *buffer, snd_pcm_uframes_t size)
 {
+	unsigned long long start;
+	snd_pcm_sframes_t result;
+
 	/* lock handled in the callback */
 	if (!pcm->fast_ops->readi)
 		return -ENOSYS;
-	return pcm->fast_ops->readi(pcm->fast_op_arg, buffer, size);
+	start = snd_pcm_trace_begin();
+	result = pcm->fast_ops->readi(pcm->fast_op_arg, buffer, size);
+	snd_pcm_trace(pcm, PCM_TRACE_READ, start, result);
+	return result;
 }
 
 static inline snd_pcm_sframes_t _snd_pcm_readn(snd_pcm_t *pcm, void **bufs, snd_pcm_uframes_t size)
 {
+	unsigned long long start;
+	snd_pcm_sframes_t result;
+
 	/* lock handled in the callback */
 	if (!pcm->fast_ops->readn)
 		return -ENOSYS;
-	return pcm->fast_ops->readn(pcm->fast_op_arg, bufs, size);
+	start = snd_pcm_trace_begin();
+	result = pcm->fast_ops->readn(pcm->fast_op_arg, bufs, size);
+	snd_pcm_trace(pcm, PCM_TRACE_READ, start, result);
+	return result;
 }
 
 static inline int muldiv(int a, int b, int c, int *r)
@@ -710,6 +859,28 @@ static inline int muldiv_near(int a, int b, int c)
 }
 
 int snd_pcm_hw_refine(snd_pcm_t *pcm, snd_pcm_hw_params_t *params);
+
+/* records the PCMs created while a PCM is opened by name */
+struct snd_pcm_refine_open {
+	struct snd_pcm_refine_open *prev;	/* outer open */
+	uint64_t sig;			/* signature of the definition */
+	int uncacheable;
+	int private;			/* not reusable by another open */
+	unsigned int count;
+	unsigned int alloc;
+	snd_pcm_t **pcms;
+};
+
+void snd_pcm_refine_open_begin(struct snd_pcm_refine_open *open);
+void snd_pcm_refine_open_end(struct snd_pcm_refine_open *open, int err);
+void snd_pcm_refine_open_conf(const char *name, snd_config_t *conf,
+			      snd_pcm_stream_t stream, int mode);
+void snd_pcm_refine_open_data(const void *data, size_t size);
+void snd_pcm_refine_new(snd_pcm_t *pcm);
+void snd_pcm_refine_free(snd_pcm_t *pcm);
+unsigned long snd_pcm_refine_hits(snd_pcm_t *pcm);
+int snd_pcm_refine_flush(snd_pcm_t *pcm, unsigned long hits);
+
 int _snd_pcm_hw_params_internal(snd_pcm_t *pcm, snd_pcm_hw_params_t *params);
 #undef _snd_pcm_hw_params
 int snd_pcm_hw_refine_soft(snd_pcm_t *pcm, snd_pcm_hw_params_t *params);
@@ -1134,6 +1305,51 @@ static inline void gettimestamp(snd_htimestamp_t *tstamp,
 }
 #endif /* HAVE_CLOCK_GETTIME */
 
+/*
+ * Performance counters: snd_pcm_perf_begin() returns the start time of
+ * a processing call plus one, or zero when the counters are disabled,
+ * which is passed to snd_pcm_perf_end() with the frames processed.
+ */
+static inline unsigned long long snd_pcm_perf_begin(snd_pcm_perf_t *perf)
+{
+	snd_htimestamp_t ts;
+
+	if (!perf->enabled)
+		return 0;
+	gettimestamp(&ts, SND_PCM_TSTAMP_TYPE_MONOTONIC);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec + 1;
+}
+
+static inline void snd_pcm_perf_end(snd_pcm_perf_t *perf, unsigned long long start,
+				    snd_pcm_sframes_t frames)
+{
+	snd_htimestamp_t ts;
+	unsigned long long ns;
+
+	if (!start)
+		return;
+	gettimestamp(&ts, SND_PCM_TSTAMP_TYPE_MONOTONIC);
+	ns = ts.tv_sec * 1000000000ULL + ts.tv_nsec + 1 - start;
+	perf->c.calls++;
+	if (frames > 0)
+		perf->c.frames += frames;
+	perf->c.total_ns += ns;
+	if (ns > perf->c.max_ns)
+		perf->c.max_ns = ns;
+}
+
+static inline void snd_pcm_perf_syscall(snd_pcm_perf_t *perf)
+{
+	if (perf->enabled)
+		perf->c.syscalls++;
+}
+
+static inline void snd_pcm_perf_xrun(snd_pcm_perf_t *perf)
+{
+	if (perf->enabled)
+		perf->c.xruns++;
+}
+
 snd_pcm_chmap_query_t **
 _snd_pcm_make_single_query_chmaps(const snd_pcm_chmap_t *src);
 snd_pcm_chmap_t *_snd_pcm_copy_chmap(const snd_pcm_chmap_t *src);
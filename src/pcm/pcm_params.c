@@ -1936,6 +1936,40 @@ static const snd_pcm_hw_rule_t refine_rules[] = {
 };
 
 #define RULES (sizeof(refine_rules) / sizeof(refine_rules[0]))
+
+/* the rules depending on each parameter, one bit per rule */
+static unsigned int refine_rule_users[SND_PCM_HW_PARAM_LAST_INTERVAL + 1];
+
+static void refine_rule_users_build(void)
+{
+	unsigned int k, d;
+
+	assert(RULES <= sizeof(refine_rule_users[0]) * 8);
+	for (k = 0; k < RULES; k++) {
+		for (d = 0; refine_rules[k].deps[d] >= 0; d++)
+			refine_rule_users[refine_rules[k].deps[d]] |= 1U << k;
+	}
+}
+
+#ifdef THREAD_SAFE_API
+static pthread_once_t refine_rule_users_once = PTHREAD_ONCE_INIT;
+
+static inline void refine_rule_users_init(void)
+{
+	pthread_once(&refine_rule_users_once, refine_rule_users_build);
+}
+#else
+static int refine_rule_users_ready;
+
+static inline void refine_rule_users_init(void)
+{
+	if (!refine_rule_users_ready) {
+		refine_rule_users_build();
+		refine_rule_users_ready = 1;
+	}
+}
+#endif
+
 #define PCM_BIT(x) \
 	(1U << ((x) < 32 ? (x) : ((x) - 32)))
 
@@ -2076,10 +2110,8 @@ int snd_pcm_hw_refine_soft(snd_pcm_t *pcm ATTRIBUTE_UNUSED, snd_pcm_hw_params_t
 	unsigned int k;
 	snd_interval_t *i;
 	snd_mask_t *m;
-	unsigned int rstamps[RULES];
-	unsigned int vstamps[SND_PCM_HW_PARAM_LAST_INTERVAL + 1];
-	unsigned int stamp = 2;
-	int changed, again;
+	unsigned int pending;
+	int changed;
 #ifdef RULES_DEBUG
 	snd_output_t *log;
 	snd_output_stdio_attach(&log, stderr, 0);
@@ -2109,53 +2141,53 @@ int snd_pcm_hw_refine_soft(snd_pcm_t *pcm ATTRIBUTE_UNUSED, snd_pcm_hw_params_t
 			goto _err;
 	}
 
-	for (k = 0; k < RULES; k++)
-		rstamps[k] = 0;
-	for (k = 0; k <= SND_PCM_HW_PARAM_LAST_INTERVAL; k++)
-		vstamps[k] = (params->rmask & (1 << k)) ? 1 : 0;
-	do {
-		again = 0;
-		for (k = 0; k < RULES; k++) {
-			const snd_pcm_hw_rule_t *r = &refine_rules[k];
-			unsigned int d;
-			int doit = 0;
-			for (d = 0; r->deps[d] >= 0; d++) {
-				if (vstamps[r->deps[d]] > rstamps[k]) {
-					doit = 1;
-					break;
-				}
-			}
-			if (!doit)
-				continue;
+	/* run the rules whose inputs changed, in the order of the table;
+	 * a changed parameter queues its users again, except the rule
+	 * which changed it
+	 */
+	refine_rule_users_init();
+	pending = 0;
+	for (k = 0; k <= SND_PCM_HW_PARAM_LAST_INTERVAL; k++) {
+		if (params->rmask & (1 << k))
+			pending |= refine_rule_users[k];
+	}
+	k = 0;
+	while (pending) {
+		const snd_pcm_hw_rule_t *r;
+		unsigned int next = k < RULES ? pending & (~0U << k) : 0;
 #ifdef RULES_DEBUG
-			snd_output_printf(log, "Rule %d (%p): ", k, r->func);
-			if (r->var >= 0) {
-				snd_output_printf(log, "%s=", snd_pcm_hw_param_name(r->var));
-				snd_pcm_hw_param_dump(params, r->var, log);
-				snd_output_puts(log, " -> ");
-			}
+		unsigned int d;
 #endif
-			changed = r->func(params, r);
+		/* wrap around to the next pass */
+		k = ffs(next ? next : pending) - 1;
+		pending &= ~(1U << k);
+		r = &refine_rules[k];
 #ifdef RULES_DEBUG
-			if (r->var >= 0)
-				snd_pcm_hw_param_dump(params, r->var, log);
-			for (d = 0; r->deps[d] >= 0; d++) {
-				snd_output_printf(log, " %s=", snd_pcm_hw_param_name(r->deps[d]));
-				snd_pcm_hw_param_dump(params, r->deps[d], log);
-			}
-			snd_output_putc(log, '\n');
+		snd_output_printf(log, "Rule %d (%p): ", k, r->func);
+		if (r->var >= 0) {
+			snd_output_printf(log, "%s=", snd_pcm_hw_param_name(r->var));
+			snd_pcm_hw_param_dump(params, r->var, log);
+			snd_output_puts(log, " -> ");
+		}
 #endif
-			rstamps[k] = stamp;
-			if (changed && r->var >= 0) {
-				params->cmask |= 1 << r->var;
-				vstamps[r->var] = stamp;
-				again = 1;
-			}
-			if (changed < 0)
-				goto _err;
-			stamp++;
+		changed = r->func(params, r);
+#ifdef RULES_DEBUG
+		if (r->var >= 0)
+			snd_pcm_hw_param_dump(params, r->var, log);
+		for (d = 0; r->deps[d] >= 0; d++) {
+			snd_output_printf(log, " %s=", snd_pcm_hw_param_name(r->deps[d]));
+			snd_pcm_hw_param_dump(params, r->deps[d], log);
 		}
-	} while (again);
+		snd_output_putc(log, '\n');
+#endif
+		if (changed && r->var >= 0) {
+			params->cmask |= 1 << r->var;
+			pending |= refine_rule_users[r->var] & ~(1U << k);
+		}
+		if (changed < 0)
+			goto _err;
+		k++;
+	}
 	if (!params->msbits) {
 		i = hw_param_interval(params, SND_PCM_HW_PARAM_SAMPLE_BITS);
 		if (snd_interval_single(i))
@@ -2352,6 +2384,456 @@ static int snd_pcm_sw_params_default(snd_pcm_t *pcm, snd_pcm_sw_params_t *params
 	return 0;
 }
 
+#ifndef DOC_HIDDEN
+#ifdef HAVE___THREAD
+#define TLS_PFX		__thread
+#else
+#define TLS_PFX		/* NOP */
+#endif
+
+/*
+ * Cache of the refined hw_params.
+ *
+ * All PCMs created while a PCM is opened by name share one definition.
+ * The definition is identified by a signature of the expanded
+ * configurations and of the opened hardware, so a chain opened again
+ * from the same definition finds the results of the previous
+ * negotiations.  The entries are keyed by the position of the PCM in
+ * the chain and by the whole input parameter space.  The chains with
+ * the PCMs whose constraints depend on other state (external plugins,
+ * the shared and the server PCMs) are not cached.  The constraints of
+ * the hw and the direct (dmix, dsnoop, dshare) PCMs may change while
+ * the configuration stays the same (symmetric rates of the ASoC links,
+ * HDMI ELD updates), so a chain containing them gets a private
+ * definition, used only by the PCMs of that open.
+ *
+ * The cache is enabled by setting LIBASOUND_REFINE_CACHE to 1.
+ */
+#define REFINE_CACHE_MAX	512	/* entries per definition */
+#define REFINE_CACHE_HASH	64
+#define REFINE_DEFS_UNUSED	4	/* definitions kept without PCMs */
+
+struct refine_entry {
+	struct list_head list;		/* most recently used first */
+	struct refine_entry *next;	/* hash chain */
+	unsigned int slot;
+	unsigned int hash;
+	int result;
+	snd_pcm_hw_params_t in;
+	snd_pcm_hw_params_t out;
+};
+
+struct snd_pcm_refine_def {
+	struct list_head list;		/* most recently used first */
+	uint64_t sig;
+	unsigned int refs;		/* PCMs using the definition */
+	int private;			/* not in refine_defs, freed with the PCMs */
+	unsigned long hits;
+	struct list_head entries;
+	unsigned int count;
+	struct refine_entry *hash[REFINE_CACHE_HASH];
+};
+
+static LIST_HEAD(refine_defs);
+static TLS_PFX struct snd_pcm_refine_open *refine_open;
+static unsigned long refine_hits, refine_misses;
+
+#ifdef THREAD_SAFE_API
+static pthread_mutex_t refine_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static inline void refine_lock(void)
+{
+	pthread_mutex_lock(&refine_mutex);
+}
+
+static inline void refine_unlock(void)
+{
+	pthread_mutex_unlock(&refine_mutex);
+}
+#else
+static inline void refine_lock(void) { }
+static inline void refine_unlock(void) { }
+#endif
+
+static int refine_cache_enabled(void)
+{
+	static int enabled = -1;	/* uninitialized */
+
+	/* evaluate env var only once at the first open for consistency */
+	if (enabled < 0) {
+		const char *p = getenv("LIBASOUND_REFINE_CACHE");
+		enabled = p && *p && *p != '0';
+	}
+	return enabled;
+}
+
+static uint64_t refine_sig(uint64_t h, const void *data, size_t size)
+{
+	const unsigned char *p = data;
+
+	while (size-- > 0)
+		h = (h ^ *p++) * 1099511628211ULL;
+	return h;
+}
+
+static uint64_t refine_sig_string(uint64_t h, const char *str)
+{
+	if (str)
+		return refine_sig(h, str, strlen(str) + 1);
+	return refine_sig(h, "", 1);
+}
+
+static uint64_t refine_sig_conf(uint64_t h, snd_config_t *conf)
+{
+	snd_config_iterator_t i, next;
+	snd_config_type_t type = snd_config_get_type(conf);
+	const char *id = NULL, *str = NULL;
+	long long integer64 = 0;
+	long integer = 0;
+	double real = 0;
+	const void *ptr = NULL;
+
+	snd_config_get_id(conf, &id);
+	h = refine_sig_string(h, id);
+	h = refine_sig(h, &type, sizeof(type));
+	switch (type) {
+	case SND_CONFIG_TYPE_INTEGER:
+		snd_config_get_integer(conf, &integer);
+		return refine_sig(h, &integer, sizeof(integer));
+	case SND_CONFIG_TYPE_INTEGER64:
+		snd_config_get_integer64(conf, &integer64);
+		return refine_sig(h, &integer64, sizeof(integer64));
+	case SND_CONFIG_TYPE_REAL:
+		snd_config_get_real(conf, &real);
+		return refine_sig(h, &real, sizeof(real));
+	case SND_CONFIG_TYPE_STRING:
+		snd_config_get_string(conf, &str);
+		return refine_sig_string(h, str);
+	case SND_CONFIG_TYPE_POINTER:
+		snd_config_get_pointer(conf, &ptr);
+		return refine_sig(h, &ptr, sizeof(ptr));
+	case SND_CONFIG_TYPE_COMPOUND:
+		snd_config_for_each(i, next, conf)
+			h = refine_sig_conf(h, snd_config_iterator_entry(i));
+		return refine_sig(h, "}", 1);
+	}
+	return h;
+}
+
+/* start recording the chain of a PCM opened by name */
+void snd_pcm_refine_open_begin(struct snd_pcm_refine_open *open)
+{
+	memset(open, 0, sizeof(*open));
+	open->sig = 14695981039346656037ULL;
+	if (!refine_cache_enabled())
+		open->uncacheable = 1;
+	open->prev = refine_open;
+	refine_open = open;
+}
+
+/* mix an expanded PCM definition into the signature */
+void snd_pcm_refine_open_conf(const char *name, snd_config_t *conf,
+			      snd_pcm_stream_t stream, int mode)
+{
+	struct snd_pcm_refine_open *open = refine_open;
+
+	if (!open || open->uncacheable)
+		return;
+	open->sig = refine_sig_string(open->sig, name);
+	open->sig = refine_sig(open->sig, &stream, sizeof(stream));
+	open->sig = refine_sig(open->sig, &mode, sizeof(mode));
+	open->sig = refine_sig_conf(open->sig, conf);
+}
+
+/* mix an identity of the opened device into the signature */
+void snd_pcm_refine_open_data(const void *data, size_t size)
+{
+	struct snd_pcm_refine_open *open = refine_open;
+
+	if (open && !open->uncacheable)
+		open->sig = refine_sig(open->sig, data, size);
+}
+
+void snd_pcm_refine_new(snd_pcm_t *pcm)
+{
+	struct snd_pcm_refine_open *open = refine_open;
+	snd_pcm_t **pcms;
+
+	if (!open || open->uncacheable)
+		return;
+	switch (pcm->type) {
+	case SND_PCM_TYPE_IOPLUG:
+	case SND_PCM_TYPE_EXTPLUG:
+	case SND_PCM_TYPE_SHARE:
+	case SND_PCM_TYPE_SHM:
+		open->uncacheable = 1;
+		return;
+	case SND_PCM_TYPE_HW:
+	case SND_PCM_TYPE_DMIX:
+	case SND_PCM_TYPE_DSNOOP:
+	case SND_PCM_TYPE_DSHARE:
+		open->private = 1;
+		break;
+	default:
+		break;
+	}
+	if (open->count >= open->alloc) {
+		pcms = realloc(open->pcms, (open->alloc + 8) * sizeof(*pcms));
+		if (!pcms) {
+			open->uncacheable = 1;
+			return;
+		}
+		open->pcms = pcms;
+		open->alloc += 8;
+	}
+	open->pcms[open->count++] = pcm;
+	open->sig = refine_sig(open->sig, &pcm->type, sizeof(pcm->type));
+}
+
+static void refine_def_clear(struct snd_pcm_refine_def *def)
+{
+	struct refine_entry *e;
+
+	while (!list_empty(&def->entries)) {
+		e = list_entry(def->entries.next, struct refine_entry, list);
+		list_del(&e->list);
+		free(e);
+	}
+	memset(def->hash, 0, sizeof(def->hash));
+	def->count = 0;
+}
+
+/* release the least recently used definitions without PCMs */
+static void refine_defs_trim(void)
+{
+	struct list_head *pos, *prev;
+	struct snd_pcm_refine_def *def;
+	unsigned int unused = 0;
+
+	for (pos = refine_defs.next; pos != &refine_defs; pos = pos->next) {
+		def = list_entry(pos, struct snd_pcm_refine_def, list);
+		if (def->refs == 0)
+			unused++;
+	}
+	for (pos = refine_defs.prev; unused > REFINE_DEFS_UNUSED && pos != &refine_defs; pos = prev) {
+		prev = pos->prev;
+		def = list_entry(pos, struct snd_pcm_refine_def, list);
+		if (def->refs)
+			continue;
+		list_del(&def->list);
+		refine_def_clear(def);
+		free(def);
+		unused--;
+	}
+}
+
+/* attach the recorded PCMs to the definition of the signature */
+void snd_pcm_refine_open_end(struct snd_pcm_refine_open *open, int err)
+{
+	struct snd_pcm_refine_def *def = NULL;
+	struct list_head *pos;
+	unsigned int i;
+
+	refine_open = open->prev;
+	if (open->prev) {
+		/* the outer chain depends on this one */
+		if (open->uncacheable)
+			open->prev->uncacheable = 1;
+		else
+			open->prev->sig = refine_sig(open->prev->sig, &open->sig,
+						     sizeof(open->sig));
+		if (open->private)
+			open->prev->private = 1;
+	}
+	if (err < 0 || open->uncacheable || open->count == 0)
+		goto _end;
+	if (open->private) {
+		def = calloc(1, sizeof(*def));
+		if (!def)
+			goto _end;
+		def->private = 1;
+		INIT_LIST_HEAD(&def->list);
+		INIT_LIST_HEAD(&def->entries);
+		refine_lock();
+		goto _attach;
+	}
+	refine_lock();
+	list_for_each(pos, &refine_defs) {
+		def = list_entry(pos, struct snd_pcm_refine_def, list);
+		if (def->sig == open->sig)
+			break;
+		def = NULL;
+	}
+	if (!def) {
+		def = calloc(1, sizeof(*def));
+		if (!def) {
+			refine_unlock();
+			goto _end;
+		}
+		def->sig = open->sig;
+		INIT_LIST_HEAD(&def->entries);
+	} else {
+		list_del(&def->list);
+	}
+	list_add(&def->list, &refine_defs);
+ _attach:
+	for (i = 0; i < open->count; i++) {
+		if (!open->pcms[i] || open->pcms[i]->refine_def)
+			continue;
+		open->pcms[i]->refine_def = def;
+		open->pcms[i]->refine_slot = i;
+		def->refs++;
+	}
+	if (def->private && def->refs == 0)
+		free(def);
+	refine_unlock();
+ _end:
+	free(open->pcms);
+}
+
+void snd_pcm_refine_free(snd_pcm_t *pcm)
+{
+	struct snd_pcm_refine_open *open;
+	unsigned int i;
+
+	for (open = refine_open; open; open = open->prev) {
+		for (i = 0; i < open->count; i++) {
+			if (open->pcms[i] == pcm)
+				open->pcms[i] = NULL;
+		}
+	}
+	if (!pcm->refine_def)
+		return;
+	refine_lock();
+	if (--pcm->refine_def->refs == 0) {
+		if (pcm->refine_def->private) {
+			refine_def_clear(pcm->refine_def);
+			free(pcm->refine_def);
+		} else {
+			refine_defs_trim();
+		}
+	}
+	refine_unlock();
+	pcm->refine_def = NULL;
+}
+
+unsigned long snd_pcm_refine_hits(snd_pcm_t *pcm)
+{
+	unsigned long hits;
+
+	if (!pcm->refine_def)
+		return 0;
+	refine_lock();
+	hits = pcm->refine_def->hits;
+	refine_unlock();
+	return hits;
+}
+
+/* drop the cached results if some were used since hits were taken */
+int snd_pcm_refine_flush(snd_pcm_t *pcm, unsigned long hits)
+{
+	struct snd_pcm_refine_def *def = pcm->refine_def;
+	int flushed = 0;
+
+	if (!def)
+		return 0;
+	refine_lock();
+	if (def->hits != hits) {
+		refine_def_clear(def);
+		flushed = 1;
+	}
+	refine_unlock();
+	return flushed;
+}
+
+static unsigned int refine_hash(unsigned int slot, const snd_pcm_hw_params_t *params)
+{
+	const uint32_t *p = (const uint32_t *)params;
+	unsigned int i, h = 2166136261U ^ slot;
+
+	for (i = 0; i < sizeof(*params) / sizeof(*p); i++)
+		h = (h ^ p[i]) * 16777619U;
+	return h;
+}
+
+static struct refine_entry *refine_find(struct snd_pcm_refine_def *def,
+					unsigned int slot, unsigned int hash,
+					const snd_pcm_hw_params_t *params)
+{
+	struct refine_entry *e;
+
+	for (e = def->hash[hash % REFINE_CACHE_HASH]; e; e = e->next) {
+		if (e->hash == hash && e->slot == slot &&
+		    memcmp(&e->in, params, sizeof(*params)) == 0)
+			return e;
+	}
+	return NULL;
+}
+
+static void refine_evict(struct snd_pcm_refine_def *def)
+{
+	struct refine_entry *e, **pe;
+
+	e = list_entry(def->entries.prev, struct refine_entry, list);
+	for (pe = &def->hash[e->hash % REFINE_CACHE_HASH]; *pe != e; pe = &(*pe)->next)
+		;
+	*pe = e->next;
+	list_del(&e->list);
+	free(e);
+	def->count--;
+}
+
+static int snd_pcm_hw_refine_cached(snd_pcm_t *pcm, snd_pcm_hw_params_t *params)
+{
+	struct snd_pcm_refine_def *def = pcm->refine_def;
+	unsigned int slot = pcm->refine_slot;
+	unsigned int hash = refine_hash(slot, params);
+	struct refine_entry *e;
+	int res;
+
+	refine_lock();
+	e = refine_find(def, slot, hash, params);
+	if (e) {
+		list_del(&e->list);
+		list_add(&e->list, &def->entries);
+		*params = e->out;
+		res = e->result;
+		def->hits++;
+		refine_hits++;
+		refine_unlock();
+		return res;
+	}
+	refine_misses++;
+	refine_unlock();
+
+	e = malloc(sizeof(*e));
+	if (e)
+		e->in = *params;
+	res = pcm->ops->hw_refine(pcm->op_arg, params);
+	if (!e)
+		return res;
+	e->slot = slot;
+	e->hash = hash;
+	e->result = res;
+	e->out = *params;
+	refine_lock();
+	if (refine_find(def, slot, hash, &e->in)) {
+		/* stored by another thread meanwhile */
+		refine_unlock();
+		free(e);
+		return res;
+	}
+	if (def->count >= REFINE_CACHE_MAX)
+		refine_evict(def);
+	e->next = def->hash[hash % REFINE_CACHE_HASH];
+	def->hash[hash % REFINE_CACHE_HASH] = e;
+	list_add(&e->list, &def->entries);
+	def->count++;
+	refine_unlock();
+	return res;
+}
+#endif /* DOC_HIDDEN */
+
 #if 0
 #define REFINE_DEBUG
 #endif
@@ -2368,9 +2850,12 @@ int snd_pcm_hw_refine(snd_pcm_t *pcm, snd_pcm_hw_params_t *params)
 	snd_output_printf(log, "REFINE called:\n");
 	snd_pcm_hw_params_dump(params, log);
 #endif
-	if (pcm->ops->hw_refine)
-		res = pcm->ops->hw_refine(pcm->op_arg, params);
-	else
+	if (pcm->ops->hw_refine) {
+		if (pcm->refine_def)
+			res = snd_pcm_hw_refine_cached(pcm, params);
+		else
+			res = pcm->ops->hw_refine(pcm->op_arg, params);
+	} else
 		res = -ENOSYS;
 #ifdef REFINE_DEBUG
 	snd_output_printf(log, "refine done - result = %i\n", res);
@@ -2380,6 +2865,32 @@ int snd_pcm_hw_refine(snd_pcm_t *pcm, snd_pcm_hw_params_t *params)
 	return res;
 }
 
+/**
+ * \brief Returns the statistics of the hw_params refine cache.
+ * \param[out] hits The number of refinements served from the cache.
+ * \param[out] misses The number of refinements done by the PCM plugins.
+ * \return Zero if successful, otherwise a negative error code.
+ *
+ * When the environment variable \c LIBASOUND_REFINE_CACHE is set to
+ * \c 1, the PCMs opened by name remember the results of the refinements
+ * of their configuration space.  The results are reused by the next open
+ * of the same definition only when the chain contains no hw, dmix, dsnoop
+ * or dshare PCM, whose constraints may change between the opens.
+ *
+ * Either pointer may be \c NULL.  This is a debugging aid, the counters
+ * are global for the process.
+ */
+int snd_pcm_hw_params_cache_stats(unsigned long *hits, unsigned long *misses)
+{
+	refine_lock();
+	if (hits)
+		*hits = refine_hits;
+	if (misses)
+		*misses = refine_misses;
+	refine_unlock();
+	return 0;
+}
+
 /* Install one of the configurations present in configuration
    space defined by PARAMS.
    The configuration chosen is that obtained fixing in this order:
@@ -706,6 +706,8 @@ static int snd_pcm_plug_insert_plugins(snd_pcm_t *pcm,
 			return err;
 		}
 		if (err) {
+			/* the conversions are counted like the plug PCM */
+			new->perf.enabled = pcm->perf.enabled;
 			plug->gen.slave = new;
 		}
 		k++;
@@ -239,6 +239,7 @@ static snd_pcm_sframes_t snd_pcm_plugin_write_areas(snd_pcm_t *pcm,
 	snd_pcm_t *slave = plugin->gen.slave;
 	snd_pcm_uframes_t xfer = 0;
 	snd_pcm_sframes_t result;
+	unsigned long long start;
 	int err;
 
 	while (size > 0) {
@@ -254,8 +255,10 @@ static snd_pcm_sframes_t snd_pcm_plugin_write_areas(snd_pcm_t *pcm,
 		}
 		if (slave_frames == 0)
 			break;
+		start = snd_pcm_perf_begin(&pcm->perf);
 		frames = plugin->write(pcm, areas, offset, frames,
 				       slave_areas, slave_offset, &slave_frames);
+		snd_pcm_perf_end(&pcm->perf, start, frames);
 		if (CHECK_SANITY(slave_frames > snd_pcm_mmap_playback_avail(slave))) {
 			SNDMSG("write overflow %ld > %ld", slave_frames,
 			       snd_pcm_mmap_playback_avail(slave));
@@ -296,6 +299,7 @@ static snd_pcm_sframes_t snd_pcm_plugin_read_areas(snd_pcm_t *pcm,
 	snd_pcm_t *slave = plugin->gen.slave;
 	snd_pcm_uframes_t xfer = 0;
 	snd_pcm_sframes_t result;
+	unsigned long long start;
 	int err;
 	
 	while (size > 0) {
@@ -311,8 +315,10 @@ static snd_pcm_sframes_t snd_pcm_plugin_read_areas(snd_pcm_t *pcm,
 		}
 		if (slave_frames == 0)
 			break;
+		start = snd_pcm_perf_begin(&pcm->perf);
 		frames = (plugin->read)(pcm, areas, offset, frames,
 				      slave_areas, slave_offset, &slave_frames);
+		snd_pcm_perf_end(&pcm->perf, start, frames);
 		if (CHECK_SANITY(slave_frames > snd_pcm_mmap_capture_avail(slave))) {
 			SNDMSG("read overflow %ld > %ld", slave_frames,
 			       snd_pcm_mmap_playback_avail(slave));
@@ -393,6 +399,7 @@ snd_pcm_plugin_mmap_commit(snd_pcm_t *pcm,
 	snd_pcm_uframes_t appl_offset;
 	snd_pcm_sframes_t slave_size;
 	snd_pcm_sframes_t xfer;
+	unsigned long long start;
 	int err;
 
 	if (pcm->stream == SND_PCM_STREAM_CAPTURE) {
@@ -420,8 +427,10 @@ snd_pcm_plugin_mmap_commit(snd_pcm_t *pcm,
 		}
 		if (frames > cont)
 			frames = cont;
+		start = snd_pcm_perf_begin(&pcm->perf);
 		frames = plugin->write(pcm, areas, appl_offset, frames,
 				       slave_areas, slave_offset, &slave_frames);
+		snd_pcm_perf_end(&pcm->perf, start, frames);
 		result = snd_pcm_mmap_commit(slave, slave_offset, slave_frames);
 		if (result > 0 && (snd_pcm_uframes_t)result != slave_frames) {
 			snd_pcm_sframes_t res;
@@ -464,6 +473,7 @@ snd_pcm_plugin_sync_hw_ptr_capture(snd_pcm_t *pcm,
 	snd_pcm_t *slave = plugin->gen.slave;
 	const snd_pcm_channel_area_t *areas;
 	snd_pcm_uframes_t xfer, hw_offset, size;
+	unsigned long long start;
 	int err;
 
 	xfer = snd_pcm_mmap_capture_avail(pcm);
@@ -492,8 +502,10 @@ snd_pcm_plugin_sync_hw_ptr_capture(snd_pcm_t *pcm,
 		}
 		if (frames > cont)
 			frames = cont;
+		start = snd_pcm_perf_begin(&pcm->perf);
 		frames = (plugin->read)(pcm, areas, hw_offset, frames,
 					slave_areas, slave_offset, &slave_frames);
+		snd_pcm_perf_end(&pcm->perf, start, frames);
 		result = snd_pcm_mmap_commit(slave, slave_offset, slave_frames);
 		if (result > 0 && (snd_pcm_uframes_t)result != slave_frames) {
 			snd_pcm_sframes_t res;
@@ -616,9 +616,12 @@ snd_pcm_rate_write_areas1(snd_pcm_t *pcm,
 			 snd_pcm_uframes_t slave_offset)
 {
 	snd_pcm_rate_t *rate = pcm->private_data;
+	unsigned long long start = snd_pcm_perf_begin(&pcm->perf);
+
 	do_convert(slave_areas, slave_offset, rate->gen.slave->period_size,
 		   areas, offset, pcm->period_size,
 		   pcm->channels, rate);
+	snd_pcm_perf_end(&pcm->perf, start, pcm->period_size);
 }
 
 static inline void
@@ -629,9 +632,12 @@ snd_pcm_rate_read_areas1(snd_pcm_t *pcm,
 			 snd_pcm_uframes_t slave_offset)
 {
 	snd_pcm_rate_t *rate = pcm->private_data;
+	unsigned long long start = snd_pcm_perf_begin(&pcm->perf);
+
 	do_convert(areas, offset, pcm->period_size,
 		   slave_areas, slave_offset, rate->gen.slave->period_size,
 		   pcm->channels, rate);
+	snd_pcm_perf_end(&pcm->perf, start, pcm->period_size);
 }
 
 static inline void snd_pcm_rate_sync_hwptr0(snd_pcm_t *pcm, snd_pcm_uframes_t slave_hw_ptr)
@@ -44,6 +44,7 @@
 #include <arpa/inet.h>
 #include <net/if.h>
 #include <netdb.h>
+#include <time.h>
 #include "aserver.h"
 
 #ifndef PIC
@@ -52,12 +53,152 @@ const char *_snd_module_pcm_shm = "";
 #endif
 
 #ifndef DOC_HIDDEN
+/* how long to wait for the completion of a slot command before sleeping */
+#define SHM_SLOT_SPIN_NS	50000
+/* how old a published snapshot may be to answer delay and hwsync */
+#define SHM_PUB_FRESH_NS	200000
+
 typedef struct {
 	int socket;
 	volatile snd_pcm_shm_ctrl_t *ctrl;
+	int slot;			/* the server serves the command slot */
+	long spin_ns;
+	int publish;			/* the server publishes the state */
 } snd_pcm_shm_t;
 #endif
 
+static int shm_publish_enabled(void)
+{
+	static int enabled = -1;	/* uninitialized */
+
+	/* evaluate env var only once at the first open for consistency */
+	if (enabled < 0) {
+		const char *p = getenv("LIBASOUND_SHM_PUBLISH");
+		enabled = !p || *p != '0';
+	}
+	return enabled;
+}
+
+static long shm_elapsed_ns(const struct timespec *start)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) * 1000000000L +
+		(now.tv_nsec - start->tv_nsec);
+}
+
+/* take the wait flag if it still waits for the command req */
+static int shm_slot_take(volatile unsigned int *wait, unsigned int req)
+{
+	unsigned int expected = req;
+
+	return __atomic_load_n(wait, __ATOMIC_RELAXED) == req &&
+		__atomic_compare_exchange_n(wait, &expected, 0, 0,
+					    __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * Post the command to the slot and wait until the server completes it.
+ * The server is woken by a byte on the socket only when it sleeps, and
+ * the completion is waited for on the socket only after a short spin.
+ */
+static int snd_pcm_shm_slot_action(snd_pcm_shm_t *shm)
+{
+	volatile snd_pcm_shm_slot_t *slot = &shm->ctrl->slot;
+	unsigned int req = SND_PCM_SHM_SLOT_NEXT(slot->req);
+	struct timespec start;
+	char buf[1] = "";
+	unsigned int k;
+
+	__atomic_store_n(&slot->req, req, __ATOMIC_RELEASE);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (shm_slot_take(&slot->server_wait, req)) {
+		if (write(shm->socket, buf, 1) != 1)
+			return -EBADFD;
+	}
+	if (shm->spin_ns > 0) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (k = 0; ; k++) {
+			if (__atomic_load_n(&slot->ack, __ATOMIC_ACQUIRE) == req)
+				return 0;
+			if ((k & 63) == 63 && shm_elapsed_ns(&start) >= shm->spin_ns)
+				break;
+		}
+	}
+	__atomic_store_n(&slot->client_wait, req, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (__atomic_load_n(&slot->ack, __ATOMIC_ACQUIRE) == req &&
+	    shm_slot_take(&slot->client_wait, req))
+		return 0;
+	/* the server took the flag, so its wakeup is on the way */
+	if (read(shm->socket, buf, 1) != 1)
+		return -EBADFD;
+	return 0;
+}
+
+static long long shm_now_ns(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
+
+/*
+ * Take the snapshot published by the server.  The server learns about
+ * an xrun or a suspend of a running stream only at its next update, so
+ * a running state is trusted only while the poll descriptor reports no
+ * error.  Returns 1 when the snapshot may be used.
+ */
+static int snd_pcm_shm_published(snd_pcm_t *pcm, snd_pcm_shm_pub_t *pub)
+{
+	snd_pcm_shm_t *shm = pcm->private_data;
+	volatile snd_pcm_shm_pub_t *p = &shm->ctrl->pub;
+	struct pollfd pfd;
+	unsigned int seq, k;
+
+	if (!shm->publish)
+		return 0;
+	for (k = 0; ; k++) {
+		if (k == 4)
+			return 0;
+		seq = __atomic_load_n(&p->seq, __ATOMIC_ACQUIRE);
+		if (seq == 0)
+			return 0;
+		if (seq & 1)
+			continue;
+		pub->state = p->state;
+		pub->valid = p->valid;
+		pub->avail = p->avail;
+		pub->delay = p->delay;
+		pub->stamp = p->stamp;
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if (__atomic_load_n(&p->seq, __ATOMIC_RELAXED) == seq)
+			break;
+	}
+	switch (pub->state) {
+	case SND_PCM_STATE_PREPARED:
+	case SND_PCM_STATE_RUNNING:
+	case SND_PCM_STATE_DRAINING:
+	case SND_PCM_STATE_PAUSED:
+		pfd.fd = pcm->poll_fd;
+		pfd.events = 0;
+		if (poll(&pfd, 1, 0) != 0)
+			return 0;
+		break;
+	default:
+		break;
+	}
+	return 1;
+}
+
+/* the snapshot was taken just now, e.g. by the last command */
+static int snd_pcm_shm_pub_fresh(const snd_pcm_shm_pub_t *pub)
+{
+	return pub->valid && shm_now_ns() - pub->stamp <= SHM_PUB_FRESH_NS;
+}
+
 static long snd_pcm_shm_action_fd0(snd_pcm_t *pcm, int *fd)
 {
 	snd_pcm_shm_t *shm = pcm->private_data;
@@ -119,12 +260,18 @@ static long snd_pcm_shm_action(snd_pcm_t *pcm)
 
 	if (ctrl->hw.changed || ctrl->appl.changed)
 		return -EBADFD;
-	err = write(shm->socket, buf, 1);
-	if (err != 1)
-		return -EBADFD;
-	err = read(shm->socket, buf, 1);
-	if (err != 1)
-		return -EBADFD;
+	if (shm->slot && ctrl->cmd != SND_PCM_IOCTL_CLOSE) {
+		err = snd_pcm_shm_slot_action(shm);
+		if (err < 0)
+			return err;
+	} else {
+		err = write(shm->socket, buf, 1);
+		if (err != 1)
+			return -EBADFD;
+		err = read(shm->socket, buf, 1);
+		if (err != 1)
+			return -EBADFD;
+	}
 	if (ctrl->cmd) {
 		SNDERR("Server has not done the cmd");
 		return -EBADFD;
@@ -405,6 +552,9 @@ static snd_pcm_state_t snd_pcm_shm_state(snd_pcm_t *pcm)
 {
 	snd_pcm_shm_t *shm = pcm->private_data;
 	volatile snd_pcm_shm_ctrl_t *ctrl = shm->ctrl;
+	snd_pcm_shm_pub_t pub;
+	if (snd_pcm_shm_published(pcm, &pub))
+		return pub.state;
 	ctrl->cmd = SND_PCM_IOCTL_STATE;
 	return snd_pcm_shm_action(pcm);
 }
@@ -413,6 +563,10 @@ static int snd_pcm_shm_hwsync(snd_pcm_t *pcm)
 {
 	snd_pcm_shm_t *shm = pcm->private_data;
 	volatile snd_pcm_shm_ctrl_t *ctrl = shm->ctrl;
+	snd_pcm_shm_pub_t pub;
+	/* the server has just synchronized the pointers */
+	if (snd_pcm_shm_published(pcm, &pub) && snd_pcm_shm_pub_fresh(&pub))
+		return 0;
 	ctrl->cmd = SND_PCM_IOCTL_HWSYNC;
 	return snd_pcm_shm_action(pcm);
 }
@@ -421,7 +575,12 @@ static int snd_pcm_shm_delay(snd_pcm_t *pcm, snd_pcm_sframes_t *delayp)
 {
 	snd_pcm_shm_t *shm = pcm->private_data;
 	volatile snd_pcm_shm_ctrl_t *ctrl = shm->ctrl;
+	snd_pcm_shm_pub_t pub;
 	int err;
+	if (snd_pcm_shm_published(pcm, &pub) && snd_pcm_shm_pub_fresh(&pub)) {
+		*delayp = pub.delay;
+		return 0;
+	}
 	ctrl->cmd = SNDRV_PCM_IOCTL_DELAY;
 	err = snd_pcm_shm_action(pcm);
 	if (err < 0)
@@ -434,7 +593,17 @@ static snd_pcm_sframes_t snd_pcm_shm_avail_update(snd_pcm_t *pcm)
 {
 	snd_pcm_shm_t *shm = pcm->private_data;
 	volatile snd_pcm_shm_ctrl_t *ctrl = shm->ctrl;
+	snd_pcm_shm_pub_t pub;
 	int err;
+	/*
+	 * An older snapshot still tells the room which was there at least,
+	 * so it is good enough unless the caller would have to wait.
+	 */
+	if (snd_pcm_shm_published(pcm, &pub) && pub.valid &&
+	    pub.avail >= pcm->avail_min &&
+	    (pub.state == SND_PCM_STATE_PREPARED ||
+	     (pub.state == SND_PCM_STATE_RUNNING && pub.avail < pcm->stop_threshold)))
+		return pub.avail;
 	ctrl->cmd = SND_PCM_IOCTL_AVAIL_UPDATE;
 	err = snd_pcm_shm_action(pcm);
 	if (err < 0)
@@ -741,6 +910,11 @@ int snd_pcm_shm_open(snd_pcm_t **pcmp, const char *name,
 
 	shm->socket = sock;
 	shm->ctrl = ctrl;
+	/* an older server leaves the slot capabilities zero */
+	shm->slot = !!(ctrl->slot.caps & SND_PCM_SHM_CAP_SLOT);
+	shm->spin_ns = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SHM_SLOT_SPIN_NS : 0;
+	shm->publish = (ctrl->slot.caps & SND_PCM_SHM_CAP_PUBLISH) && shm_publish_enabled();
+	ctrl->pub.enable = shm->publish;
 
 	err = snd_pcm_new(&pcm, SND_PCM_TYPE_SHM, name, stream, mode);
 	if (err < 0) {
@@ -787,6 +961,11 @@ pcm.name {
 }
 \endcode
 
+When the server publishes the stream state in the shared memory, the
+state, avail and delay queries are answered without asking the server
+and only the operations changing the stream are sent to it.  Set the
+LIBASOUND_SHM_PUBLISH environment variable to 0 to always ask the server.
+
 \subsection pcm_plugins_shm_funcref Function reference
 
 <UL>
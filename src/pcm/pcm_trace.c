@@ -0,0 +1,426 @@
+/**
+ * \file pcm/pcm_trace.c
+ * \ingroup PCM
+ * \brief PCM Tracing
+ *
+ * The tracing records the calls changing the state and the pointers
+ * of the PCM streams into a ring per thread.
+ */
+/*
+ *  PCM Interface - tracing
+ *
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation; either version 2.1 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "pcm_local.h"
+
+#ifdef BUILD_PCM_TRACE
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#ifdef HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
+
+#ifndef DOC_HIDDEN
+#define TRACE_EVENTS	4096		/* events per thread, power of two */
+
+/*
+ * The owner thread is the only writer of its ring.  An event is valid
+ * when its seq is the index of the event plus one; it is cleared while
+ * the event is written, so a reader copying the event and checking the
+ * seq again never returns a torn event.
+ */
+struct trace_event {
+	unsigned long seq;
+	const snd_pcm_t *pcm;
+	unsigned long long tstamp;	/* end of the call, CLOCK_MONOTONIC ns */
+	unsigned int duration;		/* ns */
+	int tid;
+	unsigned int type;
+	long result;
+	snd_pcm_uframes_t hw_ptr;
+	snd_pcm_uframes_t appl_ptr;
+};
+
+struct trace_ring {
+	struct trace_ring *next;	/* all rings, never freed */
+	int used;			/* owned by a thread */
+	unsigned long head;		/* events written */
+	struct trace_event events[TRACE_EVENTS];
+};
+
+struct trace_line {
+	char buf[192];
+	size_t len;
+};
+
+int snd_pcm_trace_active;
+
+static struct trace_ring *trace_rings;
+static __thread struct trace_ring *trace_thread_ring;
+static __thread int trace_tid;
+static __thread int trace_nested;	/* inside of a traced call */
+
+static const char *const trace_names[PCM_TRACE_LAST + 1] = {
+	[PCM_TRACE_AVAIL] = "avail",
+	[PCM_TRACE_COMMIT] = "commit",
+	[PCM_TRACE_WRITE] = "write",
+	[PCM_TRACE_READ] = "read",
+	[PCM_TRACE_WAKEUP] = "wakeup",
+	[PCM_TRACE_PREPARE] = "prepare",
+	[PCM_TRACE_RESET] = "reset",
+	[PCM_TRACE_START] = "start",
+	[PCM_TRACE_DROP] = "drop",
+	[PCM_TRACE_DRAIN] = "drain",
+	[PCM_TRACE_PAUSE] = "pause",
+	[PCM_TRACE_RELEASE] = "release",
+	[PCM_TRACE_RESUME] = "resume",
+};
+
+#ifdef HAVE_LIBPTHREAD
+static pthread_once_t trace_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t trace_key;
+static int trace_key_ok;
+
+/* hand the ring of an exiting thread over to the next new thread */
+static void trace_ring_put(void *data)
+{
+	struct trace_ring *ring = data;
+
+	trace_thread_ring = NULL;
+	__atomic_store_n(&ring->used, 0, __ATOMIC_RELEASE);
+}
+
+static void trace_key_init(void)
+{
+	trace_key_ok = pthread_key_create(&trace_key, trace_ring_put) == 0;
+}
+#endif
+
+static struct trace_ring *trace_ring_get(void)
+{
+	struct trace_ring *ring;
+	int unused;
+
+	for (ring = __atomic_load_n(&trace_rings, __ATOMIC_ACQUIRE); ring; ring = ring->next) {
+		unused = 0;
+		if (__atomic_compare_exchange_n(&ring->used, &unused, 1, 0,
+						__ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+			goto _found;
+	}
+	ring = calloc(1, sizeof(*ring));
+	if (!ring)
+		return NULL;
+	ring->used = 1;
+	ring->next = __atomic_load_n(&trace_rings, __ATOMIC_RELAXED);
+	while (!__atomic_compare_exchange_n(&trace_rings, &ring->next, ring, 1,
+					    __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+		;
+ _found:
+#ifdef SYS_gettid
+	trace_tid = syscall(SYS_gettid);
+#else
+	trace_tid = getpid();
+#endif
+#ifdef HAVE_LIBPTHREAD
+	pthread_once(&trace_key_once, trace_key_init);
+	if (trace_key_ok)
+		pthread_setspecific(trace_key, ring);
+#endif
+	trace_thread_ring = ring;
+	return ring;
+}
+
+void snd_pcm_trace_init(void)
+{
+	static int initialized;
+	const char *p;
+
+	/* evaluate env var only once at the first open for consistency */
+	if (initialized)
+		return;
+	initialized = 1;
+	p = getenv("LIBASOUND_PCM_TRACE");
+	if (p && *p && *p != '0')
+		__atomic_store_n(&snd_pcm_trace_active, 1, __ATOMIC_RELAXED);
+}
+
+unsigned long long snd_pcm_trace_now(void)
+{
+	snd_htimestamp_t ts;
+
+	gettimestamp(&ts, SND_PCM_TSTAMP_TYPE_MONOTONIC);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* the calls of the plugins to their slaves are not recorded */
+unsigned long long snd_pcm_trace_enter(void)
+{
+	if (trace_nested)
+		return 0;
+	trace_nested = 1;
+	return snd_pcm_trace_now();
+}
+
+void snd_pcm_trace_leave(snd_pcm_t *pcm, unsigned int type,
+			 unsigned long long start, long result)
+{
+	snd_pcm_trace_event(pcm, type, start, result);
+	trace_nested = 0;
+}
+
+void snd_pcm_trace_event(snd_pcm_t *pcm, unsigned int type,
+			 unsigned long long start, long result)
+{
+	struct trace_ring *ring = trace_thread_ring;
+	struct trace_event *ev;
+	unsigned long long now, duration;
+	unsigned long idx;
+	int saved_errno = errno;
+
+	if (!ring) {
+		ring = trace_ring_get();
+		if (!ring)
+			goto _end;
+	}
+	now = snd_pcm_trace_now();
+	duration = now > start ? now - start : 0;
+	/* claimed at once, an event of a signal handler here is lost at most */
+	idx = ring->head;
+	__atomic_store_n(&ring->head, idx + 1, __ATOMIC_RELAXED);
+	ev = &ring->events[idx & (TRACE_EVENTS - 1)];
+	__atomic_store_n(&ev->seq, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+	ev->pcm = pcm;
+	ev->tstamp = now;
+	ev->duration = duration > UINT_MAX ? UINT_MAX : duration;
+	ev->tid = trace_tid;
+	ev->type = type;
+	ev->result = result;
+	if (pcm->setup) {
+		ev->hw_ptr = *pcm->hw.ptr;
+		ev->appl_ptr = *pcm->appl.ptr;
+	} else {
+		ev->hw_ptr = ev->appl_ptr = 0;
+	}
+	__atomic_store_n(&ev->seq, idx + 1, __ATOMIC_RELEASE);
+ _end:
+	errno = saved_errno;
+}
+
+/* the line formatting is async-signal-safe */
+static void line_str(struct trace_line *line, const char *str)
+{
+	while (*str && line->len < sizeof(line->buf) - 1)
+		line->buf[line->len++] = *str++;
+}
+
+static void line_num(struct trace_line *line, unsigned long long val,
+		     unsigned int base, unsigned int width)
+{
+	char tmp[24];
+	unsigned int i = sizeof(tmp) - 1;
+
+	tmp[i] = '\0';
+	do {
+		tmp[--i] = "0123456789abcdef"[val % base];
+		val /= base;
+	} while ((val || sizeof(tmp) - 1 - i < width) && i > 0);
+	line_str(line, tmp + i);
+}
+
+static void line_snum(struct trace_line *line, long long val)
+{
+	if (val < 0) {
+		line_str(line, "-");
+		line_num(line, -(unsigned long long)val, 10, 1);
+	} else {
+		line_num(line, val, 10, 1);
+	}
+}
+
+static void trace_format(struct trace_line *line, const struct trace_event *ev)
+{
+	line->len = 0;
+	line_num(line, ev->tstamp / 1000000000ULL, 10, 1);
+	line_str(line, ".");
+	line_num(line, ev->tstamp % 1000000000ULL, 10, 9);
+	line_str(line, " tid ");
+	line_num(line, ev->tid, 10, 1);
+	line_str(line, " pcm 0x");
+	line_num(line, (uintptr_t)ev->pcm, 16, 1);
+	line_str(line, " ");
+	line_str(line, ev->type <= PCM_TRACE_LAST ? trace_names[ev->type] : "?");
+	line_str(line, " ");
+	line_num(line, ev->duration, 10, 1);
+	line_str(line, " ns result ");
+	line_snum(line, ev->result);
+	if (ev->result == -EPIPE)
+		line_str(line, " (xrun)");
+	else if (ev->result == -ESTRPIPE)
+		line_str(line, " (suspended)");
+	line_str(line, " hw_ptr ");
+	line_num(line, ev->hw_ptr, 10, 1);
+	line_str(line, " appl_ptr ");
+	line_num(line, ev->appl_ptr, 10, 1);
+	line_str(line, "\n");
+	line->buf[line->len] = '\0';
+}
+
+/*
+ * Call the callback for the recorded events of the PCM (all if NULL),
+ * thread by thread in the order of recording.
+ */
+static int trace_walk(snd_pcm_t *pcm,
+		      void (*callback)(const struct trace_line *line, void *data),
+		      void *data)
+{
+	struct trace_ring *ring;
+	struct trace_event ev;
+	struct trace_line line;
+	unsigned long head, idx;
+	int count = 0;
+
+	for (ring = __atomic_load_n(&trace_rings, __ATOMIC_ACQUIRE); ring; ring = ring->next) {
+		head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		idx = head > TRACE_EVENTS ? head - TRACE_EVENTS : 0;
+		for (; idx < head; idx++) {
+			struct trace_event *src = &ring->events[idx & (TRACE_EVENTS - 1)];
+
+			if (__atomic_load_n(&src->seq, __ATOMIC_ACQUIRE) != idx + 1)
+				continue;
+			ev = *src;
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+			if (__atomic_load_n(&src->seq, __ATOMIC_RELAXED) != idx + 1)
+				continue;	/* overwritten meanwhile */
+			if (pcm && ev.pcm != pcm)
+				continue;
+			trace_format(&line, &ev);
+			callback(&line, data);
+			count++;
+		}
+	}
+	return count;
+}
+
+static void trace_output(const struct trace_line *line, void *data)
+{
+	snd_output_puts(data, line->buf);
+}
+
+static void trace_write(const struct trace_line *line, void *data)
+{
+	const char *buf = line->buf;
+	size_t len = line->len;
+	ssize_t res;
+
+	while (len > 0) {
+		res = write(*(int *)data, buf, len);
+		if (res <= 0) {
+			if (res < 0 && errno == EINTR)
+				continue;
+			break;
+		}
+		buf += res;
+		len -= res;
+	}
+}
+#endif /* DOC_HIDDEN */
+
+/**
+ * \brief Enable or disable the PCM tracing
+ * \param enable 1 = enable, 0 = disable
+ * \return the previous state (0 or 1), -ENXIO if the library was built
+ *         without the tracing
+ *
+ * When enabled, the calls changing the state of a PCM (prepare, start,
+ * drop, drain, pause, resume), the transfers, the mmap commits, the
+ * avail updates and the wakeups of #snd_pcm_wait() made by the
+ * application are recorded with their duration, result and the hw_ptr
+ * and appl_ptr after the call; the calls of the plugins to their slaves
+ * are not.  Each thread records into its own ring of the last 4096
+ * events without any lock.
+ *
+ * The tracing is enabled at the first open also by the environment
+ * variable \c LIBASOUND_PCM_TRACE set to \c 1.
+ */
+int snd_pcm_trace_enable(int enable)
+{
+	snd_pcm_trace_init();
+	return __atomic_exchange_n(&snd_pcm_trace_active, !!enable, __ATOMIC_RELAXED);
+}
+
+/**
+ * \brief Dump the recorded PCM events
+ * \param pcm PCM handle, NULL for the events of all PCMs
+ * \param out Output handle
+ * \return the number of events, -ENXIO if the library was built without
+ *         the tracing
+ *
+ * The events are printed thread by thread, one line per event with the
+ * monotonic timestamp of the end of the call, the thread id, the PCM
+ * handle, the event, the duration of the call, its result and the
+ * hw_ptr and appl_ptr.
+ */
+int snd_pcm_trace_dump(snd_pcm_t *pcm, snd_output_t *out)
+{
+	assert(out);
+	return trace_walk(pcm, trace_output, out);
+}
+
+/**
+ * \brief Dump the recorded PCM events to a file descriptor
+ * \param pcm PCM handle, NULL for the events of all PCMs
+ * \param fd File descriptor
+ * \return the number of events, -ENXIO if the library was built without
+ *         the tracing
+ *
+ * The same as #snd_pcm_trace_dump(), but async-signal-safe, so it can be
+ * called from a signal handler, e.g. snd_pcm_trace_dump_fd(NULL, 2) on
+ * SIGUSR1 dumps the history of a stream which just had an xrun.
+ */
+int snd_pcm_trace_dump_fd(snd_pcm_t *pcm, int fd)
+{
+	return trace_walk(pcm, trace_write, &fd);
+}
+
+#else /* BUILD_PCM_TRACE */
+
+#ifndef DOC_HIDDEN
+int snd_pcm_trace_enable(int enable ATTRIBUTE_UNUSED)
+{
+	return -ENXIO;
+}
+
+int snd_pcm_trace_dump(snd_pcm_t *pcm ATTRIBUTE_UNUSED,
+		       snd_output_t *out ATTRIBUTE_UNUSED)
+{
+	return -ENXIO;
+}
+
+int snd_pcm_trace_dump_fd(snd_pcm_t *pcm ATTRIBUTE_UNUSED,
+			  int fd ATTRIBUTE_UNUSED)
+{
+	return -ENXIO;
+}
+#endif /* DOC_HIDDEN */
+
+#endif /* BUILD_PCM_TRACE */
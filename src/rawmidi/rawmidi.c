@@ -430,6 +430,8 @@ int snd_rawmidi_poll_descriptors_count(snd_rawmidi_t *rawmidi)
 int snd_rawmidi_poll_descriptors(snd_rawmidi_t *rawmidi, struct pollfd *pfds, unsigned int space)
 {
 	assert(rawmidi);
+	if (rawmidi->ops->poll_descriptors)
+		return rawmidi->ops->poll_descriptors(rawmidi, pfds, space);
 	if (space >= 1) {
 		pfds->fd = rawmidi->poll_fd;
 		pfds->events = rawmidi->stream == SND_RAWMIDI_STREAM_OUTPUT ? (POLLOUT|POLLERR|POLLNVAL) : (POLLIN|POLLERR|POLLNVAL);
@@ -449,6 +451,8 @@ int snd_rawmidi_poll_descriptors(snd_rawmidi_t *rawmidi, struct pollfd *pfds, un
 int snd_rawmidi_poll_descriptors_revents(snd_rawmidi_t *rawmidi, struct pollfd *pfds, unsigned int nfds, unsigned short *revents)
 {
         assert(rawmidi && pfds && revents);
+        if (rawmidi->ops->poll_revents)
+                return rawmidi->ops->poll_revents(rawmidi, pfds, nfds, revents);
         if (nfds == 1) {
                 *revents = pfds->revents;
                 return 0;
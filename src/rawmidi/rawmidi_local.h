@@ -37,6 +37,8 @@ typedef struct {
 	ssize_t (*tread)(snd_rawmidi_t *rawmidi, struct timespec *tstamp, void *buffer, size_t size);
 	int (*ump_endpoint_info)(snd_rawmidi_t *rmidi, void *buf);
 	int (*ump_block_info)(snd_rawmidi_t *rmidi, void *buf);
+	int (*poll_descriptors)(snd_rawmidi_t *rmidi, struct pollfd *pfds, unsigned int space); /* optional */
+	int (*poll_revents)(snd_rawmidi_t *rmidi, struct pollfd *pfds, unsigned int nfds, unsigned short *revents); /* optional */
 } snd_rawmidi_ops_t;
 
 struct _snd_rawmidi {
@@ -63,6 +65,11 @@ int snd_rawmidi_virtual_open(snd_rawmidi_t **inputp, snd_rawmidi_t **outputp,
 			     const char *name, snd_seq_t *seq_handle, int port,
 			     int merge, int mode);
 
+#define snd_rawmidi_shm_open snd1_rawmidi_shm_open
+int snd_rawmidi_shm_open(snd_rawmidi_t **inputp, snd_rawmidi_t **outputp,
+			 const char *name, const char *ring_name, size_t size,
+			 int mode);
+
 #define snd_rawmidi_conf_generic_id(id)	_snd_conf_generic_id(id)
 
 int _snd_rawmidi_ump_endpoint_info(snd_rawmidi_t *rmidi, void *info);
@@ -0,0 +1,686 @@
+/*
+ *  RawMIDI - Shared memory ring
+ *
+ *
+ *   This library is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU Lesser General Public License as
+ *   published by the Free Software Foundation; either version 2.1 of
+ *   the License, or (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include "rawmidi_local.h"
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#ifndef PIC
+/* entry for static linking */
+const char *_snd_module_rawmidi_shm = "";
+#endif
+
+#ifndef DOC_HIDDEN
+
+#define SHM_RING_MAGIC		0x524d4952	/* "RIMR" */
+#define SHM_RING_DEFAULT_SIZE	(64 * 1024)
+#define SHM_RING_MIN_SIZE	256
+#define SHM_RING_MAX_SIZE	(1024 * 1024)
+#define SHM_RING_NAME_MAX	64
+
+/*
+ * The ring is shared by exactly one producer (output stream) and one
+ * consumer (input stream).  The producer only advances head, the consumer
+ * only advances tail; both are free running and wrap at 2^32.
+ */
+typedef struct {
+	unsigned int magic;
+	unsigned int size;		/* data size, power of two */
+	unsigned int head __attribute__((aligned(64)));	/* write position */
+	unsigned int reader_wait;	/* consumer waits for data */
+	unsigned int tail __attribute__((aligned(64)));	/* read position */
+	unsigned int writer_wait;	/* producer waits for room */
+	unsigned char data[] __attribute__((aligned(64)));
+} snd_rawmidi_shm_ring_t;
+
+typedef struct {
+	char *ring_name;
+	int shm_fd;
+	size_t map_size;
+	snd_rawmidi_shm_ring_t *ring;
+	int sock;			/* own notification socket */
+	struct sockaddr_un addr;
+	socklen_t addr_len;
+	struct sockaddr_un peer;	/* notification socket of the other side */
+	socklen_t peer_len;
+	int room_signaled;		/* output: own datagram pending on sock */
+} snd_rawmidi_shm_t;
+#endif
+
+/*
+ * Notifications are sent as empty datagrams to abstract unix sockets
+ * bound by each side.  Unlike eventfd, they can be addressed by name
+ * from unrelated processes, and binding the address also ensures there
+ * is a single producer and consumer per ring.
+ */
+static socklen_t shm_sock_addr(struct sockaddr_un *addr, const char *ring_name,
+			       snd_rawmidi_stream_t stream)
+{
+	memset(addr, 0, sizeof(*addr));
+	addr->sun_family = AF_UNIX;
+	/* the leading NUL byte selects the abstract namespace */
+	snprintf(addr->sun_path + 1, sizeof(addr->sun_path) - 1,
+		 "alsa-rawmidi-shm-%s-%s", ring_name,
+		 stream == SND_RAWMIDI_STREAM_INPUT ? "in" : "out");
+	return offsetof(struct sockaddr_un, sun_path) + 1 +
+		strlen(addr->sun_path + 1);
+}
+
+static void shm_notify(snd_rawmidi_shm_t *shm, unsigned int *wait)
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	if (!__atomic_load_n(wait, __ATOMIC_RELAXED))
+		return;
+	if (!__atomic_exchange_n(wait, 0, __ATOMIC_SEQ_CST))
+		return;
+	/* the peer may not be attached yet; ignore errors */
+	sendto(shm->sock, "", 0, MSG_DONTWAIT,
+	       (struct sockaddr *)&shm->peer, shm->peer_len);
+}
+
+/*
+ * arm the wait flag; returns 1 if the ring position did not change
+ * meanwhile, i.e. it's safe to sleep on the notification socket
+ */
+static int shm_arm(snd_rawmidi_shm_t *shm, unsigned int *wait,
+		   unsigned int *pos, unsigned int old)
+{
+	char c;
+
+	/* consume the stale notifications so that POLLIN is cleared */
+	while (recv(shm->sock, &c, sizeof(c), MSG_DONTWAIT) >= 0)
+		;
+	shm->room_signaled = 0;
+	__atomic_store_n(wait, 1, __ATOMIC_SEQ_CST);
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+	return __atomic_load_n(pos, __ATOMIC_ACQUIRE) == old;
+}
+
+/*
+ * The output handle is polled for POLLIN on its socket, which is
+ * readable while the ring has room: a datagram sent to itself stays
+ * queued until the ring gets full and the writer arms its wait flag,
+ * then the consumer wakes it when it frees some room.
+ */
+static void shm_signal_room(snd_rawmidi_shm_t *shm)
+{
+	snd_rawmidi_shm_ring_t *ring = shm->ring;
+
+	if (shm->room_signaled)
+		return;
+	if (ring->head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= ring->size)
+		return;
+	if (sendto(shm->sock, "", 0, MSG_DONTWAIT,
+		   (struct sockaddr *)&shm->addr, shm->addr_len) >= 0)
+		shm->room_signaled = 1;
+}
+
+static int shm_wait(snd_rawmidi_shm_t *shm)
+{
+	struct pollfd pfd;
+
+	pfd.fd = shm->sock;
+	pfd.events = POLLIN;
+	if (poll(&pfd, 1, -1) < 0) {
+		if (errno == EINTR)
+			return 0;
+		SYSERR("poll");
+		return -errno;
+	}
+	return 0;
+}
+
+/*
+ * The socket of the other side is bound as long as its process holds
+ * the ring open, and vanishes with the process, so it tells whether
+ * the ring is still used even after a crash.
+ */
+static int shm_peer_alive(snd_rawmidi_shm_t *shm)
+{
+	int fd, alive;
+
+	fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return 1;
+	alive = connect(fd, (struct sockaddr *)&shm->peer, shm->peer_len) == 0 ||
+		errno != ECONNREFUSED;
+	close(fd);
+	return alive;
+}
+
+static void shm_detach(snd_rawmidi_shm_t *shm)
+{
+	if (shm->ring != MAP_FAILED && shm->ring) {
+		flock(shm->shm_fd, LOCK_EX);
+		/*
+		 * unbind under the lock, so that of two sides closing at
+		 * once the latter one always sees the former one gone
+		 */
+		close(shm->sock);
+		shm->sock = -1;
+		if (!shm_peer_alive(shm)) {
+			char path[SHM_RING_NAME_MAX + 16];
+			snprintf(path, sizeof(path), "/alsa-rawmidi-%s", shm->ring_name);
+			shm_unlink(path);
+		}
+		flock(shm->shm_fd, LOCK_UN);
+		munmap(shm->ring, shm->map_size);
+	}
+	if (shm->shm_fd >= 0)
+		close(shm->shm_fd);
+	if (shm->sock >= 0)
+		close(shm->sock);
+	free(shm->ring_name);
+	free(shm);
+}
+
+static int shm_attach(snd_rawmidi_shm_t *shm, size_t size)
+{
+	char path[SHM_RING_NAME_MAX + 16];
+	struct stat st;
+	int fresh = 0;
+	int err;
+
+	snprintf(path, sizeof(path), "/alsa-rawmidi-%s", shm->ring_name);
+	for (;;) {
+		shm->shm_fd = shm_open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+		if (shm->shm_fd < 0) {
+			SYSERR("shm_open %s failed", path);
+			return -errno;
+		}
+		flock(shm->shm_fd, LOCK_EX);
+		if (fstat(shm->shm_fd, &st) < 0) {
+			err = -errno;
+			goto _err;
+		}
+		/* unlinked by the last user in the meantime, try again */
+		if (st.st_nlink > 0)
+			break;
+		flock(shm->shm_fd, LOCK_UN);
+		close(shm->shm_fd);
+	}
+	/* left over by a side which died, start over */
+	if (st.st_size > 0 && !shm_peer_alive(shm)) {
+		st.st_size = 0;
+		fresh = 1;
+	}
+	if (st.st_size == 0) {
+		if (ftruncate(shm->shm_fd, sizeof(snd_rawmidi_shm_ring_t) + size) < 0) {
+			err = -errno;
+			goto _err;
+		}
+	} else {
+		size = st.st_size - sizeof(snd_rawmidi_shm_ring_t);
+	}
+	shm->map_size = sizeof(snd_rawmidi_shm_ring_t) + size;
+	shm->ring = mmap(NULL, shm->map_size, PROT_READ | PROT_WRITE,
+			 MAP_SHARED, shm->shm_fd, 0);
+	if (shm->ring == MAP_FAILED) {
+		err = -errno;
+		goto _err;
+	}
+	if (fresh || shm->ring->magic != SHM_RING_MAGIC) {
+		shm->ring->size = size;
+		shm->ring->head = shm->ring->tail = 0;
+		shm->ring->reader_wait = shm->ring->writer_wait = 0;
+		shm->ring->magic = SHM_RING_MAGIC;
+	} else if (shm->ring->size != size) {
+		SNDERR("shm ring %s is corrupted", shm->ring_name);
+		munmap(shm->ring, shm->map_size);
+		shm->ring = NULL;
+		err = -EBADFD;
+		goto _err;
+	}
+	flock(shm->shm_fd, LOCK_UN);
+	return 0;
+
+ _err:
+	flock(shm->shm_fd, LOCK_UN);
+	return err;
+}
+
+static int snd_rawmidi_shm_close(snd_rawmidi_t *rmidi)
+{
+	shm_detach(rmidi->private_data);
+	return 0;
+}
+
+static int snd_rawmidi_shm_nonblock(snd_rawmidi_t *rmidi ATTRIBUTE_UNUSED,
+				    int nonblock ATTRIBUTE_UNUSED)
+{
+	/* the mode bit is checked at each read and write */
+	return 0;
+}
+
+static int snd_rawmidi_shm_info(snd_rawmidi_t *rmidi, snd_rawmidi_info_t * info)
+{
+	snd_rawmidi_shm_t *shm = rmidi->private_data;
+
+	info->stream = rmidi->stream;
+	info->card = -1;
+	info->device = 0;
+	info->subdevice = 0;
+	info->flags = 0;
+	strcpy((char *)info->id, "Shm");
+	strcpy((char *)info->name, "Shared Memory RawMIDI");
+	snd_strlcpy((char *)info->subname, shm->ring_name, sizeof(info->subname));
+	info->subdevices_count = 1;
+	info->subdevices_avail = 0;
+	return 0;
+}
+
+static int snd_rawmidi_shm_params(snd_rawmidi_t *rmidi, snd_rawmidi_params_t * params)
+{
+	snd_rawmidi_shm_t *shm = rmidi->private_data;
+
+	/* the ring size is fixed when the ring is created */
+	params->stream = rmidi->stream;
+	params->buffer_size = shm->ring->size;
+	return 0;
+}
+
+static int snd_rawmidi_shm_status(snd_rawmidi_t *rmidi, snd_rawmidi_status_t * status)
+{
+	snd_rawmidi_shm_t *shm = rmidi->private_data;
+	snd_rawmidi_shm_ring_t *ring = shm->ring;
+	unsigned int used;
+
+	memset(status, 0, sizeof(*status));
+	status->stream = rmidi->stream;
+	used = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) -
+		__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	if (rmidi->stream == SND_RAWMIDI_STREAM_INPUT)
+		status->avail = used;
+	else
+		status->avail = ring->size - used;
+	return 0;
+}
+
+static int snd_rawmidi_shm_drop(snd_rawmidi_t *rmidi)
+{
+	snd_rawmidi_shm_t *shm = rmidi->private_data;
+	snd_rawmidi_shm_ring_t *ring = shm->ring;
+
+	/* the published output bytes belong to the consumer already */
+	if (rmidi->stream == SND_RAWMIDI_STREAM_INPUT) {
+		__atomic_store_n(&ring->tail,
+				 __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE),
+				 __ATOMIC_RELEASE);
+		shm_notify(shm, &ring->writer_wait);
+	}
+	return 0;
+}
+
+static int snd_rawmidi_shm_drain(snd_rawmidi_t *rmidi)
+{
+	snd_rawmidi_shm_t *shm = rmidi->private_data;
+	snd_rawmidi_shm_ring_t *ring = shm->ring;
+	unsigned int tail;
+	int err;
+
+	if (rmidi->stream == SND_RAWMIDI_STREAM_INPUT)
+		return snd_rawmidi_shm_drop(rmidi);
+	for (;;) {
+		tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if (tail == ring->head)
+			break;
+		if (!shm_arm(shm, &ring->writer_wait, &ring->tail, tail))
+			continue;
+		if (rmidi->mode & SND_RAWMIDI_NONBLOCK)
+			return -EAGAIN;
+		err = shm_wait(shm);
+		if (err < 0) {
+			shm_signal_room(shm);
+			return err;
+		}
+	}
+	shm_signal_room(shm);
+	return 0;
+}
+
+static ssize_t snd_rawmidi_shm_write(snd_rawmidi_t *rmidi, const void *buffer, size_t size)
+{
+	snd_rawmidi_shm_t *shm = rmidi->private_data;
+	snd_rawmidi_shm_ring_t *ring = shm->ring;
+	unsigned int head, tail, ofs;
+	size_t room, size1;
+	ssize_t result = 0;
+	int err;
+
+	while (size > 0) {
+		tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		head = ring->head;
+		room = ring->size - (head - tail);
+		if (room > 0) {
+			if (room > size)
+				room = size;
+			ofs = head & (ring->size - 1);
+			size1 = ring->size - ofs;
+			if (size1 > room)
+				size1 = room;
+			memcpy(ring->data + ofs, buffer, size1);
+			memcpy(ring->data, (const char *)buffer + size1, room - size1);
+			__atomic_store_n(&ring->head, head + room, __ATOMIC_RELEASE);
+			shm_notify(shm, &ring->reader_wait);
+			buffer = (const char *)buffer + room;
+			size -= room;
+			result += room;
+			continue;
+		}
+		if (!shm_arm(shm, &ring->writer_wait, &ring->tail, tail))
+			continue;
+		if (rmidi->mode & SND_RAWMIDI_NONBLOCK)
+			return result > 0 ? result : -EAGAIN;
+		err = shm_wait(shm);
+		if (err < 0) {
+			shm_signal_room(shm);
+			return result > 0 ? result : err;
+		}
+	}
+	shm_signal_room(shm);
+	return result;
+}
+
+static ssize_t snd_rawmidi_shm_read(snd_rawmidi_t *rmidi, void *buffer, size_t size)
+{
+	snd_rawmidi_shm_t *shm = rmidi->private_data;
+	snd_rawmidi_shm_ring_t *ring = shm->ring;
+	unsigned int head, tail, ofs;
+	size_t avail, size1;
+	int err;
+
+	if (size == 0)
+		return 0;
+	for (;;) {
+		head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		tail = ring->tail;
+		avail = head - tail;
+		if (avail > 0) {
+			if (avail > size)
+				avail = size;
+			ofs = tail & (ring->size - 1);
+			size1 = ring->size - ofs;
+			if (size1 > avail)
+				size1 = avail;
+			memcpy(buffer, ring->data + ofs, size1);
+			memcpy((char *)buffer + size1, ring->data, avail - size1);
+			__atomic_store_n(&ring->tail, tail + avail, __ATOMIC_RELEASE);
+			shm_notify(shm, &ring->writer_wait);
+			return avail;
+		}
+		if (!shm_arm(shm, &ring->reader_wait, &ring->head, head))
+			continue;
+		if (rmidi->mode & SND_RAWMIDI_NONBLOCK)
+			return -EAGAIN;
+		err = shm_wait(shm);
+		if (err < 0)
+			return err;
+	}
+}
+
+static int snd_rawmidi_shm_poll_descriptors(snd_rawmidi_t *rmidi,
+					    struct pollfd *pfds,
+					    unsigned int space)
+{
+	if (space < 1)
+		return 0;
+	/* see shm_signal_room() for the output stream */
+	pfds->fd = rmidi->poll_fd;
+	pfds->events = POLLIN | POLLERR | POLLNVAL;
+	return 1;
+}
+
+static int snd_rawmidi_shm_poll_revents(snd_rawmidi_t *rmidi,
+					struct pollfd *pfds, unsigned int nfds,
+					unsigned short *revents)
+{
+	snd_rawmidi_shm_t *shm = rmidi->private_data;
+	snd_rawmidi_shm_ring_t *ring = shm->ring;
+	unsigned short events;
+	unsigned int tail;
+
+	if (nfds != 1)
+		return -EINVAL;
+	events = pfds->revents & ~POLLIN;
+	if (rmidi->stream == SND_RAWMIDI_STREAM_INPUT) {
+		if (pfds->revents & POLLIN)
+			events |= POLLIN;
+	} else if (pfds->revents & POLLIN) {
+		tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+		if (ring->head - tail < ring->size ||
+		    !shm_arm(shm, &ring->writer_wait, &ring->tail, tail)) {
+			/* keep the socket readable while there is room */
+			shm_signal_room(shm);
+			events |= POLLOUT;
+		}
+	}
+	*revents = events;
+	return 0;
+}
+
+static const snd_rawmidi_ops_t snd_rawmidi_shm_ops = {
+	.close = snd_rawmidi_shm_close,
+	.nonblock = snd_rawmidi_shm_nonblock,
+	.info = snd_rawmidi_shm_info,
+	.params = snd_rawmidi_shm_params,
+	.status = snd_rawmidi_shm_status,
+	.drop = snd_rawmidi_shm_drop,
+	.drain = snd_rawmidi_shm_drain,
+	.write = snd_rawmidi_shm_write,
+	.read = snd_rawmidi_shm_read,
+	.poll_descriptors = snd_rawmidi_shm_poll_descriptors,
+	.poll_revents = snd_rawmidi_shm_poll_revents,
+};
+
+static int snd_rawmidi_shm_new(snd_rawmidi_t **rmidip, const char *name,
+			       const char *ring_name, size_t size,
+			       snd_rawmidi_stream_t stream, int mode)
+{
+	snd_rawmidi_t *rmidi;
+	snd_rawmidi_shm_t *shm;
+	int err;
+
+	shm = calloc(1, sizeof(*shm));
+	if (shm == NULL)
+		return -ENOMEM;
+	shm->shm_fd = -1;
+	shm->sock = -1;
+	shm->ring_name = strdup(ring_name);
+	if (shm->ring_name == NULL) {
+		err = -ENOMEM;
+		goto _err;
+	}
+	shm->sock = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (shm->sock < 0) {
+		SYSERR("socket failed");
+		err = -errno;
+		goto _err;
+	}
+	shm->addr_len = shm_sock_addr(&shm->addr, ring_name, stream);
+	if (bind(shm->sock, (struct sockaddr *)&shm->addr, shm->addr_len) < 0) {
+		err = errno == EADDRINUSE ? -EBUSY : -errno;
+		goto _err;
+	}
+	shm->peer_len = shm_sock_addr(&shm->peer, ring_name,
+				      stream == SND_RAWMIDI_STREAM_INPUT ?
+				      SND_RAWMIDI_STREAM_OUTPUT :
+				      SND_RAWMIDI_STREAM_INPUT);
+	err = shm_attach(shm, size);
+	if (err < 0)
+		goto _err;
+
+	rmidi = calloc(1, sizeof(*rmidi));
+	if (rmidi == NULL) {
+		err = -ENOMEM;
+		goto _err;
+	}
+	if (name)
+		rmidi->name = strdup(name);
+	rmidi->type = SND_RAWMIDI_TYPE_SHM;
+	rmidi->stream = stream;
+	rmidi->mode = mode;
+	rmidi->poll_fd = shm->sock;
+	rmidi->ops = &snd_rawmidi_shm_ops;
+	rmidi->private_data = shm;
+	if (stream == SND_RAWMIDI_STREAM_INPUT) {
+		/* data written before the consumer attached */
+		if (!shm_arm(shm, &shm->ring->reader_wait, &shm->ring->head,
+			     shm->ring->tail))
+			sendto(shm->sock, "", 0, MSG_DONTWAIT,
+			       (struct sockaddr *)&shm->addr, shm->addr_len);
+	} else {
+		shm_signal_room(shm);
+	}
+	*rmidip = rmidi;
+	return 0;
+
+ _err:
+	shm_detach(shm);
+	return err;
+}
+
+/*! \page rawmidi RawMidi interface
+
+\section rawmidi_shm Shared memory RawMidi interface
+
+The "shm" plugin passes the MIDI byte stream through a lock-free ring
+buffer in POSIX shared memory, without any kernel round trip for the data.
+The rings are identified by name; the output stream of one handle feeds the
+input stream of another handle opened with the same ring name, either in
+the same process or in another process of the same user.
+
+Each ring has at most one writer and one reader.  The consumer is woken
+through a datagram on an abstract unix socket, which is also the poll
+descriptor of the input handle.  The producer is woken the same way when
+the consumer frees room in a full ring, so the output handle polls for
+\c POLLIN on its socket; #snd_rawmidi_poll_descriptors_revents() translates
+it to \c POLLOUT.  A non-blocking write returns \c -EAGAIN when the ring
+is full.
+
+\code
+rawmidi.NAME {
+	type shm		# Shared memory ring RawMidi
+	[ring STR]		# Ring name, the RawMidi name is used as default
+	[size INT]		# Ring size in bytes when created
+}
+\endcode
+
+Example:
+\code
+snd_rawmidi_open(NULL, &write_handle, "shm:bus1", 0);
+snd_rawmidi_open(&read_handle, NULL, "shm:bus1", 0);
+\endcode
+
+*/
+
+int snd_rawmidi_shm_open(snd_rawmidi_t **inputp, snd_rawmidi_t **outputp,
+			 const char *name, const char *ring_name, size_t size,
+			 int mode)
+{
+	unsigned int rsize;
+	int err;
+
+	if (inputp)
+		*inputp = NULL;
+	if (outputp)
+		*outputp = NULL;
+	if (!ring_name || !*ring_name || strchr(ring_name, '/') ||
+	    strlen(ring_name) > SHM_RING_NAME_MAX) {
+		SNDERR("Invalid shm ring name");
+		return -EINVAL;
+	}
+	if (size > SHM_RING_MAX_SIZE)
+		return -EINVAL;
+	for (rsize = SHM_RING_MIN_SIZE; rsize < size; rsize <<= 1)
+		;
+
+	if (inputp) {
+		err = snd_rawmidi_shm_new(inputp, name, ring_name, rsize,
+					  SND_RAWMIDI_STREAM_INPUT, mode);
+		if (err < 0)
+			return err;
+	}
+	if (outputp) {
+		err = snd_rawmidi_shm_new(outputp, name, ring_name, rsize,
+					  SND_RAWMIDI_STREAM_OUTPUT, mode);
+		if (err < 0) {
+			if (inputp) {
+				snd_rawmidi_shm_close(*inputp);
+				free((*inputp)->name);
+				free(*inputp);
+				*inputp = NULL;
+			}
+			return err;
+		}
+	}
+	return 0;
+}
+
+int _snd_rawmidi_shm_open(snd_rawmidi_t **inputp, snd_rawmidi_t **outputp,
+			  char *name, snd_config_t *root ATTRIBUTE_UNUSED,
+			  snd_config_t *conf, int mode)
+{
+	snd_config_iterator_t i, next;
+	const char *ring_name = name;
+	long size = SHM_RING_DEFAULT_SIZE;
+	int err;
+
+	snd_config_for_each(i, next, conf) {
+		snd_config_t *n = snd_config_iterator_entry(i);
+		const char *id;
+		if (snd_config_get_id(n, &id) < 0)
+			continue;
+		if (snd_rawmidi_conf_generic_id(id))
+			continue;
+		if (strcmp(id, "ring") == 0) {
+			err = snd_config_get_string(n, &ring_name);
+			if (err < 0) {
+				SNDERR("Invalid type for %s", id);
+				return err;
+			}
+			continue;
+		}
+		if (strcmp(id, "size") == 0) {
+			err = snd_config_get_integer(n, &size);
+			if (err < 0 || size <= 0) {
+				SNDERR("Invalid value for %s", id);
+				return -EINVAL;
+			}
+			continue;
+		}
+		SNDERR("Unknown field %s", id);
+		return -EINVAL;
+	}
+	if (!inputp && !outputp)
+		return -EINVAL;
+
+	return snd_rawmidi_shm_open(inputp, outputp, name, ring_name, size, mode);
+}
+
+#ifndef DOC_HIDDEN
+SND_DLSYM_BUILD_VERSION(_snd_rawmidi_shm_open, SND_RAWMIDI_DLSYM_VERSION);
+#endif
@@ -767,3 +767,490 @@ int snd_ump_msg_sysex_expand(const uint32_t *ump, uint8_t *buf, size_t maxlen,
 		return -EINVAL;
 	}
 }
+
+/*
+ * UMP <-> MIDI 1.0 byte stream translation
+ */
+
+/* UMP packet size in 32bit words, indexed by message type */
+static const unsigned char ump_packet_words[16] = {
+	1, 1, 1, 2, 2, 4, 1, 1, 2, 2, 2, 3, 3, 4, 4, 4
+};
+
+/* data bytes of MIDI 1.0 channel messages, indexed by status 0x8-0xe */
+static const unsigned char midi1_channel_len[8] = {
+	2, 2, 2, 2, 1, 1, 2, 0
+};
+
+/* data bytes of MIDI 1.0 system messages, indexed by status 0xf0-0xff;
+ * -1 for undefined or sysex
+ */
+static const signed char midi1_system_len[16] = {
+	-1, 1, 2, 1, -1, -1, 0, -1, 0, -1, 0, 0, 0, -1, 0, 0
+};
+
+/**
+ * \brief get the UMP packet length in 32bit words
+ * \param type UMP message type
+ * \return the number of 32bit words of the packet
+ */
+int snd_ump_packet_length(unsigned int type)
+{
+	if (type >= 16)
+		return 0;
+	return ump_packet_words[type];
+}
+
+/* Min-Center-Max upscaling of MIDI 1.0 values as defined in the UMP spec */
+static uint32_t ump_upscale(uint32_t val, int src_bits, int dst_bits)
+{
+	unsigned int scale_bits = dst_bits - src_bits;
+	unsigned int repeat_bits = src_bits - 1;
+	uint32_t shifted = val << scale_bits;
+	uint32_t repeat;
+
+	if (val <= (1U << repeat_bits))
+		return shifted;
+	repeat = val & ((1U << repeat_bits) - 1);
+	if (scale_bits > repeat_bits)
+		repeat <<= scale_bits - repeat_bits;
+	else
+		repeat >>= repeat_bits - scale_bits;
+	while (repeat) {
+		shifted |= repeat;
+		repeat >>= repeat_bits;
+	}
+	return shifted;
+}
+
+/* convert a MIDI 2.0 channel voice message to MIDI 1.0 bytes */
+static int decode_midi2_cvm(const uint32_t *ump, uint8_t *buf)
+{
+	unsigned char status = snd_ump_msg_status(ump);
+	unsigned char channel = snd_ump_msg_channel(ump);
+	unsigned char cc = (SND_UMP_MSG_CONTROL_CHANGE << 4) | channel;
+	uint32_t data = ump[1];
+	int len = 0;
+
+	switch (status) {
+	case SND_UMP_MSG_NOTE_OFF:
+	case SND_UMP_MSG_NOTE_ON:
+		buf[0] = (status << 4) | channel;
+		buf[1] = (ump[0] >> 8) & 0x7f;
+		buf[2] = data >> 25;
+		/* keep a note-on a note-on */
+		if (status == SND_UMP_MSG_NOTE_ON && !buf[2])
+			buf[2] = 1;
+		return 3;
+	case SND_UMP_MSG_POLY_PRESSURE:
+		buf[0] = (status << 4) | channel;
+		buf[1] = (ump[0] >> 8) & 0x7f;
+		buf[2] = data >> 25;
+		return 3;
+	case SND_UMP_MSG_CONTROL_CHANGE:
+		buf[0] = cc;
+		buf[1] = (ump[0] >> 8) & 0x7f;
+		buf[2] = data >> 25;
+		return 3;
+	case SND_UMP_MSG_PROGRAM_CHANGE:
+		if (ump[0] & 1) {
+			/* bank valid */
+			buf[len++] = cc;
+			buf[len++] = 0x00;
+			buf[len++] = (data >> 8) & 0x7f;
+			buf[len++] = cc;
+			buf[len++] = 0x20;
+			buf[len++] = data & 0x7f;
+		}
+		buf[len++] = (status << 4) | channel;
+		buf[len++] = (data >> 24) & 0x7f;
+		return len;
+	case SND_UMP_MSG_CHANNEL_PRESSURE:
+		buf[0] = (status << 4) | channel;
+		buf[1] = data >> 25;
+		return 2;
+	case SND_UMP_MSG_PITCHBEND:
+		buf[0] = (status << 4) | channel;
+		buf[1] = (data >> 18) & 0x7f;
+		buf[2] = data >> 25;
+		return 3;
+	case SND_UMP_MSG_RPN:
+	case SND_UMP_MSG_NRPN:
+		buf[0] = cc;
+		buf[1] = status == SND_UMP_MSG_RPN ? 0x65 : 0x63;
+		buf[2] = (ump[0] >> 8) & 0x7f;
+		buf[3] = cc;
+		buf[4] = status == SND_UMP_MSG_RPN ? 0x64 : 0x62;
+		buf[5] = ump[0] & 0x7f;
+		buf[6] = cc;
+		buf[7] = 0x06;
+		buf[8] = data >> 25;
+		buf[9] = cc;
+		buf[10] = 0x26;
+		buf[11] = (data >> 18) & 0x7f;
+		return 12;
+	default:
+		return 0;
+	}
+}
+
+/* convert a 7bit sysex packet to MIDI 1.0 bytes, -EINVAL if malformed */
+static int decode_sysex7(const uint32_t *ump, uint8_t *buf)
+{
+	unsigned char status = snd_ump_sysex_msg_status(ump);
+	unsigned char bytes = snd_ump_sysex_msg_length(ump);
+	int len = 0;
+
+	if (bytes > 6 || status > SND_UMP_SYSEX_STATUS_END)
+		return -EINVAL;
+	if (status == SND_UMP_SYSEX_STATUS_SINGLE ||
+	    status == SND_UMP_SYSEX_STATUS_START)
+		buf[len++] = SND_UMP_MSG_SYSEX_START;
+	len += expand_sysex_data(ump, buf + len, bytes, bytes, 8);
+	if (status == SND_UMP_SYSEX_STATUS_SINGLE ||
+	    status == SND_UMP_SYSEX_STATUS_END)
+		buf[len++] = SND_UMP_MSG_SYSEX_END;
+	return len;
+}
+
+/**
+ * \brief convert UMP packets to a MIDI 1.0 byte stream
+ * \param ump array of UMP words
+ * \param words the number of words in \a ump
+ * \param buf buffer to store the MIDI 1.0 bytes
+ * \param maxlen the size of \a buf in bytes
+ * \param consumed the number of words consumed, or NULL
+ * \return the number of bytes stored in \a buf, or -EINVAL if the
+ *         first packet is malformed
+ *
+ * Translates the system messages, MIDI 1.0 and MIDI 2.0 channel voice
+ * messages and 7bit sysex packets of all groups.  MIDI 2.0 values are
+ * scaled down to MIDI 1.0 resolution; RPN/NRPN messages and program
+ * changes with a valid bank become control change sequences.  Other
+ * packets are skipped.  Running status is not used.
+ *
+ * The translation stops at an incomplete packet at the end of \a ump, at
+ * the first packet whose bytes don't fit into \a buf, or at a malformed
+ * packet (an undefined status of a system or MIDI 1.0 channel voice
+ * message, or an invalid 7bit sysex packet); these packets are not
+ * consumed.  A malformed packet is reported by -EINVAL when it is the
+ * first one; the caller may skip it by snd_ump_packet_length() words.
+ */
+ssize_t snd_ump_msg_decode_bytes(const uint32_t *ump, size_t words,
+				 uint8_t *buf, size_t maxlen, size_t *consumed)
+{
+	const uint32_t *p = ump, *end = ump + words;
+	uint8_t tmp[12];
+	unsigned char type, status;
+	size_t filled = 0;
+	int len, plen;
+
+	while (p < end) {
+		type = snd_ump_msg_type(p);
+		plen = ump_packet_words[type];
+		if (end - p < plen)
+			break;
+		len = 0;
+		switch (type) {
+		case SND_UMP_MSG_TYPE_SYSTEM:
+			status = (*p >> 16) & 0xff;
+			len = midi1_system_len[status & 0x0f];
+			if (status < 0xf0 || len < 0) {
+				len = -EINVAL;
+				break;
+			}
+			tmp[0] = status;
+			tmp[1] = (*p >> 8) & 0x7f;
+			tmp[2] = *p & 0x7f;
+			len++;
+			break;
+		case SND_UMP_MSG_TYPE_MIDI1_CHANNEL_VOICE:
+			status = (*p >> 16) & 0xff;
+			if (status < 0x80 || status >= 0xf0) {
+				len = -EINVAL;
+				break;
+			}
+			tmp[0] = status;
+			tmp[1] = (*p >> 8) & 0x7f;
+			tmp[2] = *p & 0x7f;
+			len = midi1_channel_len[(status >> 4) & 0x07] + 1;
+			break;
+		case SND_UMP_MSG_TYPE_DATA:
+			len = decode_sysex7(p, tmp);
+			break;
+		case SND_UMP_MSG_TYPE_MIDI2_CHANNEL_VOICE:
+			len = decode_midi2_cvm(p, tmp);
+			break;
+		}
+		if (len < 0) {
+			if (p > ump)
+				break;
+			if (consumed)
+				*consumed = 0;
+			return len;
+		}
+		if (filled + len > maxlen)
+			break;
+		memcpy(buf + filled, tmp, len);
+		filled += len;
+		p += plen;
+	}
+
+	if (consumed)
+		*consumed = p - ump;
+	return filled;
+}
+
+#ifndef DOC_HIDDEN
+struct _snd_ump_msg_encoder {
+	unsigned int group;
+	int midi2;
+	unsigned char status;		/* current (running) status, 0 = none */
+	unsigned char need;		/* data bytes of the current status */
+	unsigned char read;		/* data bytes received */
+	unsigned char data[2];
+	unsigned char in_sysex;
+	unsigned char sysex_started;	/* sysex start packet was sent */
+	unsigned char sysex_len;
+	unsigned char sysex[6];
+};
+#endif
+
+/**
+ * \brief create a MIDI 1.0 byte stream to UMP encoder
+ * \param encp the pointer to store the new encoder
+ * \param group UMP group of the generated packets
+ * \param midi2 non-zero to generate MIDI 2.0 channel voice messages
+ * \return 0 on success otherwise a negative error code
+ */
+int snd_ump_msg_encoder_new(snd_ump_msg_encoder_t **encp, unsigned int group,
+			    int midi2)
+{
+	snd_ump_msg_encoder_t *enc;
+
+	*encp = NULL;
+	if (group >= 16)
+		return -EINVAL;
+	enc = calloc(1, sizeof(*enc));
+	if (!enc)
+		return -ENOMEM;
+	enc->group = group;
+	enc->midi2 = !!midi2;
+	*encp = enc;
+	return 0;
+}
+
+/**
+ * \brief free the UMP encoder
+ * \param enc UMP encoder
+ */
+void snd_ump_msg_encoder_free(snd_ump_msg_encoder_t *enc)
+{
+	free(enc);
+}
+
+/**
+ * \brief reset the UMP encoder
+ * \param enc UMP encoder
+ *
+ * Drops any partially received message and the running status.
+ */
+void snd_ump_msg_encoder_reset(snd_ump_msg_encoder_t *enc)
+{
+	unsigned int group = enc->group;
+	int midi2 = enc->midi2;
+
+	memset(enc, 0, sizeof(*enc));
+	enc->group = group;
+	enc->midi2 = midi2;
+}
+
+/* build a MIDI 1.0 or 2.0 channel voice packet from the received bytes */
+static int encode_channel(snd_ump_msg_encoder_t *enc, uint32_t *ump)
+{
+	unsigned char status = enc->status >> 4;
+	unsigned char d0 = enc->data[0], d1 = enc->data[1];
+	uint32_t hdr;
+
+	if (!enc->midi2) {
+		ump[0] = ((uint32_t)SND_UMP_MSG_TYPE_MIDI1_CHANNEL_VOICE << 28) |
+			(enc->group << 24) | (enc->status << 16) | (d0 << 8) | d1;
+		return 1;
+	}
+
+	/* a note-on with zero velocity is a note-off */
+	if (status == SND_UMP_MSG_NOTE_ON && !d1)
+		status = SND_UMP_MSG_NOTE_OFF;
+	hdr = ((uint32_t)SND_UMP_MSG_TYPE_MIDI2_CHANNEL_VOICE << 28) |
+		(enc->group << 24) | (status << 20) | ((enc->status & 0x0f) << 16);
+	switch (status) {
+	case SND_UMP_MSG_NOTE_OFF:
+	case SND_UMP_MSG_NOTE_ON:
+		ump[0] = hdr | (d0 << 8);
+		ump[1] = ump_upscale(d1, 7, 16) << 16;
+		break;
+	case SND_UMP_MSG_POLY_PRESSURE:
+	case SND_UMP_MSG_CONTROL_CHANGE:
+		ump[0] = hdr | (d0 << 8);
+		ump[1] = ump_upscale(d1, 7, 32);
+		break;
+	case SND_UMP_MSG_PROGRAM_CHANGE:
+		ump[0] = hdr;
+		ump[1] = (uint32_t)d0 << 24;
+		break;
+	case SND_UMP_MSG_CHANNEL_PRESSURE:
+		ump[0] = hdr;
+		ump[1] = ump_upscale(d0, 7, 32);
+		break;
+	case SND_UMP_MSG_PITCHBEND:
+		ump[0] = hdr;
+		ump[1] = ump_upscale(d0 | (d1 << 7), 14, 32);
+		break;
+	}
+	return 2;
+}
+
+/* build a 7bit sysex packet from the pending sysex bytes */
+static void encode_sysex(snd_ump_msg_encoder_t *enc, uint32_t *ump, int last)
+{
+	unsigned char status;
+	const unsigned char *b = enc->sysex;
+	int i;
+
+	if (last)
+		status = enc->sysex_started ? SND_UMP_SYSEX_STATUS_END :
+			SND_UMP_SYSEX_STATUS_SINGLE;
+	else
+		status = enc->sysex_started ? SND_UMP_SYSEX_STATUS_CONTINUE :
+			SND_UMP_SYSEX_STATUS_START;
+	for (i = enc->sysex_len; i < 6; i++)
+		enc->sysex[i] = 0;
+	ump[0] = ((uint32_t)SND_UMP_MSG_TYPE_DATA << 28) | (enc->group << 24) |
+		(status << 20) | (enc->sysex_len << 16) | (b[0] << 8) | b[1];
+	ump[1] = ((uint32_t)b[2] << 24) | (b[3] << 16) | (b[4] << 8) | b[5];
+	enc->sysex_started = !last;
+	enc->sysex_len = 0;
+}
+
+/**
+ * \brief convert a MIDI 1.0 byte stream to UMP packets
+ * \param enc UMP encoder
+ * \param buf MIDI 1.0 bytes
+ * \param len the number of bytes in \a buf
+ * \param ump array to store the UMP words
+ * \param maxwords the size of \a ump in words
+ * \param consumed the number of bytes consumed, or NULL
+ * \return the number of words stored in \a ump
+ *
+ * Channel messages become MIDI 1.0 or MIDI 2.0 channel voice packets
+ * depending on the encoder setup; MIDI 1.0 values are scaled up with the
+ * Min-Center-Max scheme.  System messages become system packets and sysex
+ * is split into 7bit sysex packets.  Running status is handled, and the
+ * state is kept over the calls, so the stream may be passed in arbitrary
+ * chunks.
+ *
+ * The translation stops when the next packet does not fit into \a ump;
+ * the byte completing that packet is not consumed.
+ */
+ssize_t snd_ump_msg_encode_bytes(snd_ump_msg_encoder_t *enc,
+				 const uint8_t *buf, size_t len,
+				 uint32_t *ump, size_t maxwords,
+				 size_t *consumed)
+{
+	const uint8_t *p = buf, *end = buf + len;
+	size_t filled = 0;
+	unsigned char c;
+	int need_words = enc->midi2 ? 2 : 1;
+
+	for (; p < end; p++) {
+		c = *p;
+		if (c >= 0xf8) {
+			/* real-time messages don't affect the state */
+			if (midi1_system_len[c & 0x0f] < 0)
+				continue;
+			if (filled + 1 > maxwords)
+				break;
+			ump[filled++] = ((uint32_t)SND_UMP_MSG_TYPE_SYSTEM << 28) |
+				(enc->group << 24) | (c << 16);
+			continue;
+		}
+		if (c & 0x80) {
+			if (enc->in_sysex) {
+				/* end of sysex, possibly implicit */
+				if (filled + 2 > maxwords)
+					break;
+				encode_sysex(enc, ump + filled, 1);
+				filled += 2;
+				enc->in_sysex = 0;
+				if (c == SND_UMP_MSG_SYSEX_END)
+					continue;
+			}
+			enc->read = 0;
+			if (c < 0xf0) {
+				enc->status = c;
+				enc->need = midi1_channel_len[(c >> 4) & 0x07];
+				continue;
+			}
+			enc->status = 0;
+			if (c == SND_UMP_MSG_SYSEX_START) {
+				enc->in_sysex = 1;
+				enc->sysex_started = 0;
+				enc->sysex_len = 0;
+				continue;
+			}
+			if (midi1_system_len[c & 0x0f] < 0)
+				continue;
+			if (midi1_system_len[c & 0x0f] == 0) {
+				if (filled + 1 > maxwords)
+					break;
+				ump[filled++] = ((uint32_t)SND_UMP_MSG_TYPE_SYSTEM << 28) |
+					(enc->group << 24) | (c << 16);
+				continue;
+			}
+			enc->status = c;
+			enc->need = midi1_system_len[c & 0x0f];
+			continue;
+		}
+
+		/* data byte */
+		if (enc->in_sysex) {
+			if (enc->sysex_len == 6) {
+				if (filled + 2 > maxwords)
+					break;
+				encode_sysex(enc, ump + filled, 0);
+				filled += 2;
+			}
+			enc->sysex[enc->sysex_len++] = c;
+			continue;
+		}
+		if (!enc->status)
+			continue;
+		if (enc->read + 1 < enc->need) {
+			enc->data[enc->read++] = c;
+			continue;
+		}
+		/* the message is complete */
+		if (enc->status >= 0xf0) {
+			if (filled + 1 > maxwords)
+				break;
+			enc->data[enc->read] = c;
+			ump[filled++] = ((uint32_t)SND_UMP_MSG_TYPE_SYSTEM << 28) |
+				(enc->group << 24) | (enc->status << 16) |
+				(enc->data[0] << 8) |
+				(enc->need > 1 ? enc->data[1] : 0);
+			enc->status = 0;
+		} else {
+			if (filled + need_words > maxwords)
+				break;
+			enc->data[enc->read] = c;
+			if (enc->need < 2)
+				enc->data[1] = 0;
+			filled += encode_channel(enc, ump + filled);
+		}
+		enc->read = 0;
+	}
+
+	if (consumed)
+		*consumed = p - buf;
+	return filled;
+}
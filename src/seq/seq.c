@@ -4262,6 +4262,125 @@ int snd_seq_event_output_direct(snd_seq_t *seq, snd_seq_event_t *ev)
 	return seq->ops->write(seq, buf, (size_t) len);
 }
 
+/*
+ * write the I/O vectors, falling back to sequential writes
+ */
+static ssize_t seq_write_vec(snd_seq_t *seq, const struct iovec *vec, int count)
+{
+	ssize_t result, total = 0;
+	int i;
+
+	if (seq->ops->writev)
+		return seq->ops->writev(seq, vec, count);
+	for (i = 0; i < count; i++) {
+		result = seq->ops->write(seq, vec[i].iov_base, vec[i].iov_len);
+		if (result < 0)
+			return total > 0 ? total : result;
+		total += result;
+		if ((size_t)result < vec[i].iov_len)
+			break;
+	}
+	return total;
+}
+
+/**
+ * \brief output an array of events directly to the sequencer
+ * \param seq sequencer handle
+ * \param evs array of events to be output
+ * \param count the number of events in the array
+ * \return the number of events sent to sequencer or a negative error code
+ *
+ * This function sends the events to the sequencer directly not through the
+ * output buffer, like snd_seq_event_output_direct(), but with a single
+ * writev() call per up to 64 I/O vectors.  Runs of fixed length events are
+ * passed from the given array as is, without copying.  Since the sequencer
+ * expects the variable length data to follow the event record, each
+ * variable length event is gathered into the temporary buffer beforehand.
+ *
+ * The pending events on the output buffer are drained at first to keep
+ * the order of events.  \c -EAGAIN is returned if they cannot be drained
+ * completely.
+ *
+ * When the sequencer pool becomes full, the number of events sent so far
+ * is returned, which may be less than \p count.
+ *
+ * \note
+ * UMP events cannot be passed to this function.
+ *
+ * \sa snd_seq_event_output_direct(), snd_seq_event_input_batch()
+ */
+int snd_seq_event_output_batch(snd_seq_t *seq, snd_seq_event_t *evs,
+			       unsigned int count)
+{
+	struct iovec vec[SND_SEQ_IOV_MAX];
+	snd_seq_event_t *ev;
+	unsigned int idx, start, run, written = 0;
+	size_t stage = 0, staged;
+	ssize_t result, len;
+	int nvec, err;
+
+	assert(seq && (evs || !count));
+	err = snd_seq_drain_output(seq);
+	if (err < 0)
+		return err;
+	if (err > 0)
+		return -EAGAIN;
+
+	for (idx = 0; idx < count; idx++) {
+		ev = &evs[idx];
+		clear_ump_for_legacy_apps(seq, ev);
+		if (snd_seq_ev_is_ump(ev))
+			return -EINVAL;
+		if (snd_seq_ev_is_variable(ev))
+			stage += snd_seq_event_length(ev);
+	}
+	if (stage > 0 && alloc_tmpbuf(seq, stage) < 0)
+		return -ENOMEM;
+
+	start = 0;
+	while (start < count) {
+		nvec = 0;
+		staged = 0;
+		idx = start;
+		while (idx < count && nvec < SND_SEQ_IOV_MAX) {
+			ev = &evs[idx];
+			if (snd_seq_ev_is_variable(ev)) {
+				char *buf = (char *)seq->tmpbuf + staged;
+				memcpy(buf, ev, sizeof(*ev));
+				memcpy(buf + sizeof(*ev), ev->data.ext.ptr,
+				       ev->data.ext.len);
+				vec[nvec].iov_base = buf;
+				vec[nvec].iov_len = sizeof(*ev) + ev->data.ext.len;
+				staged += vec[nvec].iov_len;
+				idx++;
+			} else {
+				run = idx;
+				while (idx < count && !snd_seq_ev_is_variable(&evs[idx]))
+					idx++;
+				vec[nvec].iov_base = &evs[run];
+				vec[nvec].iov_len = (idx - run) * sizeof(*ev);
+			}
+			nvec++;
+		}
+		result = seq_write_vec(seq, vec, nvec);
+		if (result < 0) {
+			if (result == -EAGAIN && written)
+				return written;
+			return result;
+		}
+		/* the sequencer accepts only complete events */
+		for (run = start; run < idx; run++) {
+			len = snd_seq_event_length(&evs[run]);
+			if (result < len)
+				return written;
+			result -= len;
+			written++;
+		}
+		start = idx;
+	}
+	return written;
+}
+
 /**
  * \brief return the size of pending events on output buffer
  * \param seq sequencer handle
@@ -4431,6 +4550,46 @@ int snd_seq_event_input(snd_seq_t *seq, snd_seq_event_t **ev)
 	return snd_seq_event_retrieve_buffer(seq, ev);
 }
 
+/**
+ * \brief retrieve a span of events from sequencer
+ * \param seq sequencer handle
+ * \param evs array to store the event pointers
+ * \param count the size of the array
+ * \return the number of events stored or a negative error code
+ *
+ * Obtains up to \p count input events at once.  Like snd_seq_event_input(),
+ * the input buffer is filled from the sequencer when it is empty, and
+ * the pointers stored in \p evs point to the decoded events on the input
+ * buffer.  They remain valid until the next input call.
+ *
+ * Only the events already received on the input buffer are returned, so
+ * the function reads from the sequencer at most once.
+ *
+ * When the client is set to UMP mode, the stored pointers refer to
+ * snd_seq_ump_event_t records.
+ *
+ * \sa snd_seq_event_input(), snd_seq_event_output_batch()
+ */
+int snd_seq_event_input_batch(snd_seq_t *seq, snd_seq_event_t **evs,
+			      unsigned int count)
+{
+	unsigned int n = 0;
+	int err;
+
+	assert(seq && evs);
+	if (seq->ibuflen <= 0) {
+		if ((err = snd_seq_event_read_buffer(seq)) < 0)
+			return err;
+	}
+	while (n < count && seq->ibuflen > 0) {
+		err = snd_seq_event_retrieve_buffer(seq, &evs[n]);
+		if (err < 0)
+			return n > 0 ? (int)n : err;
+		n++;
+	}
+	return n;
+}
+
 /*
  * read input data from sequencer if available
  */
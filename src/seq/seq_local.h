@@ -27,10 +27,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <sys/uio.h>
 
 #define SND_SEQ_OBUF_SIZE	(16*1024)	/* default size */
 #define SND_SEQ_IBUF_SIZE	500		/* in event_size aligned */
 #define DEFAULT_TMPBUF_SIZE	20
+#define SND_SEQ_IOV_MAX		64		/* I/O vectors per batch write */
 
 typedef struct snd_seq_queue_client snd_seq_queue_client_t;
 
@@ -64,6 +66,7 @@ typedef struct {
 	int (*set_queue_info)(snd_seq_t *seq, snd_seq_queue_info_t *info);
 	int (*get_named_queue)(snd_seq_t *seq, snd_seq_queue_info_t *info);
 	ssize_t (*write)(snd_seq_t *seq, void *buf, size_t len);
+	ssize_t (*writev)(snd_seq_t *seq, const struct iovec *vec, int count);
 	ssize_t (*read)(snd_seq_t *seq, void *buf, size_t len);
 	int (*remove_events)(snd_seq_t *seq, snd_seq_remove_events_t *rmp);
 	int (*get_client_pool)(snd_seq_t *seq, snd_seq_client_pool_t *info);
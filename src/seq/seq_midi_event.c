@@ -127,6 +127,32 @@ static const struct extra_event_list_t {
 	{SND_SEQ_EVENT_REGPARAM, extra_decode_xrpn},
 };
 
+/* sequencer event type -> index into status_event[] or extra_event[], plus one */
+#define EXTRA_EVENT	0x80
+static const unsigned char event_index[256] = {
+	[SND_SEQ_EVENT_NOTEOFF] = 0 + 1,
+	[SND_SEQ_EVENT_NOTEON] = 1 + 1,
+	[SND_SEQ_EVENT_KEYPRESS] = 2 + 1,
+	[SND_SEQ_EVENT_CONTROLLER] = 3 + 1,
+	[SND_SEQ_EVENT_PGMCHANGE] = 4 + 1,
+	[SND_SEQ_EVENT_CHANPRESS] = 5 + 1,
+	[SND_SEQ_EVENT_PITCHBEND] = 6 + 1,
+	[SND_SEQ_EVENT_SYSEX] = ST_SPECIAL + 0x0 + 1,
+	[SND_SEQ_EVENT_QFRAME] = ST_SPECIAL + 0x1 + 1,
+	[SND_SEQ_EVENT_SONGPOS] = ST_SPECIAL + 0x2 + 1,
+	[SND_SEQ_EVENT_SONGSEL] = ST_SPECIAL + 0x3 + 1,
+	[SND_SEQ_EVENT_TUNE_REQUEST] = ST_SPECIAL + 0x6 + 1,
+	[SND_SEQ_EVENT_CLOCK] = ST_SPECIAL + 0x8 + 1,
+	[SND_SEQ_EVENT_START] = ST_SPECIAL + 0xa + 1,
+	[SND_SEQ_EVENT_CONTINUE] = ST_SPECIAL + 0xb + 1,
+	[SND_SEQ_EVENT_STOP] = ST_SPECIAL + 0xc + 1,
+	[SND_SEQ_EVENT_SENSING] = ST_SPECIAL + 0xe + 1,
+	[SND_SEQ_EVENT_RESET] = ST_SPECIAL + 0xf + 1,
+	[SND_SEQ_EVENT_CONTROL14] = EXTRA_EVENT | (0 + 1),
+	[SND_SEQ_EVENT_NONREGPARAM] = EXTRA_EVENT | (1 + 1),
+	[SND_SEQ_EVENT_REGPARAM] = EXTRA_EVENT | (2 + 1),
+};
+
 #define numberof(ary)	(sizeof(ary)/sizeof(ary[0]))
 #endif /* DOC_HIDDEN */
 
@@ -462,6 +488,135 @@ int snd_midi_event_encode_byte(snd_midi_event_t *dev, int c, snd_seq_event_t *ev
 	return rc;
 }
 
+/*
+ * check whether the count bytes are all MIDI data bytes
+ */
+static inline int is_data_bytes(const unsigned char *buf, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (buf[i] & 0x80)
+			return 0;
+	}
+	return 1;
+}
+
+/*
+ * encode a channel message from the data bytes in the stream
+ */
+static inline void encode_channel(int type, int status, const unsigned char *data,
+				  snd_seq_event_t *ev)
+{
+	ev->type = status_event[type].event;
+	ev->flags &= ~SND_SEQ_EVENT_LENGTH_MASK;
+	ev->flags |= SND_SEQ_EVENT_LENGTH_FIXED;
+	/* data.note.channel and data.control.channel is identical */
+	ev->data.control.channel = status & 0x0f;
+	switch (type) {
+	case 0: /* note off */
+	case 1: /* note on */
+	case 2: /* key pressure */
+		ev->data.note.note = data[0];
+		ev->data.note.velocity = data[1];
+		break;
+	case 3: /* control change */
+		ev->data.control.param = data[0];
+		ev->data.control.value = data[1];
+		break;
+	case 4: /* program change */
+	case 5: /* channel pressure */
+		ev->data.control.value = data[0];
+		break;
+	case 6: /* pitch bend */
+		ev->data.control.value = (int)data[1] * 128 + (int)data[0] - 8192;
+		break;
+	}
+}
+
+/**
+ * \brief Encodes a byte stream to an array of sequencer events.
+ * \param[in] dev MIDI event parser.
+ * \param[in] buf Buffer containing bytes of a raw MIDI stream.
+ * \param[in] count Number of bytes in \a buf.
+ * \param[out] evs Array of sequencer events.
+ * \param[in] nevs Number of events in \a evs.
+ * \param[out] consumed The number of bytes consumed, or NULL.
+ * \return The number of events written to \a evs, or a negative error code.
+ *
+ * This function encodes as many complete MIDI messages from \a buf as fit
+ * into \a evs, and gives the same results as calling
+ * #snd_midi_event_encode repeatedly.
+ *
+ * Channel messages whose bytes are all present in \a buf, including the
+ * messages with running status, are converted directly from the stream
+ * using the status table; other bytes go through
+ * #snd_midi_event_encode_byte.
+ *
+ * Only the type, flags and data fields of the events are set.
+ *
+ * Since the data pointer of a system exclusive event points into the MIDI
+ * event parser's buffer, the encoding stops after such an event is
+ * returned.  The remaining bytes, as indicated by \a consumed, have to be
+ * passed to the next call.
+ *
+ * \sa snd_midi_event_encode, snd_midi_event_decode_bulk
+ */
+long snd_midi_event_encode_bulk(snd_midi_event_t *dev, const unsigned char *buf, long count,
+				snd_seq_event_t *evs, long nevs, long *consumed)
+{
+	const unsigned char *p = buf, *end = buf + count;
+	snd_seq_event_t *ev;
+	long n = 0;
+	int c, type, qlen, rc;
+
+	while (p < end && n < nevs) {
+		ev = &evs[n];
+		c = *p;
+		type = -1;
+		if (dev->bufsize >= 3) {
+			if (c >= 0x80 && c < 0xf0) {
+				/* new channel message */
+				qlen = status_event[(c >> 4) & 0x07].qlen;
+				if (end - p > qlen && is_data_bytes(p + 1, qlen)) {
+					type = (c >> 4) & 0x07;
+					dev->buf[0] = c;
+					p++;
+				}
+			} else if (c < 0x80 && dev->qlen == 0 && dev->type < ST_INVALID) {
+				/* running status */
+				qlen = status_event[dev->type].qlen;
+				if (end - p >= qlen && is_data_bytes(p, qlen))
+					type = dev->type;
+			}
+		}
+		if (type >= 0) {
+			encode_channel(type, dev->buf[0], p, ev);
+			p += qlen;
+			dev->type = type;
+			dev->read = qlen + 1;
+			dev->qlen = 0;
+			n++;
+			continue;
+		}
+		rc = snd_midi_event_encode_byte(dev, *p++, ev);
+		if (rc < 0) {
+			if (n > 0)
+				break;
+			return rc;
+		}
+		if (rc > 0) {
+			n++;
+			if (ev->type == SND_SEQ_EVENT_SYSEX)
+				break;
+		}
+	}
+
+	if (consumed)
+		*consumed = p - buf;
+	return n;
+}
+
 /* encode note event */
 static void note_event(snd_midi_event_t *dev, snd_seq_event_t *ev)
 {
@@ -562,20 +717,13 @@ long snd_midi_event_decode(snd_midi_event_t *dev, unsigned char *buf, long count
 	long qlen;
 	unsigned int type;
 
-	if (ev->type == SND_SEQ_EVENT_NONE)
+	type = event_index[ev->type];
+	if (type == 0)
 		return -ENOENT;
+	if (type & EXTRA_EVENT)
+		return extra_event[(type & ~EXTRA_EVENT) - 1].decode(dev, buf, count, ev);
+	type--;
 
-	for (type = 0; type < numberof(status_event); type++) {
-		if (ev->type == status_event[type].event)
-			goto __found;
-	}
-	for (type = 0; type < numberof(extra_event); type++) {
-		if (ev->type == extra_event[type].event)
-			return extra_event[type].decode(dev, buf, count, ev);
-	}
-	return -ENOENT;
-
-      __found:
 	if (type >= ST_SPECIAL)
 		cmd = 0xf0 + (type - ST_SPECIAL);
 	else
@@ -617,6 +765,101 @@ long snd_midi_event_decode(snd_midi_event_t *dev, unsigned char *buf, long count
 	}
 }
 
+/**
+ * \brief Decodes an array of sequencer events to MIDI byte stream.
+ * \param[in] dev MIDI event parser.
+ * \param[out] buf Buffer for the resulting MIDI byte stream.
+ * \param[in] count Number of bytes in \a buf.
+ * \param[in] evs Array of sequencer events to decode.
+ * \param[in] nevs Number of events in \a evs.
+ * \param[out] consumed The number of events consumed, or NULL.
+ * \return The number of bytes written to \a buf, or a negative error code.
+ *
+ * This function decodes the events in order as #snd_midi_event_decode
+ * does, with running status applied across the events unless disabled with
+ * #snd_midi_event_no_status.  The events that don't correspond to MIDI
+ * messages are skipped.
+ *
+ * The decoding stops at the first event that does not fit into the rest of
+ * \a buf; it is not consumed, and the running status is kept so that the
+ * event can be passed again to the next call.
+ *
+ * \par Errors:
+ * <dl>
+ * <dt>-EINVAL<dd>The first event is not a valid sequencer event.
+ * <dt>-ENOMEM<dd>The MIDI message(s) of the first event would not fit into
+ *                \a count bytes.
+ *
+ * \sa snd_midi_event_decode, snd_midi_event_encode_bulk
+ */
+long snd_midi_event_decode_bulk(snd_midi_event_t *dev, unsigned char *buf, long count,
+				const snd_seq_event_t *evs, long nevs, long *consumed)
+{
+	const snd_seq_event_t *ev;
+	unsigned char *p;
+	long idx, len, written = 0;
+	unsigned int type;
+	int cmd, value;
+	unsigned char lastcmd;
+
+	for (idx = 0; idx < nevs; idx++) {
+		ev = &evs[idx];
+		type = event_index[ev->type] - 1;
+		if (type < ST_INVALID) {
+			/* channel message */
+			cmd = 0x80 | (type << 4) | (ev->data.note.channel & 0x0f);
+			len = status_event[type].qlen;
+			if (cmd != dev->lastcmd || dev->nostat)
+				len++;
+			if (count - written < len) {
+				if (written > 0)
+					break;
+				return -ENOMEM;
+			}
+			p = buf + written;
+			if (cmd != dev->lastcmd || dev->nostat)
+				*p++ = dev->lastcmd = cmd;
+			switch (type) {
+			case 0: /* note off */
+			case 1: /* note on */
+			case 2: /* key pressure */
+				p[0] = ev->data.note.note & 0x7f;
+				p[1] = ev->data.note.velocity & 0x7f;
+				break;
+			case 3: /* control change */
+				p[0] = ev->data.control.param & 0x7f;
+				p[1] = ev->data.control.value & 0x7f;
+				break;
+			case 4: /* program change */
+			case 5: /* channel pressure */
+				p[0] = ev->data.control.value & 0x7f;
+				break;
+			case 6: /* pitch bend */
+				value = ev->data.control.value + 8192;
+				p[0] = value & 0x7f;
+				p[1] = (value >> 7) & 0x7f;
+				break;
+			}
+			written += len;
+			continue;
+		}
+		lastcmd = dev->lastcmd;
+		len = snd_midi_event_decode(dev, buf + written, count - written, ev);
+		if (len == -ENOENT)
+			continue;
+		if (len < 0) {
+			dev->lastcmd = lastcmd;
+			if (written > 0)
+				break;
+			return len;
+		}
+		written += len;
+	}
+
+	if (consumed)
+		*consumed = idx;
+	return written;
+}
 
 /* decode note event */
 static void note_decode(const snd_seq_event_t *ev, unsigned char *buf)
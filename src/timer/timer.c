@@ -949,6 +949,57 @@ ssize_t snd_timer_read(snd_timer_t *timer, void *buffer, size_t size)
 	return (timer->ops->read)(timer, buffer, size);
 }
 
+/**
+ * \brief read all pending timer events at once
+ * \param timer timer handle
+ * \param events array to store the events
+ * \param count size of \a events in records
+ * \param batch summary of the read events, or NULL
+ * \return the count of read events otherwise a negative error code
+ *
+ * The timer must be opened with #SND_TIMER_OPEN_TREAD. Up to \a count
+ * pending events are fetched with a single read. If \a batch is given,
+ * it is filled with the count of read events, the sum of the ticks
+ * reported by #SND_TIMER_EVENT_TICK events, the time stamp of the most
+ * recent event and the delay between that time stamp and the current
+ * monotonic time. The delay is meaningful only when the kernel stamps
+ * the timer events with the monotonic clock (the default).
+ */
+ssize_t snd_timer_read_batch(snd_timer_t *timer, snd_timer_tread_t *events,
+			     size_t count, snd_timer_batch_t *batch)
+{
+	struct timespec now;
+	ssize_t result;
+	size_t i;
+
+	assert(timer);
+	assert(events || count == 0);
+	if (!timer->tread)
+		return -EINVAL;
+	if (batch)
+		memset(batch, 0, sizeof(*batch));
+	result = (timer->ops->read)(timer, events, count * sizeof(*events));
+	if (result <= 0)
+		return result;
+	result /= sizeof(*events);
+	if (!batch || !result)
+		return result;
+	batch->events = result;
+	for (i = 0; i < (size_t)result; i++) {
+		if (events[i].event == SND_TIMER_EVENT_TICK)
+			batch->ticks += events[i].val;
+	}
+	batch->tstamp = events[result - 1].tstamp;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	batch->latency.tv_sec = now.tv_sec - batch->tstamp.tv_sec;
+	batch->latency.tv_nsec = now.tv_nsec - batch->tstamp.tv_nsec;
+	if (batch->latency.tv_nsec < 0) {
+		batch->latency.tv_sec--;
+		batch->latency.tv_nsec += 1000000000L;
+	}
+	return result;
+}
+
 /**
  * \brief (DEPRECATED) get maximum timer ticks
  * \param info pointer to #snd_timer_info_t structure
@@ -43,6 +43,7 @@ struct _snd_timer {
 	char *name;
 	snd_timer_type_t type;
 	int mode;
+	int tread;
 	int poll_fd;
 	const snd_timer_ops_t *ops;
 	void *private_data;
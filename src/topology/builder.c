@@ -19,9 +19,61 @@
 
 #include "tplg_local.h"
 
+/* staging buffer size of the streamed output */
+#define TPLG_STREAM_BUF_SIZE	(64 * 1024)
+
+/* pass all data to the output callback */
+static ssize_t stream_out(snd_tplg_t *tplg, const void *data, size_t data_size)
+{
+	const char *ptr = data;
+	size_t left = data_size;
+	ssize_t r;
+
+	while (left > 0) {
+		r = tplg->out_write(tplg->out_private, ptr, left);
+		if (r < 0)
+			return r;
+		if (r == 0)
+			return -EIO;
+		ptr += r;
+		left -= r;
+	}
+	return data_size;
+}
+
+static ssize_t stream_flush(snd_tplg_t *tplg)
+{
+	ssize_t ret;
+
+	if (tplg->out_len == 0)
+		return 0;
+	ret = stream_out(tplg, tplg->bin, tplg->out_len);
+	tplg->out_len = 0;
+	return ret;
+}
+
 /* write a block, track the position */
 static ssize_t twrite(snd_tplg_t *tplg, void *data, size_t data_size)
 {
+	ssize_t ret;
+
+	if (tplg->out_write) {
+		if (tplg->out_len + data_size > tplg->bin_size) {
+			ret = stream_flush(tplg);
+			if (ret < 0)
+				return ret;
+		}
+		if (data_size >= tplg->bin_size) {
+			ret = stream_out(tplg, data, data_size);
+			if (ret < 0)
+				return ret;
+		} else {
+			memcpy(tplg->bin + tplg->out_len, data, data_size);
+			tplg->out_len += data_size;
+		}
+		tplg->bin_pos += data_size;
+		return data_size;
+	}
 	if (tplg->bin_pos + data_size > tplg->bin_size)
 		return -EIO;
 	memcpy(tplg->bin + tplg->bin_pos, data, data_size);
@@ -120,7 +172,7 @@ static int write_elem_block(snd_tplg_t *tplg,
 
 				wsize = twrite(tplg, elem->obj, elem->size);
 				if (wsize < 0)
-					return size;
+					return wsize;
 
 				total_size += wsize;
 				/* get to the end of sub list */
@@ -226,34 +278,16 @@ static ssize_t write_manifest_data(snd_tplg_t *tplg)
 	return ret;
 }
 
-int tplg_write_data(snd_tplg_t *tplg)
+/* write the manifest and all element blocks */
+static int write_blocks(snd_tplg_t *tplg)
 {
 	struct tplg_table *tptr;
 	struct list_head *list;
 	ssize_t ret;
-	size_t total_size, size;
+	size_t size;
 	unsigned int index;
 
-	/* calculate total size */
-	total_size = calc_manifest_size(tplg);
-	for (index = 0; index < tplg_table_items; index++) {
-		tptr = &tplg_table[index];
-		if (!tptr->build)
-			continue;
-		list = (struct list_head *)((void *)tplg + tptr->loff);
-		size = calc_real_size(list);
-		total_size += size;
-	}
-
-	/* allocate new binary output */
-	free(tplg->bin);
-	tplg->bin = malloc(total_size);
-	tplg->bin_pos = 0;
-	tplg->bin_size = total_size;
-	if (tplg->bin == NULL) {
-		tplg->bin_size = 0;
-		return -ENOMEM;
-	}
+	tplg->next_hdr_pos = 0;
 
 	/* write manifest */
 	ret = write_manifest_data(tplg);
@@ -287,6 +321,41 @@ int tplg_write_data(snd_tplg_t *tplg)
 
 	tplg_log(tplg, 'B', tplg->bin_pos, "total size is 0x%zx/%zd",
 		 tplg->bin_pos, tplg->bin_pos);
+	return 0;
+}
+
+int tplg_write_data(snd_tplg_t *tplg)
+{
+	struct tplg_table *tptr;
+	struct list_head *list;
+	size_t total_size, size;
+	unsigned int index;
+	int err;
+
+	/* calculate total size */
+	total_size = calc_manifest_size(tplg);
+	for (index = 0; index < tplg_table_items; index++) {
+		tptr = &tplg_table[index];
+		if (!tptr->build)
+			continue;
+		list = (struct list_head *)((void *)tplg + tptr->loff);
+		size = calc_real_size(list);
+		total_size += size;
+	}
+
+	/* allocate new binary output */
+	free(tplg->bin);
+	tplg->bin = malloc(total_size);
+	tplg->bin_pos = 0;
+	tplg->bin_size = total_size;
+	if (tplg->bin == NULL) {
+		tplg->bin_size = 0;
+		return -ENOMEM;
+	}
+
+	err = write_blocks(tplg);
+	if (err < 0)
+		return err;
 
 	if (total_size != tplg->bin_pos) {
 		SNDERR("total size mismatch (%zd != %zd)",
@@ -296,3 +365,41 @@ int tplg_write_data(snd_tplg_t *tplg)
 
 	return 0;
 }
+
+/*
+ * Write the blocks through a small staging buffer as they are built.
+ * The headers carry the block sizes only, so the total size is not
+ * needed beforehand and the whole binary is never kept in memory.
+ */
+int tplg_write_stream(snd_tplg_t *tplg, snd_tplg_write_t write, void *private_data)
+{
+	ssize_t ret;
+	int err;
+
+	free(tplg->bin);
+	tplg->bin = malloc(TPLG_STREAM_BUF_SIZE);
+	tplg->bin_pos = 0;
+	tplg->bin_size = TPLG_STREAM_BUF_SIZE;
+	if (tplg->bin == NULL) {
+		tplg->bin_size = 0;
+		return -ENOMEM;
+	}
+	tplg->out_write = write;
+	tplg->out_private = private_data;
+	tplg->out_len = 0;
+
+	err = write_blocks(tplg);
+	if (err >= 0) {
+		ret = stream_flush(tplg);
+		if (ret < 0)
+			err = ret;
+	}
+
+	tplg->out_write = NULL;
+	tplg->out_private = NULL;
+	tplg->out_len = 0;
+	free(tplg->bin);
+	tplg->bin = NULL;
+	tplg->bin_size = 0;
+	return err;
+}
@@ -175,7 +175,7 @@ static int tplg_build_mixer_control(snd_tplg_t *tplg,
 			continue;
 
 		if (ref->type == SND_TPLG_TYPE_TLV) {
-			ref->elem = tplg_elem_lookup(&tplg->tlv_list,
+			ref->elem = tplg_elem_lookup(tplg, &tplg->tlv_list,
 				ref->id, SND_TPLG_TYPE_TLV, elem->index);
 			if (ref->elem)
 				 err = copy_tlv(elem, ref->elem);
@@ -225,7 +225,7 @@ static int tplg_build_enum_control(snd_tplg_t *tplg,
 			continue;
 
 		if (ref->type == SND_TPLG_TYPE_TEXT) {
-			ref->elem = tplg_elem_lookup(&tplg->text_list,
+			ref->elem = tplg_elem_lookup(tplg, &tplg->text_list,
 				ref->id, SND_TPLG_TYPE_TEXT, elem->index);
 			if (ref->elem)
 				copy_enum_texts(elem, ref->elem);
@@ -999,7 +999,7 @@ int tplg_add_mixer(snd_tplg_t *tplg, struct snd_tplg_mixer_template *mixer,
 	mc->size = elem->size;
 	ret = init_ctl_hdr(tplg, elem, &mc->hdr, &mixer->hdr);
 	if (ret < 0) {
-		tplg_elem_free(elem);
+		tplg_elem_free(tplg, elem);
 		return ret;
 	}
 
@@ -1062,7 +1062,7 @@ int tplg_add_enum(snd_tplg_t *tplg, struct snd_tplg_enum_template *enum_ctl,
 	ec->size = elem->size;
 	ret = init_ctl_hdr(tplg, elem, &ec->hdr, &enum_ctl->hdr);
 	if (ret < 0) {
-		tplg_elem_free(elem);
+		tplg_elem_free(tplg, elem);
 		return ret;
 	}
 
@@ -1153,7 +1153,7 @@ int tplg_add_bytes(snd_tplg_t *tplg, struct snd_tplg_bytes_template *bytes_ctl,
 	be->size = elem->size;
 	ret = init_ctl_hdr(tplg, elem, &be->hdr, &bytes_ctl->hdr);
 	if (ret < 0) {
-		tplg_elem_free(elem);
+		tplg_elem_free(tplg, elem);
 		return ret;
 	}
 
@@ -1179,12 +1179,12 @@ int tplg_add_bytes(snd_tplg_t *tplg, struct snd_tplg_bytes_template *bytes_ctl,
 			!= SNDRV_CTL_ELEM_ACCESS_TLV_READWRITE) {
 			SNDERR("Invalid TLV bytes control access 0x%x",
 				be->hdr.access);
-			tplg_elem_free(elem);
+			tplg_elem_free(tplg, elem);
 			return -EINVAL;
 		}
 
 		if (!be->max) {
-			tplg_elem_free(elem);
+			tplg_elem_free(tplg, elem);
 			return -EINVAL;
 		}
 	}
@@ -540,7 +540,7 @@ static struct tplg_elem *get_tokens(snd_tplg_t *tplg, struct tplg_elem *elem)
 			continue;
 
 		if (!ref->elem) {
-			ref->elem = tplg_elem_lookup(&tplg->token_list,
+			ref->elem = tplg_elem_lookup(tplg, &tplg->token_list,
 				ref->id, SND_TPLG_TYPE_TOKEN, elem->index);
 		}
 
@@ -689,7 +689,7 @@ static int build_tuples(snd_tplg_t *tplg, struct tplg_elem *elem)
 		tplg_dbg("tuples '%s' used by data '%s'", ref->id, elem->id);
 
 		if (!ref->elem)
-			ref->elem = tplg_elem_lookup(&tplg->tuple_list,
+			ref->elem = tplg_elem_lookup(tplg, &tplg->tuple_list,
 				ref->id, SND_TPLG_TYPE_TUPLE, elem->index);
 		tuples = ref->elem;
 		if (!tuples) {
@@ -1505,7 +1505,7 @@ int tplg_copy_data(snd_tplg_t *tplg, struct tplg_elem *elem,
 	int priv_data_size, old_priv_data_size;
 	void *obj;
 
-	ref_elem = tplg_elem_lookup(&tplg->pdata_list,
+	ref_elem = tplg_elem_lookup(tplg, &tplg->pdata_list,
 				     ref->id, SND_TPLG_TYPE_DATA, elem->index);
 	if (!ref_elem) {
 		SNDERR("cannot find data '%s' referenced by"
@@ -1625,7 +1625,7 @@ int tplg_add_token(snd_tplg_t *tplg, struct tplg_elem *parent,
 	unsigned int i;
 	size_t size;
 
-	elem = tplg_elem_lookup(&tplg->token_list, parent->id,
+	elem = tplg_elem_lookup(tplg, &tplg->token_list, parent->id,
 				SND_TPLG_TYPE_TOKEN, parent->index);
 	if (elem == NULL) {
 		elem = tplg_elem_new_common(tplg, NULL, parent->id,
@@ -298,9 +298,82 @@ struct tplg_elem *tplg_elem_new(void)
 	return elem;
 }
 
-void tplg_elem_free(struct tplg_elem *elem)
+/* element name index: chains keyed by (list, id), in list order */
+static unsigned int elem_hash(struct list_head *base, const char *id)
+{
+	unsigned int h = 2166136261U ^ (unsigned int)((uintptr_t)base >> 4);
+
+	while (*id)
+		h = (h ^ (unsigned char)*id++) * 16777619U;
+	return h;
+}
+
+static void elem_hash_unlink(snd_tplg_t *tplg, struct tplg_elem *elem)
+{
+	if (!elem->hash_pprev)
+		return;
+	*elem->hash_pprev = elem->hash_next;
+	if (elem->hash_next)
+		elem->hash_next->hash_pprev = elem->hash_pprev;
+	elem->hash_next = NULL;
+	elem->hash_pprev = NULL;
+	tplg->elem_hash_count--;
+}
+
+/* append to the chain, the elements with the same key keep the list order */
+static void elem_hash_link(snd_tplg_t *tplg, struct tplg_elem *elem)
+{
+	struct tplg_elem **pp, *e;
+
+	pp = &tplg->elem_hash[elem_hash(elem->hash_base, elem->id) & tplg->elem_hash_mask];
+	while ((e = *pp) != NULL) {
+		if (e->hash_base == elem->hash_base && e->index > elem->index &&
+		    strcmp(e->id, elem->id) == 0)
+			break;
+		pp = &e->hash_next;
+	}
+	elem->hash_next = *pp;
+	elem->hash_pprev = pp;
+	if (*pp)
+		(*pp)->hash_pprev = &elem->hash_next;
+	*pp = elem;
+}
+
+static int elem_hash_add(snd_tplg_t *tplg, struct tplg_elem *elem,
+			 struct list_head *base)
+{
+	struct tplg_elem **old, *e, *next;
+	unsigned int i, old_mask;
+
+	if (tplg->elem_hash_count >= tplg->elem_hash_mask) {
+		old = tplg->elem_hash;
+		old_mask = tplg->elem_hash_mask;
+		tplg->elem_hash_mask = old ? old_mask * 2 + 1 : 255;
+		tplg->elem_hash = calloc(tplg->elem_hash_mask + 1, sizeof(*old));
+		if (!tplg->elem_hash) {
+			tplg->elem_hash = old;
+			tplg->elem_hash_mask = old_mask;
+			return -ENOMEM;
+		}
+		/* relink in the chain order to keep the list order */
+		for (i = 0; old && i <= old_mask; i++) {
+			for (e = old[i]; e; e = next) {
+				next = e->hash_next;
+				elem_hash_link(tplg, e);
+			}
+		}
+		free(old);
+	}
+	elem->hash_base = base;
+	elem_hash_link(tplg, elem);
+	tplg->elem_hash_count++;
+	return 0;
+}
+
+void tplg_elem_free(snd_tplg_t *tplg, struct tplg_elem *elem)
 {
 	list_del(&elem->list);
+	elem_hash_unlink(tplg, elem);
 
 	tplg_ref_free_list(&elem->ref_list);
 
@@ -317,18 +390,19 @@ void tplg_elem_free(struct tplg_elem *elem)
 	free(elem);
 }
 
-void tplg_elem_free_list(struct list_head *base)
+void tplg_elem_free_list(snd_tplg_t *tplg, struct list_head *base)
 {
 	struct list_head *pos, *npos;
 	struct tplg_elem *elem;
 
 	list_for_each_safe(pos, npos, base) {
 		elem = list_entry(pos, struct tplg_elem, list);
-		tplg_elem_free(elem);
+		tplg_elem_free(tplg, elem);
 	}
 }
 
-struct tplg_elem *tplg_elem_lookup(struct list_head *base, const char* id,
+struct tplg_elem *tplg_elem_lookup(snd_tplg_t *tplg,
+				   struct list_head *base, const char* id,
 				   unsigned int type, int index)
 {
 	struct list_head *pos;
@@ -337,6 +411,26 @@ struct tplg_elem *tplg_elem_lookup(struct list_head *base, const char* id,
 	if (!base || !id)
 		return NULL;
 
+	/* the hash chains keep the list order, routes are not indexed */
+	if (tplg->elem_hash && base != &tplg->route_list) {
+		elem = tplg->elem_hash[elem_hash(base, id) & tplg->elem_hash_mask];
+		for (; elem; elem = elem->hash_next) {
+			if (elem->hash_base != base || strcmp(elem->id, id))
+				continue;
+			if ((index != SND_TPLG_INDEX_ALL) && (elem->index > index)) {
+				/* the list walk stops after the first such one */
+				pos = elem->list.prev;
+				if (pos != base &&
+				    list_entry(pos, struct tplg_elem, list)->index > index)
+					return NULL;
+				return elem->type == type ? elem : NULL;
+			}
+			if (elem->type == type)
+				return elem;
+		}
+		return NULL;
+	}
+
 	list_for_each(pos, base) {
 
 		elem = list_entry(pos, struct tplg_elem, list);
@@ -389,6 +483,13 @@ void tplg_elem_insert(struct tplg_elem *elem_p, struct list_head *list)
 	struct list_head *pos, *p = &(elem_p->list);
 	struct tplg_elem *elem;
 
+	/* the elements come mostly in the index order */
+	if (list_empty(list) ||
+	    list_entry(list->prev, struct tplg_elem, list)->index <= elem_p->index) {
+		list_add_tail(p, list);
+		return;
+	}
+
 	list_for_each(pos, list) {
 		elem = list_entry(pos, struct tplg_elem, list);
 		if (elem_p->index < elem->index)
@@ -460,6 +561,10 @@ struct tplg_elem* tplg_elem_new_common(snd_tplg_t *tplg,
 	}
 
 	list = (struct list_head *)((void *)tplg + tptr->loff);
+	if (elem_hash_add(tplg, elem, list) < 0) {
+		free(elem);
+		return NULL;
+	}
 	tplg_elem_insert(elem, list);
 	obj_size = tptr->size;
 	elem->free = tptr->free;
@@ -469,7 +574,7 @@ struct tplg_elem* tplg_elem_new_common(snd_tplg_t *tplg,
 	if (obj_size > 0) {
 		obj = calloc(1, obj_size);
 		if (obj == NULL) {
-			free(elem);
+			tplg_elem_free(tplg, elem);
 			return NULL;
 		}
 
@@ -348,30 +348,63 @@ int snd_tplg_add_object(snd_tplg_t *tplg, snd_tplg_obj_template_t *t)
 	};
 }
 
+static ssize_t tplg_write_fd(void *private_data, const void *data, size_t size)
+{
+	int fd = *(int *)private_data;
+	ssize_t r;
+
+	do {
+		r = write(fd, data, size);
+	} while (r < 0 && errno == EINTR);
+	if (r < 0) {
+		r = -errno;
+		SNDERR("write error: %s", strerror(errno));
+	}
+	return r;
+}
+
 int snd_tplg_build(snd_tplg_t *tplg, const char *outfile)
 {
 	int fd, err;
-	ssize_t r;
 
-	err = tplg_build(tplg);
-	if (err < 0)
+	err = tplg_build_integ(tplg);
+	if (err < 0) {
+		SNDERR("failed to check topology integrity");
 		return err;
+	}
 
 	fd = open(outfile, O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
 	if (fd < 0) {
 		SNDERR("failed to open %s err %d", outfile, -errno);
 		return -errno;
 	}
-	r = write(fd, tplg->bin, tplg->bin_size);
-	close(fd);
-	if (r < 0) {
+	err = tplg_write_stream(tplg, tplg_write_fd, &fd);
+	if (close(fd) < 0 && err >= 0) {
 		err = -errno;
 		SNDERR("write error: %s", strerror(errno));
+	}
+	if (err < 0) {
+		SNDERR("failed to write data %d", err);
+		unlink(outfile);
 		return err;
 	}
-	if ((size_t)r != tplg->bin_size) {
-		SNDERR("partial write (%zd != %zd)", r, tplg->bin_size);
-		return -EIO;
+	return 0;
+}
+
+int snd_tplg_build_stream(snd_tplg_t *tplg, snd_tplg_write_t write, void *private_data)
+{
+	int err;
+
+	err = tplg_build_integ(tplg);
+	if (err < 0) {
+		SNDERR("failed to check topology integrity");
+		return err;
+	}
+
+	err = tplg_write_stream(tplg, write, private_data);
+	if (err < 0) {
+		SNDERR("failed to write data %d", err);
+		return err;
 	}
 	return 0;
 }
@@ -481,24 +514,25 @@ void snd_tplg_free(snd_tplg_t *tplg)
 	free(tplg->bin);
 	free(tplg->manifest_pdata);
 
-	tplg_elem_free_list(&tplg->tlv_list);
-	tplg_elem_free_list(&tplg->widget_list);
-	tplg_elem_free_list(&tplg->pcm_list);
-	tplg_elem_free_list(&tplg->dai_list);
-	tplg_elem_free_list(&tplg->be_list);
-	tplg_elem_free_list(&tplg->cc_list);
-	tplg_elem_free_list(&tplg->route_list);
-	tplg_elem_free_list(&tplg->pdata_list);
-	tplg_elem_free_list(&tplg->manifest_list);
-	tplg_elem_free_list(&tplg->text_list);
-	tplg_elem_free_list(&tplg->pcm_config_list);
-	tplg_elem_free_list(&tplg->pcm_caps_list);
-	tplg_elem_free_list(&tplg->mixer_list);
-	tplg_elem_free_list(&tplg->enum_list);
-	tplg_elem_free_list(&tplg->bytes_ext_list);
-	tplg_elem_free_list(&tplg->token_list);
-	tplg_elem_free_list(&tplg->tuple_list);
-	tplg_elem_free_list(&tplg->hw_cfg_list);
+	tplg_elem_free_list(tplg, &tplg->tlv_list);
+	tplg_elem_free_list(tplg, &tplg->widget_list);
+	tplg_elem_free_list(tplg, &tplg->pcm_list);
+	tplg_elem_free_list(tplg, &tplg->dai_list);
+	tplg_elem_free_list(tplg, &tplg->be_list);
+	tplg_elem_free_list(tplg, &tplg->cc_list);
+	tplg_elem_free_list(tplg, &tplg->route_list);
+	tplg_elem_free_list(tplg, &tplg->pdata_list);
+	tplg_elem_free_list(tplg, &tplg->manifest_list);
+	tplg_elem_free_list(tplg, &tplg->text_list);
+	tplg_elem_free_list(tplg, &tplg->pcm_config_list);
+	tplg_elem_free_list(tplg, &tplg->pcm_caps_list);
+	tplg_elem_free_list(tplg, &tplg->mixer_list);
+	tplg_elem_free_list(tplg, &tplg->enum_list);
+	tplg_elem_free_list(tplg, &tplg->bytes_ext_list);
+	tplg_elem_free_list(tplg, &tplg->token_list);
+	tplg_elem_free_list(tplg, &tplg->tuple_list);
+	tplg_elem_free_list(tplg, &tplg->hw_cfg_list);
+	free(tplg->elem_hash);
 
 	free(tplg);
 }
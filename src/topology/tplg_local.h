@@ -66,6 +66,16 @@ struct snd_tplg {
 	size_t bin_pos;
 	size_t bin_size;
 
+	/* element name index, see tplg_elem_lookup() */
+	struct tplg_elem **elem_hash;
+	unsigned int elem_hash_mask;
+	unsigned int elem_hash_count;
+
+	/* streamed output (snd_tplg_build_stream), bin is the staging buffer */
+	snd_tplg_write_t out_write;
+	void *out_private;
+	size_t out_len;
+
 	int verbose;
 	unsigned int dapm_sort: 1;
 	unsigned int version;
@@ -194,6 +204,11 @@ struct tplg_elem {
 	struct list_head ref_list;
 	struct list_head list; /* list of all elements with same type */
 
+	/* name index of the elements created by tplg_elem_new_common() */
+	struct list_head *hash_base;	/* list of the element */
+	struct tplg_elem *hash_next;
+	struct tplg_elem **hash_pprev;
+
 	void (*free)(void *obj);
 };
 
@@ -271,6 +286,7 @@ int tplg_parse_compound(snd_tplg_t *tplg, snd_config_t *cfg,
 	void *private);
 
 int tplg_write_data(snd_tplg_t *tplg);
+int tplg_write_stream(snd_tplg_t *tplg, snd_tplg_write_t write, void *private_data);
 
 int tplg_parse_tlv(snd_tplg_t *tplg, snd_config_t *cfg, void *priv);
 int tplg_parse_text(snd_tplg_t *tplg, snd_config_t *cfg, void *priv);
@@ -310,10 +326,11 @@ int tplg_ref_add(struct tplg_elem *elem, int type, const char* id);
 int tplg_ref_add_elem(struct tplg_elem *elem, struct tplg_elem *elem_ref);
 
 struct tplg_elem *tplg_elem_new(void);
-void tplg_elem_free(struct tplg_elem *elem);
-void tplg_elem_free_list(struct list_head *base);
+void tplg_elem_free(snd_tplg_t *tplg, struct tplg_elem *elem);
+void tplg_elem_free_list(snd_tplg_t *tplg, struct list_head *base);
 void tplg_elem_insert(struct tplg_elem *elem_p, struct list_head *list);
-struct tplg_elem *tplg_elem_lookup(struct list_head *base,
+struct tplg_elem *tplg_elem_lookup(snd_tplg_t *tplg,
+				struct list_head *base,
 				const char* id,
 				unsigned int type,
 				int index);
@@ -516,6 +516,266 @@ static int execute_cset(snd_ctl_t *ctl, const char *cset, unsigned int type)
 	return err;
 }
 
+/*
+ * Compiled csets
+ *
+ * The element id of a plain cset is parsed with the sequence. The first
+ * execution resolves the element info and the value for the used control
+ * handle. When the value does not depend on the current element state,
+ * the next executions are a single element write.
+ */
+struct cset_compiled {
+	snd_ctl_elem_id_t id;		/* parsed element id */
+	const char *value;		/* value part of the cset string */
+	snd_ctl_t *ctl;			/* handle of the resolved element */
+	unsigned int generation;	/* uc_mgr->cset_generation when resolved */
+	bool resolved;
+	bool complete;			/* value does not depend on the element state */
+	snd_ctl_elem_info_t info;
+	snd_ctl_elem_value_t val;
+};
+
+int uc_mgr_compile_cset(struct sequence_element *seq)
+{
+	struct cset_compiled *cset;
+	const char *pos;
+
+	if (seq->type != SEQUENCE_ELEMENT_TYPE_CSET)
+		return 0;
+	cset = calloc(1, sizeof(*cset));
+	if (cset == NULL)
+		return -ENOMEM;
+	/* the syntax errors are reported when the cset is executed */
+	if (__snd_ctl_ascii_elem_id_parse(&cset->id, seq->data.cset, &pos) < 0)
+		goto __skip;
+	while (*pos && isspace(*pos))
+		pos++;
+	if (!*pos)
+		goto __skip;
+	cset->value = pos;
+	seq->compiled = cset;
+	return 0;
+
+      __skip:
+	free(cset);
+	return 0;
+}
+
+void uc_mgr_free_cset(struct cset_compiled *cset)
+{
+	free(cset);
+}
+
+/* check if the parsed value is same for a different element state */
+static bool cset_value_complete(snd_ctl_t *ctl, struct cset_compiled *cset)
+{
+	snd_ctl_elem_value_t value;
+	unsigned int idx, count = cset->info.count;
+
+	snd_ctl_elem_value_clear(&value);
+	switch (cset->info.type) {
+	case SND_CTL_ELEM_TYPE_BOOLEAN:
+	case SND_CTL_ELEM_TYPE_INTEGER:
+		for (idx = 0; idx < count && idx < ARRAY_SIZE(value.value.integer.value); idx++)
+			value.value.integer.value[idx] = 1;
+		break;
+	case SND_CTL_ELEM_TYPE_INTEGER64:
+		for (idx = 0; idx < count && idx < ARRAY_SIZE(value.value.integer64.value); idx++)
+			value.value.integer64.value[idx] = 1;
+		break;
+	case SND_CTL_ELEM_TYPE_ENUMERATED:
+		for (idx = 0; idx < count && idx < ARRAY_SIZE(value.value.enumerated.item); idx++)
+			value.value.enumerated.item[idx] = 1;
+		break;
+	case SND_CTL_ELEM_TYPE_BYTES:
+		for (idx = 0; idx < count && idx < ARRAY_SIZE(value.value.bytes.data); idx++)
+			value.value.bytes.data[idx] = 1;
+		break;
+	default:
+		return false;
+	}
+	if (snd_ctl_ascii_value_parse(ctl, &value, &cset->info, cset->value) < 0)
+		return false;
+	return memcmp(&value.value, &cset->val.value, sizeof(value.value)) == 0;
+}
+
+static int cset_resolve(snd_use_case_mgr_t *uc_mgr, snd_ctl_t *ctl,
+			struct cset_compiled *cset)
+{
+	int err;
+
+	cset->resolved = false;
+	snd_ctl_elem_info_clear(&cset->info);
+	snd_ctl_elem_info_set_id(&cset->info, &cset->id);
+	err = snd_ctl_elem_info(ctl, &cset->info);
+	if (err < 0)
+		return err;
+	snd_ctl_elem_value_clear(&cset->val);
+	err = snd_ctl_ascii_value_parse(ctl, &cset->val, &cset->info, cset->value);
+	if (err < 0)
+		return err;
+	cset->complete = cset_value_complete(ctl, cset);
+	cset->ctl = ctl;
+	cset->generation = uc_mgr->cset_generation;
+	cset->resolved = true;
+	return 0;
+}
+
+/*
+ * Transition plan
+ *
+ * When a verb, device or modifier is switched, the disable and enable
+ * sequences often write the same elements several times. The complete
+ * csets are collected while the transition runs and only the last value
+ * of each element is kept. The plan is flushed when the transition ends
+ * or before a sequence element which may depend on the written state
+ * (exec, shell, sleep, sysw, cfgsave or other cset types). The elements
+ * which already hold the final value are not written at all.
+ */
+struct cset_plan_entry {
+	struct list_head list;
+	struct sequence_element *seq;	/* for error reports */
+	snd_ctl_t *ctl;
+	bool volatile_elem;
+	snd_ctl_elem_value_t val;
+};
+
+static void cset_plan_begin(snd_use_case_mgr_t *uc_mgr)
+{
+	uc_mgr->cset_plan_depth++;
+}
+
+static int cset_plan_add(snd_use_case_mgr_t *uc_mgr, snd_ctl_t *ctl,
+			 struct sequence_element *s)
+{
+	struct cset_compiled *cset = s->compiled;
+	struct cset_plan_entry *entry;
+	struct list_head *pos;
+
+	list_for_each(pos, &uc_mgr->cset_plan) {
+		entry = list_entry(pos, struct cset_plan_entry, list);
+		if (entry->ctl == ctl &&
+		    entry->val.id.numid == cset->val.id.numid) {
+			/* the write order is kept, move it to the end */
+			list_del(&entry->list);
+			goto __set;
+		}
+	}
+	entry = malloc(sizeof(*entry));
+	if (entry == NULL)
+		return -ENOMEM;
+      __set:
+	entry->seq = s;
+	entry->ctl = ctl;
+	entry->volatile_elem = snd_ctl_elem_info_is_volatile(&cset->info);
+	entry->val = cset->val;
+	list_add_tail(&entry->list, &uc_mgr->cset_plan);
+	return 0;
+}
+
+static int cset_plan_flush(snd_use_case_mgr_t *uc_mgr)
+{
+	struct cset_plan_entry *entry;
+	struct list_head *pos, *npos;
+	snd_ctl_elem_value_t value;
+	int err = 0, err2;
+
+	list_for_each_safe(pos, npos, &uc_mgr->cset_plan) {
+		entry = list_entry(pos, struct cset_plan_entry, list);
+		list_del(&entry->list);
+		if (err >= 0) {
+			if (!entry->volatile_elem) {
+				snd_ctl_elem_value_clear(&value);
+				value.id = entry->val.id;
+				err2 = snd_ctl_elem_read(entry->ctl, &value);
+				if (err2 >= 0 &&
+				    memcmp(&value.value, &entry->val.value,
+					   sizeof(value.value)) == 0)
+					goto __skip;
+			}
+			err2 = snd_ctl_elem_write(entry->ctl, &entry->val);
+			if (err2 < 0) {
+				/* take the slow path to report errors */
+				((struct cset_compiled *)entry->seq->compiled)->resolved = false;
+				err = execute_cset(entry->ctl, entry->seq->data.cset,
+						   entry->seq->type);
+				if (err < 0)
+					uc_error("unable to execute cset '%s'",
+						 entry->seq->data.cset);
+			}
+		}
+      __skip:
+		free(entry);
+	}
+	return err;
+}
+
+/* the elements with side effects outside of the plan */
+static bool cset_plan_barrier(unsigned int type)
+{
+	switch (type) {
+	case SEQUENCE_ELEMENT_TYPE_SYSSET:
+	case SEQUENCE_ELEMENT_TYPE_SLEEP:
+	case SEQUENCE_ELEMENT_TYPE_EXEC:
+	case SEQUENCE_ELEMENT_TYPE_SHELL:
+	case SEQUENCE_ELEMENT_TYPE_CFGSAVE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static int cset_plan_end(snd_use_case_mgr_t *uc_mgr)
+{
+	if (--uc_mgr->cset_plan_depth > 0)
+		return 0;
+	return cset_plan_flush(uc_mgr);
+}
+
+static int execute_cset_compiled(snd_use_case_mgr_t *uc_mgr, snd_ctl_t *ctl,
+				 struct sequence_element *s)
+{
+	struct cset_compiled *cset = s->compiled;
+	snd_ctl_elem_value_t value;
+	int err;
+
+	if (cset != NULL &&
+	    (!cset->resolved || cset->ctl != ctl ||
+	     cset->generation != uc_mgr->cset_generation)) {
+		err = cset_resolve(uc_mgr, ctl, cset);
+		if (err < 0)
+			cset = NULL;
+	}
+	if (cset != NULL && cset->complete && uc_mgr->cset_plan_depth > 0)
+		return cset_plan_add(uc_mgr, ctl, s);
+	/* the pending writes must be visible for this element */
+	err = cset_plan_flush(uc_mgr);
+	if (err < 0)
+		return err;
+	if (cset == NULL)
+		return execute_cset(ctl, s->data.cset, s->type);
+	if (cset->complete) {
+		value = cset->val;
+	} else {
+		/* the value depends on the current state (toggle etc.) */
+		snd_ctl_elem_value_clear(&value);
+		value.id = cset->val.id;
+		err = snd_ctl_elem_read(ctl, &value);
+		if (err < 0)
+			goto __retry;
+		err = snd_ctl_ascii_value_parse(ctl, &value, &cset->info, cset->value);
+		if (err < 0)
+			goto __retry;
+	}
+	err = snd_ctl_elem_write(ctl, &value);
+	if (err >= 0)
+		return 0;
+      __retry:
+	/* the element might be gone, take the slow path to report errors */
+	cset->resolved = false;
+	return execute_cset(ctl, s->data.cset, s->type);
+}
+
 static int execute_sysw(const char *sysw)
 {
 	char path[PATH_MAX];
@@ -749,6 +1009,11 @@ static int execute_sequence(snd_use_case_mgr_t *uc_mgr,
 	uc_mgr->sequence_hops++;
 	list_for_each(pos, seq) {
 		s = list_entry(pos, struct sequence_element, list);
+		if (cset_plan_barrier(s->type)) {
+			err = cset_plan_flush(uc_mgr);
+			if (err < 0)
+				goto __fail;
+		}
 		switch (s->type) {
 		case SEQUENCE_ELEMENT_TYPE_CDEV:
 			cdev = strdup(s->data.cdev);
@@ -823,11 +1088,15 @@ static int execute_sequence(snd_use_case_mgr_t *uc_mgr,
 				}
 				ctl = ctl_list->ctl;
 			}
-			err = execute_cset(ctl, s->data.cset, s->type);
+			err = execute_cset_compiled(uc_mgr, ctl, s);
 			if (err < 0) {
 				uc_error("unable to execute cset '%s'", s->data.cset);
 				goto __fail;
 			}
+			/* the element numids might be changed */
+			if (s->type == SEQUENCE_ELEMENT_TYPE_CSET_NEW ||
+			    s->type == SEQUENCE_ELEMENT_TYPE_CTL_REMOVE)
+				uc_mgr->cset_generation++;
 			break;
 		case SEQUENCE_ELEMENT_TYPE_SYSSET:
 			err = execute_sysw(s->data.sysw);
@@ -1524,6 +1793,7 @@ int snd_use_case_mgr_open(snd_use_case_mgr_t **uc_mgr,
 	INIT_LIST_HEAD(&mgr->active_devices);
 	INIT_LIST_HEAD(&mgr->ctl_list);
 	INIT_LIST_HEAD(&mgr->variable_list);
+	INIT_LIST_HEAD(&mgr->cset_plan);
 	pthread_mutex_init(&mgr->mutex, NULL);
 
 	if (card_name && *card_name == '-') {
@@ -2516,7 +2786,7 @@ static int set_verb_user(snd_use_case_mgr_t *uc_mgr,
 			 const char *verb_name)
 {
 	struct use_case_verb *verb;
-	int err = 0;
+	int err = 0, err2;
 
 	if (uc_mgr->active_verb &&
 	    strcmp(uc_mgr->active_verb->name, verb_name) == 0)
@@ -2528,12 +2798,13 @@ static int set_verb_user(snd_use_case_mgr_t *uc_mgr,
 	} else {
 		verb = NULL;
 	}
+	cset_plan_begin(uc_mgr);
 	if (uc_mgr->active_verb) {
 		err = handle_transition_verb(uc_mgr, verb);
 		if (err == 0) {
 			err = dismantle_use_case(uc_mgr);
 			if (err < 0)
-				return err;
+				goto __end;
 		} else if (err == 1) {
 			uc_mgr->active_verb = verb;
 			verb = NULL;
@@ -2547,7 +2818,9 @@ static int set_verb_user(snd_use_case_mgr_t *uc_mgr,
 			uc_error("error: failed to initialize new use case: %s",
 				 verb_name);
 	}
-	return err;
+      __end:
+	err2 = cset_plan_end(uc_mgr);
+	return err < 0 ? err : (err2 < 0 ? err2 : err);
 }
 
 
@@ -2587,7 +2860,7 @@ static int switch_device(snd_use_case_mgr_t *uc_mgr,
 	struct use_case_device *xold, *xnew;
 	struct transition_sequence *trans;
 	struct list_head *pos;
-	int err, seq_found = 0;
+	int err, err2, seq_found = 0;
 
 	if (uc_mgr->active_verb == NULL)
 		return -ENOENT;
@@ -2608,6 +2881,7 @@ static int switch_device(snd_use_case_mgr_t *uc_mgr,
 	if (xnew == NULL)
 		return -ENOENT;
 	err = 0;
+	cset_plan_begin(uc_mgr);
 	list_for_each(pos, &xold->transition_list) {
 		trans = list_entry(pos, struct transition_sequence, list);
 		if (strcmp(trans->name, new_device) == 0) {
@@ -2626,13 +2900,11 @@ static int switch_device(snd_use_case_mgr_t *uc_mgr,
 	}
 	if (!seq_found) {
 		err = set_device(uc_mgr, xold, 0);
-		if (err < 0)
-			return err;
-		err = set_device(uc_mgr, xnew, 1);
-		if (err < 0)
-			return err;
+		if (err >= 0)
+			err = set_device(uc_mgr, xnew, 1);
 	}
-	return err;
+	err2 = cset_plan_end(uc_mgr);
+	return err < 0 ? err : (err2 < 0 ? err2 : err);
 }
 
 static int switch_modifier(snd_use_case_mgr_t *uc_mgr,
@@ -2642,7 +2914,7 @@ static int switch_modifier(snd_use_case_mgr_t *uc_mgr,
 	struct use_case_modifier *xold, *xnew;
 	struct transition_sequence *trans;
 	struct list_head *pos;
-	int err, seq_found = 0;
+	int err, err2, seq_found = 0;
 
 	if (uc_mgr->active_verb == NULL)
 		return -ENOENT;
@@ -2661,6 +2933,7 @@ static int switch_modifier(snd_use_case_mgr_t *uc_mgr,
 	if (xnew == NULL)
 		return -ENOENT;
 	err = 0;
+	cset_plan_begin(uc_mgr);
 	list_for_each(pos, &xold->transition_list) {
 		trans = list_entry(pos, struct transition_sequence, list);
 		if (strcmp(trans->name, new_modifier) == 0) {
@@ -2679,13 +2952,11 @@ static int switch_modifier(snd_use_case_mgr_t *uc_mgr,
 	}
 	if (!seq_found) {
 		err = set_modifier(uc_mgr, xold, 0);
-		if (err < 0)
-			return err;
-		err = set_modifier(uc_mgr, xnew, 1);
-		if (err < 0)
-			return err;
+		if (err >= 0)
+			err = set_modifier(uc_mgr, xnew, 1);
 	}
-	return err;
+	err2 = cset_plan_end(uc_mgr);
+	return err < 0 ? err : (err2 < 0 ? err2 : err);
 }
 
 int snd_use_case_set(snd_use_case_mgr_t *uc_mgr,
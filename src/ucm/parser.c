@@ -73,7 +73,8 @@ int uc_mgr_config_load_file(snd_use_case_mgr_t *uc_mgr,
 	ucm_filename(filename, sizeof(filename), uc_mgr->conf_format,
 		     file[0] == '/' ? NULL : uc_mgr->conf_dir_name,
 		     file);
-	err = uc_mgr_config_load(uc_mgr->conf_format, filename, cfg);
+	uc_mgr_cache_file(uc_mgr, filename);
+	err = uc_mgr_config_load(uc_mgr, uc_mgr->conf_format, filename, cfg);
 	if (err < 0) {
 		uc_error("error: failed to open file %s: %d", filename, err);
 		return err;
@@ -742,7 +743,8 @@ static int parse_libconfig1(snd_use_case_mgr_t *uc_mgr, snd_config_t *cfg)
 	if (file) {
 		if (substfile) {
 			snd_config_t *cfg;
-			err = uc_mgr_config_load(uc_mgr->conf_format, file, &cfg);
+			uc_mgr_cache_file(uc_mgr, file);
+			err = uc_mgr_config_load(uc_mgr, uc_mgr->conf_format, file, &cfg);
 			if (err < 0)
 				return err;
 			err = uc_mgr_substitute_tree(uc_mgr, cfg);
@@ -761,7 +763,9 @@ static int parse_libconfig1(snd_use_case_mgr_t *uc_mgr, snd_config_t *cfg)
 			ucm_filename(filename, sizeof(filename), uc_mgr->conf_format,
 				     file[0] == '/' ? NULL : uc_mgr->conf_dir_name,
 				     file);
-			err = uc_mgr_config_load_into(uc_mgr->conf_format, filename, uc_mgr->local_config);
+			uc_mgr_cache_file(uc_mgr, filename);
+			err = uc_mgr_config_load_into(uc_mgr, uc_mgr->conf_format, filename,
+						      uc_mgr->local_config);
 			if (err < 0)
 				return err;
 		}
@@ -1116,6 +1120,9 @@ cset:
 				uc_error("error: %s requires a string!", cmd);
 				return err;
 			}
+			err = uc_mgr_compile_cset(curr);
+			if (err < 0)
+				return err;
 			continue;
 		}
 
@@ -2661,6 +2668,7 @@ static int parse_toplevel_path(snd_use_case_mgr_t *uc_mgr,
 		}
 
 		ucm_filename(fn, sizeof(fn), version, dir, file);
+		uc_mgr_cache_file(uc_mgr, fn);
 		if (access(fn, R_OK) == 0 && lstat64(fn, &st) == 0) {
 			if (S_ISLNK(st.st_mode)) {
 				ssize_t r;
@@ -2792,12 +2800,13 @@ static int load_toplevel_config(snd_use_case_mgr_t *uc_mgr,
 
 	ucm_filename(filename, sizeof(filename), 2, NULL, "ucm.conf");
 
+	uc_mgr_cache_file(uc_mgr, filename);
 	if (access(filename, R_OK) != 0) {
 		uc_error("Unable to find the top-level configuration file '%s'.", filename);
 		return -ENOENT;
 	}
 
-	err = uc_mgr_config_load(2, filename, &tcfg);
+	err = uc_mgr_config_load(uc_mgr, 2, filename, &tcfg);
 	if (err < 0)
 		goto __error;
 
@@ -2807,7 +2816,7 @@ static int load_toplevel_config(snd_use_case_mgr_t *uc_mgr,
 	if (err < 0)
 		goto __error;
 
-	err = uc_mgr_config_load(uc_mgr->conf_format, filename, cfg);
+	err = uc_mgr_config_load(uc_mgr, uc_mgr->conf_format, filename, cfg);
 	if (err < 0) {
 		uc_error("error: could not parse configuration for card %s",
 				uc_mgr->card_name);
@@ -2849,6 +2858,14 @@ int uc_mgr_import_master_config(snd_use_case_mgr_t *uc_mgr)
 		get_by_card_name(uc_mgr, name);
 	}
 
+	/* the evaluated configuration might be cached by a previous open */
+	if (uc_mgr_cache_load(uc_mgr) == 0) {
+		snd_config_delete(uc_mgr->macros);
+		uc_mgr->macros = NULL;
+		return 0;
+	}
+	uc_mgr_cache_begin(uc_mgr);
+
 	err = load_toplevel_config(uc_mgr, &cfg);
 	if (err < 0)
 		goto __error;
@@ -2862,11 +2879,15 @@ int uc_mgr_import_master_config(snd_use_case_mgr_t *uc_mgr)
 	if (err < 0) {
 		uc_mgr_free_ctl_list(uc_mgr);
 		uc_mgr_free_verb(uc_mgr);
+	} else {
+		uc_mgr_cache_save(uc_mgr);
 	}
+	uc_mgr_cache_end(uc_mgr);
 
 	return err;
 
 __error:
+	uc_mgr_cache_end(uc_mgr);
 	uc_mgr_free_ctl_list(uc_mgr);
 	replace_string(&uc_mgr->conf_dir_name, NULL);
 	return err;
@@ -3008,7 +3029,7 @@ int uc_mgr_scan_master_configs(const char **_list[])
 #endif
 			continue;
 
-		err = uc_mgr_config_load(2, filename, &cfg);
+		err = uc_mgr_config_load(NULL, 2, filename, &cfg);
 		if (err < 0)
 			goto __err;
 		err = snd_config_search(cfg, "Syntax", &c);
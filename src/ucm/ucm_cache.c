@@ -0,0 +1,1234 @@
+/*
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public
+ *  License as published by the Free Software Foundation; either
+ *  version 2 of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * Parsed configuration cache
+ *
+ * The evaluation of the ucm2 tree (includes, macros, conditions) is done
+ * by every process which opens the use case manager. When the parsing
+ * succeeds, the evaluated model (verbs, devices, modifiers, sequences,
+ * values and variables) is stored to a per-user cache file together with
+ * the state it depended on:
+ *
+ *  - the configuration files which were read or probed (path, mtime,
+ *    size and inode, or their absence),
+ *  - the substitutions which read the card, environment or sysfs state,
+ *  - the results of the ControlExists and Path conditions.
+ *
+ * The next open evaluates these dependencies again and loads the model
+ * directly when nothing changed. The files included using the alsa-lib
+ * configuration <file> syntax are recorded, too, including the search
+ * directory candidates which do not exist.
+ *
+ * The cache is used only when ALSA_CONFIG_UCM2_CACHE is set. An absolute
+ * path selects the cache directory, any other non-empty value selects
+ * $XDG_CACHE_HOME/alsa/ucm2 or $HOME/.cache/alsa/ucm2.
+ */
+
+#include "ucm_local.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+
+#define UCM_CACHE_MAGIC		0x55434d43	/* UCMC */
+#define UCM_CACHE_VERSION	1
+
+enum {
+	CACHE_DEP_FILE,
+	CACHE_DEP_SUBST,
+	CACHE_DEP_CONTROL_EXISTS,
+	CACHE_DEP_PATH,
+};
+
+struct ucm_cache_dep {
+	struct list_head list;
+	unsigned int type;
+	char *s[3];
+	int64_t n[4];		/* file: mtime sec/nsec, size (-1 absent), inode */
+	int result;		/* condition result */
+};
+
+struct ucm_cache {
+	struct list_head deps;
+	int err;		/* a dependency cannot be recorded */
+};
+
+struct cache_buf {
+	char *data;
+	size_t size;
+	size_t pos;
+	int err;
+};
+
+/* component device reference resolved when all verbs are loaded */
+struct cache_fixup {
+	struct component_sequence *cmpt_seq;
+	uint32_t verb;
+	char *name;
+};
+
+struct cache_reader {
+	struct cache_buf buf;
+	struct cache_fixup *fixups;
+	unsigned int fixups_count;
+	unsigned int fixups_alloc;
+};
+
+/*
+ * dependency recording
+ */
+
+static bool str_equal(const char *s1, const char *s2)
+{
+	if (s1 == NULL || s2 == NULL)
+		return s1 == s2;
+	return strcmp(s1, s2) == 0;
+}
+
+static struct ucm_cache_dep *dep_add(snd_use_case_mgr_t *uc_mgr,
+				     unsigned int type,
+				     const char *s0, const char *s1,
+				     const char *s2)
+{
+	struct ucm_cache *cache = uc_mgr->cache;
+	struct ucm_cache_dep *dep;
+	struct list_head *pos;
+	const char *s[3] = { s0, s1, s2 };
+	unsigned int i;
+
+	list_for_each(pos, &cache->deps) {
+		dep = list_entry(pos, struct ucm_cache_dep, list);
+		if (dep->type == type && str_equal(dep->s[0], s0) &&
+		    str_equal(dep->s[1], s1) && str_equal(dep->s[2], s2))
+			return NULL;
+	}
+	dep = calloc(1, sizeof(*dep));
+	if (dep == NULL)
+		goto __nomem;
+	dep->type = type;
+	for (i = 0; i < 3; i++) {
+		if (s[i] == NULL)
+			continue;
+		dep->s[i] = strdup(s[i]);
+		if (dep->s[i] == NULL)
+			goto __nomem;
+	}
+	list_add_tail(&dep->list, &cache->deps);
+	return dep;
+
+      __nomem:
+	if (dep) {
+		for (i = 0; i < 3; i++)
+			free(dep->s[i]);
+		free(dep);
+	}
+	cache->err = -ENOMEM;
+	return NULL;
+}
+
+static void dep_free(struct ucm_cache_dep *dep)
+{
+	unsigned int i;
+
+	list_del(&dep->list);
+	for (i = 0; i < 3; i++)
+		free(dep->s[i]);
+	free(dep);
+}
+
+static void file_stat(const char *filename, int64_t *n)
+{
+	struct stat64 st;
+
+	if (stat64(filename, &st) < 0) {
+		n[0] = n[1] = n[3] = 0;
+		n[2] = -1;
+		return;
+	}
+	n[0] = st.st_mtim.tv_sec;
+	n[1] = st.st_mtim.tv_nsec;
+	n[2] = st.st_size;
+	n[3] = st.st_ino;
+}
+
+void uc_mgr_cache_file(snd_use_case_mgr_t *uc_mgr, const char *filename)
+{
+	struct ucm_cache_dep *dep;
+
+	if (uc_mgr->cache == NULL)
+		return;
+	dep = dep_add(uc_mgr, CACHE_DEP_FILE, filename, NULL, NULL);
+	if (dep)
+		file_stat(filename, dep->n);
+}
+
+void uc_mgr_cache_subst(snd_use_case_mgr_t *uc_mgr, const char *id,
+			const char *arg, const char *rval)
+{
+	struct ucm_cache_dep *dep;
+
+	if (uc_mgr->cache == NULL)
+		return;
+	dep = dep_add(uc_mgr, CACHE_DEP_SUBST, id, arg, rval);
+	if (dep)
+		dep->result = rval != NULL;
+}
+
+void uc_mgr_cache_control_exists(snd_use_case_mgr_t *uc_mgr,
+				 const char *device, const char *ctlid,
+				 const char *enumval, int result)
+{
+	struct ucm_cache_dep *dep;
+
+	if (uc_mgr->cache == NULL)
+		return;
+	dep = dep_add(uc_mgr, CACHE_DEP_CONTROL_EXISTS, device, ctlid, enumval);
+	if (dep)
+		dep->result = result;
+}
+
+void uc_mgr_cache_path(snd_use_case_mgr_t *uc_mgr, const char *path,
+		       int amode, int result)
+{
+	struct ucm_cache_dep *dep;
+	char mode[16];
+
+	if (uc_mgr->cache == NULL)
+		return;
+	snprintf(mode, sizeof(mode), "%d", amode);
+	dep = dep_add(uc_mgr, CACHE_DEP_PATH, path, mode, NULL);
+	if (dep) {
+		dep->n[0] = amode;
+		dep->result = result;
+	}
+}
+
+static bool dep_valid(snd_use_case_mgr_t *uc_mgr, struct ucm_cache_dep *dep)
+{
+	int64_t n[4];
+	char *rval = NULL;
+	bool ret;
+	int err;
+
+	switch (dep->type) {
+	case CACHE_DEP_FILE:
+		file_stat(dep->s[0], n);
+		return memcmp(n, dep->n, sizeof(n)) == 0;
+	case CACHE_DEP_SUBST:
+		err = uc_mgr_subst_dep_value(uc_mgr, dep->s[0], dep->s[1], &rval);
+		if (err < 0)
+			return false;
+		if (dep->result)
+			ret = rval && strcmp(rval, dep->s[2] ?: "") == 0;
+		else
+			ret = rval == NULL;
+		free(rval);
+		return ret;
+	case CACHE_DEP_CONTROL_EXISTS:
+		err = uc_mgr_cond_control_exists(uc_mgr, dep->s[0], dep->s[1],
+						 dep->s[2]);
+		return err == dep->result;
+	case CACHE_DEP_PATH:
+		return uc_mgr_cond_path(dep->s[0], dep->n[0]) == dep->result;
+	default:
+		return false;
+	}
+}
+
+/*
+ * serialization
+ */
+
+static void put_data(struct cache_buf *b, const void *data, size_t len)
+{
+	size_t size;
+	char *d;
+
+	if (b->err < 0)
+		return;
+	if (b->pos + len > b->size) {
+		size = b->size ? b->size : 16384;
+		while (size < b->pos + len)
+			size *= 2;
+		d = realloc(b->data, size);
+		if (d == NULL) {
+			b->err = -ENOMEM;
+			return;
+		}
+		b->data = d;
+		b->size = size;
+	}
+	memcpy(b->data + b->pos, data, len);
+	b->pos += len;
+}
+
+static void put_u32(struct cache_buf *b, uint32_t v)
+{
+	put_data(b, &v, sizeof(v));
+}
+
+static void put_i64(struct cache_buf *b, int64_t v)
+{
+	put_data(b, &v, sizeof(v));
+}
+
+/* the length is stored incremented, zero means NULL */
+static void put_str(struct cache_buf *b, const char *s)
+{
+	uint32_t len;
+
+	if (s == NULL) {
+		put_u32(b, 0);
+		return;
+	}
+	len = strlen(s);
+	put_u32(b, len + 1);
+	put_data(b, s, len);
+}
+
+static int get_data(struct cache_buf *b, void *data, size_t len)
+{
+	if (b->err < 0)
+		return b->err;
+	if (b->pos + len > b->size) {
+		b->err = -EINVAL;
+		return b->err;
+	}
+	memcpy(data, b->data + b->pos, len);
+	b->pos += len;
+	return 0;
+}
+
+static uint32_t get_u32(struct cache_buf *b)
+{
+	uint32_t v = 0;
+
+	get_data(b, &v, sizeof(v));
+	return v;
+}
+
+static int64_t get_i64(struct cache_buf *b)
+{
+	int64_t v = 0;
+
+	get_data(b, &v, sizeof(v));
+	return v;
+}
+
+/* returns NULL for the NULL string or an error (b->err is set) */
+static char *get_str(struct cache_buf *b)
+{
+	uint32_t len = get_u32(b);
+	char *s;
+
+	if (len == 0 || b->err < 0)
+		return NULL;
+	len--;
+	if (b->pos + len > b->size) {
+		b->err = -EINVAL;
+		return NULL;
+	}
+	s = malloc(len + 1);
+	if (s == NULL) {
+		b->err = -ENOMEM;
+		return NULL;
+	}
+	memcpy(s, b->data + b->pos, len);
+	s[len] = '\0';
+	b->pos += len;
+	return s;
+}
+
+static const char *seq_string(struct sequence_element *seq)
+{
+	switch (seq->type) {
+	case SEQUENCE_ELEMENT_TYPE_CDEV:
+		return seq->data.cdev;
+	case SEQUENCE_ELEMENT_TYPE_CSET:
+	case SEQUENCE_ELEMENT_TYPE_CSET_NEW:
+	case SEQUENCE_ELEMENT_TYPE_CSET_BIN_FILE:
+	case SEQUENCE_ELEMENT_TYPE_CSET_TLV:
+	case SEQUENCE_ELEMENT_TYPE_CTL_REMOVE:
+		return seq->data.cset;
+	case SEQUENCE_ELEMENT_TYPE_SYSSET:
+		return seq->data.sysw;
+	case SEQUENCE_ELEMENT_TYPE_EXEC:
+	case SEQUENCE_ELEMENT_TYPE_SHELL:
+		return seq->data.exec;
+	case SEQUENCE_ELEMENT_TYPE_CFGSAVE:
+		return seq->data.cfgsave;
+	case SEQUENCE_ELEMENT_TYPE_DEV_ENABLE_SEQ:
+	case SEQUENCE_ELEMENT_TYPE_DEV_DISABLE_SEQ:
+		return seq->data.device;
+	default:
+		return NULL;
+	}
+}
+
+static int cmpt_verb_index(snd_use_case_mgr_t *uc_mgr,
+			   struct use_case_device *device)
+{
+	struct list_head *pos, *pos2;
+	struct use_case_verb *verb;
+	int idx = 0;
+
+	list_for_each(pos, &uc_mgr->verb_list) {
+		verb = list_entry(pos, struct use_case_verb, list);
+		list_for_each(pos2, &verb->cmpt_device_list) {
+			if (list_entry(pos2, struct use_case_device, list) == device)
+				return idx;
+		}
+		idx++;
+	}
+	return -ENOENT;
+}
+
+static uint32_t list_count(struct list_head *base)
+{
+	struct list_head *pos;
+	uint32_t count = 0;
+
+	list_for_each(pos, base)
+		count++;
+	return count;
+}
+
+static void put_values(struct cache_buf *b, struct list_head *base)
+{
+	struct list_head *pos;
+	struct ucm_value *val;
+
+	put_u32(b, list_count(base));
+	list_for_each(pos, base) {
+		val = list_entry(pos, struct ucm_value, list);
+		put_str(b, val->name);
+		put_str(b, val->data);
+	}
+}
+
+static void put_sequence(snd_use_case_mgr_t *uc_mgr, struct cache_buf *b,
+			 struct list_head *base)
+{
+	struct list_head *pos;
+	struct sequence_element *seq;
+	int idx;
+
+	put_u32(b, list_count(base));
+	list_for_each(pos, base) {
+		seq = list_entry(pos, struct sequence_element, list);
+		put_u32(b, seq->type);
+		switch (seq->type) {
+		case SEQUENCE_ELEMENT_TYPE_SLEEP:
+			put_i64(b, seq->data.sleep);
+			break;
+		case SEQUENCE_ELEMENT_TYPE_CMPT_SEQ:
+			idx = cmpt_verb_index(uc_mgr, seq->data.cmpt_seq.device);
+			if (idx < 0) {
+				b->err = idx;
+				return;
+			}
+			put_u32(b, idx);
+			put_str(b, seq->data.cmpt_seq.device->name);
+			put_u32(b, seq->data.cmpt_seq.enable);
+			break;
+		case SEQUENCE_ELEMENT_TYPE_DEV_DISABLE_ALL:
+			break;
+		default:
+			put_str(b, seq_string(seq));
+			break;
+		}
+	}
+}
+
+static void put_transitions(snd_use_case_mgr_t *uc_mgr, struct cache_buf *b,
+			    struct list_head *base)
+{
+	struct list_head *pos;
+	struct transition_sequence *tseq;
+
+	put_u32(b, list_count(base));
+	list_for_each(pos, base) {
+		tseq = list_entry(pos, struct transition_sequence, list);
+		put_str(b, tseq->name);
+		put_sequence(uc_mgr, b, &tseq->transition_list);
+	}
+}
+
+static void put_dev_list(struct cache_buf *b, struct dev_list *dev_list)
+{
+	struct list_head *pos;
+	struct dev_list_node *dlist;
+
+	put_u32(b, dev_list->type);
+	put_u32(b, list_count(&dev_list->list));
+	/* uc_mgr_put_to_dev_list() prepends, store the names reversed */
+	for (pos = dev_list->list.prev; pos != &dev_list->list; pos = pos->prev) {
+		dlist = list_entry(pos, struct dev_list_node, list);
+		put_str(b, dlist->name);
+	}
+}
+
+static void put_devices(snd_use_case_mgr_t *uc_mgr, struct cache_buf *b,
+			struct list_head *base)
+{
+	struct list_head *pos;
+	struct use_case_device *device;
+
+	put_u32(b, list_count(base));
+	list_for_each(pos, base) {
+		device = list_entry(pos, struct use_case_device, list);
+		put_str(b, device->name);
+		put_str(b, device->comment);
+		put_sequence(uc_mgr, b, &device->enable_list);
+		put_sequence(uc_mgr, b, &device->disable_list);
+		put_transitions(uc_mgr, b, &device->transition_list);
+		put_dev_list(b, &device->dev_list);
+		put_values(b, &device->value_list);
+	}
+}
+
+static void put_modifiers(snd_use_case_mgr_t *uc_mgr, struct cache_buf *b,
+			  struct list_head *base)
+{
+	struct list_head *pos;
+	struct use_case_modifier *modifier;
+
+	put_u32(b, list_count(base));
+	list_for_each(pos, base) {
+		modifier = list_entry(pos, struct use_case_modifier, list);
+		put_str(b, modifier->name);
+		put_str(b, modifier->comment);
+		put_sequence(uc_mgr, b, &modifier->enable_list);
+		put_sequence(uc_mgr, b, &modifier->disable_list);
+		put_transitions(uc_mgr, b, &modifier->transition_list);
+		put_dev_list(b, &modifier->dev_list);
+		put_values(b, &modifier->value_list);
+	}
+}
+
+static void put_local_config(struct cache_buf *b, snd_config_t *config)
+{
+	snd_output_t *out;
+	char *text;
+	size_t len;
+	int err;
+
+	if (config == NULL || snd_config_iterator_first(config) ==
+			      snd_config_iterator_end(config)) {
+		put_str(b, NULL);
+		return;
+	}
+	err = snd_output_buffer_open(&out);
+	if (err < 0) {
+		b->err = err;
+		return;
+	}
+	err = snd_config_save(config, out);
+	if (err < 0) {
+		b->err = err;
+	} else {
+		len = snd_output_buffer_string(out, &text);
+		put_u32(b, len + 1);
+		put_data(b, text, len);
+	}
+	snd_output_close(out);
+}
+
+static void put_model(snd_use_case_mgr_t *uc_mgr, struct cache_buf *b)
+{
+	struct list_head *pos;
+	struct use_case_verb *verb;
+
+	put_u32(b, uc_mgr->conf_format);
+	put_str(b, uc_mgr->conf_dir_name);
+	put_str(b, uc_mgr->conf_file_name);
+	put_str(b, uc_mgr->comment);
+	put_local_config(b, uc_mgr->local_config);
+	put_values(b, &uc_mgr->variable_list);
+	put_sequence(uc_mgr, b, &uc_mgr->fixedboot_list);
+	put_sequence(uc_mgr, b, &uc_mgr->boot_list);
+	put_sequence(uc_mgr, b, &uc_mgr->default_list);
+	put_values(b, &uc_mgr->value_list);
+	put_u32(b, list_count(&uc_mgr->verb_list));
+	list_for_each(pos, &uc_mgr->verb_list) {
+		verb = list_entry(pos, struct use_case_verb, list);
+		put_str(b, verb->name);
+		put_str(b, verb->comment);
+		put_sequence(uc_mgr, b, &verb->enable_list);
+		put_sequence(uc_mgr, b, &verb->disable_list);
+		put_transitions(uc_mgr, b, &verb->transition_list);
+		put_values(b, &verb->value_list);
+		put_devices(uc_mgr, b, &verb->device_list);
+		put_devices(uc_mgr, b, &verb->cmpt_device_list);
+		put_modifiers(uc_mgr, b, &verb->modifier_list);
+	}
+}
+
+/*
+ * deserialization - the objects are linked to the manager lists
+ * immediately, so uc_mgr_free_verb() releases a partially loaded model
+ */
+
+static int get_values(struct cache_buf *b, struct list_head *base)
+{
+	uint32_t count = get_u32(b);
+	char *name, *data;
+	int err;
+
+	while (count-- > 0 && b->err == 0) {
+		name = get_str(b);
+		data = get_str(b);
+		if (name == NULL || data == NULL) {
+			free(name);
+			free(data);
+			return b->err ?: -EINVAL;
+		}
+		err = uc_mgr_add_value(base, name, data);
+		free(name);
+		if (err < 0) {
+			free(data);
+			return err;
+		}
+	}
+	return b->err;
+}
+
+static int add_fixup(struct cache_reader *r, struct component_sequence *cmpt_seq,
+		     uint32_t verb, char *name)
+{
+	struct cache_fixup *f;
+	unsigned int alloc;
+
+	if (r->fixups_count >= r->fixups_alloc) {
+		alloc = r->fixups_alloc ? r->fixups_alloc * 2 : 16;
+		f = realloc(r->fixups, alloc * sizeof(*f));
+		if (f == NULL)
+			return -ENOMEM;
+		r->fixups = f;
+		r->fixups_alloc = alloc;
+	}
+	f = &r->fixups[r->fixups_count++];
+	f->cmpt_seq = cmpt_seq;
+	f->verb = verb;
+	f->name = name;
+	return 0;
+}
+
+static int get_sequence(struct cache_reader *r, struct list_head *base)
+{
+	struct cache_buf *b = &r->buf;
+	uint32_t count = get_u32(b), verb;
+	struct sequence_element *seq;
+	char *name;
+	int err;
+
+	while (count-- > 0 && b->err == 0) {
+		seq = calloc(1, sizeof(*seq));
+		if (seq == NULL)
+			return -ENOMEM;
+		seq->type = get_u32(b);
+		list_add_tail(&seq->list, base);
+		switch (seq->type) {
+		case SEQUENCE_ELEMENT_TYPE_SLEEP:
+			seq->data.sleep = get_i64(b);
+			break;
+		case SEQUENCE_ELEMENT_TYPE_CMPT_SEQ:
+			verb = get_u32(b);
+			name = get_str(b);
+			seq->data.cmpt_seq.enable = get_u32(b);
+			if (name == NULL)
+				return b->err ?: -EINVAL;
+			err = add_fixup(r, &seq->data.cmpt_seq, verb, name);
+			if (err < 0) {
+				free(name);
+				return err;
+			}
+			break;
+		case SEQUENCE_ELEMENT_TYPE_DEV_DISABLE_ALL:
+			break;
+		case SEQUENCE_ELEMENT_TYPE_CDEV:
+		case SEQUENCE_ELEMENT_TYPE_CSET:
+		case SEQUENCE_ELEMENT_TYPE_CSET_NEW:
+		case SEQUENCE_ELEMENT_TYPE_CSET_BIN_FILE:
+		case SEQUENCE_ELEMENT_TYPE_CSET_TLV:
+		case SEQUENCE_ELEMENT_TYPE_CTL_REMOVE:
+		case SEQUENCE_ELEMENT_TYPE_SYSSET:
+		case SEQUENCE_ELEMENT_TYPE_EXEC:
+		case SEQUENCE_ELEMENT_TYPE_SHELL:
+		case SEQUENCE_ELEMENT_TYPE_CFGSAVE:
+		case SEQUENCE_ELEMENT_TYPE_DEV_ENABLE_SEQ:
+		case SEQUENCE_ELEMENT_TYPE_DEV_DISABLE_SEQ:
+			/* all string members share the same storage */
+			seq->data.cdev = get_str(b);
+			if (seq->data.cdev == NULL && seq->type != SEQUENCE_ELEMENT_TYPE_EXEC &&
+			    seq->type != SEQUENCE_ELEMENT_TYPE_SHELL)
+				return b->err ?: -EINVAL;
+			err = uc_mgr_compile_cset(seq);
+			if (err < 0)
+				return err;
+			break;
+		default:
+			seq->type = 0;
+			return -EINVAL;
+		}
+	}
+	return b->err;
+}
+
+static int get_transitions(struct cache_reader *r, struct list_head *base)
+{
+	struct cache_buf *b = &r->buf;
+	uint32_t count = get_u32(b);
+	struct transition_sequence *tseq;
+	int err;
+
+	while (count-- > 0 && b->err == 0) {
+		tseq = calloc(1, sizeof(*tseq));
+		if (tseq == NULL)
+			return -ENOMEM;
+		INIT_LIST_HEAD(&tseq->transition_list);
+		list_add_tail(&tseq->list, base);
+		tseq->name = get_str(b);
+		if (tseq->name == NULL)
+			return b->err ?: -EINVAL;
+		err = get_sequence(r, &tseq->transition_list);
+		if (err < 0)
+			return err;
+	}
+	return b->err;
+}
+
+static int get_dev_list(struct cache_buf *b, struct dev_list *dev_list)
+{
+	uint32_t count;
+	char *name;
+	int err;
+
+	dev_list->type = get_u32(b);
+	count = get_u32(b);
+	while (count-- > 0 && b->err == 0) {
+		name = get_str(b);
+		if (name == NULL)
+			return b->err ?: -EINVAL;
+		err = uc_mgr_put_to_dev_list(dev_list, name);
+		free(name);
+		if (err < 0)
+			return err;
+	}
+	return b->err;
+}
+
+static int get_devices(struct cache_reader *r, struct list_head *base)
+{
+	struct cache_buf *b = &r->buf;
+	uint32_t count = get_u32(b);
+	struct use_case_device *device;
+	int err;
+
+	while (count-- > 0 && b->err == 0) {
+		device = calloc(1, sizeof(*device));
+		if (device == NULL)
+			return -ENOMEM;
+		INIT_LIST_HEAD(&device->enable_list);
+		INIT_LIST_HEAD(&device->disable_list);
+		INIT_LIST_HEAD(&device->transition_list);
+		INIT_LIST_HEAD(&device->dev_list.list);
+		INIT_LIST_HEAD(&device->value_list);
+		list_add_tail(&device->list, base);
+		device->name = get_str(b);
+		device->comment = get_str(b);
+		if (device->name == NULL)
+			return b->err ?: -EINVAL;
+		err = get_sequence(r, &device->enable_list);
+		if (err >= 0)
+			err = get_sequence(r, &device->disable_list);
+		if (err >= 0)
+			err = get_transitions(r, &device->transition_list);
+		if (err >= 0)
+			err = get_dev_list(b, &device->dev_list);
+		if (err >= 0)
+			err = get_values(b, &device->value_list);
+		if (err < 0)
+			return err;
+	}
+	return b->err;
+}
+
+static int get_modifiers(struct cache_reader *r, struct list_head *base)
+{
+	struct cache_buf *b = &r->buf;
+	uint32_t count = get_u32(b);
+	struct use_case_modifier *modifier;
+	int err;
+
+	while (count-- > 0 && b->err == 0) {
+		modifier = calloc(1, sizeof(*modifier));
+		if (modifier == NULL)
+			return -ENOMEM;
+		INIT_LIST_HEAD(&modifier->enable_list);
+		INIT_LIST_HEAD(&modifier->disable_list);
+		INIT_LIST_HEAD(&modifier->transition_list);
+		INIT_LIST_HEAD(&modifier->dev_list.list);
+		INIT_LIST_HEAD(&modifier->value_list);
+		list_add_tail(&modifier->list, base);
+		modifier->name = get_str(b);
+		modifier->comment = get_str(b);
+		if (modifier->name == NULL)
+			return b->err ?: -EINVAL;
+		err = get_sequence(r, &modifier->enable_list);
+		if (err >= 0)
+			err = get_sequence(r, &modifier->disable_list);
+		if (err >= 0)
+			err = get_transitions(r, &modifier->transition_list);
+		if (err >= 0)
+			err = get_dev_list(b, &modifier->dev_list);
+		if (err >= 0)
+			err = get_values(b, &modifier->value_list);
+		if (err < 0)
+			return err;
+	}
+	return b->err;
+}
+
+static int get_local_config(struct cache_buf *b, snd_config_t *config)
+{
+	snd_input_t *in;
+	char *text;
+	int err;
+
+	text = get_str(b);
+	if (text == NULL)
+		return b->err;
+	err = snd_input_buffer_open(&in, text, strlen(text));
+	if (err >= 0) {
+		err = snd_config_load(config, in);
+		snd_input_close(in);
+	}
+	free(text);
+	return err;
+}
+
+static int resolve_fixups(snd_use_case_mgr_t *uc_mgr, struct cache_reader *r)
+{
+	struct list_head *pos, *pos2;
+	struct use_case_verb *verb;
+	struct use_case_device *device;
+	struct cache_fixup *f;
+	unsigned int i, idx;
+
+	for (i = 0; i < r->fixups_count; i++) {
+		f = &r->fixups[i];
+		idx = 0;
+		list_for_each(pos, &uc_mgr->verb_list) {
+			if (idx++ != f->verb)
+				continue;
+			verb = list_entry(pos, struct use_case_verb, list);
+			list_for_each(pos2, &verb->cmpt_device_list) {
+				device = list_entry(pos2, struct use_case_device, list);
+				if (strcmp(device->name, f->name) == 0) {
+					f->cmpt_seq->device = device;
+					break;
+				}
+			}
+			break;
+		}
+		if (f->cmpt_seq->device == NULL)
+			return -EINVAL;
+	}
+	return 0;
+}
+
+static int get_model(snd_use_case_mgr_t *uc_mgr, struct cache_reader *r)
+{
+	struct cache_buf *b = &r->buf;
+	struct use_case_verb *verb;
+	uint32_t count;
+	int err;
+
+	uc_mgr->conf_format = get_u32(b);
+	uc_mgr->conf_dir_name = get_str(b);
+	uc_mgr->conf_file_name = get_str(b);
+	uc_mgr->comment = get_str(b);
+	if (uc_mgr->conf_dir_name == NULL || uc_mgr->conf_file_name == NULL)
+		return b->err ?: -EINVAL;
+	err = get_local_config(b, uc_mgr->local_config);
+	if (err >= 0)
+		err = get_values(b, &uc_mgr->variable_list);
+	if (err >= 0)
+		err = get_sequence(r, &uc_mgr->fixedboot_list);
+	if (err >= 0)
+		err = get_sequence(r, &uc_mgr->boot_list);
+	if (err >= 0)
+		err = get_sequence(r, &uc_mgr->default_list);
+	if (err >= 0)
+		err = get_values(b, &uc_mgr->value_list);
+	if (err < 0)
+		return err;
+	count = get_u32(b);
+	while (count-- > 0 && b->err == 0) {
+		verb = calloc(1, sizeof(*verb));
+		if (verb == NULL)
+			return -ENOMEM;
+		INIT_LIST_HEAD(&verb->enable_list);
+		INIT_LIST_HEAD(&verb->disable_list);
+		INIT_LIST_HEAD(&verb->transition_list);
+		INIT_LIST_HEAD(&verb->device_list);
+		INIT_LIST_HEAD(&verb->cmpt_device_list);
+		INIT_LIST_HEAD(&verb->modifier_list);
+		INIT_LIST_HEAD(&verb->value_list);
+		INIT_LIST_HEAD(&verb->rename_list);
+		INIT_LIST_HEAD(&verb->remove_list);
+		list_add_tail(&verb->list, &uc_mgr->verb_list);
+		verb->name = get_str(b);
+		verb->comment = get_str(b);
+		if (verb->name == NULL)
+			return b->err ?: -EINVAL;
+		err = get_sequence(r, &verb->enable_list);
+		if (err >= 0)
+			err = get_sequence(r, &verb->disable_list);
+		if (err >= 0)
+			err = get_transitions(r, &verb->transition_list);
+		if (err >= 0)
+			err = get_values(b, &verb->value_list);
+		if (err >= 0)
+			err = get_devices(r, &verb->device_list);
+		if (err >= 0)
+			err = get_devices(r, &verb->cmpt_device_list);
+		if (err >= 0)
+			err = get_modifiers(r, &verb->modifier_list);
+		if (err < 0)
+			return err;
+	}
+	if (b->err < 0)
+		return b->err;
+	return resolve_fixups(uc_mgr, r);
+}
+
+/*
+ * cache file
+ */
+
+static uint64_t key_hash(const char *key)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	while (*key) {
+		h ^= (unsigned char)*key++;
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+/* the key contains everything which selects the configuration files */
+static char *cache_key(snd_use_case_mgr_t *uc_mgr)
+{
+	char *key;
+	size_t len;
+
+	len = strlen(uc_mgr->card_name) + PATH_MAX * 3 + 4;
+	key = malloc(len);
+	if (key == NULL)
+		return NULL;
+	snprintf(key, len, "%s\n%s\n%s\n%s", uc_mgr->card_name,
+		 uc_mgr_config_dir(2), uc_mgr_config_dir(1),
+		 snd_config_topdir());
+	return key;
+}
+
+static int cache_dir(char *path, size_t size)
+{
+	const char *env;
+	int len;
+
+	env = getenv(ALSA_CONFIG_UCM2_CACHE_VAR);
+	if (env == NULL || env[0] == '\0')
+		return -ENOENT;
+	if (env[0] == '/') {
+		len = snprintf(path, size, "%s", env);
+		goto __len;
+	}
+	env = getenv("XDG_CACHE_HOME");
+	if (env && env[0] == '/') {
+		len = snprintf(path, size, "%s/alsa/ucm2", env);
+		goto __len;
+	}
+	env = getenv("HOME");
+	if (env && env[0] == '/') {
+		len = snprintf(path, size, "%s/.cache/alsa/ucm2", env);
+		goto __len;
+	}
+	return -ENOENT;
+__len:
+	if (len < 0 || (size_t)len >= size)
+		return -ENAMETOOLONG;
+	return 0;
+}
+
+static int cache_filename(snd_use_case_mgr_t *uc_mgr, const char *key,
+			  char *path, size_t size)
+{
+	char name[33];
+	const char *s;
+	unsigned int i;
+	int err, len;
+
+	err = cache_dir(path, size);
+	if (err < 0)
+		return err;
+	for (s = uc_mgr->card_name, i = 0; *s && i < sizeof(name) - 1; s++, i++)
+		name[i] = isalnum((unsigned char)*s) || *s == '-' ? *s : '_';
+	name[i] = '\0';
+	len = strlen(path);
+	err = snprintf(path + len, size - len, "/%s-%016llx.cache", name,
+		       (unsigned long long)key_hash(key));
+	if (err < 0 || (size_t)err >= size - len)
+		return -ENAMETOOLONG;
+	return 0;
+}
+
+static int mkdir_parents(char *path)
+{
+	char *s;
+
+	for (s = strchr(path + 1, '/'); s; s = strchr(s + 1, '/')) {
+		*s = '\0';
+		if (mkdir(path, 0700) < 0 && errno != EEXIST) {
+			*s = '/';
+			return -errno;
+		}
+		*s = '/';
+	}
+	return 0;
+}
+
+static int read_file(const char *filename, struct cache_buf *b)
+{
+	struct stat64 st;
+	ssize_t r;
+	size_t pos = 0;
+	int fd, err = 0;
+
+	fd = open(filename, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+	if (fstat64(fd, &st) < 0 || st.st_size <= 0 || st.st_uid != geteuid()) {
+		err = -EINVAL;
+		goto __end;
+	}
+	b->data = malloc(st.st_size);
+	if (b->data == NULL) {
+		err = -ENOMEM;
+		goto __end;
+	}
+	b->size = st.st_size;
+	while (pos < b->size) {
+		r = read(fd, b->data + pos, b->size - pos);
+		if (r <= 0) {
+			err = r < 0 ? -errno : -EINVAL;
+			goto __end;
+		}
+		pos += r;
+	}
+      __end:
+	close(fd);
+	return err;
+}
+
+void uc_mgr_cache_begin(snd_use_case_mgr_t *uc_mgr)
+{
+	char path[PATH_MAX];
+	struct ucm_cache *cache;
+
+	if (cache_dir(path, sizeof(path)) < 0)
+		return;
+	cache = calloc(1, sizeof(*cache));
+	if (cache == NULL)
+		return;
+	INIT_LIST_HEAD(&cache->deps);
+	uc_mgr->cache = cache;
+}
+
+void uc_mgr_cache_end(snd_use_case_mgr_t *uc_mgr)
+{
+	struct ucm_cache *cache = uc_mgr->cache;
+	struct list_head *pos, *npos;
+
+	if (cache == NULL)
+		return;
+	list_for_each_safe(pos, npos, &cache->deps)
+		dep_free(list_entry(pos, struct ucm_cache_dep, list));
+	free(cache);
+	uc_mgr->cache = NULL;
+}
+
+/**
+ * \brief Store the parsed configuration with the recorded dependencies
+ * \param uc_mgr Use case manager
+ * \return zero on success, otherwise a negative error code
+ */
+int uc_mgr_cache_save(snd_use_case_mgr_t *uc_mgr)
+{
+	struct ucm_cache *cache = uc_mgr->cache;
+	struct ucm_cache_dep *dep;
+	struct list_head *pos;
+	struct cache_buf b;
+	char path[PATH_MAX], tmp[PATH_MAX + 8], *key;
+	unsigned int i;
+	size_t written;
+	ssize_t r;
+	int fd, err;
+
+	if (cache == NULL || cache->err < 0)
+		return -EINVAL;
+	key = cache_key(uc_mgr);
+	if (key == NULL)
+		return -ENOMEM;
+	err = cache_filename(uc_mgr, key, path, sizeof(path));
+	if (err < 0) {
+		free(key);
+		return err;
+	}
+
+	memset(&b, 0, sizeof(b));
+	put_u32(&b, UCM_CACHE_MAGIC);
+	put_u32(&b, UCM_CACHE_VERSION);
+	put_str(&b, key);
+	free(key);
+	put_u32(&b, list_count(&cache->deps));
+	list_for_each(pos, &cache->deps) {
+		dep = list_entry(pos, struct ucm_cache_dep, list);
+		put_u32(&b, dep->type);
+		for (i = 0; i < 3; i++)
+			put_str(&b, dep->s[i]);
+		for (i = 0; i < 4; i++)
+			put_i64(&b, dep->n[i]);
+		put_u32(&b, dep->result);
+	}
+	put_model(uc_mgr, &b);
+	if (b.err < 0) {
+		err = b.err;
+		goto __end;
+	}
+
+	/* write a temporary file and replace the old cache atomically */
+	err = mkdir_parents(path);
+	if (err < 0)
+		goto __end;
+	snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path);
+	fd = mkstemp(tmp);
+	if (fd < 0) {
+		err = -errno;
+		goto __end;
+	}
+	for (written = 0; written < b.pos; written += r) {
+		r = write(fd, b.data + written, b.pos - written);
+		if (r < 0) {
+			if (errno == EINTR) {
+				r = 0;
+				continue;
+			}
+			err = -errno;
+			break;
+		}
+	}
+	close(fd);
+	if (err >= 0 && rename(tmp, path) < 0)
+		err = -errno;
+	if (err < 0)
+		unlink(tmp);
+      __end:
+	free(b.data);
+	return err;
+}
+
+/**
+ * \brief Load the parsed configuration when its dependencies are unchanged
+ * \param uc_mgr Use case manager
+ * \return zero on success, otherwise a negative error code
+ */
+int uc_mgr_cache_load(snd_use_case_mgr_t *uc_mgr)
+{
+	struct cache_reader r;
+	struct cache_buf *b = &r.buf;
+	struct ucm_cache_dep dep;
+	char path[PATH_MAX], *key, *key2;
+	uint32_t count;
+	unsigned int i;
+	int err;
+
+	key = cache_key(uc_mgr);
+	if (key == NULL)
+		return -ENOMEM;
+	err = cache_filename(uc_mgr, key, path, sizeof(path));
+	if (err < 0) {
+		free(key);
+		return err;
+	}
+	memset(&r, 0, sizeof(r));
+	err = read_file(path, b);
+	if (err < 0)
+		goto __end;
+
+	err = -EINVAL;
+	if (get_u32(b) != UCM_CACHE_MAGIC || get_u32(b) != UCM_CACHE_VERSION)
+		goto __end;
+	key2 = get_str(b);
+	if (key2 == NULL || strcmp(key, key2) != 0) {
+		free(key2);
+		goto __end;
+	}
+	free(key2);
+
+	/* check all dependencies before the model is touched */
+	count = get_u32(b);
+	while (count-- > 0 && b->err == 0) {
+		memset(&dep, 0, sizeof(dep));
+		dep.type = get_u32(b);
+		for (i = 0; i < 3; i++)
+			dep.s[i] = get_str(b);
+		for (i = 0; i < 4; i++)
+			dep.n[i] = get_i64(b);
+		dep.result = get_u32(b);
+		if (b->err < 0 || !dep_valid(uc_mgr, &dep))
+			err = -ESTALE;
+		for (i = 0; i < 3; i++)
+			free(dep.s[i]);
+		if (err == -ESTALE)
+			goto __end;
+	}
+	if (b->err < 0)
+		goto __end;
+
+	err = get_model(uc_mgr, &r);
+	if (err < 0) {
+		/* release the partially loaded model */
+		uc_mgr_free_verb(uc_mgr);
+		if (snd_config_top(&uc_mgr->local_config) < 0 ||
+		    snd_config_top(&uc_mgr->macros) < 0)
+			err = -ENOMEM;
+	}
+
+      __end:
+	for (i = 0; i < r.fixups_count; i++)
+		free(r.fixups[i].name);
+	free(r.fixups);
+	free(b->data);
+	free(key);
+	return err;
+}
@@ -178,45 +178,25 @@ static int if_eval_regex_match(snd_use_case_mgr_t *uc_mgr, snd_config_t *eval)
 	return err == 0;
 }
 
-static int if_eval_control_exists(snd_use_case_mgr_t *uc_mgr, snd_config_t *eval)
+int uc_mgr_cond_control_exists(snd_use_case_mgr_t *uc_mgr,
+			       const char *device,
+			       const char *ctlid,
+			       const char *enumval)
 {
 	snd_ctl_t *ctl;
 	struct ctl_list *ctl_list;
-	const char *device = NULL, *ctldef, *enumval = NULL, *name;
+	const char *name;
 	snd_ctl_elem_id_t *elem_id;
 	snd_ctl_elem_info_t *elem_info;
 	snd_ctl_elem_type_t type;
-	char *s;
 	int err, i, items;
 
 	snd_ctl_elem_id_alloca(&elem_id);
 	snd_ctl_elem_info_alloca(&elem_info);
 
-	err = get_string(eval, "Device", &device);
-	if (err < 0 && err != -ENOENT) {
-		uc_error("ControlExists error (If.Condition.Device)");
-		return -EINVAL;
-	}
-
-	err = get_string(eval, "Control", &ctldef);
-	if (err < 0) {
-		uc_error("ControlExists error (If.Condition.Control)");
-		return -EINVAL;
-	}
-
-	err = get_string(eval, "ControlEnum", &enumval);
-	if (err < 0 && err != -ENOENT) {
-		uc_error("ControlExists error (If.Condition.ControlEnum)");
-		return -EINVAL;
-	}
-
-	err = uc_mgr_get_substituted_value(uc_mgr, &s, ctldef);
-	if (err < 0)
-		return err;
-	err = snd_ctl_ascii_elem_id_parse(elem_id, s);
-	free(s);
+	err = snd_ctl_ascii_elem_id_parse(elem_id, ctlid);
 	if (err < 0) {
-		uc_error("unable to parse element identificator (%s)", ctldef);
+		uc_error("unable to parse element identificator (%s)", ctlid);
 		return -EINVAL;
 	}
 
@@ -227,11 +207,7 @@ static int if_eval_control_exists(snd_use_case_mgr_t *uc_mgr, snd_config_t *eval
 			return -EINVAL;
 		}
 	} else {
-		err = uc_mgr_get_substituted_value(uc_mgr, &s, device);
-		if (err < 0)
-			return err;
-		err = uc_mgr_open_ctl(uc_mgr, &ctl_list, s, 1);
-		free(s);
+		err = uc_mgr_open_ctl(uc_mgr, &ctl_list, device, 1);
 		if (err < 0)
 			return err;
 		ctl = ctl_list->ctl;
@@ -246,30 +222,82 @@ static int if_eval_control_exists(snd_use_case_mgr_t *uc_mgr, snd_config_t *eval
 		type = snd_ctl_elem_info_get_type(elem_info);
 		if (type != SND_CTL_ELEM_TYPE_ENUMERATED)
 			return 0;
-		err = uc_mgr_get_substituted_value(uc_mgr, &s, enumval);
-		if (err < 0)
-			return err;
 		items = snd_ctl_elem_info_get_items(elem_info);
 		for (i = 0; i < items; i++) {
 			snd_ctl_elem_info_set_item(elem_info, i);
 			err = snd_ctl_elem_info(ctl, elem_info);
-			if (err < 0) {
-				free(s);
+			if (err < 0)
 				return err;
-			}
 			name = snd_ctl_elem_info_get_item_name(elem_info);
-			if (strcasecmp(name, s) == 0) {
-				free(s);
+			if (strcasecmp(name, enumval) == 0)
 				return 1;
-			}
 		}
-		free(s);
 		return 0;
 	}
 
 	return 1;
 }
 
+static int if_eval_control_exists(snd_use_case_mgr_t *uc_mgr, snd_config_t *eval)
+{
+	const char *device = NULL, *ctldef, *enumval = NULL;
+	char *s1 = NULL, *s2 = NULL, *s3 = NULL;
+	int err;
+
+	err = get_string(eval, "Device", &device);
+	if (err < 0 && err != -ENOENT) {
+		uc_error("ControlExists error (If.Condition.Device)");
+		return -EINVAL;
+	}
+
+	err = get_string(eval, "Control", &ctldef);
+	if (err < 0) {
+		uc_error("ControlExists error (If.Condition.Control)");
+		return -EINVAL;
+	}
+
+	err = get_string(eval, "ControlEnum", &enumval);
+	if (err < 0 && err != -ENOENT) {
+		uc_error("ControlExists error (If.Condition.ControlEnum)");
+		return -EINVAL;
+	}
+
+	err = uc_mgr_get_substituted_value(uc_mgr, &s2, ctldef);
+	if (err < 0)
+		return err;
+	if (device) {
+		err = uc_mgr_get_substituted_value(uc_mgr, &s1, device);
+		if (err < 0)
+			goto __end;
+	}
+	if (enumval) {
+		err = uc_mgr_get_substituted_value(uc_mgr, &s3, enumval);
+		if (err < 0)
+			goto __end;
+	}
+
+	err = uc_mgr_cond_control_exists(uc_mgr, s1, s2, s3);
+	if (err >= 0)
+		uc_mgr_cache_control_exists(uc_mgr, s1, s2, s3, err);
+      __end:
+	free(s1);
+	free(s2);
+	free(s3);
+	return err;
+}
+
+int uc_mgr_cond_path(const char *path, int amode)
+{
+	int err;
+
+#ifdef HAVE_EACCESS
+	err = eaccess(path, amode);
+#else
+	err = access(path, amode);
+#endif
+	return err ? 0 : 1;
+}
+
 static int if_eval_path(snd_use_case_mgr_t *uc_mgr, snd_config_t *eval)
 {
 	const char *path, *mode = "";
@@ -323,14 +351,11 @@ static int if_eval_path(snd_use_case_mgr_t *uc_mgr, snd_config_t *eval)
 		if (err < 0)
 			return err;
 	}
-#ifdef HAVE_EACCESS
-	err = eaccess(s, amode);
-#else
-	err = access(s, amode);
-#endif
+	err = uc_mgr_cond_path(s, amode);
+	uc_mgr_cache_path(uc_mgr, s, amode, err);
 	if (s != path)
 		free(s);
-	return err ? 0 : 1;
+	return err;
 }
 
 static int if_eval(snd_use_case_mgr_t *uc_mgr, snd_config_t *eval)
@@ -73,9 +73,13 @@ struct component_sequence {
 	int enable; /* flag to choose enable or disable list of the device */
 };
 
+struct cset_compiled;
+struct ucm_cache;
+
 struct sequence_element {
 	struct list_head list;
 	unsigned int type;
+	struct cset_compiled *compiled;	/* resolved cset, may be NULL */
 	union {
 		long sleep; /* Sleep time in microseconds if sleep element, else 0 */
 		char *cdev;
@@ -283,6 +287,16 @@ struct snd_use_case_mgr {
 	 */
 	int in_component_domain;
 	char *cdev;
+
+	/* bumped when the compiled csets may refer to stale elements */
+	unsigned int cset_generation;
+
+	/* csets postponed while a verb, device or modifier is switched */
+	struct list_head cset_plan;
+	int cset_plan_depth;
+
+	/* dependencies recorded for the parsed configuration cache */
+	struct ucm_cache *cache;
 };
 
 #define uc_error SNDERR
@@ -298,8 +312,10 @@ void uc_mgr_stdout(const char *fmt, ...);
 
 const char *uc_mgr_sysfs_root(void);
 const char *uc_mgr_config_dir(int format);
-int uc_mgr_config_load_into(int format, const char *file, snd_config_t *cfg);
-int uc_mgr_config_load(int format, const char *file, snd_config_t **cfg);
+int uc_mgr_config_load_into(snd_use_case_mgr_t *uc_mgr, int format,
+			    const char *file, snd_config_t *cfg);
+int uc_mgr_config_load(snd_use_case_mgr_t *uc_mgr, int format,
+		       const char *file, snd_config_t **cfg);
 int uc_mgr_config_load_file(snd_use_case_mgr_t *uc_mgr,  const char *file, snd_config_t **cfg);
 int uc_mgr_import_master_config(snd_use_case_mgr_t *uc_mgr);
 int uc_mgr_scan_master_configs(const char **_list[]);
@@ -311,6 +327,8 @@ int uc_mgr_rename_device(struct use_case_verb *verb, const char *src,
 
 void uc_mgr_free_dev_name_list(struct list_head *base);
 void uc_mgr_free_sequence_element(struct sequence_element *seq);
+int uc_mgr_compile_cset(struct sequence_element *seq);
+void uc_mgr_free_cset(struct cset_compiled *cset);
 void uc_mgr_free_transition_element(struct transition_sequence *seq);
 void uc_mgr_free_verb(snd_use_case_mgr_t *uc_mgr);
 void uc_mgr_free(snd_use_case_mgr_t *uc_mgr);
@@ -373,10 +391,36 @@ int uc_mgr_define_regex(snd_use_case_mgr_t *uc_mgr,
 			const char *name,
 			snd_config_t *eval);
 
+int uc_mgr_cond_control_exists(snd_use_case_mgr_t *uc_mgr,
+			       const char *device,
+			       const char *ctlid,
+			       const char *enumval);
+
+int uc_mgr_cond_path(const char *path, int amode);
+
+int uc_mgr_subst_dep_value(snd_use_case_mgr_t *uc_mgr, const char *id,
+			   const char *arg, char **rval);
+
 int uc_mgr_exec(const char *prog);
 
+void uc_mgr_cache_begin(snd_use_case_mgr_t *uc_mgr);
+void uc_mgr_cache_end(snd_use_case_mgr_t *uc_mgr);
+int uc_mgr_cache_load(snd_use_case_mgr_t *uc_mgr);
+int uc_mgr_cache_save(snd_use_case_mgr_t *uc_mgr);
+void uc_mgr_cache_file(snd_use_case_mgr_t *uc_mgr, const char *filename);
+void uc_mgr_cache_subst(snd_use_case_mgr_t *uc_mgr, const char *id,
+			const char *arg, const char *rval);
+void uc_mgr_cache_control_exists(snd_use_case_mgr_t *uc_mgr,
+				 const char *device, const char *ctlid,
+				 const char *enumval, int result);
+void uc_mgr_cache_path(snd_use_case_mgr_t *uc_mgr, const char *path,
+		       int amode, int result);
+
 /** The name of the environment variable containing the UCM directory */
 #define ALSA_CONFIG_UCM_VAR "ALSA_CONFIG_UCM"
 
 /** The name of the environment variable containing the UCM directory (new syntax) */
 #define ALSA_CONFIG_UCM2_VAR "ALSA_CONFIG_UCM2"
+
+/** The name of the environment variable containing the parsed UCM cache directory */
+#define ALSA_CONFIG_UCM2_CACHE_VAR "ALSA_CONFIG_UCM2_CACHE"
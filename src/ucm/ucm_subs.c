@@ -654,6 +654,7 @@ static int rval_evali(snd_use_case_mgr_t *uc_mgr, snd_config_t *node, const char
 		rval = fcn(uc_mgr);					\
 		idsize = sizeof(id) - 1;				\
 		allow_empty = (empty_ok);				\
+		vid = (id);						\
 		goto __rval;						\
 	}
 
@@ -662,9 +663,64 @@ static int rval_evali(snd_use_case_mgr_t *uc_mgr, snd_config_t *node, const char
 		idsize = sizeof(id) - 1;				\
 		allow_empty = (empty_ok);				\
 		fcn2 = (fcn);						\
+		vid = (id);						\
 		goto __match2;						\
 	}
 
+/*
+ * The substitutions which read the card, environment or sysfs state.
+ * Their results are dependencies of the parsed configuration cache.
+ */
+static const struct {
+	const char *id;
+	char *(*fcn)(snd_use_case_mgr_t *uc_mgr);
+	char *(*fcn2)(snd_use_case_mgr_t *uc_mgr, const char *arg);
+} subst_deps[] = {
+	{ "${ConfLibDir}", rval_conf_libdir, NULL },
+	{ "${ConfTopDir}", rval_conf_topdir, NULL },
+	{ "${CardNumber}", rval_card_number, NULL },
+	{ "${CardId}", rval_card_id, NULL },
+	{ "${CardDriver}", rval_card_driver, NULL },
+	{ "${CardName}", rval_card_name, NULL },
+	{ "${CardLongName}", rval_card_longname, NULL },
+	{ "${CardComponents}", rval_card_components, NULL },
+	{ "${env:", NULL, rval_env },
+	{ "${sys:", NULL, rval_sysfs },
+	{ "${find-card:", NULL, rval_card_lookup },
+	{ "${find-device:", NULL, rval_device_lookup },
+	{ "${CardNumberByName:", NULL, rval_card_number_by_name },
+	{ "${CardIdByName:", NULL, rval_card_id_by_name },
+};
+
+static int subst_dep_find(const char *id)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(subst_deps); i++)
+		if (strcmp(subst_deps[i].id, id) == 0)
+			return i;
+	return -ENOENT;
+}
+
+/*
+ * Evaluate one recorded substitution again
+ */
+int uc_mgr_subst_dep_value(snd_use_case_mgr_t *uc_mgr, const char *id,
+			   const char *arg, char **rval)
+{
+	int idx = subst_dep_find(id);
+
+	if (idx < 0)
+		return idx;
+	if (subst_deps[idx].fcn)
+		*rval = subst_deps[idx].fcn(uc_mgr);
+	else if (arg)
+		*rval = subst_deps[idx].fcn2(uc_mgr, arg);
+	else
+		return -EINVAL;
+	return 0;
+}
+
 /*
  * skip escaped } character (simple version)
  */
@@ -711,6 +767,7 @@ int uc_mgr_get_substituted_value(snd_use_case_mgr_t *uc_mgr,
 	size_t size, nsize, idsize, rvalsize, dpos = 0;
 	const char *tmp;
 	char *r, *nr, *rval, v2[128];
+	const char *vid, *rarg;
 	bool ignore_error, allow_empty;
 	char *(*fcn2)(snd_use_case_mgr_t *, const char *id);
 	int err;
@@ -738,6 +795,7 @@ __std:
 			goto __std;
 		}
 		fcn2 = NULL;
+		vid = rarg = NULL;
 		MATCH_VARIABLE(value, "${OpenName}", rval_open_name, false);
 		MATCH_VARIABLE(value, "${ConfLibDir}", rval_conf_libdir, false);
 		MATCH_VARIABLE(value, "${ConfTopDir}", rval_conf_topdir, false);
@@ -785,17 +843,22 @@ __match2:
 				if (tmp == NULL) {
 					uc_error("define '%s' is not reachable in this context!", v2 + 1);
 					rval = NULL;
+					vid = NULL;
 				} else {
 					rval = fcn2(uc_mgr, tmp);
+					rarg = tmp;
 				}
 			} else {
 __direct_fcn2:
 				rval = fcn2(uc_mgr, v2);
+				rarg = v2;
 			}
 			goto __rval;
 		}
 		goto __merr;
 __rval:
+		if (uc_mgr->cache && vid && subst_dep_find(vid) >= 0)
+			uc_mgr_cache_subst(uc_mgr, vid, rarg, rval);
 		if (rval == NULL || (!allow_empty && rval[0] == '\0')) {
 			free(rval);
 			if (ignore_error) {
@@ -167,6 +167,8 @@ void uc_mgr_free_ctl_list(snd_use_case_mgr_t *uc_mgr)
 		list_del(&ctl_list->list);
 		uc_mgr_free_ctl(ctl_list);
 	}
+	/* the compiled csets refer to the closed handles */
+	uc_mgr->cset_generation++;
 }
 
 static int uc_mgr_ctl_add_dev(struct ctl_list *ctl_list, const char *device)
@@ -350,7 +352,13 @@ const char *uc_mgr_config_dir(int format)
 	return path;
 }
 
-int uc_mgr_config_load_into(int format, const char *file, snd_config_t *top)
+static void config_file_cb(void *private_data, const char *filename)
+{
+	uc_mgr_cache_file(private_data, filename);
+}
+
+int uc_mgr_config_load_into(snd_use_case_mgr_t *uc_mgr, int format,
+			    const char *file, snd_config_t *top)
 {
 	FILE *fp;
 	snd_input_t *in;
@@ -370,7 +378,12 @@ int uc_mgr_config_load_into(int format, const char *file, snd_config_t *top)
 
 	default_paths[0] = uc_mgr_config_dir(format);
 	default_paths[1] = NULL;
-	err = _snd_config_load_with_include(top, in, 0, default_paths);
+	/* the <file> includes are dependencies of the cached model, too */
+	if (uc_mgr && uc_mgr->cache)
+		err = _snd_config_load_with_include_cb(top, in, 0, default_paths,
+						       config_file_cb, uc_mgr);
+	else
+		err = _snd_config_load_with_include(top, in, 0, default_paths);
 	if (err < 0) {
 		uc_error("could not load configuration file %s", file);
 		if (in)
@@ -383,7 +396,8 @@ int uc_mgr_config_load_into(int format, const char *file, snd_config_t *top)
 	return 0;
 }
 
-int uc_mgr_config_load(int format, const char *file, snd_config_t **cfg)
+int uc_mgr_config_load(snd_use_case_mgr_t *uc_mgr, int format,
+		       const char *file, snd_config_t **cfg)
 {
 	snd_config_t *top;
 	int err;
@@ -391,7 +405,7 @@ int uc_mgr_config_load(int format, const char *file, snd_config_t **cfg)
 	err = snd_config_top(&top);
 	if (err < 0)
 		return err;
-	err = uc_mgr_config_load_into(format, file, top);
+	err = uc_mgr_config_load_into(uc_mgr, format, file, top);
 	if (err < 0) {
 		snd_config_delete(top);
 		return err;
@@ -508,6 +522,7 @@ void uc_mgr_free_sequence_element(struct sequence_element *seq)
 	case SEQUENCE_ELEMENT_TYPE_CSET_BIN_FILE:
 	case SEQUENCE_ELEMENT_TYPE_CSET_TLV:
 	case SEQUENCE_ELEMENT_TYPE_CTL_REMOVE:
+		uc_mgr_free_cset(seq->compiled);
 		free(seq->data.cset);
 		break;
 	case SEQUENCE_ELEMENT_TYPE_SYSSET:
@@ -0,0 +1,121 @@
+/*
+ * alisp interpreter benchmark
+ *
+ * Loads the given script (src/conf/sndo-mixer.alisp by default) into a
+ * new interpreter instance repeatedly, then runs a generated program
+ * which sets and reads back the given number of distinct variables to
+ * exercise the object and variable hashes.
+ *
+ * Usage: alisp_bench [-l loops] [-n variables] [script]
+ */
+
+#include "config.h"
+
+#include <sys/stat.h>
+
+#include "bench.h"
+#include "../include/alisp.h"
+
+static struct bench_buf text;
+
+static void generate(int variables)
+{
+	int i;
+
+	for (i = 0; i < variables; i++)
+		bench_buf_printf(&text, "(setq var%d %d)\n(setq str%d \"value %d\")\n", i, i, i, i);
+	bench_buf_printf(&text, "(setq sum 0)\n");
+	for (i = 0; i < variables; i++)
+		bench_buf_printf(&text, "(setq sum (+ sum var%d))\n(setq last str%d)\n", i, i);
+	for (i = 0; i < variables; i++)
+		bench_buf_printf(&text, "(unsetq var%d str%d)\n", i, i);
+	bench_buf_printf(&text, "(unsetq sum last)\n");
+}
+
+static char *load_file(const char *name, size_t *size)
+{
+	struct stat st;
+	char *data;
+	FILE *fp;
+
+	if (stat(name, &st) < 0 || st.st_size <= 0) {
+		perror(name);
+		exit(EXIT_FAILURE);
+	}
+	data = malloc(st.st_size);
+	fp = fopen(name, "r");
+	if (!data || !fp || fread(data, 1, st.st_size, fp) != (size_t)st.st_size) {
+		perror(name);
+		exit(EXIT_FAILURE);
+	}
+	fclose(fp);
+	*size = st.st_size;
+	return data;
+}
+
+struct script {
+	struct alisp_cfg cfg;
+	const char *data;
+	size_t size;
+};
+
+static int interpret(void *arg)
+{
+	struct script *s = arg;
+	int err;
+
+	err = snd_input_buffer_open(&s->cfg.in, s->data, s->size);
+	if (err >= 0) {
+		err = alsa_lisp(&s->cfg, NULL);
+		snd_input_close(s->cfg.in);
+	}
+	return err;
+}
+
+static void run(const char *name, const char *data, size_t size, int loops)
+{
+	struct script s;
+	snd_output_t *out;
+	double t;
+
+	if (snd_output_buffer_open(&out) < 0) {
+		fprintf(stderr, "cannot open the output buffer\n");
+		exit(EXIT_FAILURE);
+	}
+	memset(&s, 0, sizeof(s));
+	s.cfg.out = s.cfg.eout = s.cfg.vout = s.cfg.wout = s.cfg.dout = out;
+	s.data = data;
+	s.size = size;
+	t = bench_run(name, loops, interpret, &s);
+	printf("%-8s %10.3f ms/loop\n", name, t * 1000.0 / loops);
+	snd_output_close(out);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *script = "../src/conf/sndo-mixer.alisp";
+	int c, loops = 200, variables = 2000;
+	size_t size;
+	char *data;
+
+	while ((c = bench_getopt(argc, argv, "l:n:",
+				 "[-l loops] [-n variables] [script]",
+				 &loops)) != -1) {
+		if (c == 'n')
+			variables = atoi(optarg);
+	}
+	if (variables <= 0)
+		variables = 1;
+	if (optind < argc)
+		script = argv[optind];
+
+	data = load_file(script, &size);
+	run("script", data, size, loops * 10);
+	free(data);
+
+	generate(variables);
+	printf("%d variables, %zu bytes of text\n", variables, text.len);
+	run("vars", text.data, text.len, loops / 10 + 1);
+	free(text.data);
+	return EXIT_SUCCESS;
+}
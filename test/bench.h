@@ -0,0 +1,150 @@
+/*
+ * Common scaffolding of the benchmarks
+ *
+ * The clock, the option parsing with the loop count, the timed loop,
+ * a growing buffer for the generated input and the configuration
+ * loaded from a string.  Each benchmark is a single source file, so
+ * the helpers are static; a benchmark keeps only its workload and its
+ * report.
+ */
+
+#ifndef BENCH_H_INCLUDED
+#define BENCH_H_INCLUDED
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "../include/asoundlib.h"
+
+static inline void bench_nomem(void)
+{
+	fprintf(stderr, "out of memory\n");
+	exit(EXIT_FAILURE);
+}
+
+/* monotonic time in seconds */
+static inline double bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * getopt() which handles the "-l loops" option (at least one loop) and
+ * prints the usage for the unknown options.  It returns the other
+ * options of optstring and -1 after the last option.
+ */
+static inline int bench_getopt(int argc, char *argv[], const char *optstring,
+			       const char *usage, int *loops)
+{
+	int c;
+
+	while ((c = getopt(argc, argv, optstring)) == 'l' && loops) {
+		*loops = atoi(optarg);
+		if (*loops <= 0)
+			*loops = 1;
+	}
+	if (c == '?' || c == ':') {
+		fprintf(stderr, "Usage: %s %s\n", argv[0], usage);
+		exit(EXIT_FAILURE);
+	}
+	return c;
+}
+
+/*
+ * Call fcn loops times and return the elapsed seconds.  A negative
+ * return value of fcn stops the benchmark.
+ */
+static inline double bench_run(const char *name, int loops,
+			       int (*fcn)(void *arg), void *arg)
+{
+	double t;
+	int l, err;
+
+	t = bench_now();
+	for (l = 0; l < loops; l++) {
+		err = fcn(arg);
+		if (err < 0) {
+			fprintf(stderr, "%s failed: %s\n", name, snd_strerror(err));
+			exit(EXIT_FAILURE);
+		}
+	}
+	return bench_now() - t;
+}
+
+/* generated input */
+struct bench_buf {
+	char *data;
+	size_t len;
+	size_t size;
+};
+
+static inline void bench_buf_reserve(struct bench_buf *b, size_t len)
+{
+	while (b->len + len >= b->size) {
+		b->size = b->size ? b->size * 2 : 64 * 1024;
+		b->data = realloc(b->data, b->size);
+		if (!b->data)
+			bench_nomem();
+	}
+}
+
+static inline void bench_buf_byte(struct bench_buf *b, int c)
+{
+	bench_buf_reserve(b, 1);
+	b->data[b->len++] = c;
+}
+
+static inline void bench_buf_printf(struct bench_buf *b, const char *fmt, ...)
+	__attribute__ ((format (printf, 2, 3)));
+
+static inline void bench_buf_printf(struct bench_buf *b, const char *fmt, ...)
+{
+	va_list ap;
+	int len;
+
+	va_start(ap, fmt);
+	len = vsnprintf(NULL, 0, fmt, ap);
+	va_end(ap);
+	if (len < 0)
+		bench_nomem();
+	bench_buf_reserve(b, len);
+	va_start(ap, fmt);
+	vsnprintf(b->data + b->len, b->size - b->len, fmt, ap);
+	va_end(ap);
+	b->len += len;
+}
+
+/* a configuration tree parsed from a string */
+static inline snd_config_t *bench_config(const char *str)
+{
+	snd_config_t *conf;
+	snd_input_t *in;
+	int err;
+
+	err = snd_config_top(&conf);
+	if (err < 0)
+		goto __error;
+	err = snd_input_buffer_open(&in, str, strlen(str));
+	if (err >= 0) {
+		err = snd_config_load(conf, in);
+		snd_input_close(in);
+	}
+	if (err < 0) {
+		snd_config_delete(conf);
+		goto __error;
+	}
+	return conf;
+
+ __error:
+	fprintf(stderr, "cannot load the configuration: %s\n", snd_strerror(err));
+	exit(EXIT_FAILURE);
+}
+
+#endif
@@ -0,0 +1,188 @@
+/*
+ * Configuration parser throughput benchmark
+ *
+ * Parses every *.conf file below the given directory (the shipped
+ * src/conf tree by default) from a stdio file and from a memory buffer
+ * and reports the parse throughput.  The <confdir:...> includes are
+ * resolved against the same directory.
+ *
+ * Usage: conf_bench [-l loops] [confdir]
+ */
+
+#include "config.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "bench.h"
+
+struct conf_file {
+	char *name;
+	char *data;
+	size_t size;
+};
+
+static struct conf_file *files;
+static size_t files_count, files_alloc;
+
+static void add_file(const char *name)
+{
+	struct conf_file *f;
+	struct stat st;
+	FILE *fp;
+
+	if (stat(name, &st) < 0 || st.st_size <= 0)
+		return;
+	if (files_count >= files_alloc) {
+		files_alloc = files_alloc ? files_alloc * 2 : 64;
+		files = realloc(files, files_alloc * sizeof(*files));
+		if (!files)
+			goto __nomem;
+	}
+	f = &files[files_count];
+	f->name = strdup(name);
+	f->size = st.st_size;
+	f->data = malloc(f->size);
+	if (!f->name || !f->data)
+		goto __nomem;
+	fp = fopen(name, "r");
+	if (!fp || fread(f->data, 1, f->size, fp) != f->size) {
+		perror(name);
+		exit(EXIT_FAILURE);
+	}
+	fclose(fp);
+	files_count++;
+	return;
+
+      __nomem:
+	fprintf(stderr, "out of memory\n");
+	exit(EXIT_FAILURE);
+}
+
+static void scan_dir(const char *dir)
+{
+	char path[PATH_MAX];
+	struct dirent *d;
+	struct stat st;
+	size_t len;
+	DIR *dp;
+
+	dp = opendir(dir);
+	if (!dp) {
+		perror(dir);
+		exit(EXIT_FAILURE);
+	}
+	while ((d = readdir(dp)) != NULL) {
+		if (d->d_name[0] == '.')
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", dir, d->d_name);
+		if (stat(path, &st) < 0)
+			continue;
+		if (S_ISDIR(st.st_mode)) {
+			scan_dir(path);
+			continue;
+		}
+		len = strlen(d->d_name);
+		if (len > 5 && strcmp(d->d_name + len - 5, ".conf") == 0)
+			add_file(path);
+	}
+	closedir(dp);
+}
+
+static void silent_error(const char *file ATTRIBUTE_UNUSED, int line ATTRIBUTE_UNUSED,
+			 const char *function ATTRIBUTE_UNUSED, int err ATTRIBUTE_UNUSED,
+			 const char *fmt ATTRIBUTE_UNUSED, ...)
+{
+}
+
+static int parse(struct conf_file *f, int from_file)
+{
+	snd_config_t *top;
+	snd_input_t *in;
+	int err;
+
+	if (from_file)
+		err = snd_input_stdio_open(&in, f->name, "r");
+	else
+		err = snd_input_buffer_open(&in, f->data, f->size);
+	if (err < 0)
+		return err;
+	err = snd_config_top(&top);
+	if (err >= 0) {
+		err = snd_config_load(top, in);
+		snd_config_delete(top);
+	}
+	snd_input_close(in);
+	return err;
+}
+
+struct parse_pass {
+	int from_file;
+	size_t bytes;
+	size_t failed;
+};
+
+static int parse_all(void *arg)
+{
+	struct parse_pass *p = arg;
+	size_t i;
+
+	for (i = 0; i < files_count; i++) {
+		if (parse(&files[i], p->from_file) < 0) {
+			p->failed++;
+			continue;
+		}
+		p->bytes += files[i].size;
+	}
+	return 0;
+}
+
+static void run(const char *name, int from_file, int loops)
+{
+	struct parse_pass p = { .from_file = from_file };
+	double t;
+
+	t = bench_run(name, loops, parse_all, &p);
+	printf("%-8s %8.3f ms/loop %8.1f MB/s", name, t * 1000.0 / loops,
+	       p.bytes / t / 1e6);
+	if (p.failed)
+		printf(" (%zu failed)", p.failed / loops);
+	printf("\n");
+}
+
+int main(int argc, char *argv[])
+{
+	const char *dir = "../src/conf";
+	char topdir[PATH_MAX];
+	size_t i, total = 0;
+	int loops = 50;
+
+	while (bench_getopt(argc, argv, "l:", "[-l loops] [confdir]", &loops) != -1)
+		;
+	if (optind < argc)
+		dir = argv[optind];
+	/* resolve <confdir:...> against the scanned tree */
+	if (realpath(dir, topdir))
+		setenv("ALSA_CONFIG_DIR", topdir, 0);
+
+	scan_dir(dir);
+	if (files_count == 0) {
+		fprintf(stderr, "no configuration files in %s\n", dir);
+		return EXIT_FAILURE;
+	}
+	for (i = 0; i < files_count; i++)
+		total += files[i].size;
+	printf("%zu files, %zu bytes, %d loops\n", files_count, total, loops);
+
+	/* silence the errors of the files which need a runtime context */
+	snd_lib_error_set_handler(silent_error);
+	run("file", 1, loops);
+	run("buffer", 0, loops);
+
+	for (i = 0; i < files_count; i++) {
+		free(files[i].name);
+		free(files[i].data);
+	}
+	free(files);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,407 @@
+/*
+ * Control remap plugin lookup benchmark
+ *
+ * Stacks the remap plugin over an external control plugin with the given
+ * count of integer controls, a quarter of them renamed and a map control
+ * per sixteen child controls, and measures the element read throughput
+ * through the remap handle, compared to reading the child controls
+ * directly. The map controls are read with and without the events
+ * subscribed; only hw children are cached, so both should be the same
+ * here, and a child change announced on the poll descriptor must be
+ * visible at once.
+ *
+ * Usage: ctl_remap_bench [-l loops] [count...]
+ */
+
+#include "config.h"
+
+#include "bench.h"
+#include "../include/control_external.h"
+#include "../include/control_plugin.h"
+
+struct bench_ctl {
+	snd_ctl_ext_t ext;
+	unsigned int count;
+	long *values;
+};
+
+static int bench_elem_count(snd_ctl_ext_t *ext)
+{
+	struct bench_ctl *b = ext->private_data;
+
+	return b->count;
+}
+
+static int bench_elem_list(snd_ctl_ext_t *ext, unsigned int offset,
+			   snd_ctl_elem_id_t *id)
+{
+	char name[44];
+
+	snprintf(name, sizeof(name), "Ctl %u Playback Volume", offset);
+	snd_ctl_elem_id_set_interface(id, SND_CTL_ELEM_IFACE_MIXER);
+	snd_ctl_elem_id_set_name(id, name);
+	return 0;
+}
+
+static snd_ctl_ext_key_t bench_find_elem(snd_ctl_ext_t *ext,
+					 const snd_ctl_elem_id_t *id)
+{
+	struct bench_ctl *b = ext->private_data;
+	unsigned int numid = snd_ctl_elem_id_get_numid(id), idx;
+
+	if (numid > 0 && numid <= b->count)
+		return numid - 1;
+	if (sscanf(snd_ctl_elem_id_get_name(id), "Ctl %u ", &idx) == 1 &&
+	    idx < b->count)
+		return idx;
+	return SND_CTL_EXT_KEY_NOT_FOUND;
+}
+
+static int bench_get_attribute(snd_ctl_ext_t *ext ATTRIBUTE_UNUSED,
+			       snd_ctl_ext_key_t key ATTRIBUTE_UNUSED,
+			       int *type, unsigned int *acc, unsigned int *count)
+{
+	*type = SND_CTL_ELEM_TYPE_INTEGER;
+	*acc = SND_CTL_EXT_ACCESS_READWRITE;
+	*count = 2;
+	return 0;
+}
+
+static int bench_get_integer_info(snd_ctl_ext_t *ext ATTRIBUTE_UNUSED,
+				  snd_ctl_ext_key_t key ATTRIBUTE_UNUSED,
+				  long *imin, long *imax, long *istep)
+{
+	*imin = 0;
+	*imax = 100;
+	*istep = 1;
+	return 0;
+}
+
+static int bench_read_integer(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key,
+			      long *value)
+{
+	struct bench_ctl *b = ext->private_data;
+
+	value[0] = value[1] = b->values[key];
+	return 0;
+}
+
+static int bench_write_integer(snd_ctl_ext_t *ext, snd_ctl_ext_key_t key,
+			       long *value)
+{
+	struct bench_ctl *b = ext->private_data;
+
+	if (b->values[key] == value[0])
+		return 0;
+	b->values[key] = value[0];
+	return 1;
+}
+
+static const snd_ctl_ext_callback_t bench_callback = {
+	.elem_count = bench_elem_count,
+	.elem_list = bench_elem_list,
+	.find_elem = bench_find_elem,
+	.get_attribute = bench_get_attribute,
+	.get_integer_info = bench_get_integer_info,
+	.read_integer = bench_read_integer,
+	.write_integer = bench_write_integer,
+};
+
+static int add_string(snd_config_t *parent, const char *id, const char *val)
+{
+	snd_config_t *n;
+	int err;
+
+	err = snd_config_imake_string(&n, id, val);
+	if (err < 0)
+		return err;
+	return snd_config_add(parent, n);
+}
+
+static int add_compound(snd_config_t *parent, const char *id, snd_config_t **n)
+{
+	int err;
+
+	err = snd_config_make_compound(n, id, 0);
+	if (err < 0)
+		return err;
+	return snd_config_add(parent, *n);
+}
+
+static int make_config(unsigned int count, snd_config_t **remap,
+		       snd_config_t **map)
+{
+	snd_config_t *m, *c, *v, *n;
+	char child[64], app[64];
+	unsigned int i, j;
+	int err;
+
+	err = snd_config_make_compound(remap, "remap", 0);
+	if (err < 0)
+		return err;
+	err = snd_config_make_compound(map, "map", 0);
+	if (err < 0)
+		return err;
+	for (i = 0; i < count; i += 4) {
+		snprintf(child, sizeof(child), "name='Ctl %u Playback Volume'", i);
+		snprintf(app, sizeof(app), "name='App %u Playback Volume'", i);
+		err = add_string(*remap, child, app);
+		if (err < 0)
+			return err;
+	}
+	for (i = 1; i + 8 < count; i += 16) {
+		snprintf(app, sizeof(app), "name='Map %u Playback Volume'", i);
+		err = add_compound(*map, app, &m);
+		if (err < 0)
+			return err;
+		for (j = 0; j < 2; j++) {
+			snprintf(child, sizeof(child),
+				 "name='Ctl %u Playback Volume'", i + j * 8);
+			err = add_compound(m, child, &c);
+			if (err < 0)
+				return err;
+			err = add_compound(c, "vindex", &v);
+			if (err < 0)
+				return err;
+			snprintf(app, sizeof(app), "%u", j);
+			err = snd_config_imake_integer(&n, app, 0);
+			if (err < 0)
+				return err;
+			err = snd_config_add(v, n);
+			if (err < 0)
+				return err;
+		}
+	}
+	return 0;
+}
+
+struct read_pass {
+	snd_ctl_t *ctl;
+	const unsigned int *numids;
+	unsigned int used;
+	snd_ctl_elem_value_t *val;
+	snd_ctl_elem_id_t *id;
+};
+
+static int read_all(void *arg)
+{
+	struct read_pass *r = arg;
+	unsigned int i;
+	int err;
+
+	for (i = 0; i < r->used; i++) {
+		snd_ctl_elem_id_clear(r->id);
+		snd_ctl_elem_id_set_numid(r->id, r->numids[i]);
+		snd_ctl_elem_value_set_id(r->val, r->id);
+		err = snd_ctl_elem_read(r->ctl, r->val);
+		if (err < 0) {
+			fprintf(stderr, "read of numid %u failed\n",
+				r->numids[i]);
+			return err;
+		}
+	}
+	return 0;
+}
+
+/* the time per read in ns */
+static double read_loop(snd_ctl_t *ctl, const unsigned int *numids,
+			unsigned int used, int loops)
+{
+	struct read_pass r = { .ctl = ctl, .numids = numids, .used = used };
+
+	snd_ctl_elem_value_alloca(&r.val);
+	snd_ctl_elem_id_alloca(&r.id);
+	return bench_run("read", loops, read_all, &r) * 1e9 /
+		((double)loops * used);
+}
+
+/* write through a renamed and a map control, check the child values */
+static int check(snd_ctl_t *ctl, struct bench_ctl *b)
+{
+	snd_ctl_elem_value_t *val;
+	snd_ctl_elem_info_t *info;
+	int err;
+
+	snd_ctl_elem_value_alloca(&val);
+	snd_ctl_elem_info_alloca(&info);
+	snd_ctl_elem_value_set_interface(val, SND_CTL_ELEM_IFACE_MIXER);
+	snd_ctl_elem_value_set_name(val, "App 4 Playback Volume");
+	snd_ctl_elem_value_set_integer(val, 0, 11);
+	snd_ctl_elem_value_set_integer(val, 1, 11);
+	err = snd_ctl_elem_write(ctl, val);
+	if (err < 0)
+		return err;
+	snd_ctl_elem_value_clear(val);
+	snd_ctl_elem_value_set_interface(val, SND_CTL_ELEM_IFACE_MIXER);
+	snd_ctl_elem_value_set_name(val, "Map 1 Playback Volume");
+	/* the map type is known after the info call */
+	snd_ctl_elem_info_set_interface(info, SND_CTL_ELEM_IFACE_MIXER);
+	snd_ctl_elem_info_set_name(info, "Map 1 Playback Volume");
+	err = snd_ctl_elem_info(ctl, info);
+	if (err < 0)
+		return err;
+	snd_ctl_elem_value_set_integer(val, 0, 22);
+	snd_ctl_elem_value_set_integer(val, 1, 33);
+	err = snd_ctl_elem_write(ctl, val);
+	if (err < 0)
+		return err;
+	if (b->values[4] != 11 || b->values[1] != 22 || b->values[9] != 33) {
+		fprintf(stderr, "unexpected child values %ld %ld %ld\n",
+			b->values[4], b->values[1], b->values[9]);
+		return -EIO;
+	}
+	return 0;
+}
+
+/* a child change not yet read as an event must bypass the cache */
+static int check_cached(snd_ctl_t *ctl, struct bench_ctl *b, int event_fd)
+{
+	snd_ctl_elem_value_t *val;
+	char c = 0;
+	int err;
+
+	snd_ctl_elem_value_alloca(&val);
+	snd_ctl_elem_value_set_interface(val, SND_CTL_ELEM_IFACE_MIXER);
+	snd_ctl_elem_value_set_name(val, "Map 1 Playback Volume");
+	b->values[1] = 44;
+	if (write(event_fd, &c, 1) != 1)
+		return -errno;
+	err = snd_ctl_elem_read(ctl, val);
+	if (read(b->ext.poll_fd, &c, 1) != 1)
+		return -errno;
+	if (err < 0)
+		return err;
+	if (snd_ctl_elem_value_get_integer(val, 0) != 44) {
+		fprintf(stderr, "stale cached value %ld\n",
+			snd_ctl_elem_value_get_integer(val, 0));
+		return -EIO;
+	}
+	return 0;
+}
+
+static int run(unsigned int count, int loops)
+{
+	struct bench_ctl b;
+	snd_config_t *remap, *map;
+	snd_ctl_t *ctl;
+	snd_ctl_elem_list_t *list;
+	snd_ctl_elem_info_t *info;
+	unsigned int i, used, maps, *numids, *child_numids;
+	double t_child, t_remap, t_map, t_map_cached;
+	int err, fds[2];
+
+	memset(&b, 0, sizeof(b));
+	b.count = count;
+	b.values = calloc(count, sizeof(*b.values));
+	if (!b.values)
+		return -ENOMEM;
+	b.ext.version = SND_CTL_EXT_VERSION;
+	strcpy(b.ext.id, "bench");
+	strcpy(b.ext.name, "Bench");
+	if (pipe(fds) < 0)
+		return -errno;
+	b.ext.poll_fd = fds[0];
+	b.ext.callback = &bench_callback;
+	b.ext.private_data = &b;
+	err = snd_ctl_ext_create(&b.ext, "bench", 0);
+	if (err < 0)
+		return err;
+	err = make_config(count, &remap, &map);
+	if (err < 0)
+		return err;
+	err = snd_ctl_remap_open(&ctl, "remap", remap, map, b.ext.handle, 0);
+	if (err < 0)
+		return err;
+
+	snd_ctl_elem_list_alloca(&list);
+	snd_ctl_elem_info_alloca(&info);
+	err = snd_ctl_elem_list(ctl, list);
+	if (err < 0)
+		return err;
+	err = snd_ctl_elem_list_alloc_space(list, snd_ctl_elem_list_get_count(list));
+	if (err < 0)
+		return err;
+	err = snd_ctl_elem_list(ctl, list);
+	if (err < 0)
+		return err;
+	used = snd_ctl_elem_list_get_used(list);
+	numids = calloc(used, sizeof(*numids));
+	child_numids = calloc(count, sizeof(*child_numids));
+	if (!numids || !child_numids)
+		return -ENOMEM;
+	for (i = 0; i < used; i++)
+		numids[i] = snd_ctl_elem_list_get_numid(list, i);
+	for (i = 0; i < count; i++)
+		child_numids[i] = i + 1;
+	/* the map controls follow the child ones */
+	maps = used - count;
+	for (i = count; i < used; i++) {
+		snd_ctl_elem_info_clear(info);
+		snd_ctl_elem_info_set_numid(info, numids[i]);
+		err = snd_ctl_elem_info(ctl, info);
+		if (err < 0)
+			return err;
+	}
+
+	if (count >= 16) {
+		err = check(ctl, &b);
+		if (err < 0)
+			return err;
+	}
+	t_child = read_loop(b.ext.handle, child_numids, count, loops);
+	t_remap = read_loop(ctl, numids, used, loops);
+	printf("%6u controls: child %8.1f ns/read, remap %8.1f ns/read",
+	       count, t_child, t_remap);
+	if (maps > 0) {
+		t_map = read_loop(ctl, numids + count, maps, loops);
+		err = snd_ctl_subscribe_events(ctl, 1);
+		if (err < 0)
+			return err;
+		t_map_cached = read_loop(ctl, numids + count, maps, loops);
+		err = check_cached(ctl, &b, fds[1]);
+		if (err < 0)
+			return err;
+		printf(", map %8.1f ns/read, subscribed %8.1f ns/read",
+		       t_map, t_map_cached);
+	}
+	printf("\n");
+
+	free(numids);
+	free(child_numids);
+	snd_ctl_elem_list_free_space(list);
+	snd_ctl_close(ctl);
+	snd_config_delete(remap);
+	snd_config_delete(map);
+	free(b.values);
+	close(fds[0]);
+	close(fds[1]);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	static const unsigned int counts[] = { 16, 128, 1024, 4096 };
+	unsigned int i;
+	int err, loops = 20;
+
+	while (bench_getopt(argc, argv, "l:", "[-l loops] [count...]", &loops) != -1)
+		;
+	if (optind < argc) {
+		for (; optind < argc; optind++) {
+			err = run(atoi(argv[optind]), loops);
+			if (err < 0)
+				goto __error;
+		}
+		return EXIT_SUCCESS;
+	}
+	for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+		err = run(counts[i], loops);
+		if (err < 0)
+			goto __error;
+	}
+	return EXIT_SUCCESS;
+
+ __error:
+	fprintf(stderr, "benchmark failed: %s\n", snd_strerror(err));
+	return EXIT_FAILURE;
+}
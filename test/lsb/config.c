@@ -283,6 +283,40 @@ static void test_copy(void)
 	ALSA_CHECK(snd_config_delete(c3));
 }
 
+static void test_copy_lifetime(void)
+{
+	snd_config_t *c1, *c2, *c3, *n;
+	const char *id, *str;
+
+	/* a copy and its strings outlive the source tree */
+	ALSA_CHECK(snd_config_load_string(&c1, "a { b 'x' c 1 }", 0));
+	ALSA_CHECK(snd_config_search(c1, "a", &n));
+	ALSA_CHECK(snd_config_copy(&c2, n));
+	ALSA_CHECK(snd_config_delete(c1));
+	ALSA_CHECK(snd_config_search(c2, "b", &n));
+	ALSA_CHECK(snd_config_get_string(n, &str));
+	TEST_CHECK(strcmp(str, "x") == 0);
+
+	/* substitute and move nodes between trees */
+	ALSA_CHECK(snd_config_load_string(&c3, "d 'y' e { f 2 }", 0));
+	ALSA_CHECK(snd_config_remove(n));
+	ALSA_CHECK(snd_config_search(c3, "d", &c1));
+	ALSA_CHECK(snd_config_substitute(c1, n));
+	ALSA_CHECK(snd_config_delete(c2));
+	ALSA_CHECK(snd_config_get_id(c1, &id));
+	TEST_CHECK(strcmp(id, "b") == 0);
+	ALSA_CHECK(snd_config_get_string(c1, &str));
+	TEST_CHECK(strcmp(str, "x") == 0);
+	ALSA_CHECK(snd_config_search(c3, "e", &n));
+	ALSA_CHECK(snd_config_remove(n));
+	ALSA_CHECK(snd_config_delete(c3));
+	ALSA_CHECK(snd_config_set_id(n, "g"));
+	ALSA_CHECK(snd_config_search(n, "f", &c1));
+	ALSA_CHECK(snd_config_get_id(c1, &id));
+	TEST_CHECK(strcmp(id, "f") == 0);
+	ALSA_CHECK(snd_config_delete(n));
+}
+
 static void test_make_integer(void)
 {
 	snd_config_t *c;
@@ -598,6 +632,55 @@ static void test_evaluate_string(void)
 	}
 }
 
+static void test_search_definition(void)
+{
+	const char *text =
+		"pcm.a {\n"
+		"	@args [ X ]\n"
+		"	@args.X {\n"
+		"		type string\n"
+		"		default { @func getenv vars [ ALSA_TEST_DEF ] default 'x' }\n"
+		"	}\n"
+		"	v $X\n"
+		"}\n";
+	snd_config_t *top, *c, *n;
+	unsigned long hits, hits2;
+	const char *str;
+
+	unsetenv("ALSA_TEST_DEF");
+	ALSA_CHECK(snd_config_load_string(&top, text, 0));
+	ALSA_CHECK(snd_config_search_definition(top, "pcm", "a", &c));
+	ALSA_CHECK(snd_config_delete(c));
+	ALSA_CHECK(snd_config_search_definition_stats(&hits, NULL));
+	ALSA_CHECK(snd_config_search_definition(top, "pcm", "a", &c));
+	ALSA_CHECK(snd_config_search_definition_stats(&hits2, NULL));
+	TEST_CHECK(hits2 > hits);
+	ALSA_CHECK(snd_config_search(c, "v", &n));
+	ALSA_CHECK(snd_config_get_string(n, &str));
+	TEST_CHECK(strcmp(str, "x") == 0);
+	ALSA_CHECK(snd_config_delete(c));
+
+	/* a changed environment variable is expanded again */
+	setenv("ALSA_TEST_DEF", "y", 1);
+	ALSA_CHECK(snd_config_search_definition(top, "pcm", "a", &c));
+	ALSA_CHECK(snd_config_search(c, "v", &n));
+	ALSA_CHECK(snd_config_get_string(n, &str));
+	TEST_CHECK(strcmp(str, "y") == 0);
+	ALSA_CHECK(snd_config_delete(c));
+
+	/* and so is a changed tree */
+	ALSA_CHECK(snd_config_search(top, "pcm.a.v", &n));
+	ALSA_CHECK(snd_config_set_string(n, "z"));
+	ALSA_CHECK(snd_config_search_definition(top, "pcm", "a", &c));
+	ALSA_CHECK(snd_config_search(c, "v", &n));
+	ALSA_CHECK(snd_config_get_string(n, &str));
+	TEST_CHECK(strcmp(str, "z") == 0);
+	ALSA_CHECK(snd_config_delete(c));
+	TEST_CHECK(snd_config_search_definition(top, "pcm", "b", &c) == -ENOENT);
+	ALSA_CHECK(snd_config_delete(top));
+	unsetenv("ALSA_TEST_DEF");
+}
+
 static void test_load_string(void)
 {
 	const char **cfg, *configs[] = {
@@ -625,6 +708,7 @@ int main(void)
 	test_add();
 	test_delete();
 	test_copy();
+	test_copy_lifetime();
 	test_make_integer();
 	test_make_integer64();
 	test_make_string();
@@ -645,6 +729,7 @@ int main(void)
 	test_iterators();
 	test_for_each();
 	test_evaluate_string();
+	test_search_definition();
 	test_load_string();
 	return TEST_EXIT_CODE();
 }
@@ -359,6 +359,99 @@ static void test_encode_byte(void)
 	snd_midi_event_free(midi_event);
 }
 
+static void test_encode_bulk(void)
+{
+	static const unsigned char stream[] =
+		"\x90\x3c\x40\x3e\x40"		/* note on + running status */
+		"\xb1\x07\xf8\x64"		/* realtime inside a message */
+		"\x0a\x20"			/* running status */
+		"\xf0\x7e\x7f\x06\x01\xf7"	/* sysex */
+		"\xe2\x00\x40"
+		"\xc3";				/* incomplete */
+	snd_midi_event_t *midi_event;
+	snd_seq_event_t evs[8];
+	long n, consumed;
+
+	if (ALSA_CHECK(snd_midi_event_new(256, &midi_event)) < 0)
+		return;
+
+	memset(evs, 0, sizeof(evs));
+	n = snd_midi_event_encode_bulk(midi_event, stream, sizeof(stream) - 1,
+				       evs, 8, &consumed);
+	TEST_CHECK(n == 6);
+	TEST_CHECK(consumed == 17);
+	TEST_CHECK(evs[0].type == SND_SEQ_EVENT_NOTEON);
+	TEST_CHECK(evs[0].data.note.note == 0x3c);
+	TEST_CHECK(evs[1].type == SND_SEQ_EVENT_NOTEON);
+	TEST_CHECK(evs[1].data.note.note == 0x3e);
+	TEST_CHECK(evs[1].data.note.velocity == 0x40);
+	TEST_CHECK(evs[2].type == SND_SEQ_EVENT_CLOCK);
+	TEST_CHECK(evs[3].type == SND_SEQ_EVENT_CONTROLLER);
+	TEST_CHECK(evs[3].data.control.channel == 1);
+	TEST_CHECK(evs[3].data.control.param == 7);
+	TEST_CHECK(evs[3].data.control.value == 0x64);
+	TEST_CHECK(evs[4].type == SND_SEQ_EVENT_CONTROLLER);
+	TEST_CHECK(evs[4].data.control.param == 10);
+	TEST_CHECK(evs[4].data.control.value == 0x20);
+	/* stops after sysex */
+	TEST_CHECK(evs[5].type == SND_SEQ_EVENT_SYSEX);
+	TEST_CHECK(evs[5].data.ext.len == 6);
+
+	n = snd_midi_event_encode_bulk(midi_event, stream + consumed,
+				       sizeof(stream) - 1 - consumed, evs, 8, &consumed);
+	TEST_CHECK(n == 1);
+	TEST_CHECK(consumed == 4);
+	TEST_CHECK(evs[0].type == SND_SEQ_EVENT_PITCHBEND);
+	TEST_CHECK(evs[0].data.control.channel == 2);
+	TEST_CHECK(evs[0].data.control.value == 0);
+
+	/* the array size limits the encoding */
+	snd_midi_event_reset_encode(midi_event);
+	n = snd_midi_event_encode_bulk(midi_event, stream, sizeof(stream) - 1,
+				       evs, 1, &consumed);
+	TEST_CHECK(n == 1);
+	TEST_CHECK(consumed == 3);
+
+	snd_midi_event_free(midi_event);
+}
+
+static void test_decode_bulk(void)
+{
+	snd_midi_event_t *midi_event;
+	snd_seq_event_t evs[4];
+	unsigned char buf[50];
+	long count, consumed;
+
+	if (ALSA_CHECK(snd_midi_event_new(256, &midi_event)) < 0)
+		return;
+
+	snd_seq_ev_clear(&evs[0]);
+	snd_seq_ev_set_noteon(&evs[0], 1, 2, 3);
+	snd_seq_ev_clear(&evs[1]);
+	evs[1].type = SND_SEQ_EVENT_ECHO;
+	snd_seq_ev_clear(&evs[2]);
+	snd_seq_ev_set_noteon(&evs[2], 1, 4, 5);
+	snd_seq_ev_clear(&evs[3]);
+	snd_seq_ev_set_controller(&evs[3], 2, 7, 100);
+
+	count = snd_midi_event_decode_bulk(midi_event, buf, sizeof(buf), evs, 4, &consumed);
+	TEST_CHECK(consumed == 4);
+	TEST_CHECK(BUF_MATCHES("9102030405b20764"));
+
+	/* running status is kept over a short buffer */
+	snd_midi_event_reset_decode(midi_event);
+	count = snd_midi_event_decode_bulk(midi_event, buf, 5, evs, 4, &consumed);
+	TEST_CHECK(consumed == 3);
+	TEST_CHECK(BUF_MATCHES("9102030405"));
+	count = snd_midi_event_decode_bulk(midi_event, buf, 2, evs + 3, 1, &consumed);
+	TEST_CHECK(count == -ENOMEM);
+	count = snd_midi_event_decode_bulk(midi_event, buf, 3, evs + 3, 1, &consumed);
+	TEST_CHECK(consumed == 1);
+	TEST_CHECK(BUF_MATCHES("b20764"));
+
+	snd_midi_event_free(midi_event);
+}
+
 int main(void)
 {
 	test_decode();
@@ -367,5 +460,7 @@ int main(void)
 	test_reset_encode();
 	test_encode_byte();
 	test_init();
+	test_encode_bulk();
+	test_decode_bulk();
 	return TEST_EXIT_CODE();
 }
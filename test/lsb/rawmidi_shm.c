@@ -0,0 +1,129 @@
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include "test.h"
+
+static char ring_name[32];
+
+/* opens the input or the output side of the test ring */
+static int open_ring(snd_rawmidi_t **inputp, snd_rawmidi_t **outputp, int mode)
+{
+	char conf_str[128];
+	snd_config_t *conf;
+	snd_input_t *input;
+	int err;
+
+	snprintf(conf_str, sizeof(conf_str),
+		 "rawmidi.test { type shm ring \"%s\" size 256 }", ring_name);
+	err = snd_config_top(&conf);
+	if (err < 0)
+		return err;
+	err = snd_input_buffer_open(&input, conf_str, strlen(conf_str));
+	if (err >= 0) {
+		err = snd_config_load(conf, input);
+		snd_input_close(input);
+	}
+	if (err >= 0)
+		err = snd_rawmidi_open_lconf(inputp, outputp, "test", mode, conf);
+	snd_config_delete(conf);
+	return err;
+}
+
+static int ring_exists(void)
+{
+	char path[64];
+
+	snprintf(path, sizeof(path), "/dev/shm/alsa-rawmidi-%s", ring_name);
+	return access(path, F_OK) == 0;
+}
+
+/* polls a handle without waiting, returns the translated events */
+static unsigned short poll_now(snd_rawmidi_t *rmidi)
+{
+	struct pollfd pfd;
+	unsigned short revents = 0;
+
+	if (snd_rawmidi_poll_descriptors(rmidi, &pfd, 1) != 1)
+		return 0;
+	if (poll(&pfd, 1, 0) < 0)
+		return 0;
+	if (snd_rawmidi_poll_descriptors_revents(rmidi, &pfd, 1, &revents) < 0)
+		return 0;
+	return revents;
+}
+
+static void test_round_trip(void)
+{
+	snd_rawmidi_t *in, *out, *in2;
+	unsigned char buf[64];
+	ssize_t n;
+
+	if (ALSA_CHECK(open_ring(NULL, &out, 0)) < 0)
+		return;
+	if (ALSA_CHECK(open_ring(&in, NULL, SND_RAWMIDI_NONBLOCK)) < 0) {
+		snd_rawmidi_close(out);
+		return;
+	}
+	/* a single reader per ring */
+	TEST_CHECK(open_ring(&in2, NULL, 0) == -EBUSY);
+
+	TEST_CHECK(snd_rawmidi_read(in, buf, sizeof(buf)) == -EAGAIN);
+	TEST_CHECK(!(poll_now(in) & POLLIN));
+
+	TEST_CHECK(snd_rawmidi_write(out, "\x90\x3c\x7f", 3) == 3);
+	TEST_CHECK(snd_rawmidi_write(out, "\x80\x3c\x00", 3) == 3);
+	TEST_CHECK(poll_now(in) & POLLIN);
+	n = snd_rawmidi_read(in, buf, sizeof(buf));
+	TEST_CHECK(n == 6);
+	TEST_CHECK(n == 6 && memcmp(buf, "\x90\x3c\x7f\x80\x3c\x00", 6) == 0);
+	TEST_CHECK(snd_rawmidi_read(in, buf, sizeof(buf)) == -EAGAIN);
+
+	snd_rawmidi_close(in);
+	snd_rawmidi_close(out);
+	TEST_CHECK(!ring_exists());
+}
+
+static void test_poll_output(void)
+{
+	snd_rawmidi_t *in, *out;
+	unsigned char buf[64];
+	ssize_t n, total = 0;
+
+	if (ALSA_CHECK(open_ring(&in, NULL, SND_RAWMIDI_NONBLOCK)) < 0)
+		return;
+	if (ALSA_CHECK(open_ring(NULL, &out, SND_RAWMIDI_NONBLOCK)) < 0) {
+		snd_rawmidi_close(in);
+		return;
+	}
+	memset(buf, 0x7f, sizeof(buf));
+	TEST_CHECK(poll_now(out) & POLLOUT);
+
+	/* fill the ring, then the output must not be writable */
+	while ((n = snd_rawmidi_write(out, buf, sizeof(buf))) > 0)
+		total += n;
+	TEST_CHECK(n == -EAGAIN);
+	TEST_CHECK(total == 256);
+	TEST_CHECK(!(poll_now(out) & POLLOUT));
+	TEST_CHECK(!(poll_now(out) & POLLOUT));
+
+	/* reading wakes the writer */
+	TEST_CHECK(snd_rawmidi_read(in, buf, 16) == 16);
+	TEST_CHECK(poll_now(out) & POLLOUT);
+	TEST_CHECK(snd_rawmidi_write(out, buf, sizeof(buf)) == 16);
+	TEST_CHECK(!(poll_now(out) & POLLOUT));
+
+	snd_rawmidi_close(out);
+	TEST_CHECK(ring_exists());
+	snd_rawmidi_close(in);
+	TEST_CHECK(!ring_exists());
+}
+
+int main(void)
+{
+	snprintf(ring_name, sizeof(ring_name), "lsb-test-%d", (int)getpid());
+	test_round_trip();
+	test_poll_output();
+	return TEST_EXIT_CODE();
+}
@@ -0,0 +1,320 @@
+/*
+ * MIDI byte stream <-> sequencer event coder benchmark
+ *
+ * Compares snd_midi_event_encode()/snd_midi_event_decode() called once per
+ * event with the bulk variants.  The byte stream is taken from the tracks
+ * of a standard MIDI file, or synthesized as dense controller data when no
+ * file is given.
+ *
+ * Usage: midi_event_bench [-l loops] [file.mid]
+ */
+
+#include "config.h"
+
+#include "bench.h"
+
+#include "midifile.h"		/* SMF library header */
+#include "midifile.c"		/* SMF library code */
+
+#define EVENTS_CHUNK	256
+
+static struct bench_buf stream;
+static int last_status = -1;
+static FILE *smf;
+
+static void put_msg(int status, int len, int d1, int d2)
+{
+	if (status != last_status)
+		bench_buf_byte(&stream, status);
+	last_status = status;
+	if (len > 0)
+		bench_buf_byte(&stream, d1 & 0x7f);
+	if (len > 1)
+		bench_buf_byte(&stream, d2 & 0x7f);
+}
+
+static int smf_getc(void)
+{
+	return getc(smf);
+}
+
+static void smf_noteon(int chan, int pitch, int vol)
+{
+	put_msg(0x90 | chan, 2, pitch, vol);
+}
+
+static void smf_noteoff(int chan, int pitch, int vol)
+{
+	put_msg(0x80 | chan, 2, pitch, vol);
+}
+
+static void smf_pressure(int chan, int pitch, int pressure)
+{
+	put_msg(0xa0 | chan, 2, pitch, pressure);
+}
+
+static void smf_parameter(int chan, int control, int value)
+{
+	put_msg(0xb0 | chan, 2, control, value);
+}
+
+static void smf_program(int chan, int program)
+{
+	put_msg(0xc0 | chan, 1, program, 0);
+}
+
+static void smf_chanpressure(int chan, int pressure)
+{
+	put_msg(0xd0 | chan, 1, pressure, 0);
+}
+
+static void smf_pitchbend(int chan, int lsb, int msb)
+{
+	put_msg(0xe0 | chan, 2, lsb, msb);
+}
+
+static void smf_sysex(int len, char *msg)
+{
+	int i;
+
+	bench_buf_byte(&stream, 0xf0);
+	for (i = 0; i < len; i++)
+		if ((unsigned char)msg[i] != 0xf7)
+			bench_buf_byte(&stream, msg[i] & 0x7f);
+	bench_buf_byte(&stream, 0xf7);
+	last_status = -1;
+}
+
+static void load_smf(const char *name)
+{
+	smf = fopen(name, "r");
+	if (!smf) {
+		perror(name);
+		exit(EXIT_FAILURE);
+	}
+	Mf_getc = smf_getc;
+	Mf_noteon = smf_noteon;
+	Mf_noteoff = smf_noteoff;
+	Mf_pressure = smf_pressure;
+	Mf_parameter = smf_parameter;
+	Mf_program = smf_program;
+	Mf_chanpressure = smf_chanpressure;
+	Mf_pitchbend = smf_pitchbend;
+	Mf_sysex = smf_sysex;
+	mfread();
+	fclose(smf);
+}
+
+/* dense controller sweeps with notes, pitch bends and occasional sysex */
+static void synthesize(void)
+{
+	int i, ch;
+
+	for (i = 0; i < 200000; i++) {
+		ch = (i >> 10) & 0x0f;
+		put_msg(0xb0 | ch, 2, 1 + (i & 3), i);
+		if ((i & 15) == 0)
+			put_msg(0x90 | ch, 2, 36 + (i & 63), 100);
+		if ((i & 7) == 0)
+			put_msg(0xe0 | ch, 2, i, i >> 7);
+		if ((i & 4095) == 0) {
+			bench_buf_byte(&stream, 0xf0);
+			bench_buf_byte(&stream, 0x7e);
+			bench_buf_byte(&stream, 0x7f);
+			bench_buf_byte(&stream, 0x06);
+			bench_buf_byte(&stream, 0x01);
+			bench_buf_byte(&stream, 0xf7);
+			last_status = -1;
+		}
+	}
+}
+
+static size_t encode_single(snd_midi_event_t *dev, snd_seq_event_t *evs, size_t max)
+{
+	const unsigned char *p = (const unsigned char *)stream.data;
+	long left = stream.len, n;
+	size_t nevs = 0;
+
+	snd_midi_event_reset_encode(dev);
+	while (left > 0) {
+		n = snd_midi_event_encode(dev, p, left, &evs[nevs]);
+		if (n <= 0)
+			break;
+		p += n;
+		left -= n;
+		/* keep sysex events out of the comparison */
+		if (evs[nevs].type != SND_SEQ_EVENT_NONE &&
+		    evs[nevs].type != SND_SEQ_EVENT_SYSEX && nevs < max - 1)
+			nevs++;
+	}
+	return nevs;
+}
+
+static size_t encode_bulk(snd_midi_event_t *dev, snd_seq_event_t *evs, size_t max)
+{
+	const unsigned char *p = (const unsigned char *)stream.data;
+	long left = stream.len, n, i, consumed;
+	size_t nevs = 0, w;
+
+	snd_midi_event_reset_encode(dev);
+	while (left > 0) {
+		n = snd_midi_event_encode_bulk(dev, p, left, evs + nevs,
+					       EVENTS_CHUNK, &consumed);
+		if (n < 0 || consumed <= 0)
+			break;
+		p += consumed;
+		left -= consumed;
+		w = nevs;
+		for (i = 0; i < n; i++) {
+			if (evs[nevs + i].type != SND_SEQ_EVENT_SYSEX)
+				evs[w++] = evs[nevs + i];
+		}
+		nevs = w < max - EVENTS_CHUNK ? w : max - EVENTS_CHUNK;
+	}
+	return nevs;
+}
+
+static int same_event(const snd_seq_event_t *a, const snd_seq_event_t *b)
+{
+	if (a->type != b->type)
+		return 0;
+	switch (a->type) {
+	case SND_SEQ_EVENT_NOTEON:
+	case SND_SEQ_EVENT_NOTEOFF:
+	case SND_SEQ_EVENT_KEYPRESS:
+		return a->data.note.channel == b->data.note.channel &&
+			a->data.note.note == b->data.note.note &&
+			a->data.note.velocity == b->data.note.velocity;
+	case SND_SEQ_EVENT_CONTROLLER:
+		return a->data.control.channel == b->data.control.channel &&
+			a->data.control.param == b->data.control.param &&
+			a->data.control.value == b->data.control.value;
+	case SND_SEQ_EVENT_PGMCHANGE:
+	case SND_SEQ_EVENT_CHANPRESS:
+	case SND_SEQ_EVENT_PITCHBEND:
+		return a->data.control.channel == b->data.control.channel &&
+			a->data.control.value == b->data.control.value;
+	default:
+		return a->data.control.value == b->data.control.value;
+	}
+}
+
+static size_t decode_single(snd_midi_event_t *dev, const snd_seq_event_t *evs,
+			    size_t nevs, unsigned char *buf, size_t size)
+{
+	size_t i, len = 0;
+	long n;
+
+	snd_midi_event_reset_decode(dev);
+	for (i = 0; i < nevs; i++) {
+		n = snd_midi_event_decode(dev, buf + len, size - len, &evs[i]);
+		if (n > 0)
+			len += n;
+	}
+	return len;
+}
+
+static size_t decode_bulk(snd_midi_event_t *dev, const snd_seq_event_t *evs,
+			  size_t nevs, unsigned char *buf, size_t size)
+{
+	size_t i = 0, len = 0;
+	long n, consumed;
+
+	snd_midi_event_reset_decode(dev);
+	while (i < nevs) {
+		n = snd_midi_event_decode_bulk(dev, buf + len, size - len,
+					       evs + i, nevs - i, &consumed);
+		if (n < 0)
+			break;
+		len += n;
+		i += consumed;
+	}
+	return len;
+}
+
+static void report(const char *name, double t, int loops, size_t bytes, size_t nevs)
+{
+	printf("%-14s %8.2f ms/loop %10.1f MB/s %10.2f Mev/s\n", name,
+	       t * 1000.0 / loops, bytes * (double)loops / t / 1e6,
+	       nevs * (double)loops / t / 1e6);
+}
+
+int main(int argc, char *argv[])
+{
+	snd_midi_event_t *dev;
+	snd_seq_event_t *evs1, *evs2;
+	unsigned char *out1, *out2;
+	size_t max, n1, n2, len1, len2;
+	int i, loops = 20;
+	double t;
+
+	while (bench_getopt(argc, argv, "l:", "[-l loops] [file.mid]", &loops) != -1)
+		;
+	if (optind < argc)
+		load_smf(argv[optind]);
+	else
+		synthesize();
+	if (stream.len == 0) {
+		fprintf(stderr, "empty MIDI stream\n");
+		return EXIT_FAILURE;
+	}
+
+	max = stream.len + EVENTS_CHUNK;
+	evs1 = calloc(max, sizeof(*evs1));
+	evs2 = calloc(max, sizeof(*evs2));
+	out1 = malloc(stream.len * 2);
+	out2 = malloc(stream.len * 2);
+	if (!evs1 || !evs2 || !out1 || !out2 ||
+	    snd_midi_event_new(256, &dev) < 0) {
+		fprintf(stderr, "out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("stream: %zu bytes, %d loops\n", stream.len, loops);
+
+	n1 = n2 = 0;
+	t = bench_now();
+	for (i = 0; i < loops; i++)
+		n1 = encode_single(dev, evs1, max);
+	report("encode", bench_now() - t, loops, stream.len, n1);
+
+	t = bench_now();
+	for (i = 0; i < loops; i++)
+		n2 = encode_bulk(dev, evs2, max);
+	report("encode_bulk", bench_now() - t, loops, stream.len, n2);
+
+	if (n1 != n2) {
+		fprintf(stderr, "encoded events differ (%zu vs %zu)\n", n1, n2);
+		return EXIT_FAILURE;
+	}
+	for (i = 0; i < (int)n1; i++) {
+		if (!same_event(&evs1[i], &evs2[i])) {
+			fprintf(stderr, "encoded event %d differs\n", i);
+			return EXIT_FAILURE;
+		}
+	}
+
+	len1 = len2 = 0;
+	t = bench_now();
+	for (i = 0; i < loops; i++)
+		len1 = decode_single(dev, evs1, n1, out1, stream.len * 2);
+	report("decode", bench_now() - t, loops, len1, n1);
+
+	t = bench_now();
+	for (i = 0; i < loops; i++)
+		len2 = decode_bulk(dev, evs1, n1, out2, stream.len * 2);
+	report("decode_bulk", bench_now() - t, loops, len2, n1);
+
+	if (len1 != len2 || memcmp(out1, out2, len1)) {
+		fprintf(stderr, "decoded streams differ\n");
+		return EXIT_FAILURE;
+	}
+
+	snd_midi_event_free(dev);
+	free(evs1);
+	free(evs2);
+	free(out1);
+	free(out2);
+	free(stream.data);
+	return EXIT_SUCCESS;
+}
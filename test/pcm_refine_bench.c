@@ -0,0 +1,138 @@
+/*
+ * hw_params refinement benchmark
+ *
+ * Refines a few representative configuration spaces of a null PCM
+ * (the soft rules only) and reports the time per operation.  The
+ * refine cache is disabled, so every operation runs the rules.
+ *
+ * Usage: pcm_refine_bench [-l loops]
+ */
+
+#include "config.h"
+
+#include "bench.h"
+
+static const char *bench_conf = "pcm.bench { type null }";
+
+/* the whole configuration space */
+static int op_any(snd_pcm_t *pcm, snd_pcm_hw_params_t *params)
+{
+	return snd_pcm_hw_params_any(pcm, params);
+}
+
+/* the usual fixed parameters of an application */
+static int op_fixed(snd_pcm_t *pcm, snd_pcm_hw_params_t *params)
+{
+	int err;
+
+	err = snd_pcm_hw_params_any(pcm, params);
+	if (err >= 0)
+		err = snd_pcm_hw_params_set_access(pcm, params, SND_PCM_ACCESS_RW_INTERLEAVED);
+	if (err >= 0)
+		err = snd_pcm_hw_params_set_format(pcm, params, SND_PCM_FORMAT_S16_LE);
+	if (err >= 0)
+		err = snd_pcm_hw_params_set_channels(pcm, params, 2);
+	if (err >= 0)
+		err = snd_pcm_hw_params_set_rate(pcm, params, 48000, 0);
+	return err;
+}
+
+/* the buffer and period times near the requested values */
+static int op_near(snd_pcm_t *pcm, snd_pcm_hw_params_t *params)
+{
+	unsigned int rate = 44100, buffer_time = 500000, period_time = 100000;
+	int err;
+
+	err = snd_pcm_hw_params_any(pcm, params);
+	if (err >= 0)
+		err = snd_pcm_hw_params_set_format(pcm, params, SND_PCM_FORMAT_S24_3LE);
+	if (err >= 0)
+		err = snd_pcm_hw_params_set_rate_near(pcm, params, &rate, 0);
+	if (err >= 0)
+		err = snd_pcm_hw_params_set_buffer_time_near(pcm, params, &buffer_time, 0);
+	if (err >= 0)
+		err = snd_pcm_hw_params_set_period_time_near(pcm, params, &period_time, 0);
+	return err;
+}
+
+/* the sizes in bytes, resolved through the frame bits */
+static int op_bytes(snd_pcm_t *pcm, snd_pcm_hw_params_t *params)
+{
+	snd_pcm_uframes_t period_size = 1024;
+	int err;
+
+	err = snd_pcm_hw_params_any(pcm, params);
+	if (err >= 0)
+		err = snd_pcm_hw_params_set_channels_minmax(pcm, params, &(unsigned int){ 2 },
+							    &(unsigned int){ 8 });
+	if (err >= 0)
+		err = snd_pcm_hw_params_set_period_size_near(pcm, params, &period_size, 0);
+	if (err >= 0)
+		err = snd_pcm_hw_params_set_periods_integer(pcm, params);
+	return err;
+}
+
+/* the complete negotiation including the choice of the values */
+static int op_setup(snd_pcm_t *pcm, snd_pcm_hw_params_t *params)
+{
+	int err;
+
+	err = op_near(pcm, params);
+	if (err >= 0)
+		err = snd_pcm_hw_params(pcm, params);
+	return err;
+}
+
+struct refine_op {
+	snd_pcm_t *pcm;
+	snd_pcm_hw_params_t *params;
+	int (*op)(snd_pcm_t *, snd_pcm_hw_params_t *);
+};
+
+static int refine_op(void *arg)
+{
+	struct refine_op *r = arg;
+
+	return r->op(r->pcm, r->params);
+}
+
+static void run(snd_pcm_t *pcm, const char *name,
+		int (*op)(snd_pcm_t *, snd_pcm_hw_params_t *), int loops)
+{
+	struct refine_op r = { .pcm = pcm, .op = op };
+	double t;
+
+	snd_pcm_hw_params_alloca(&r.params);
+	t = bench_run(name, loops, refine_op, &r);
+	printf("%-8s %10.2f us/op\n", name, t * 1e6 / loops);
+}
+
+int main(int argc, char *argv[])
+{
+	snd_config_t *conf;
+	snd_pcm_t *pcm;
+	int loops = 20000, err;
+
+	while (bench_getopt(argc, argv, "l:", "[-l loops]", &loops) != -1)
+		;
+
+	/* measure the rules, not the cached results */
+	setenv("LIBASOUND_REFINE_CACHE", "0", 1);
+
+	conf = bench_config(bench_conf);
+	err = snd_pcm_open_lconf(&pcm, "bench", SND_PCM_STREAM_PLAYBACK, 0, conf);
+	if (err < 0) {
+		fprintf(stderr, "cannot open the null PCM: %s\n", snd_strerror(err));
+		return EXIT_FAILURE;
+	}
+
+	run(pcm, "any", op_any, loops);
+	run(pcm, "fixed", op_fixed, loops);
+	run(pcm, "near", op_near, loops);
+	run(pcm, "bytes", op_bytes, loops);
+	run(pcm, "setup", op_setup, loops / 10 + 1);
+
+	snd_pcm_close(pcm);
+	snd_config_delete(conf);
+	return EXIT_SUCCESS;
+}
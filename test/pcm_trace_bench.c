@@ -0,0 +1,119 @@
+/*
+ * PCM tracing benchmark
+ *
+ * Writes periods to a null PCM directly and through a plug PCM doing
+ * a format and a rate conversion, with the tracing disabled and
+ * enabled in turns, and reports the time per write and the overhead
+ * of the tracing.
+ *
+ * Usage: pcm_trace_bench [-l loops] [-d]
+ *
+ * -d dumps the recorded events at the end.
+ */
+
+#include "config.h"
+
+#include "bench.h"
+
+#define PERIOD	1024
+#define ROUNDS	5
+
+static const char *bench_conf =
+	"pcm.tnull { type null }\n"
+	"pcm.tplug { type plug slave { pcm { type null } format S16_LE rate 48000 channels 2 } }\n";
+
+static snd_pcm_t *open_pcm(snd_config_t *conf, const char *name,
+			   snd_pcm_format_t format, unsigned int rate)
+{
+	snd_pcm_t *pcm;
+	int err;
+
+	err = snd_pcm_open_lconf(&pcm, name, SND_PCM_STREAM_PLAYBACK, 0, conf);
+	if (err >= 0)
+		err = snd_pcm_set_params(pcm, format, SND_PCM_ACCESS_RW_INTERLEAVED,
+					 2, rate, 1, 100000);
+	if (err < 0) {
+		fprintf(stderr, "cannot open %s: %s\n", name, snd_strerror(err));
+		exit(EXIT_FAILURE);
+	}
+	return pcm;
+}
+
+struct period {
+	snd_pcm_t *pcm;
+	const void *buf;
+};
+
+static int write_period(void *arg)
+{
+	struct period *p = arg;
+	snd_pcm_sframes_t res;
+
+	res = snd_pcm_writei(p->pcm, p->buf, PERIOD);
+	if (res < 0)
+		res = snd_pcm_recover(p->pcm, res, 0);
+	return res < 0 ? res : 0;
+}
+
+static void bench(snd_pcm_t *pcm, const char *name, const void *buf, int loops)
+{
+	struct period p = { .pcm = pcm, .buf = buf };
+	double off = 0, on = 0;
+	int r;
+
+	/* alternate the rounds to spread the noise over both cases */
+	for (r = 0; r < ROUNDS; r++) {
+		snd_pcm_trace_enable(0);
+		off += bench_run("write", loops, write_period, &p);
+		snd_pcm_trace_enable(1);
+		on += bench_run("write", loops, write_period, &p);
+	}
+	snd_pcm_trace_enable(0);
+	printf("%-6s off %8.1f ns/write, on %8.1f ns/write, overhead %5.2f%%\n",
+	       name, off * 1e9 / (loops * ROUNDS), on * 1e9 / (loops * ROUNDS),
+	       (on - off) * 100.0 / off);
+}
+
+int main(int argc, char *argv[])
+{
+	static int buf[PERIOD * 2];
+	snd_config_t *conf;
+	snd_output_t *out;
+	snd_pcm_t *pcm;
+	int c, loops = 20000, dump = 0, err;
+
+	while ((c = bench_getopt(argc, argv, "l:d", "[-l loops] [-d]",
+				 &loops)) != -1) {
+		if (c == 'd')
+			dump = 1;
+	}
+
+	err = snd_pcm_trace_enable(0);
+	if (err < 0) {
+		fprintf(stderr, "tracing not available: %s\n", snd_strerror(err));
+		return EXIT_SUCCESS;
+	}
+
+	conf = bench_config(bench_conf);
+
+	pcm = open_pcm(conf, "tnull", SND_PCM_FORMAT_S16_LE, 48000);
+	bench(pcm, "null", buf, loops);
+	snd_pcm_close(pcm);
+
+	pcm = open_pcm(conf, "tplug", SND_PCM_FORMAT_S32_LE, 44100);
+	bench(pcm, "plug", buf, loops / 10 + 1);
+	if (snd_output_buffer_open(&out) >= 0) {
+		err = snd_pcm_trace_dump(pcm, out);
+		printf("%d events recorded for the plug PCM\n", err);
+		if (dump) {
+			char *str;
+			snd_output_buffer_string(out, &str);
+			fputs(str, stdout);
+		}
+		snd_output_close(out);
+	}
+	snd_pcm_close(pcm);
+
+	snd_config_delete(conf);
+	return EXIT_SUCCESS;
+}
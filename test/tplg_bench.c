@@ -0,0 +1,117 @@
+/*
+ * Topology compiler benchmark
+ *
+ * Builds a synthetic topology with the given number of widgets, each
+ * with its own mixer control, private data and a graph route to the
+ * previous widget, and compiles it the same way as alsatplg does
+ * (snd_tplg_load() and snd_tplg_build_bin()).
+ *
+ * Usage: tplg_bench [-w widgets] [-i widgets per index] [-o out.bin]
+ */
+
+#include "config.h"
+
+#include "bench.h"
+#include "../include/topology.h"
+
+static struct bench_buf text;
+
+static void generate(int widgets, int per_index)
+{
+	int i, index;
+
+	for (i = 0; i < widgets; i++) {
+		index = i / per_index + 1;
+		bench_buf_printf(&text, "SectionControlMixer.\"ctl%d\" {\n"
+				 "\tindex \"%d\"\n"
+				 "\tchannel.\"FL\" { reg \"0\" shift \"0\" }\n"
+				 "\tops.\"ctl\" { info \"volsw\" get \"256\" put \"256\" }\n"
+				 "\tmax \"100\"\n"
+				 "}\n", i, index);
+		bench_buf_printf(&text, "SectionData.\"data%d\" { bytes \"0x%02x,0x00,0x01,0x02\" }\n",
+				 i, i & 0xff);
+		bench_buf_printf(&text, "SectionWidget.\"w%d\" {\n"
+				 "\tindex \"%d\"\n"
+				 "\ttype \"pga\"\n"
+				 "\tno_pm \"true\"\n"
+				 "\tmixer [ \"ctl%d\" ]\n"
+				 "\tdata [ \"data%d\" ]\n"
+				 "}\n", i, index, i, i);
+	}
+	for (i = 1; i < widgets; i++) {
+		index = i / per_index + 1;
+		bench_buf_printf(&text, "SectionGraph.\"g%d\" {\n"
+				 "\tindex \"%d\"\n"
+				 "\tlines [ \"w%d, ctl%d, w%d\" ]\n"
+				 "}\n", i, index, i, i, i - 1);
+	}
+}
+
+int main(int argc, char *argv[])
+{
+	const char *out = NULL;
+	int c, widgets = 10000, per_index = 100, err;
+	snd_tplg_t *tplg;
+	void *bin;
+	size_t size;
+	double t, t_load, t_build;
+	FILE *fp;
+
+	while ((c = bench_getopt(argc, argv, "w:i:o:",
+				 "[-w widgets] [-i widgets per index] [-o out.bin]",
+				 NULL)) != -1) {
+		switch (c) {
+		case 'w':
+			widgets = atoi(optarg);
+			break;
+		case 'i':
+			per_index = atoi(optarg);
+			break;
+		case 'o':
+			out = optarg;
+			break;
+		}
+	}
+	if (widgets <= 0)
+		widgets = 1;
+	if (per_index <= 0)
+		per_index = 1;
+
+	generate(widgets, per_index);
+	printf("%d widgets, %zu bytes of text\n", widgets, text.len);
+
+	tplg = snd_tplg_create(0);
+	if (!tplg) {
+		fprintf(stderr, "cannot create topology\n");
+		return EXIT_FAILURE;
+	}
+	t = bench_now();
+	err = snd_tplg_load(tplg, text.data, text.len);
+	t_load = bench_now() - t;
+	if (err < 0) {
+		fprintf(stderr, "load failed: %s\n", snd_strerror(err));
+		return EXIT_FAILURE;
+	}
+	t = bench_now();
+	err = snd_tplg_build_bin(tplg, &bin, &size);
+	t_build = bench_now() - t;
+	if (err < 0) {
+		fprintf(stderr, "build failed: %s\n", snd_strerror(err));
+		return EXIT_FAILURE;
+	}
+	printf("load  %10.2f ms\n", t_load * 1000.0);
+	printf("build %10.2f ms (%zu bytes)\n", t_build * 1000.0, size);
+
+	if (out) {
+		fp = fopen(out, "w");
+		if (!fp || fwrite(bin, 1, size, fp) != size) {
+			perror(out);
+			return EXIT_FAILURE;
+		}
+		fclose(fp);
+	}
+	free(bin);
+	snd_tplg_free(tplg);
+	free(text.data);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,163 @@
+/*
+ * UMP <-> MIDI 1.0 byte stream translation benchmark
+ *
+ * Translates a synthesized MIDI 1.0 stream (channel messages, real-time
+ * bytes and sysex) to MIDI 1.0 and MIDI 2.0 protocol UMP packets with
+ * snd_ump_msg_encode_bytes() and back with snd_ump_msg_decode_bytes(),
+ * verifies the round trip and reports the throughput.
+ *
+ * Usage: ump_bench [-l loops] [-c chunk]
+ */
+
+#include "config.h"
+
+#include "bench.h"
+#include "../include/ump_msg.h"
+
+static struct bench_buf stream;
+
+static void put_msg(int status, int len, int d1, int d2)
+{
+	bench_buf_byte(&stream, status);
+	if (len > 0)
+		bench_buf_byte(&stream, d1 & 0x7f);
+	if (len > 1)
+		bench_buf_byte(&stream, d2 & 0x7f);
+}
+
+/* dense controller sweeps with notes, pitch bends, clocks and sysex */
+static void synthesize(void)
+{
+	int i, j, ch;
+
+	for (i = 0; i < 200000; i++) {
+		ch = (i >> 10) & 0x0f;
+		put_msg(0xb0 | ch, 2, 1 + (i & 3), i);
+		if ((i & 15) == 0)
+			put_msg(0x90 | ch, 2, 36 + (i & 63), 1 + (i & 0x7e));
+		if ((i & 15) == 8)
+			put_msg(0x80 | ch, 2, 36 + (i & 63), 64);
+		if ((i & 7) == 0)
+			put_msg(0xe0 | ch, 2, i, i >> 7);
+		if ((i & 255) == 0)
+			put_msg(0xc0 | ch, 1, i >> 8, 0);
+		if ((i & 63) == 0)
+			bench_buf_byte(&stream, 0xf8);
+		if ((i & 4095) == 0) {
+			bench_buf_byte(&stream, 0xf0);
+			for (j = 0; j < 1 + (i >> 12) % 40; j++)
+				bench_buf_byte(&stream, j);
+			bench_buf_byte(&stream, 0xf7);
+		}
+	}
+}
+
+static size_t encode(snd_ump_msg_encoder_t *enc, uint32_t *ump, size_t chunk)
+{
+	size_t pos = 0, words = 0, consumed, n;
+	ssize_t w;
+
+	snd_ump_msg_encoder_reset(enc);
+	while (pos < stream.len) {
+		n = stream.len - pos;
+		if (n > chunk)
+			n = chunk;
+		w = snd_ump_msg_encode_bytes(enc, (const unsigned char *)stream.data + pos, n, ump + words,
+					     stream.len - words, &consumed);
+		if (w < 0 || consumed == 0)
+			break;
+		words += w;
+		pos += consumed;
+	}
+	return words;
+}
+
+static size_t decode(const uint32_t *ump, size_t words, unsigned char *buf,
+		     size_t size, size_t chunk)
+{
+	size_t pos = 0, len = 0, consumed, n;
+	ssize_t r;
+
+	while (pos < words) {
+		n = words - pos;
+		if (n > chunk)
+			n = chunk;
+		r = snd_ump_msg_decode_bytes(ump + pos, n, buf + len, size - len,
+					     &consumed);
+		if (r < 0 || consumed == 0)
+			break;
+		len += r;
+		pos += consumed;
+	}
+	return len;
+}
+
+static void report(const char *name, double t, int loops, size_t bytes,
+		   size_t words)
+{
+	printf("%-14s %8.2f ms/loop %10.1f MB/s %10.2f Mwords/s\n", name,
+	       t * 1000.0 / loops, bytes * (double)loops / t / 1e6,
+	       words * (double)loops / t / 1e6);
+}
+
+static int run(int midi2, int loops, size_t chunk)
+{
+	snd_ump_msg_encoder_t *enc;
+	uint32_t *ump;
+	unsigned char *out;
+	size_t words = 0, len = 0;
+	double t;
+	int i;
+
+	ump = malloc(stream.len * sizeof(*ump));
+	out = malloc(stream.len);
+	if (!ump || !out || snd_ump_msg_encoder_new(&enc, 0, midi2) < 0) {
+		fprintf(stderr, "out of memory\n");
+		return -1;
+	}
+
+	t = bench_now();
+	for (i = 0; i < loops; i++)
+		words = encode(enc, ump, chunk);
+	report(midi2 ? "encode midi2" : "encode midi1", bench_now() - t, loops,
+	       stream.len, words);
+
+	t = bench_now();
+	for (i = 0; i < loops; i++)
+		len = decode(ump, words, out, stream.len, chunk);
+	report(midi2 ? "decode midi2" : "decode midi1", bench_now() - t, loops,
+	       len, words);
+
+	if (len != stream.len || memcmp(stream.data, out, len)) {
+		fprintf(stderr, "%s round trip differs (%zu vs %zu bytes)\n",
+			midi2 ? "MIDI 2.0" : "MIDI 1.0", len, stream.len);
+		return -1;
+	}
+
+	snd_ump_msg_encoder_free(enc);
+	free(ump);
+	free(out);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	int c, loops = 20;
+	size_t chunk = 4096;
+
+	while ((c = bench_getopt(argc, argv, "l:c:", "[-l loops] [-c chunk]",
+				 &loops)) != -1) {
+		if (c == 'c')
+			chunk = atoi(optarg);
+	}
+	if (chunk == 0)
+		chunk = 1;
+	synthesize();
+
+	printf("stream: %zu bytes, %d loops, %zu chunk\n", stream.len, loops, chunk);
+	if (run(0, loops, chunk) < 0 || run(1, loops, chunk) < 0)
+		return EXIT_FAILURE;
+
+	free(stream.data);
+	return EXIT_SUCCESS;
+}